@@ -4,7 +4,14 @@
 #include "robotino/headers/_CompactBha.h"
 #include "robotino/headers/_LaserRangeFinder.h"
 #include "robotino/headers/_DistanceSensors.h"
+#include "robotino/headers/_Motor.h"
 #include "obstacle/Hinder.h"
+#include "navigation/gridnav.h"
+#include "navigation/DynamicWindow.h"
+#include "navigation/MonteCarloLocalizer.h"
+#include "navigation/GraphSlam.h"
+#include "navigation/SlipDetector.h"
+#include "obstacle/OccupancyGrid.h"
 #include "geometry/All.h"
 
 #include "kinect/KinectReader.h"
@@ -28,6 +35,9 @@
 
 /// Microseconds to wait before checking Kinect for a new coordinate
 #define CONTROL_KINECT_WAIT	50000
+
+/// The file savemap and loadmap use when not given one
+#define CONTROL_MAP_FILE	"map.pgm"
 #define BIGCOST 500
 #define GRIDSIZE 12
 #define SQRT2 1.4142136
@@ -90,6 +100,21 @@ class Control
 				std::cerr << "Going to " << input.substr( ++separator ) << std::endl;
 				this->goTo( input.substr( separator ) );
 			}
+			else if ( command == "planto" )
+			{
+				std::cerr << "Planning route to " << input.substr( ++separator ) << std::endl;
+				this->planTo( input.substr( separator ) );
+			}
+			else if ( command == "dwa" )
+			{
+				std::cerr << "Steering around obstacles to " << input.substr( ++separator ) << std::endl;
+				this->localTo( input.substr( separator ) );
+			}
+			else if ( command == "route" )
+			{
+				std::cerr << "Following route " << input.substr( ++separator ) << std::endl;
+				this->route( input.substr( separator ) );
+			}
 			else if ( command == "stop" )
 			{
 				std::cerr << "Stopping" << std::endl;
@@ -110,6 +135,18 @@ class Control
 				this->pBrain->drive()->stopPointing();
 				std::cerr << "Pointing stopped" << std::endl;
 			}
+			else if ( command == "holonomic" )
+			{
+				bool enable = ( separator == std::string::npos || input.substr( separator + 1 ) != "off" );
+				this->pBrain->drive()->setHolonomic( enable );
+				std::cerr << "Holonomic driving " << ( enable ? "on" : "off" ) << std::endl;
+			}
+			else if ( command == "mpc" )
+			{
+				bool enable = ( separator == std::string::npos || input.substr( separator + 1 ) != "off" );
+				this->pBrain->drive()->setModelPredictive( enable );
+				std::cerr << "Model predictive control " << ( enable ? "on" : "off" ) << std::endl;
+			}
 
 			else if ( command == "speed" )
 			{
@@ -140,6 +177,62 @@ class Control
 			{
 				std::cerr << "Current position: " << this->pBrain->odom()->getPosition() << std::endl;
 			}
+			else if ( command == "printcommands" )
+			{
+				std::cerr << "Drive commands sent: " << this->pBrain->drive()->commandsSent()
+					<< ", suppressed: " << this->pBrain->drive()->commandsSuppressed() << std::endl;
+			}
+			else if ( command == "printslip" )
+			{
+				std::cerr << "Wheels " << ( this->pBrain->slip()->isSlipping() ? "slipping" : "gripping" )
+					<< ", evidence " << this->pBrain->slip()->evidence()
+					<< ", slipped " << this->pBrain->slip()->slips() << " times" << std::endl;
+			}
+			else if ( command == "printmotors" )
+			{
+				for ( unsigned int i = 0; i < MOTOR_COUNT; i++ )
+				{
+					_Motor * pMotor = this->pBrain->motor( i );
+					std::cerr << "Motor " << i << ": " << pMotor->velocity() << " rpm, "
+						<< pMotor->meanCurrent() << " A mean"
+						<< ( pMotor->isStalled() ? ", stalled" : "" )
+						<< ", " << pMotor->energy() << " J drawn, "
+						<< pMotor->sampleRate() << " readings/s" << std::endl;
+				}
+			}
+			else if ( command == "localize" )
+			{
+				if ( separator == std::string::npos )
+					this->localize( "" );
+				else
+					this->localize( input.substr( separator + 1 ) );
+			}
+			else if ( command == "savemap" )
+			{
+				// Done by the main loop, which reports how it went
+				std::string file = ( separator == std::string::npos ) ? CONTROL_MAP_FILE : input.substr( separator + 1 );
+				this->pBrain->saveMap( file );
+			}
+			else if ( command == "loadmap" )
+			{
+				std::string file = ( separator == std::string::npos ) ? CONTROL_MAP_FILE : input.substr( separator + 1 );
+				this->pBrain->loadMap( file );
+			}
+			else if ( command == "slam" )
+			{
+				bool enable = ( separator == std::string::npos || input.substr( separator + 1 ) != "off" );
+				if ( enable && ! this->pBrain->hasLRF() )
+					std::cerr << "Mapping requires the LaserRangeFinder!" << std::endl;
+				else
+				{
+					this->pBrain->slam()->enable( enable );
+					if ( enable )
+						std::cerr << "Mapping on" << std::endl;
+					else
+						std::cerr << "Mapping off, " << this->pBrain->slam()->keyframes() << " keyframes, "
+							<< this->pBrain->slam()->loops() << " loops closed" << std::endl;
+				}
+			}
 
 /*			else if ( command == "inner" )
 			{
@@ -356,12 +449,24 @@ class Control
 
 			<< "\nDriving:\n"
 			<< "goto [coordinate]\tI will drive myself to the given coordinate\n"
+			<< "planto [coordinate]\tI will plan a route around known obstacles to the given coordinate and follow it\n"
+			<< "dwa [coordinate]\tI will drive to the given coordinate, steering around whatever my sensors see on the way\n"
+			<< "route [coordinate] [coordinate]...\tI will drive through the given coordinates without stopping, and stop at the last one\n"
 			<< "stop\tI will come to a halt, no more, no less.\n"
 			<< "go\tI will continue, if I was previously stopped\n"
 			<< "pointat [coordinate]\tI will turn myself to point at the given coordinate. I will hovever not do this until I am close enough to my destination.\n"
 			<< "stoppointing\tI will not point any more\n"
+			<< "holonomic [on|off]\tI will drive straight to my destinations sideways or backwards if need be, turning on the way\n"
+			<< "mpc [on|off]\tI will plan my speeds a second ahead, for precise approaches\n"
+			<< "printcommands\tI will tell how many drive commands I sent and skipped\n"
+			<< "printslip\tI will tell if my wheels slip, and how often they did\n"
+			<< "printmotors\tI will tell how fast each wheel turns, what current it draws and if it is stalled\n"
 			<< "speed [x< y< omega>>]\tSet Robotino's OmniDrive to the given speeds\n"
 			<< "resetodometry\tSets all odometry values to 0. Also resets destination and stops any pointing.\n"
+			<< "localize [coordinate]\tI will find out where I am on the map with my laser, near the given coordinate if you know it, and set my odometry. Then I keep correcting it, until \"localize off\"\n"
+			<< "savemap [file]\tI will save my map, to " CONTROL_MAP_FILE " if no file is given\n"
+			<< "loadmap [file]\tI will load a map saved by savemap\n"
+			<< "slam [on|off]\tI will draw a new map with my laser as I drive, closing loops when I come back to a place\n"
 
 			<< "\nArm:\n"
 //			<< "\tinner [coordinate]\n"
@@ -490,9 +595,8 @@ class Control
 
 		this->pBrain->cbha()->setMaxArmSpeed( 0.01 );
 		this->pBrain->cbha()->armRelax();
-		this->pBrain->drive()->setPointAt( Coordinate( 1.0, 0.0 ) );
-		this->pBrain->drive()->setStopWithin( 0 );
-		this->pBrain->drive()->setDestination( (Coordinate) initialPosition );
+		this->pBrain->drive()->setRoute( std::vector< Waypoint >( 1,
+				Waypoint( initialPosition, 0.0, Coordinate( 1.0, 0.0 ) ) ) );
 		this->pBrain->drive()->go();
 	}
 
@@ -527,6 +631,7 @@ class Control
 	 */
 	bool goTo( std::string input )
 	{
+		this->pBrain->dwa()->cancel();
 		this->pBrain->drive()->stopPointing();
 		Coordinate * destination = this->parseCoordinate( input );
 		if ( destination == NULL )
@@ -542,6 +647,141 @@ class Control
 		return true;
 	}
 
+	/**
+	 * Drives to a coordinate with the DynamicWindow local planner
+	 *
+	 * @param	input	A string parsable to a coordinate
+	 */
+	bool localTo( std::string input )
+	{
+		this->pBrain->gdn()->cancel();
+		this->pBrain->drive()->stopPointing();
+		Coordinate * destination = this->parseCoordinate( input );
+		if ( destination == NULL )
+		{
+			std::cerr << "Unable to parse coordinate, try again" << std::endl;
+			return false;
+		}
+
+		this->pBrain->dwa()->setGoal( * destination );
+		this->pBrain->drive()->go();
+		delete destination;
+		return true;
+	}
+
+	/**
+	 * Starts localizing on the map, around a coordinate if one is given. The
+	 * heading is guessed from the odometry. "off" stops localizing and
+	 * tracking.
+	 *
+	 * @param	input	A string parsable to a coordinate, empty, or "off"
+	 */
+	bool localize( std::string input )
+	{
+		if ( ! this->pBrain->hasLRF() )
+		{
+			std::cerr << "Localize requires the LaserRangeFinder!" << std::endl;
+			return false;
+		}
+
+		if ( input == "off" )
+		{
+			this->pBrain->localizer()->cancel();
+			std::cerr << "Localizer off, the odometry is on its own" << std::endl;
+			return true;
+		}
+
+		// Started by the main loop, which tells if the map will do
+		if ( input.empty() )
+		{
+			this->pBrain->localizer()->localize();
+			return true;
+		}
+
+		Coordinate * guess = this->parseCoordinate( input );
+		if ( guess == NULL )
+		{
+			std::cerr << "Unable to parse coordinate, try again" << std::endl;
+			return false;
+		}
+
+		AngularCoordinate pose = this->pBrain->odom()->getPosition();
+		this->pBrain->localizer()->localize( AngularCoordinate( guess->x(), guess->y(), pose.phi() ) );
+		delete guess;
+		return true;
+	}
+
+	/**
+	 * Makes Robotino drive through a series of coordinates, stopping only at
+	 * the last one
+	 *
+	 * @param	input	Space separated strings parsable to coordinates
+	 */
+	bool route( std::string input )
+	{
+		this->pBrain->dwa()->cancel();
+		this->pBrain->drive()->stopPointing();
+
+		std::vector< Waypoint > waypoints;
+		size_t start = 0;
+		while ( start < input.size() )
+		{
+			size_t end = input.find( ' ', start );
+			if ( end == std::string::npos ) end = input.size();
+
+			if ( end > start )
+			{
+				Coordinate * waypoint = this->parseCoordinate( input.substr( start, end - start ) );
+				if ( waypoint == NULL )
+				{
+					std::cerr << "Unable to parse coordinate \"" << input.substr( start, end - start ) << "\", try again" << std::endl;
+					return false;
+				}
+				waypoints.push_back( Waypoint( * waypoint ) );
+				delete waypoint;
+			}
+			start = end + 1;
+		}
+
+		if ( waypoints.empty() )
+		{
+			std::cerr << "No coordinates given, try again" << std::endl;
+			return false;
+		}
+
+		// Stop precisely at the end
+		waypoints.back() = Waypoint( waypoints.back().position, OMNIDRIVE_MIN_ACCEPTABLE_DISTANCE, true );
+
+		this->pBrain->drive()->setRoute( waypoints );
+		this->pBrain->drive()->go();
+		return true;
+	}
+
+	/**
+	 * Plans a route to a coordinate with gridnav and starts following it
+	 *
+	 * @param	input	A string parsable to a coordinate
+	 */
+	bool planTo( std::string input )
+	{
+		this->pBrain->dwa()->cancel();
+		this->pBrain->drive()->stopPointing();
+		Coordinate * destination = this->parseCoordinate( input );
+		if ( destination == NULL )
+		{
+			std::cerr << "Unable to parse coordinate, try again" << std::endl;
+			return false;
+		}
+
+		// Planned on the main loop, which tells if there is a route
+		this->pBrain->gdn()->planTo( * destination );
+		std::cerr << "Planning route to " << * destination << std::endl;
+		this->pBrain->drive()->go();
+
+		delete destination;
+		return true;
+	}
+
 	/**
 	 * Sets the point at coordinate of the OmniDrive object, which makes
 	 * Robotino turn to point at the coordinate.
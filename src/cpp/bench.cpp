@@ -0,0 +1,228 @@
+/**
+ * @file	bench.cpp
+ * @brief	Timings of the planners and the MPC controller, without Robotino
+ *
+ * Build with "make bench". Everything runs on generated data, so the numbers
+ * are comparable between machines and changes.
+ */
+#include "obstacle/OccupancyGrid.h"
+#include "obstacle/InflationLayer.h"
+#include "navigation/AStarPlanner.h"
+#include "navigation/DStarLitePlanner.h"
+#include "navigation/MpcController.h"
+#include "navigation/gridnav.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+/// Seed of the generated maps
+#define BENCH_SEED	3
+/// Cells per obstacle put on the generated maps
+#define BENCH_CELLS_PER_OBSTACLE	400
+/// Length of the walls put on the generated maps, in cells
+#define BENCH_WALL_LENGTH	6
+/// Number of walls added before each repair of D* Lite
+#define BENCH_CHANGES	3
+/// Number of repairs timed for D* Lite
+#define BENCH_REPAIRS	10
+/// Cycles of the closed loop driven with the MPC controller
+#define BENCH_MPC_CYCLES	200
+/// Cold solves timed for the MPC controller
+#define BENCH_MPC_COLD_SOLVES	1000
+/// Time allowed for a solve, in seconds, the share of a Brain cycle
+/// _OmniDrive gives it
+#define BENCH_MPC_BUDGET	0.01
+
+using namespace std;
+
+
+/**
+ * Gets the time since a starting point
+ *
+ * @param	start	The starting point
+ *
+ * @return	Milliseconds since start
+ */
+double
+msecsSince( chrono::steady_clock::time_point start )
+{
+	return chrono::duration< double, milli >( chrono::steady_clock::now() - start ).count();
+}
+
+/**
+ * Puts a short wall at a random place, across or along
+ *
+ * @param	grid	The map
+ * @param	value	Occupancy to set
+ */
+void
+addWall( OccupancyGrid & grid, unsigned char value )
+{
+	int x = rand() % grid.width(), y = rand() % grid.height();
+	bool across = rand() % 2;
+	for ( int i = 0; i < BENCH_WALL_LENGTH; i++ )
+		if ( across )
+			grid.setCell( std::min( x + i, grid.width() - 1 ), y, value );
+		else
+			grid.setCell( x, std::min( y + i, grid.height() - 1 ), value );
+}
+
+/**
+ * Times inflation, A* and D* Lite on a generated square map, from one
+ * corner to the other
+ *
+ * @param	side	Side of the map, in cells
+ */
+void
+benchPlanners( int side )
+{
+	srand( BENCH_SEED );
+	OccupancyGrid map( side, side );
+	for ( int i = 0; i < side * side / BENCH_CELLS_PER_OBSTACLE; i++ )
+		addWall( map, OCCUPANCYGRID_OCCUPIED );
+
+	int startX = 2, startY = 2, goalX = side - 3, goalY = side - 3;
+	map.setCell( startX, startY, OCCUPANCYGRID_FREE );
+	map.setCell( goalX, goalY, OCCUPANCYGRID_FREE );
+
+	InflationLayer costs( & map );
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	costs.update();
+	double inflation = msecsSince( start );
+
+	AStarPlanner aStar( & costs );
+	start = chrono::steady_clock::now();
+	bool found = aStar.plan( startX, startY, goalX, goalY );
+	double aStarTime = msecsSince( start );
+
+	DStarLitePlanner dStarLite( & costs );
+	start = chrono::steady_clock::now();
+	dStarLite.plan( startX, startY, goalX, goalY );
+	double dStarTime = msecsSince( start );
+
+	// The same plan spread over cycles as gridnav runs it. The first cycle
+	// also sizes the buffers for the grid.
+	DStarLitePlanner budgeted( & costs );
+	budgeted.setBudget( GRIDNAV_EXPANSIONS );
+	unsigned int cycles = 0;
+	double first = 0.0, longest = 0.0;
+	do
+	{
+		start = chrono::steady_clock::now();
+		budgeted.plan( startX, startY, goalX, goalY );
+		if ( cycles++ == 0 )
+			first = msecsSince( start );
+		else
+			longest = std::max( longest, msecsSince( start ) );
+	}
+	while ( budgeted.isSearching() );
+
+	// Repairs after a few walls appeared or vanished, moving along the path
+	double repairTime = 0.0;
+	unsigned int repairExpanded = 0;
+	for ( int r = 0; r < BENCH_REPAIRS; r++ )
+	{
+		for ( int i = 0; i < BENCH_CHANGES; i++ )
+			addWall( map, ( rand() % 2 ) ? OCCUPANCYGRID_OCCUPIED : OCCUPANCYGRID_FREE );
+		map.setCell( goalX, goalY, OCCUPANCYGRID_FREE );
+
+		if ( dStarLite.path().size() > 5 )
+		{
+			startX = dStarLite.path()[ 4 ] % side;
+			startY = dStarLite.path()[ 4 ] / side;
+		}
+
+		start = chrono::steady_clock::now();
+		dStarLite.plan( startX, startY, goalX, goalY );
+		repairTime += msecsSince( start );
+		repairExpanded += dStarLite.expanded();
+	}
+
+	cout << setw( 4 ) << side << "x" << setw( 4 ) << left << side << right
+		<< fixed << setprecision( 1 )
+		<< setw( 9 ) << inflation
+		<< setw( 9 ) << aStarTime << setw( 10 ) << aStar.expanded()
+		<< setw( 9 ) << dStarTime << setw( 8 ) << cycles << setw( 8 ) << first << setw( 9 ) << longest
+		<< setw( 9 ) << repairTime / BENCH_REPAIRS << setw( 10 ) << repairExpanded / BENCH_REPAIRS
+		<< ( found ? "" : "  no route" ) << endl;
+}
+
+
+/**
+ * Times the MPC controller driving a simulated Robotino from rest to a pose,
+ * each cycle warm started from the last, and from scratch
+ */
+void
+benchMpc()
+{
+	const float maxSpeed[ 3 ] = { 0.2, 0.2, 1.8 };
+	const float maxAccelleration[ 3 ] = { 0.4, 0.4, 4.0 };
+	const float goal[ 3 ] = { 0.3, 0.1, 0.5 };
+
+	MpcController mpc;
+	float position[ 3 ] = { 0.0, 0.0, 0.0 }, speed[ 3 ] = { 0.0, 0.0, 0.0 };
+	double total = 0.0, longest = 0.0;
+	unsigned int iterations = 0, unconverged = 0;
+	for ( int cycle = 0; cycle < BENCH_MPC_CYCLES; cycle++ )
+	{
+		float error[ 3 ], command[ 3 ];
+		for ( int axis = 0; axis < 3; axis++ ) error[ axis ] = position[ axis ] - goal[ axis ];
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		if ( ! mpc.control( error, speed, maxSpeed, maxAccelleration, BENCH_MPC_BUDGET, command ) )
+			unconverged++;
+		double time = msecsSince( start );
+		total += time;
+		longest = std::max( longest, time );
+		iterations += mpc.iterations();
+
+		for ( int axis = 0; axis < 3; axis++ )
+		{
+			speed[ axis ] = command[ axis ];
+			position[ axis ] += speed[ axis ] * MPC_STEP;
+		}
+	}
+
+	double cold = 0.0;
+	for ( int i = 0; i < BENCH_MPC_COLD_SOLVES; i++ )
+	{
+		MpcController fresh;
+		float error[ 3 ] = { - goal[ 0 ], - goal[ 1 ], - goal[ 2 ] }, rest[ 3 ] = { 0.0, 0.0, 0.0 }, first[ 3 ];
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		fresh.control( error, rest, maxSpeed, maxAccelleration, BENCH_MPC_BUDGET, first );
+		cold += msecsSince( start );
+	}
+
+	cout << "MPC, horizon " << MPC_HORIZON << ", times in msecs" << endl
+		<< fixed << setprecision( 3 )
+		<< "warm solve mean " << total / BENCH_MPC_CYCLES << ", longest " << longest
+		<< ", iterations mean " << setprecision( 1 ) << (double) iterations / BENCH_MPC_CYCLES
+		<< ", not converged " << unconverged << " of " << BENCH_MPC_CYCLES << endl
+		<< setprecision( 3 ) << "cold solve mean " << cold / BENCH_MPC_COLD_SOLVES
+		<< ", final error " << fabs( position[ 0 ] - goal[ 0 ] ) << " " << fabs( position[ 1 ] - goal[ 1 ] )
+		<< " " << fabs( position[ 2 ] - goal[ 2 ] ) << endl;
+}
+
+
+/**
+ * Runs all benchmarks
+ */
+int
+main()
+{
+	cout << "Planners, corner to corner, times in msecs, cycles of "
+		<< GRIDNAV_EXPANSIONS << " expansions" << endl
+		<< "     grid  inflate       A*  expanded   D*Lite  cycles   first  longest   repair  expanded" << endl;
+	const int sides[] = { 250, 500, 1000, 2000 };
+	for ( unsigned int i = 0; i < sizeof( sides ) / sizeof( sides[ 0 ] ); i++ )
+		benchPlanners( sides[ i ] );
+
+	cout << endl;
+	benchMpc();
+
+	return 0;
+}
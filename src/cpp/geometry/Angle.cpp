@@ -7,12 +7,14 @@
 #include <iostream>
 
 
-Angle::Angle()
+template< typename T >
+BasicAngle< T >::BasicAngle()
 {
 	this->setPhi( 0.0 );
 }
 
-Angle::Angle( float phi, bool degrees )
+template< typename T >
+BasicAngle< T >::BasicAngle( T phi, bool degrees )
 {
 	if ( degrees )
 		this->setPhi( phi * ( 180.0 / M_PI ) );
@@ -20,11 +22,19 @@ Angle::Angle( float phi, bool degrees )
 		this->setPhi( phi );
 }
 
+template< typename T >
+template< typename U >
+BasicAngle< T >::BasicAngle( BasicAngle< U > other )
+{
+	this->_phi = other.phi();
+}
+
+template< typename T >
 void
-Angle::setPhi( float phi )
+BasicAngle< T >::setPhi( T phi )
 {
 	// Reduce to +/- full circle
-	float newPhi = fmod( phi, 2 * M_PI );
+	T newPhi = fmod( phi, 2 * M_PI );
 
 	// Wrap around if outside bounds ( [-pi,pi] )
 	if ( newPhi > M_PI )
@@ -35,34 +45,45 @@ Angle::setPhi( float phi )
 		this->_phi = newPhi;
 }
 
-float
-Angle::phi()
+template< typename T >
+T
+BasicAngle< T >::phi()
 {
 	return this->_phi;
 }
 
-float
-Angle::degrees()
+template< typename T >
+T
+BasicAngle< T >::degrees()
 {
 	return (this->_phi * 180) / M_PI;
 }
 
+template< typename T >
 void
-Angle::reverse()
+BasicAngle< T >::reverse()
 {
 	this->setPhi( this->_phi + M_PI );
 }
 
-Angle
-Angle::deltaAngle( Angle angle )
+template< typename T >
+BasicAngle< T >
+BasicAngle< T >::deltaAngle( BasicAngle angle )
 {
-	return Angle( angle.phi() - this->_phi );
+	return BasicAngle( angle.phi() - this->_phi );
 }
 
 // Overloaded out stream operator
-std::ostream & operator << ( std::ostream & output, const Angle & a )
+template< typename T >
+std::ostream & operator << ( std::ostream & output, const BasicAngle< T > & a )
 {
 	output << "ø" << a._phi; 
 	return output;
 }
 
+template class BasicAngle< float >;
+template class BasicAngle< double >;
+template BasicAngle< float >::BasicAngle( BasicAngle< double > other );
+template BasicAngle< double >::BasicAngle( BasicAngle< float > other );
+template std::ostream & operator << ( std::ostream & output, const BasicAngle< float > & a );
+template std::ostream & operator << ( std::ostream & output, const BasicAngle< double > & a );
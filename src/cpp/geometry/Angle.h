@@ -7,14 +7,17 @@
  * Represents a geometric angle
  *
  * Holds the geometric property of an angle in radians, defined as e=[-pi, pi], and provides ways of manipulation
+ *
+ * Angle holds a float, PreciseAngle a double, see BasicCoordinate
  */
-class Angle 
+template< typename T >
+class BasicAngle
 {
  public:
 	/**
 	 * Default constructor, initializes values to 0
 	 */
-	Angle();
+	BasicAngle();
 
 	/**
 	 * Constructs angle
@@ -22,28 +25,36 @@ class Angle
 	 * @param	phi Angle, is normalized to [-pi, pi]
 	 * @param	degrees	If true, input is interpreted as degrees. Standard is radians.
 	 */
-	Angle( float phi, bool degrees = false );
+	BasicAngle( T phi, bool degrees = false );
+
+	/**
+	 * Converts an angle of the other precision
+	 *
+	 * @param	other	The angle
+	 */
+	template< typename U >
+	BasicAngle( BasicAngle< U > other );
 
 	/**
 	 * Gets the value of phi
 	 *
 	 * @return	The angle value in phi
 	 */
-	float phi();
+	T phi();
 
 	/**
 	 * Sets phi
 	 *
 	 * @param	phi Angle in rad, is normalized to [-pi, pi]
 	 */
-	void setPhi( float phi );
+	void setPhi( T phi );
 
 	/**
 	 * Returns the angle value in degrees, the value will be e=[-180, 180]
 	 *
 	 * @return	The angle value in degrees
 	 */
-	float degrees();
+	T degrees();
 
 	/**
 	 * Turns the angle pi ( 180 degrees )
@@ -57,16 +68,23 @@ class Angle
 	 *
 	 * @return	Angle representing the angle to be turned 
 	 */
-	Angle deltaAngle( Angle phi );
+	BasicAngle deltaAngle( BasicAngle phi );
 
 	/**
 	 * Overload of the << stream operator for an Angle object, allows direct use of an Angle object in a stream out situation
 	 */
-	friend std::ostream & operator << ( std::ostream & output, const Angle & a );
+	template< typename U >
+	friend std::ostream & operator << ( std::ostream & output, const BasicAngle< U > & a );
 
  private:
-	float
+	T
 		_phi;
 };
 
+template< typename T >
+std::ostream & operator << ( std::ostream & output, const BasicAngle< T > & a );
+
+typedef BasicAngle< float > Angle;
+typedef BasicAngle< double > PreciseAngle;
+
 #endif
@@ -5,20 +5,36 @@
 #include <iostream>
 
 
-AngularCoordinate::AngularCoordinate()
-	: Coordinate::Coordinate(),
-	Angle::Angle()
+template< typename T >
+BasicAngularCoordinate< T >::BasicAngularCoordinate()
+	: BasicCoordinate< T >::BasicCoordinate(),
+	BasicAngle< T >::BasicAngle()
 {}
 
-AngularCoordinate::AngularCoordinate( float x, float y, float phi )
-	: Coordinate::Coordinate( x, y ),
-	Angle::Angle( phi )
+template< typename T >
+BasicAngularCoordinate< T >::BasicAngularCoordinate( T x, T y, T phi )
+	: BasicCoordinate< T >::BasicCoordinate( x, y ),
+	BasicAngle< T >::BasicAngle( phi )
+{}
+
+template< typename T >
+template< typename U >
+BasicAngularCoordinate< T >::BasicAngularCoordinate( BasicAngularCoordinate< U > other )
+	: BasicCoordinate< T >::BasicCoordinate( other.x(), other.y() ),
+	BasicAngle< T >::BasicAngle( other.phi() )
 {}
 
 // Overloaded out stream operator
-std::ostream & operator << ( std::ostream & output, const AngularCoordinate & ac )
+template< typename T >
+std::ostream & operator << ( std::ostream & output, const BasicAngularCoordinate< T > & ac )
 {
-	output << (Coordinate) ac << " " << (Angle) ac;
+	output << (BasicCoordinate< T >) ac << " " << (BasicAngle< T >) ac;
 	return output;
 }
 
+template class BasicAngularCoordinate< float >;
+template class BasicAngularCoordinate< double >;
+template BasicAngularCoordinate< float >::BasicAngularCoordinate( BasicAngularCoordinate< double > other );
+template BasicAngularCoordinate< double >::BasicAngularCoordinate( BasicAngularCoordinate< float > other );
+template std::ostream & operator << ( std::ostream & output, const BasicAngularCoordinate< float > & ac );
+template std::ostream & operator << ( std::ostream & output, const BasicAngularCoordinate< double > & ac );
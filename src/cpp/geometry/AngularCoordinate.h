@@ -11,14 +11,19 @@
  * Represents a position and heading
  *
  * Combines a Coordinate and an Angle to create the equivalent of a position and heading
+ *
+ * AngularCoordinate holds floats, PreciseAngularCoordinate doubles, see
+ * BasicCoordinate. Poses of Robotino in the world frame are kept as
+ * PreciseAngularCoordinate from _Odometry on.
  */ 
-class AngularCoordinate : public Coordinate, public Angle
+template< typename T >
+class BasicAngularCoordinate : public BasicCoordinate< T >, public BasicAngle< T >
 {
  public:
 	/**
 	 * Default constructor, initializes values to 0
 	 */
-	AngularCoordinate();
+	BasicAngularCoordinate();
 
 	/**
 	 * Constructor, uses inherited constructors from Coordinate and Angle
@@ -27,12 +32,27 @@ class AngularCoordinate : public Coordinate, public Angle
 	 * @param	y	y-value of coordinate
 	 * @param	phi	angle in radians
 	 */
-	AngularCoordinate( float x, float y, float phi );
+	BasicAngularCoordinate( T x, T y, T phi );
+
+	/**
+	 * Converts a position and heading of the other precision
+	 *
+	 * @param	other	The position and heading
+	 */
+	template< typename U >
+	BasicAngularCoordinate( BasicAngularCoordinate< U > other );
 
 	/**
 	 * Overload of the << stream operator for an AngularCoordinate object, allows direct use of an AngularCoordinate object in a stream out situation
 	 */
-	friend std::ostream & operator << ( std::ostream & output, const AngularCoordinate & ac );
+	template< typename U >
+	friend std::ostream & operator << ( std::ostream & output, const BasicAngularCoordinate< U > & ac );
 };
 
+template< typename T >
+std::ostream & operator << ( std::ostream & output, const BasicAngularCoordinate< T > & ac );
+
+typedef BasicAngularCoordinate< float > AngularCoordinate;
+typedef BasicAngularCoordinate< double > PreciseAngularCoordinate;
+
 #endif
@@ -5,45 +5,66 @@
 #include <math.h>
 
 
-Coordinate::Coordinate()
+template< typename T >
+BasicCoordinate< T >::BasicCoordinate()
 {
 	this->_x = 0.0;
 	this->_y = 0.0;
 }
 
-Coordinate::Coordinate(float x, float y) 
+template< typename T >
+BasicCoordinate< T >::BasicCoordinate(T x, T y) 
 {
 	this->_x = x; 
 	this->_y = y; 
 }
 
-float
-Coordinate::x()
+template< typename T >
+template< typename U >
+BasicCoordinate< T >::BasicCoordinate( BasicCoordinate< U > other )
+{
+	this->_x = other.x();
+	this->_y = other.y();
+}
+
+template< typename T >
+T
+BasicCoordinate< T >::x()
 {
 	return this->_x;
 }
 
-float
-Coordinate::y()
+template< typename T >
+T
+BasicCoordinate< T >::y()
 {
 	return this->_y;
 }
 
-Vector
-Coordinate::getVector( Coordinate target ) 
+template< typename T >
+BasicVector< T >
+BasicCoordinate< T >::getVector( BasicCoordinate target ) 
 {
-	float dx = ( target.x() - this->_x ); 
-	float dy = ( target.y() - this->_y ); 
+	T dx = ( target.x() - this->_x ); 
+	T dy = ( target.y() - this->_y ); 
 
-	float length = sqrt(( dx * dx ) + ( dy * dy )); 
-	float direction = atan2( dy, dx );
+	T length = sqrt(( dx * dx ) + ( dy * dy )); 
+	T direction = atan2( dy, dx );
 
-	return Vector( length, direction );
+	return BasicVector< T >( length, direction );
 }
 
 // Overloaded out stream operator
-std::ostream & operator << ( std::ostream & output, const Coordinate & c )
+template< typename T >
+std::ostream & operator << ( std::ostream & output, const BasicCoordinate< T > & c )
 {
 	output << c._x << "," << c._y;
 	return output;
 }
+
+template class BasicCoordinate< float >;
+template class BasicCoordinate< double >;
+template BasicCoordinate< float >::BasicCoordinate( BasicCoordinate< double > other );
+template BasicCoordinate< double >::BasicCoordinate( BasicCoordinate< float > other );
+template std::ostream & operator << ( std::ostream & output, const BasicCoordinate< float > & c );
+template std::ostream & operator << ( std::ostream & output, const BasicCoordinate< double > & c );
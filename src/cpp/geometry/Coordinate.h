@@ -3,21 +3,27 @@
 
 #include <iostream>
 
-class Vector;
+template< typename T > class BasicVector;
 
 
 /**
  * Represents a two-dimentional coordinate
  *
  * Holds the two values that make up a coordinate and provides ways of manipulation
- */ 
-class Coordinate
+ *
+ * The values are of type T, float or double. Coordinate holds floats, for
+ * bulk points like laser scans and maps, PreciseCoordinate holds doubles, for
+ * poses in the world frame that have to stay exact far from the origin. Each
+ * converts to the other where one is given for the other.
+ */
+template< typename T >
+class BasicCoordinate
 {
  public:
 	/**
 	 * Default constructor, initializes values to 0
 	 */
-	Coordinate();
+	BasicCoordinate();
 
 	/**
 	 * Contructs Coordinate
@@ -25,21 +31,29 @@ class Coordinate
 	 * @param	x	X value of the coordinate
 	 * @param	y	Y value of the coordinate
 	 */
-	Coordinate(float x, float y);
+	BasicCoordinate(T x, T y);
+
+	/**
+	 * Converts a coordinate of the other precision
+	 *
+	 * @param	other	The coordinate
+	 */
+	template< typename U >
+	BasicCoordinate( BasicCoordinate< U > other );
 
 	/**
 	 * Gets the value of z
 	 *
 	 * @return	The value of z
 	 */
-	float x();
+	T x();
 
 	/**
 	 * Gets the value of y
 	 *
 	 * @return	The value of y
 	 */
-	float y();
+	T y();
 
 	/**
 	 * Calculates a vector to the given target
@@ -48,17 +62,24 @@ class Coordinate
 	 *
 	 * @return	Vector pointing to target
 	 */
-	Vector getVector( Coordinate target ); 
+	BasicVector< T > getVector( BasicCoordinate target );
 
 	/**
 	 * Overload of the << stream operator for a Coordinate object, allows direct use of a Coordinate object in a stream out situation
 	 */
-	friend std::ostream & operator << ( std::ostream & output, const Coordinate & c );
+	template< typename U >
+	friend std::ostream & operator << ( std::ostream & output, const BasicCoordinate< U > & c );
 
  private:
-	float
+	T
 		_x,
 		_y;
 };
 
+template< typename T >
+std::ostream & operator << ( std::ostream & output, const BasicCoordinate< T > & c );
+
+typedef BasicCoordinate< float > Coordinate;
+typedef BasicCoordinate< double > PreciseCoordinate;
+
 #endif
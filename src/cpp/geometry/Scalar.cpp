@@ -3,31 +3,50 @@
 #include <math.h>
 
 
-Scalar::Scalar()
+template< typename T >
+BasicScalar< T >::BasicScalar()
 {
 	this->setMagnitude( 0.0 );
 }
 
-Scalar::Scalar( float magnitude  )
+template< typename T >
+BasicScalar< T >::BasicScalar( T magnitude  )
 {
 	this->setMagnitude( magnitude );
 }
 
+template< typename T >
+template< typename U >
+BasicScalar< T >::BasicScalar( BasicScalar< U > other )
+{
+	this->_magnitude = other.magnitude();
+}
+
+template< typename T >
 void
-Scalar::setMagnitude( float magnitude )
+BasicScalar< T >::setMagnitude( T magnitude )
 {
 	this->_magnitude = fabs( magnitude );
 }
 
-float
-Scalar::magnitude()
+template< typename T >
+T
+BasicScalar< T >::magnitude()
 {
 	return this->_magnitude;
 }
 
 // Overloaded out stream operator
-std::ostream & operator << ( std::ostream & output, const Scalar & s )
+template< typename T >
+std::ostream & operator << ( std::ostream & output, const BasicScalar< T > & s )
 {
 	output << s._magnitude; 
 	return output;
 }
+
+template class BasicScalar< float >;
+template class BasicScalar< double >;
+template BasicScalar< float >::BasicScalar( BasicScalar< double > other );
+template BasicScalar< double >::BasicScalar( BasicScalar< float > other );
+template std::ostream & operator << ( std::ostream & output, const BasicScalar< float > & s );
+template std::ostream & operator << ( std::ostream & output, const BasicScalar< double > & s );
@@ -8,44 +8,62 @@
  * Represents a geometric scalar
  *
  * Holds the values of a scalar and provides ways of manipulation
+ *
+ * Scalar holds a float, PreciseScalar a double, see BasicCoordinate
  */ 
-class Scalar 
+template< typename T >
+class BasicScalar
 {
  public:
 	/**
 	 * Default Constructor, initializes values to 0
 	 */
-	Scalar();
+	BasicScalar();
 
 	/**
 	 * Contructs Scalar
 	 *
 	 * @param	magnitude	The desired magnitude of the Scalar
 	 */
-	Scalar( float magnitude );
+	BasicScalar( T magnitude );
+
+	/**
+	 * Converts a scalar of the other precision
+	 *
+	 * @param	other	The scalar
+	 */
+	template< typename U >
+	BasicScalar( BasicScalar< U > other );
 	
 	/**
 	 * Gets magnitude
 	 *
 	 * @return	The magnitude value
 	 */
-	float magnitude();
+	T magnitude();
 
 	/**
 	 * Sets magnitude
 	 * 
 	 * @param	magnitude
 	 */
-	void setMagnitude( float magnitude );
+	void setMagnitude( T magnitude );
 
 	/**
 	 * Overload of the << stream operator for a Scalar object, allows direct use of a Scalar object in a stream out situation
 	 */
-	friend std::ostream & operator << ( std::ostream & output, const Scalar & s );
+	template< typename U >
+	friend std::ostream & operator << ( std::ostream & output, const BasicScalar< U > & s );
 
  private:
-	float
+	T
 		_magnitude;
 };
 
+template< typename T >
+std::ostream & operator << ( std::ostream & output, const BasicScalar< T > & s );
+
+typedef BasicScalar< float > Scalar;
+typedef BasicScalar< double > PreciseScalar;
+
 #endif
@@ -5,27 +5,45 @@
 #include <math.h>
 
 
-Vector::Vector()
-	: Angle::Angle(),
-	Scalar::Scalar()
+template< typename T >
+BasicVector< T >::BasicVector()
+	: BasicAngle< T >::BasicAngle(),
+	BasicScalar< T >::BasicScalar()
 {}
 
-Vector::Vector( float magnitude, float phi, bool degrees ) 
-	: Angle::Angle( phi, degrees ),
-	Scalar::Scalar( magnitude )
+template< typename T >
+BasicVector< T >::BasicVector( T magnitude, T phi, bool degrees ) 
+	: BasicAngle< T >::BasicAngle( phi, degrees ),
+	BasicScalar< T >::BasicScalar( magnitude )
 {} 
 
-Coordinate
-Vector::cartesian()
+template< typename T >
+template< typename U >
+BasicVector< T >::BasicVector( BasicVector< U > other )
+	: BasicAngle< T >::BasicAngle( other.phi() ),
+	BasicScalar< T >::BasicScalar( other.magnitude() )
+{}
+
+template< typename T >
+BasicCoordinate< T >
+BasicVector< T >::cartesian()
 {
-	return Coordinate(
-			(float) this->magnitude() * cos( this->phi() ),
-			(float) this->magnitude() * sin( this->phi() ) );
+	return BasicCoordinate< T >(
+			this->magnitude() * cos( this->phi() ),
+			this->magnitude() * sin( this->phi() ) );
 }
 
 // Overloaded out stream operator
-std::ostream & operator << ( std::ostream & output, const Vector & v )
+template< typename T >
+std::ostream & operator << ( std::ostream & output, const BasicVector< T > & v )
 {
-	output << (Scalar) v << " " << (Angle) v; 
+	output << (BasicScalar< T >) v << " " << (BasicAngle< T >) v; 
 	return output;
 }
+
+template class BasicVector< float >;
+template class BasicVector< double >;
+template BasicVector< float >::BasicVector( BasicVector< double > other );
+template BasicVector< double >::BasicVector( BasicVector< float > other );
+template std::ostream & operator << ( std::ostream & output, const BasicVector< float > & v );
+template std::ostream & operator << ( std::ostream & output, const BasicVector< double > & v );
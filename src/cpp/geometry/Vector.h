@@ -10,14 +10,17 @@
  * Represents a geometric vector
  *
  * Combines and Angle and a Scalar to create a Vector
+ *
+ * Vector holds floats, PreciseVector doubles, see BasicCoordinate
  */ 
-class Vector : public Angle, public Scalar
+template< typename T >
+class BasicVector : public BasicAngle< T >, public BasicScalar< T >
 {
  public: 
 	/**
 	 * Default Constructor, initializes values to 0
 	 */
-	Vector();
+	BasicVector();
 
 	/**
 	 * Contructs vector
@@ -26,19 +29,34 @@ class Vector : public Angle, public Scalar
 	 * @param	phi Angle, is normalized to [-pi, pi]
 	 * @param	degrees	If true, input is interpreted as degrees. Standard is radians.
 	 */
-	Vector( float magnitude, float phi, bool degrees = false );
+	BasicVector( T magnitude, T phi, bool degrees = false );
+
+	/**
+	 * Converts a vector of the other precision
+	 *
+	 * @param	other	The vector
+	 */
+	template< typename U >
+	BasicVector( BasicVector< U > other );
 
 	/**
 	 * Calculates the cartesian values of the vector
 	 *
 	 * @return	Cartesian values stored as a Coordinate
 	 */
-	Coordinate cartesian();
+	BasicCoordinate< T > cartesian();
 
 	/**
 	 * Overload of the << stream operator for a Vector  object, allows direct use of a Vector object in a stream out situation
 	 */
-	friend std::ostream & operator << ( std::ostream & output, const Vector & v );
+	template< typename U >
+	friend std::ostream & operator << ( std::ostream & output, const BasicVector< U > & v );
 };
 
+template< typename T >
+std::ostream & operator << ( std::ostream & output, const BasicVector< T > & v );
+
+typedef BasicVector< float > Vector;
+typedef BasicVector< double > PreciseVector;
+
 #endif
@@ -3,27 +3,46 @@
 #include "Coordinate.h"
 
 
-VolumeCoordinate::VolumeCoordinate()
-	:Coordinate::Coordinate()
+template< typename T >
+BasicVolumeCoordinate< T >::BasicVolumeCoordinate()
+	:BasicCoordinate< T >::BasicCoordinate()
 {
 	this->_z = 0;
 }
 
-VolumeCoordinate::VolumeCoordinate( float x, float y, float z )
-	:Coordinate::Coordinate( x, y )
+template< typename T >
+BasicVolumeCoordinate< T >::BasicVolumeCoordinate( T x, T y, T z )
+	:BasicCoordinate< T >::BasicCoordinate( x, y )
 {
 	this->_z = z;
 }
 
-float
-VolumeCoordinate::z()
+template< typename T >
+template< typename U >
+BasicVolumeCoordinate< T >::BasicVolumeCoordinate( BasicVolumeCoordinate< U > other )
+	:BasicCoordinate< T >::BasicCoordinate( other.x(), other.y() )
+{
+	this->_z = other.z();
+}
+
+template< typename T >
+T
+BasicVolumeCoordinate< T >::z()
 {
 	return this->_z;
 }
 
 /// Overloaded out stream operator
-std::ostream & operator << ( std::ostream & output, const VolumeCoordinate & vc )
+template< typename T >
+std::ostream & operator << ( std::ostream & output, const BasicVolumeCoordinate< T > & vc )
 {
-	output << (Coordinate) vc << "," << vc._z;
+	output << (BasicCoordinate< T >) vc << "," << vc._z;
 	return output;
 }
+
+template class BasicVolumeCoordinate< float >;
+template class BasicVolumeCoordinate< double >;
+template BasicVolumeCoordinate< float >::BasicVolumeCoordinate( BasicVolumeCoordinate< double > other );
+template BasicVolumeCoordinate< double >::BasicVolumeCoordinate( BasicVolumeCoordinate< float > other );
+template std::ostream & operator << ( std::ostream & output, const BasicVolumeCoordinate< float > & vc );
+template std::ostream & operator << ( std::ostream & output, const BasicVolumeCoordinate< double > & vc );
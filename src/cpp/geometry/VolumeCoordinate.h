@@ -10,14 +10,18 @@
  * Represents a three-dimentional coordinate
  *
  * Adds another value to a Coordinate to make up a 3d-coordinate and provides ways of manipulation
+ *
+ * VolumeCoordinate holds floats, PreciseVolumeCoordinate doubles, see
+ * BasicCoordinate
  */ 
-class VolumeCoordinate : public Coordinate
+template< typename T >
+class BasicVolumeCoordinate : public BasicCoordinate< T >
 {
  public:
 	/**
 	 * Default Constructor, initializes values to 0
 	 */
-	VolumeCoordinate();
+	BasicVolumeCoordinate();
 
 	/**
 	 * Contructs VolumeCoordinate
@@ -26,23 +30,38 @@ class VolumeCoordinate : public Coordinate
 	 * @param	y	Y value of the volumecoordinate
 	 * @param	z	Z value of the volumecoordinate
 	 */
-	VolumeCoordinate(float x, float y, float z);
+	BasicVolumeCoordinate(T x, T y, T z);
+
+	/**
+	 * Converts a volumecoordinate of the other precision
+	 *
+	 * @param	other	The volumecoordinate
+	 */
+	template< typename U >
+	BasicVolumeCoordinate( BasicVolumeCoordinate< U > other );
 
 	/**
 	 * Gets the value of phi
 	 *
 	 * @return	The angle value in phi
 	 */
-	float  z();
+	T  z();
 
 	/**
 	 * Overload of the << stream operator for a VolumeCoordinate object, allows direct use of a VolumeCoordinate object in a stream out situation
 	 */
-	friend std::ostream & operator << ( std::ostream & output, const VolumeCoordinate & vc );
+	template< typename U >
+	friend std::ostream & operator << ( std::ostream & output, const BasicVolumeCoordinate< U > & vc );
 
  private:
-	float
+	T
 		_z;
 };
 
+template< typename T >
+std::ostream & operator << ( std::ostream & output, const BasicVolumeCoordinate< T > & vc );
+
+typedef BasicVolumeCoordinate< float > VolumeCoordinate;
+typedef BasicVolumeCoordinate< double > PreciseVolumeCoordinate;
+
 #endif
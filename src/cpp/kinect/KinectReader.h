@@ -1,10 +1,11 @@
 #ifndef KINECTREADER_H
 #define KINECTREADER_H
 
+#include "../geometry/VolumeCoordinate.h"
+
 #include <string>
 
 class TcpSocket;
-class VolumeCoordinate;
 
 namespace rec {
 	namespace robotino {
@@ -0,0 +1,157 @@
+#include "AStarPlanner.h"
+
+#include "../obstacle/OccupancyGrid.h"
+#include "../obstacle/InflationLayer.h"
+#include "../obstacle/kart.h"
+
+#include <float.h>
+#include <algorithm>
+
+
+AStarPlanner::AStarPlanner( InflationLayer * pCosts )
+	: GridPlanner::GridPlanner( pCosts )
+{
+	this->width = 0;
+	this->generation = 0;
+	this->searchGoal = -1;
+}
+
+bool
+AStarPlanner::plan( int startX, int startY, int goalX, int goalY )
+{
+	static const int dx[] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+	static const int dy[] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+	this->pCosts->update();
+	OccupancyGrid * grid = this->pCosts->grid();
+
+	this->_path.clear();
+
+	if ( ! grid->contains( startX, startY ) || ! grid->contains( goalX, goalY ) || this->cellCost( goalX, goalY ) < 0.0 )
+	{
+		this->searching = false;
+		return false;
+	}
+
+	// (Re)size buffers only when the grid changes
+	int cells = grid->width() * grid->height();
+	if ( this->width != grid->width() || (int) this->g.size() != cells )
+	{
+		this->width = grid->width();
+		this->seen.assign( cells, 0 );
+		this->closed.assign( ( cells + 31 ) / 32, 0 );
+		this->g.assign( cells, 0.0 );
+		this->parent.assign( cells, -1 );
+		this->open.resize( cells );
+		this->generation = 0;
+		this->searching = false;
+	}
+
+	int goal = goalY * this->width + goalX;
+
+	// A search that ran out of budget goes on from the start it began at,
+	// Robotino may have moved since
+	bool resumed = this->searching && goal == this->searchGoal;
+	if ( ! resumed )
+	{
+		// A new generation makes all per-cell data stale without touching it
+		if ( ++this->generation == 0 )
+		{
+			std::fill( this->seen.begin(), this->seen.end(), 0 );
+			this->generation = 1;
+		}
+		std::fill( this->closed.begin(), this->closed.end(), 0 );
+		this->open.clear();
+		this->searchGoal = goal;
+		this->_expanded = 0;
+
+		int start = startY * this->width + startX;
+		this->touch( start );
+		this->g[ start ] = 0.0;
+		this->open.update( start, this->octile( startX, startY, goalX, goalY ) );
+	}
+	this->searching = false;
+
+	unsigned int expansions = 0;
+	while ( ! this->open.empty() )
+	{
+		if ( this->budget > 0 && expansions == this->budget )
+		{
+			this->searching = true;
+			return false;
+		}
+
+		int current = this->open.pop();
+
+		if ( current == goal )
+		{
+			for ( int cell = goal; cell != -1; cell = this->parent[ cell ] )
+				this->_path.push_back( cell );
+			std::reverse( this->_path.begin(), this->_path.end() );
+
+			// The costs may have changed between the calls, start over if
+			// a cell closed before has become impassable since
+			if ( resumed )
+				for ( unsigned int i = 0; i < this->_path.size(); i++ )
+					if ( this->cellCost( this->_path[ i ] % this->width, this->_path[ i ] / this->width ) < 0.0 )
+					{
+						this->_path.clear();
+						this->searchGoal = -1;
+						this->searching = true;
+						return false;
+					}
+
+			return true;
+		}
+
+		this->closed[ current / 32 ] |= 1u << ( current % 32 );
+		this->_expanded++;
+		expansions++;
+
+		int cx = current % this->width;
+		int cy = current / this->width;
+
+		for ( int i = 0; i < 8; i++ )
+		{
+			int nx = cx + dx[ i ];
+			int ny = cy + dy[ i ];
+			if ( ! grid->contains( nx, ny ) ) continue;
+
+			int next = ny * this->width + nx;
+			if ( this->closed[ next / 32 ] & ( 1u << ( next % 32 ) ) ) continue;
+
+			float cost = this->cellCost( nx, ny );
+			if ( cost < 0.0 ) continue;
+
+			// No cutting corners of impassable cells
+			bool diagonal = ( i >= 4 );
+			if ( diagonal && ( this->cellCost( nx, cy ) < 0.0 || this->cellCost( cx, ny ) < 0.0 ) ) continue;
+
+			float tentative = this->g[ current ] + ( diagonal ? SQRT2 : 1.0 ) * cost;
+
+			this->touch( next );
+			if ( tentative >= this->g[ next ] ) continue;
+
+			this->g[ next ] = tentative;
+			this->parent[ next ] = current;
+
+			// Inserts, or decreases the key if already open
+			this->open.update( next, tentative + this->octile( nx, ny, goalX, goalY ) );
+		}
+	}
+
+	return false;
+}
+
+
+// Private functions
+
+void
+AStarPlanner::touch( int index )
+{
+	if ( this->seen[ index ] == this->generation ) return;
+
+	this->seen[ index ] = this->generation;
+	this->g[ index ] = FLT_MAX;
+	this->parent[ index ] = -1;
+}
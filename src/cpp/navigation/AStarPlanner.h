@@ -0,0 +1,78 @@
+/**
+ * @file	AStarPlanner.h
+ * @brief	Header file for the AStarPlanner class
+ */
+#ifndef ASTARPLANNER_H
+#define ASTARPLANNER_H
+
+#include "GridPlanner.h"
+#include "IndexedHeap.h"
+
+#include <vector>
+
+class InflationLayer;
+
+
+/**
+ * 8-connected A* search over the inflated cost grid
+ *
+ * The open list is an IndexedHeap, giving decrease-key through its index
+ * map. The closed set is a bitset. All buffers are kept between calls and
+ * per-cell data is invalidated by a generation counter instead of being
+ * cleared, so repeated planning on the same grid does not allocate.
+ *
+ * With a budget, a search is spread over several calls. It keeps the start
+ * it began at, and the costs may change in between: a path crossing a cell
+ * that has become impassable since is thrown away and searched again.
+ *
+ * See GridPlanner for the cost model.
+ */
+class AStarPlanner : public GridPlanner
+{
+ public:
+	/**
+	 * Constructs the planner
+	 *
+	 * @param	pCosts	Pointer to the inflated costs to plan on
+	 */
+	AStarPlanner( InflationLayer * pCosts );
+
+	bool plan( int startX, int startY, int goalX, int goalY );
+
+ private:
+	int
+	/// Width of the grid the buffers are sized for
+		width,
+	/// Goal cell of the search in the buffers, -1 if none
+		searchGoal;
+
+	unsigned int
+	/// Current search generation, see @c seen
+		generation;
+
+	std::vector< unsigned int >
+	/// Generation in which each cell was last touched, data of cells from
+	/// older generations is stale
+		seen,
+	/// Closed set, one bit per cell
+		closed;
+
+	std::vector< float >
+	/// Cost from start
+		g;
+
+	std::vector< int >
+	/// Predecessor on the cheapest known path
+		parent;
+
+	IndexedHeap
+	/// Open list, keyed on g plus heuristic
+		open;
+
+	/**
+	 * Initializes the data of a cell if it was not touched in this search
+	 */
+	void touch( int index );
+};
+
+#endif
@@ -0,0 +1,362 @@
+#include "DStarLitePlanner.h"
+
+#include "../obstacle/OccupancyGrid.h"
+#include "../obstacle/InflationLayer.h"
+#include "../obstacle/kart.h"
+
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+
+
+/// Offsets to the eight neighbours of a cell
+static const int DSTARLITE_DX[] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+static const int DSTARLITE_DY[] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+
+DStarLitePlanner::DStarLitePlanner( InflationLayer * pCosts )
+	: GridPlanner::GridPlanner( pCosts )
+{
+	this->width = 0;
+	this->height = 0;
+	this->goal = -1;
+	this->lastStart = -1;
+	this->km = 0.0;
+	this->generation = 0;
+
+	this->pCosts->grid()->addListener( this );
+}
+
+DStarLitePlanner::~DStarLitePlanner()
+{
+	this->pCosts->grid()->removeListener( this );
+}
+
+bool
+DStarLitePlanner::plan( int startX, int startY, int goalX, int goalY )
+{
+	// Brings the costs up to date, reporting changed cells to cellChanged()
+	this->pCosts->update();
+	OccupancyGrid * grid = this->pCosts->grid();
+
+	this->_path.clear();
+
+	if ( ! grid->contains( startX, startY ) || ! grid->contains( goalX, goalY ) )
+	{
+		this->searching = false;
+		return false;
+	}
+
+	// (Re)size buffers only when the grid changes
+	if ( this->width != grid->width() || this->height != grid->height() )
+	{
+		this->width = grid->width();
+		this->height = grid->height();
+		int cells = this->width * this->height;
+		this->seen.assign( cells, 0 );
+		this->g.assign( cells, 0.0 );
+		this->rhs.assign( cells, 0.0 );
+		this->changedFlag.assign( cells, 0 );
+		this->changed.clear();
+		this->open.resize( cells );
+		this->generation = 0;
+		this->goal = -1;
+	}
+
+	int start = startY * this->width + startX;
+	int goal = goalY * this->width + goalX;
+
+	// Count on over the calls a search ran out of budget in
+	if ( goal != this->goal || ! this->searching ) this->_expanded = 0;
+	this->searching = false;
+
+	if ( goal != this->goal )
+	{
+		// New goal, forget everything by starting a new generation
+		if ( ++this->generation == 0 )
+		{
+			std::fill( this->seen.begin(), this->seen.end(), 0 );
+			this->generation = 1;
+		}
+		this->open.clear();
+		this->goal = goal;
+		this->lastStart = start;
+		this->km = 0.0;
+
+		this->touch( goal );
+		this->rhs[ goal ] = 0.0;
+		this->open.update( goal, this->octile( startX, startY, goalX, goalY ), 0.0 );
+	}
+	else
+	{
+		// The start has moved, keys already in the open list are now too
+		// low by at most the distance moved
+		if ( start != this->lastStart )
+		{
+			this->km += this->octile( this->lastStart % this->width, this->lastStart / this->width, startX, startY );
+			this->lastStart = start;
+		}
+
+		// A changed cell changes the cost of every step into it, and of the
+		// diagonal steps past it, all of which start at it or a neighbour
+		for ( unsigned int i = 0; i < this->changed.size(); i++ )
+		{
+			int cx = this->changed[ i ] % this->width;
+			int cy = this->changed[ i ] / this->width;
+			this->changedFlag[ this->changed[ i ] ] = 0;
+
+			for ( int j = -1; j < 8; j++ )
+			{
+				int nx = cx + ( ( j < 0 ) ? 0 : DSTARLITE_DX[ j ] );
+				int ny = cy + ( ( j < 0 ) ? 0 : DSTARLITE_DY[ j ] );
+				if ( ! grid->contains( nx, ny ) ) continue;
+
+				int cell = ny * this->width + nx;
+				this->touch( cell );
+				if ( cell != this->goal )
+					this->rhs[ cell ] = this->lookahead( cell );
+				this->updateCell( cell, start );
+			}
+		}
+	}
+	this->changed.clear();
+
+	if ( this->cellCost( goalX, goalY ) < 0.0 ) return false;
+
+	this->touch( start );
+
+	// Out of budget, the open list keeps the rest for the next call, which
+	// repairs changed cells and a moved start like any other
+	if ( ! this->computeShortestPath( start ) )
+	{
+		this->searching = true;
+		return false;
+	}
+
+	// The search may stop with the start itself still queued, rhs is what
+	// tells if it can reach the goal
+	if ( this->rhs[ start ] == FLT_MAX ) return false;
+
+	// Follow the cheapest successors from start to goal
+	int current = start;
+	this->_path.push_back( current );
+	while ( current != this->goal )
+	{
+		int best = -1;
+		float bestCost = FLT_MAX;
+		int cx = current % this->width;
+		int cy = current / this->width;
+
+		for ( int i = 0; i < 8; i++ )
+		{
+			int nx = cx + DSTARLITE_DX[ i ];
+			int ny = cy + DSTARLITE_DY[ i ];
+			if ( ! grid->contains( nx, ny ) ) continue;
+
+			int next = ny * this->width + nx;
+			float cost = this->stepCost( current, next );
+			this->touch( next );
+			if ( cost < 0.0 || this->g[ next ] == FLT_MAX ) continue;
+
+			if ( cost + this->g[ next ] < bestCost )
+			{
+				bestCost = cost + this->g[ next ];
+				best = next;
+			}
+		}
+
+		if ( best < 0 || this->_path.size() > this->g.size() )
+		{
+			this->_path.clear();
+			return false;
+		}
+
+		current = best;
+		this->_path.push_back( current );
+	}
+
+	return true;
+}
+
+void
+DStarLitePlanner::cellChanged( int x, int y, unsigned char oldValue, unsigned char newValue )
+{
+	// Nothing to repair before the first search
+	if ( this->goal < 0 ) return;
+
+	int index = y * this->width + x;
+	if ( this->changedFlag[ index ] ) return;
+
+	this->changedFlag[ index ] = 1;
+	this->changed.push_back( index );
+}
+
+
+// Private functions
+
+void
+DStarLitePlanner::touch( int index )
+{
+	if ( this->seen[ index ] == this->generation ) return;
+
+	this->seen[ index ] = this->generation;
+	this->g[ index ] = FLT_MAX;
+	this->rhs[ index ] = FLT_MAX;
+}
+
+float
+DStarLitePlanner::stepCost( int from, int to )
+{
+	int fx = from % this->width, fy = from / this->width;
+	int tx = to % this->width, ty = to / this->width;
+
+	float cost = this->cellCost( tx, ty );
+	if ( cost < 0.0 ) return -1.0;
+
+	if ( fx != tx && fy != ty )
+	{
+		// No cutting corners of impassable cells
+		if ( this->cellCost( tx, fy ) < 0.0 || this->cellCost( fx, ty ) < 0.0 ) return -1.0;
+		return SQRT2 * cost;
+	}
+
+	return cost;
+}
+
+float
+DStarLitePlanner::lookahead( int index )
+{
+	float best = FLT_MAX;
+	int cx = index % this->width;
+	int cy = index / this->width;
+
+	for ( int i = 0; i < 8; i++ )
+	{
+		int nx = cx + DSTARLITE_DX[ i ];
+		int ny = cy + DSTARLITE_DY[ i ];
+		if ( nx < 0 || ny < 0 || nx >= this->width || ny >= this->height ) continue;
+
+		int next = ny * this->width + nx;
+		float cost = this->stepCost( index, next );
+		this->touch( next );
+		if ( cost < 0.0 || this->g[ next ] == FLT_MAX ) continue;
+
+		best = std::min( best, cost + this->g[ next ] );
+	}
+
+	return best;
+}
+
+void
+DStarLitePlanner::updateCell( int index, int start )
+{
+	if ( this->g[ index ] != this->rhs[ index ] )
+	{
+		float k1, k2;
+		this->calculateKey( index, start, & k1, & k2 );
+		this->open.update( index, k1, k2 );
+	}
+	else
+		this->open.remove( index );
+}
+
+bool
+DStarLitePlanner::computeShortestPath( int start )
+{
+	unsigned int expansions = 0;
+	while ( ! this->open.empty() )
+	{
+		float startK1, startK2;
+		this->calculateKey( start, start, & startK1, & startK2 );
+
+		// Keys equal but for rounding go on as well, the second key would
+		// not order them, and stopping could leave stale g values on the path
+		float topK1 = this->open.topK1();
+		float topK2 = this->open.topK2();
+		bool topIsLower = topK1 <= startK1 + fabs( startK1 ) * DSTARLITE_KEY_TOLERANCE;
+		if ( ! topIsLower && this->rhs[ start ] <= this->g[ start ] ) break;
+		if ( this->budget > 0 && expansions == this->budget ) return false;
+
+		int current = this->open.top();
+		float newK1, newK2;
+		this->calculateKey( current, start, & newK1, & newK2 );
+
+		// Key outdated by a moved start, requeue
+		if ( topK1 < newK1 || ( topK1 == newK1 && topK2 < newK2 ) )
+		{
+			this->open.update( current, newK1, newK2 );
+			continue;
+		}
+
+		this->_expanded++;
+		expansions++;
+		int cx = current % this->width;
+		int cy = current / this->width;
+
+		if ( this->g[ current ] > this->rhs[ current ] )
+		{
+			// Overconsistent, the cost-to-goal went down
+			this->g[ current ] = this->rhs[ current ];
+			this->open.remove( current );
+
+			for ( int i = 0; i < 8; i++ )
+			{
+				int nx = cx + DSTARLITE_DX[ i ];
+				int ny = cy + DSTARLITE_DY[ i ];
+				if ( nx < 0 || ny < 0 || nx >= this->width || ny >= this->height ) continue;
+
+				int previous = ny * this->width + nx;
+				this->touch( previous );
+				if ( previous == this->goal ) continue;
+
+				float cost = this->stepCost( previous, current );
+				if ( cost >= 0.0 && cost + this->g[ current ] < this->rhs[ previous ] )
+				{
+					this->rhs[ previous ] = cost + this->g[ current ];
+					this->updateCell( previous, start );
+				}
+			}
+		}
+		else
+		{
+			// Underconsistent, the cost-to-goal went up
+			float oldG = this->g[ current ];
+			this->g[ current ] = FLT_MAX;
+
+			for ( int i = -1; i < 8; i++ )
+			{
+				int nx = cx + ( ( i < 0 ) ? 0 : DSTARLITE_DX[ i ] );
+				int ny = cy + ( ( i < 0 ) ? 0 : DSTARLITE_DY[ i ] );
+				if ( nx < 0 || ny < 0 || nx >= this->width || ny >= this->height ) continue;
+
+				int previous = ny * this->width + nx;
+				this->touch( previous );
+
+				// Only cells that depended on the old value need a new rhs
+				if ( previous != this->goal )
+				{
+					float cost = ( previous == current ) ? 0.0 : this->stepCost( previous, current );
+					if ( previous == current || ( cost >= 0.0 && oldG != FLT_MAX && this->rhs[ previous ] == cost + oldG ) )
+						this->rhs[ previous ] = this->lookahead( previous );
+				}
+				this->updateCell( previous, start );
+			}
+		}
+	}
+
+	return true;
+}
+
+void
+DStarLitePlanner::calculateKey( int index, int start, float * k1, float * k2 )
+{
+	float minimum = std::min( this->g[ index ], this->rhs[ index ] );
+	* k2 = minimum;
+
+	if ( minimum == FLT_MAX )
+		* k1 = FLT_MAX;
+	else
+		* k1 = minimum + this->km + this->octile(
+				start % this->width, start / this->width,
+				index % this->width, index / this->width );
+}
@@ -0,0 +1,142 @@
+/**
+ * @file	DStarLitePlanner.h
+ * @brief	Header file for the DStarLitePlanner class
+ */
+#ifndef DSTARLITEPLANNER_H
+#define DSTARLITEPLANNER_H
+
+#include "GridPlanner.h"
+#include "IndexedHeap.h"
+
+#include "../obstacle/OccupancyGrid.h"
+
+#include <vector>
+
+class InflationLayer;
+
+
+/// Relative difference below which the first keys of the search count as
+/// equal. They are sums of floats reached in different orders, so equal
+/// keys come out a few ulps apart.
+#define DSTARLITE_KEY_TOLERANCE	1e-5
+
+
+/**
+ * Incremental 8-connected search with D* Lite
+ *
+ * The search runs backwards from the goal, keeping g and rhs values for
+ * every cell it has touched. As long as the goal stays the same, a new
+ * plan() reuses them: the start may move, and cells changed in the cost
+ * grid since the last call only have their own and their neighbours' rhs
+ * values recomputed. The repair then only expands cells whose cost-to-goal
+ * actually changed, instead of searching from scratch.
+ *
+ * The planner listens to the cost grid of the InflationLayer to learn which
+ * cells changed. A new goal, or a grid of a different size, starts over.
+ * What a repair costs depends on how far the change reaches: an obstacle
+ * across the path can raise the cost-to-goal of most cells behind it.
+ *
+ * With a budget, a search left unfinished is simply carried on by the next
+ * call, after the changes and the moved start have been taken in.
+ *
+ * See GridPlanner for the cost model.
+ */
+class DStarLitePlanner : public GridPlanner, public GridListener
+{
+ public:
+	/**
+	 * Constructs the planner and registers as a listener on the cost grid
+	 *
+	 * @param	pCosts	Pointer to the inflated costs to plan on
+	 */
+	DStarLitePlanner( InflationLayer * pCosts );
+
+	/**
+	 * Destructor, unregisters from the cost grid
+	 */
+	~DStarLitePlanner();
+
+	bool plan( int startX, int startY, int goalX, int goalY );
+
+	/**
+	 * Records a changed cost cell, see GridListener
+	 */
+	void cellChanged( int x, int y, unsigned char oldValue, unsigned char newValue );
+
+ private:
+	int
+	/// Width of the grid the buffers are sized for
+		width,
+	/// Height of the grid the buffers are sized for
+		height,
+	/// Goal cell of the current search, -1 if none
+		goal,
+	/// Start cell at the time @c km was last updated
+		lastStart;
+
+	float
+	/// Key modifier, accumulated heuristic distance the start has moved
+		km;
+
+	unsigned int
+	/// Current search generation, see @c seen
+		generation;
+
+	std::vector< unsigned int >
+	/// Generation in which each cell was last touched
+		seen;
+
+	std::vector< float >
+	/// Cost-to-goal of the last expansion
+		g,
+	/// One step lookahead cost-to-goal
+		rhs;
+
+	std::vector< int >
+	/// Cells changed since the last plan()
+		changed;
+
+	std::vector< unsigned char >
+	/// Flags for cells in @c changed, to avoid duplicates
+		changedFlag;
+
+	IndexedHeap
+	/// Cells whose g and rhs disagree
+		open;
+
+	/**
+	 * Initializes g and rhs of a cell if it was not touched in this search
+	 */
+	void touch( int index );
+
+	/**
+	 * Cost of stepping from one cell to an adjacent one
+	 *
+	 * @return	Step cost, or a negative value if the step is not possible
+	 */
+	float stepCost( int from, int to );
+
+	/**
+	 * Recomputes rhs of a cell from its successors
+	 */
+	float lookahead( int index );
+
+	/**
+	 * Puts a cell in, or takes it out of, the open list as needed
+	 */
+	void updateCell( int index, int start );
+
+	/**
+	 * Expands cells until the start is consistent, or the budget is used up
+	 *
+	 * @return	Boolean indicating if the start is consistent
+	 */
+	bool computeShortestPath( int start );
+
+	/**
+	 * Sets the two part key of a cell
+	 */
+	void calculateKey( int index, int start, float * k1, float * k2 );
+};
+
+#endif
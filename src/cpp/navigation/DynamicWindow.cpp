@@ -0,0 +1,432 @@
+#include "DynamicWindow.h"
+
+#include "../robotino/headers/Brain.h"
+#include "../robotino/headers/_Odometry.h"
+#include "../robotino/headers/_OmniDrive.h"
+#include "../robotino/headers/_LaserRangeFinder.h"
+#include "../robotino/headers/_DistanceSensors.h"
+
+#include "../geometry/Angle.h"
+#include "../geometry/AngularCoordinate.h"
+#include "../geometry/Vector.h"
+
+#include <float.h>
+#include <iostream>
+#include <algorithm>
+
+#ifndef _USE_MATH_DEFINES
+#define _USE_MATH_DEFINES
+#endif
+#include <math.h>
+
+
+/// Distance field value of cells not yet reached by the transform
+static const float DWA_FAR = 1.0e6;
+/// Columns and rows of the distance field, including its border
+static const int DWA_FIELD_STRIDE = DWA_FIELD_SIZE + 2;
+/// Distance field value of the border, clear of everything
+static const float DWA_FIELD_CLEAR = DWA_CLEARANCE_MAX + DWA_ROBOT_RADIUS;
+
+
+DynamicWindow::DynamicWindow( Brain * pBrain )
+	: Axon::Axon( pBrain )
+{
+	this->active = false;
+	this->blocked = false;
+	this->lastX = 0.0;
+	this->lastY = 0.0;
+	this->lastOmega = 0.0;
+	this->_candidates = 0;
+
+	// The border keeps this value, analyze() only resets the inside
+	this->field.assign( DWA_FIELD_STRIDE * DWA_FIELD_STRIDE, DWA_FIELD_CLEAR );
+
+	// Room for every linear sample, so the cycle does not allocate
+	unsigned int samples = DWA_LINEAR_SAMPLES * DWA_LINEAR_SAMPLES;
+	this->sampleX.reserve( samples );
+	this->sampleY.reserve( samples );
+	this->pointX.resize( samples );
+	this->pointY.resize( samples );
+	this->sampleClearance.resize( samples );
+	this->sampleGoalDistance.resize( samples );
+	this->sampleCollision.resize( samples );
+	this->sampleCell.resize( samples );
+	this->sampleFractionX.resize( samples );
+	this->sampleFractionY.resize( samples );
+	this->sampleDistance.resize( samples );
+	this->sampleScore.resize( samples );
+}
+
+void
+DynamicWindow::setGoal( Coordinate goal )
+{
+	this->_goal = goal;
+	this->brain()->drive()->setDestination( goal );
+
+	if ( ! this->active )
+	{
+		this->lastX = 0.0;
+		this->lastY = 0.0;
+		this->lastOmega = 0.0;
+	}
+	this->active = true;
+	this->blocked = false;
+}
+
+Coordinate
+DynamicWindow::goal()
+{
+	return this->_goal;
+}
+
+bool
+DynamicWindow::isActive()
+{
+	return this->active;
+}
+
+void
+DynamicWindow::cancel()
+{
+	this->active = false;
+}
+
+float
+DynamicWindow::clearance( float x, float y )
+{
+	// Interpolated between the four nearest cell centers, so the clearance
+	// changes with every movement and not only when crossing a cell. Points
+	// off the field are clamped onto its border.
+	float fx = std::min( std::max( x / (float) DWA_FIELD_RESOLUTION + DWA_FIELD_SIZE / 2 + 1, 0.0f ), DWA_FIELD_STRIDE - 1.0f );
+	float fy = std::min( std::max( y / (float) DWA_FIELD_RESOLUTION + DWA_FIELD_SIZE / 2 + 1, 0.0f ), DWA_FIELD_STRIDE - 1.0f );
+	int cx = std::min( (int) fx, DWA_FIELD_STRIDE - 2 );
+	int cy = std::min( (int) fy, DWA_FIELD_STRIDE - 2 );
+
+	fx -= cx;
+	fy -= cy;
+	const float * d = & this->field[ cy * DWA_FIELD_STRIDE + cx ];
+	float distance = ( 1.0f - fy ) * ( ( 1.0f - fx ) * d[ 0 ] + fx * d[ 1 ] )
+		+ fy * ( ( 1.0f - fx ) * d[ DWA_FIELD_STRIDE ] + fx * d[ DWA_FIELD_STRIDE + 1 ] );
+
+	return std::min( (float) DWA_CLEARANCE_MAX, distance - (float) DWA_ROBOT_RADIUS );
+}
+
+unsigned int
+DynamicWindow::candidates()
+{
+	return this->_candidates;
+}
+
+void
+DynamicWindow::analyze()
+{
+	if ( ! this->active ) return;
+
+	for ( int y = 1; y <= DWA_FIELD_SIZE; y++ )
+		std::fill( & this->field[ y * DWA_FIELD_STRIDE + 1 ], & this->field[ y * DWA_FIELD_STRIDE + 1 + DWA_FIELD_SIZE ], DWA_FAR );
+
+	// Scan points relative to Robotino
+	if ( this->brain()->hasLRF() )
+	{
+		std::vector< Coordinate > points = this->brain()->lrf()->scanCoordinates( AngularCoordinate( 0.0, 0.0, 0.0 ) );
+		for ( unsigned int i = 0; i < points.size(); i++ )
+			this->addObstacle( points[ i ].x(), points[ i ].y() );
+	}
+
+	// The distance sensors measure from the edge of the footprint
+	for ( unsigned int i = 0; i < DISTANCESENSORS_COUNT; i++ )
+	{
+		float distance = this->brain()->dist()->sensorDistance( i );
+		if ( distance <= 0.0 || distance > DWA_DISTANCESENSOR_RANGE ) continue;
+
+		Coordinate point = Vector( DWA_ROBOT_RADIUS + distance, this->brain()->dist()->sensorAngle( i ).phi() ).cartesian();
+		this->addObstacle( point.x(), point.y() );
+	}
+
+	this->buildField();
+}
+
+void
+DynamicWindow::apply()
+{
+	if ( ! this->active ) return;
+
+	// Nothing is driven while stopped, start over from standstill
+	if ( this->brain()->drive()->stopIsSet() )
+	{
+		this->lastX = 0.0;
+		this->lastY = 0.0;
+		this->lastOmega = 0.0;
+		return;
+	}
+
+	PreciseAngularCoordinate position = this->brain()->odom()->getPosition();
+	PreciseVector goalVector = position.getVector( this->_goal );
+
+	// _OmniDrive holds the goal from here
+	if ( goalVector.magnitude() < DWA_GOAL_DISTANCE )
+	{
+		std::cout << "DynamicWindow: goal reached" << std::endl;
+		this->active = false;
+		return;
+	}
+
+	// Goal relative to Robotino
+	goalVector.setPhi( ( (PreciseAngle) position ).deltaAngle( goalVector ).phi() );
+	Coordinate goal = goalVector.cartesian();
+
+	float x, y, omega;
+	bool found = this->evaluate( goal.x(), goal.y(), & x, & y, & omega );
+
+	if ( found == this->blocked )
+	{
+		this->blocked = ! found;
+		std::cout << "DynamicWindow: " << ( this->blocked ? "no safe way ahead, braking" : "moving on" ) << std::endl;
+	}
+
+	this->brain()->drive()->setPlannedVelocity( x, y, omega );
+	this->lastX = x;
+	this->lastY = y;
+	this->lastOmega = omega;
+}
+
+
+// Private functions
+
+void
+DynamicWindow::addObstacle( float x, float y )
+{
+	int cx = (int) floor( x / DWA_FIELD_RESOLUTION + 0.5 ) + DWA_FIELD_SIZE / 2;
+	int cy = (int) floor( y / DWA_FIELD_RESOLUTION + 0.5 ) + DWA_FIELD_SIZE / 2;
+
+	if ( cx < 0 || cy < 0 || cx >= DWA_FIELD_SIZE || cy >= DWA_FIELD_SIZE ) return;
+
+	this->field[ ( cy + 1 ) * DWA_FIELD_STRIDE + cx + 1 ] = 0.0;
+}
+
+void
+DynamicWindow::buildField()
+{
+	// The inside of the field only, the border stays clear
+	const int size = DWA_FIELD_SIZE;
+	const int stride = DWA_FIELD_STRIDE;
+	const float straight = DWA_FIELD_RESOLUTION;
+	const float diagonal = DWA_FIELD_RESOLUTION * M_SQRT2;
+	float * d = this->field.data() + stride + 1;
+
+	// Forward pass, from the neighbours above and to the left
+	for ( int y = 0; y < size; y++ )
+	{
+		for ( int x = 0; x < size; x++ )
+		{
+			float & cell = d[ y * stride + x ];
+			if ( x > 0 ) cell = std::min( cell, d[ y * stride + x - 1 ] + straight );
+			if ( y > 0 )
+			{
+				cell = std::min( cell, d[ ( y - 1 ) * stride + x ] + straight );
+				if ( x > 0 ) cell = std::min( cell, d[ ( y - 1 ) * stride + x - 1 ] + diagonal );
+				if ( x + 1 < size ) cell = std::min( cell, d[ ( y - 1 ) * stride + x + 1 ] + diagonal );
+			}
+		}
+	}
+
+	// Backward pass, from the neighbours below and to the right
+	for ( int y = size - 1; y >= 0; y-- )
+	{
+		for ( int x = size - 1; x >= 0; x-- )
+		{
+			float & cell = d[ y * stride + x ];
+			if ( x + 1 < size ) cell = std::min( cell, d[ y * stride + x + 1 ] + straight );
+			if ( y + 1 < size )
+			{
+				cell = std::min( cell, d[ ( y + 1 ) * stride + x ] + straight );
+				if ( x + 1 < size ) cell = std::min( cell, d[ ( y + 1 ) * stride + x + 1 ] + diagonal );
+				if ( x > 0 ) cell = std::min( cell, d[ ( y + 1 ) * stride + x - 1 ] + diagonal );
+			}
+		}
+	}
+}
+
+bool
+DynamicWindow::evaluate( float goalX, float goalY, float * x, float * y, float * omega )
+{
+	const float dt = this->brain()->drive()->cycleTime();
+	const float linear = DWA_ACCELERATION * dt;
+	const float angular = DWA_ANGULAR_ACCELERATION * dt;
+
+	// Hardest possible brake, used if nothing is admissible
+	float lastSpeed = sqrt( this->lastX * this->lastX + this->lastY * this->lastY );
+	float brake = ( lastSpeed > linear ) ? 1.0 - linear / lastSpeed : 0.0;
+	* x = this->lastX * brake;
+	* y = this->lastY * brake;
+	* omega = this->lastOmega - std::max( - angular, std::min( angular, this->lastOmega ) );
+
+	// Linear samples in the window and below the speed limit. The window is
+	// round, as _OmniDrive limits the accelleration of x and y together.
+	this->sampleX.clear();
+	this->sampleY.clear();
+	for ( int i = 0; i < DWA_LINEAR_SAMPLES; i++ )
+	{
+		float vx = this->lastX - linear + ( 2.0 * linear * i ) / ( DWA_LINEAR_SAMPLES - 1 );
+		for ( int j = 0; j < DWA_LINEAR_SAMPLES; j++ )
+		{
+			float vy = this->lastY - linear + ( 2.0 * linear * j ) / ( DWA_LINEAR_SAMPLES - 1 );
+			if ( vx * vx + vy * vy > DWA_MAX_SPEED * DWA_MAX_SPEED ) continue;
+
+			float dx = vx - this->lastX, dy = vy - this->lastY;
+			if ( dx * dx + dy * dy > linear * linear * 1.0001 ) continue;
+
+			this->sampleX.push_back( vx );
+			this->sampleY.push_back( vy );
+		}
+	}
+
+	const unsigned int n = this->sampleX.size();
+	const float * sx = this->sampleX.data();
+	const float * sy = this->sampleY.data();
+	float * px = this->pointX.data();
+	float * py = this->pointY.data();
+	float * clearance = this->sampleClearance.data();
+	float * goalDistance = this->sampleGoalDistance.data();
+	float * collision = this->sampleCollision.data();
+	int * cell = this->sampleCell.data();
+	float * fractionX = this->sampleFractionX.data();
+	float * fractionY = this->sampleFractionY.data();
+	float * distance = this->sampleDistance.data();
+	float * score = this->sampleScore.data();
+	const float * field = this->field.data();
+
+	float startDistance = sqrt( goalX * goalX + goalY * goalY );
+
+	// Fastest speed from which Robotino can still stop at the goal
+	float goalSpeed = sqrt( 2.0 * DWA_BRAKING * startDistance );
+
+	// Already too close to something, only getting closer counts as a
+	// collision so Robotino can still back off or slide along
+	float limit = std::min( (float) - DWA_COLLISION_TOLERANCE, this->clearance( 0.0, 0.0 ) );
+	const float never = 2.0 * DWA_HORIZON;
+	const float step = DWA_HORIZON / DWA_STEPS;
+
+	// Trajectory point to distance field column or row
+	const float inverse = 1.0 / DWA_FIELD_RESOLUTION;
+	const float offset = DWA_FIELD_SIZE / 2 + 1;
+	const float last = DWA_FIELD_STRIDE - 1;
+
+	bool found = false;
+	float bestScore = 0.0;
+	this->_candidates = 0;
+
+	for ( int k = 0; k < DWA_ANGULAR_SAMPLES && n > 0; k++ )
+	{
+		float w = this->lastOmega - angular + ( 2.0 * angular * k ) / ( DWA_ANGULAR_SAMPLES - 1 );
+		if ( fabs( w ) > DWA_MAX_OMEGA ) continue;
+
+		std::fill( clearance, clearance + n, (float) DWA_CLEARANCE_MAX );
+		std::fill( goalDistance, goalDistance + n, startDistance * startDistance );
+		std::fill( collision, collision + n, never );
+
+		for ( int s = 1; s <= DWA_STEPS; s++ )
+		{
+			float t = ( DWA_HORIZON * s ) / DWA_STEPS;
+
+			// At constant speed Robotino is at ( vx a - vy b, vx b + vy a )
+			// after t seconds
+			float a, b;
+			if ( fabs( w ) < 1.0e-4 )
+			{
+				a = t;
+				b = 0.5 * w * t * t;
+			}
+			else
+			{
+				a = sin( w * t ) / w;
+				b = ( 1.0 - cos( w * t ) ) / w;
+			}
+
+			for ( unsigned int i = 0; i < n; i++ )
+			{
+				px[ i ] = sx[ i ] * a - sy[ i ] * b;
+				py[ i ] = sx[ i ] * b + sy[ i ] * a;
+			}
+
+			// Squared, the root is taken once per sample when scoring
+			for ( unsigned int i = 0; i < n; i++ )
+			{
+				float dx = goalX - px[ i ];
+				float dy = goalY - py[ i ];
+				float least = goalDistance[ i ];
+				goalDistance[ i ] = std::min( least, dx * dx + dy * dy );
+			}
+
+			// Field cells and weights as in clearance(), clamped onto the
+			// border so there is no branch and this runs as SIMD
+			for ( unsigned int i = 0; i < n; i++ )
+			{
+				float fx = std::min( std::max( px[ i ] * inverse + offset, 0.0f ), last );
+				float fy = std::min( std::max( py[ i ] * inverse + offset, 0.0f ), last );
+				int cx = std::min( (int) fx, DWA_FIELD_STRIDE - 2 );
+				int cy = std::min( (int) fy, DWA_FIELD_STRIDE - 2 );
+				fractionX[ i ] = fx - cx;
+				fractionY[ i ] = fy - cy;
+				cell[ i ] = cy * DWA_FIELD_STRIDE + cx;
+			}
+
+			for ( unsigned int i = 0; i < n; i++ )
+			{
+				const float * d = field + cell[ i ];
+				float fx = fractionX[ i ], fy = fractionY[ i ];
+				distance[ i ] = ( 1.0f - fy ) * ( ( 1.0f - fx ) * d[ 0 ] + fx * d[ 1 ] )
+					+ fy * ( ( 1.0f - fx ) * d[ DWA_FIELD_STRIDE ] + fx * d[ DWA_FIELD_STRIDE + 1 ] );
+			}
+
+			// Clearance counts only up to the first collision
+			for ( unsigned int i = 0; i < n; i++ )
+			{
+				float c = std::min( (float) DWA_CLEARANCE_MAX, distance[ i ] - (float) DWA_ROBOT_RADIUS );
+				float first = collision[ i ], least = clearance[ i ];
+				bool free = first >= t, hit = c < limit;
+				collision[ i ] = ( free & hit ) ? t : first;
+				clearance[ i ] = ( free & ! hit ) ? std::min( least, c ) : least;
+			}
+		}
+
+		// Must be able to stop before a collision, and before the goal.
+		// Braking at constant decelleration takes half the time of driving
+		// on. The collision may be up to a step earlier than found, and
+		// braking starts a cycle from now. Speeds are compared squared, and
+		// the rest is capped to -FLT_MAX, so this runs as SIMD too.
+		float turnChange = fabs( w - this->lastOmega ) / angular;
+		for ( unsigned int i = 0; i < n; i++ )
+		{
+			float speed = sx[ i ] * sx[ i ] + sy[ i ] * sy[ i ];
+			float stop = 2.0f * (float) DWA_BRAKING * ( collision[ i ] - step - dt );
+			float bound = std::min( stop * stop, goalSpeed * goalSpeed );
+			bound = stop >= 0.0f ? bound : -1.0f;
+
+			float progress = ( startDistance - sqrtf( goalDistance[ i ] ) ) / (float) ( DWA_MAX_SPEED * DWA_HORIZON );
+			float change = ( fabs( sx[ i ] - this->lastX ) + fabs( sy[ i ] - this->lastY ) ) / ( 2.0f * linear )
+				+ turnChange;
+			float room = clearance[ i ];
+
+			float value = (float) DWA_WEIGHT_PROGRESS * progress
+				+ (float) DWA_WEIGHT_CLEARANCE * std::max( 0.0f, room ) / (float) DWA_CLEARANCE_MAX
+				- (float) DWA_WEIGHT_SMOOTHNESS * change / 2.0f;
+			score[ i ] = std::min( value, speed <= bound ? FLT_MAX : - FLT_MAX );
+		}
+
+		for ( unsigned int i = 0; i < n; i++ )
+		{
+			if ( score[ i ] == - FLT_MAX || ( found && score[ i ] <= bestScore ) ) continue;
+
+			found = true;
+			bestScore = score[ i ];
+			* x = sx[ i ];
+			* y = sy[ i ];
+			* omega = w;
+		}
+
+		this->_candidates += n;
+	}
+
+	return found;
+}
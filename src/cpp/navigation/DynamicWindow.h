@@ -0,0 +1,242 @@
+/**
+ * @file	DynamicWindow.h
+ * @brief	Header file for the DynamicWindow class
+ */
+#ifndef DYNAMICWINDOW_H
+#define DYNAMICWINDOW_H
+
+#include "../robotino/headers/Axon.h"
+
+#include "../geometry/Coordinate.h"
+
+#include <vector>
+
+class Brain;
+
+
+	// Limits
+
+/// The maximum speed, x and y combined, in m/s
+#define DWA_MAX_SPEED	0.3
+/// The maximum rotation speed, in rad/s
+#define DWA_MAX_OMEGA	1.0
+/// The acceleration reachable within a cycle, x and y combined, in m/s^2.
+/// Matches OMNIDRIVE_MAX_ACCELLERATION.
+#define DWA_ACCELERATION	0.4
+/// The angular acceleration reachable within a cycle, in rad/s^2
+#define DWA_ANGULAR_ACCELERATION	3.0
+/// The decelleration assumed when checking if Robotino can stop in time, in
+/// m/s^2. Below DWA_ACCELERATION to leave a margin.
+#define DWA_BRAKING	0.3
+
+
+	// Sampling
+
+/// Number of samples of each of x and y speed across the window
+#define DWA_LINEAR_SAMPLES	21
+/// Number of samples of omega across the window
+#define DWA_ANGULAR_SAMPLES	11
+/// How far ahead every candidate is simulated, in seconds
+#define DWA_HORIZON	1.5
+/// Number of points checked along every simulated trajectory
+#define DWA_STEPS	15
+
+
+	// Clearance
+
+/// Radius of Robotinos footprint, in meters
+#define DWA_ROBOT_RADIUS	0.2
+/// Cell size of the distance field, in meters
+#define DWA_FIELD_RESOLUTION	0.05
+/// Cells per side of the distance field, centered on Robotino
+#define DWA_FIELD_SIZE	81
+/// Clearance above which all trajectories count as equally clear, in meters
+#define DWA_CLEARANCE_MAX	0.5
+/// Overlap of the footprint with an obstacle not counted as a collision, in
+/// meters. An overlap Robotino already has is never counted either, so it can
+/// slide along a wall it has stopped at.
+#define DWA_COLLISION_TOLERANCE	0.0
+/// Distance sensor readings above this are not obstacles, in meters
+#define DWA_DISTANCESENSOR_RANGE	0.3
+
+
+	// Scoring
+
+/// Weight of the progress made towards the goal
+#define DWA_WEIGHT_PROGRESS	1.0
+/// Weight of the clearance to obstacles
+#define DWA_WEIGHT_CLEARANCE	0.4
+/// Weight of the change from the previous command
+#define DWA_WEIGHT_SMOOTHNESS	0.1
+/// Distance to the goal counting as arrived, in meters
+#define DWA_GOAL_DISTANCE	0.05
+
+
+/**
+ * Dynamic Window Approach local planner
+ *
+ * Every cycle analyze() turns the current LaserRangeFinder scan and distance
+ * sensor readings into a distance field around Robotino. apply() then
+ * samples speeds ( x, y, omega ) reachable from the previous command within
+ * the acceleration limits, simulates each at constant speed over
+ * DWA_HORIZON and hands the best one to _OmniDrive::setPlannedVelocity().
+ *
+ * Candidates that could not stop in time for an obstacle on their
+ * trajectory, or for the goal, are dropped. The rest are scored on progress
+ * towards the goal, clearance and change from the previous command.
+ *
+ * Trajectories of all ( x, y ) samples are calculated together, one omega
+ * and time step at a time, from arrays of speeds. The arc of a constant
+ * speed reduces to two factors per omega and time step, so a step costs a
+ * multiply-add per sample plus a distance field lookup. The field has a
+ * border of clear cells, like LikelihoodField, and lookups are clamped onto
+ * it, so all loops but the gather of field values are free of branches and
+ * run as SIMD.
+ *
+ * See @link DynamicWindow.h @endlink for documentation of @c \#define
+ * parameters
+ */
+class DynamicWindow : public Axon
+{
+ public:
+	/**
+	 * Constructs DynamicWindow
+	 *
+	 * @param	pBrain	A pointer to the owner Brain object
+	 */
+	DynamicWindow( Brain * pBrain );
+
+	/**
+	 * Starts driving towards a goal. The goal is also set as _OmniDrive's
+	 * destination, which takes over when the goal is reached.
+	 *
+	 * @param	goal	The goal
+	 */
+	void setGoal( Coordinate goal );
+
+	/**
+	 * Gets the current goal
+	 *
+	 * @return	The goal
+	 */
+	Coordinate goal();
+
+	/**
+	 * Checks if driving towards the goal
+	 *
+	 * @return	Boolean indicating if active
+	 */
+	bool isActive();
+
+	/**
+	 * Stops driving towards the goal, leaving _OmniDrive to its destination
+	 */
+	void cancel();
+
+	/**
+	 * Gets the distance from Robotinos footprint to the nearest obstacle,
+	 * from the last distance field
+	 *
+	 * @param	x	Forward coordinate relative to Robotino
+	 * @param	y	Leftward coordinate relative to Robotino
+	 *
+	 * @return	Clearance in meters, DWA_CLEARANCE_MAX if outside the field
+	 */
+	float clearance( float x, float y );
+
+	/**
+	 * Gets the number of candidates evaluated in the last cycle
+	 *
+	 * @return	Number of candidates
+	 */
+	unsigned int candidates();
+
+	void analyze();
+
+	void apply();
+
+ private:
+	Coordinate
+	/// The goal
+		_goal;
+
+	bool
+	/// If driving towards the goal
+		active,
+	/// If no admissible candidate was found in the last cycle
+		blocked;
+
+	float
+	/// Previous command in x direction
+		lastX,
+	/// Previous command in y direction
+		lastY,
+	/// Previous rotation command
+		lastOmega;
+
+	unsigned int
+	/// Candidates evaluated in the last cycle
+		_candidates;
+
+	std::vector< float >
+	/// Distance to the nearest obstacle of each field cell, in meters, with
+	/// a border of clear cells around
+		field,
+	/// x speed of each linear sample in the window
+		sampleX,
+	/// y speed of each linear sample in the window
+		sampleY,
+	/// Trajectory points of all samples, x
+		pointX,
+	/// Trajectory points of all samples, y
+		pointY,
+	/// Least clearance of each sample along its trajectory, up to a
+	/// collision
+		sampleClearance,
+	/// Least squared distance to goal of each sample along its trajectory
+		sampleGoalDistance,
+	/// Time of the first collision of each sample
+		sampleCollision,
+	/// Weight of the next column of each trajectory point's field cell
+		sampleFractionX,
+	/// Weight of the next row of each trajectory point's field cell
+		sampleFractionY,
+	/// Interpolated field distance of each trajectory point
+		sampleDistance,
+	/// Score of each sample, -FLT_MAX if not admissible
+		sampleScore;
+
+	std::vector< int >
+	/// Field cell of each trajectory point
+		sampleCell;
+
+	/**
+	 * Marks an obstacle in the distance field
+	 *
+	 * @param	x	Forward coordinate relative to Robotino
+	 * @param	y	Leftward coordinate relative to Robotino
+	 */
+	void addObstacle( float x, float y );
+
+	/**
+	 * Turns the marked obstacles into distances with a two pass chamfer
+	 * transform
+	 */
+	void buildField();
+
+	/**
+	 * Finds the best command for driving towards a goal
+	 *
+	 * @param	goalX	Goal, forward coordinate relative to Robotino
+	 * @param	goalY	Goal, leftward coordinate relative to Robotino
+	 * @param	x	Set to the x speed
+	 * @param	y	Set to the y speed
+	 * @param	omega	Set to the rotation speed
+	 *
+	 * @return	False if no candidate was admissible, the command is then the
+	 * hardest possible brake
+	 */
+	bool evaluate( float goalX, float goalY, float * x, float * y, float * omega );
+};
+
+#endif
@@ -0,0 +1,426 @@
+#include "GraphSlam.h"
+
+#include "../robotino/headers/Brain.h"
+#include "../robotino/headers/_Odometry.h"
+#include "../robotino/headers/_LaserRangeFinder.h"
+
+#include "../obstacle/OccupancyGrid.h"
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+
+
+/**
+ * Pose b, given in the frame of pose a, in the frame a is given in
+ */
+static void
+compose( const double * a, const double * b, double * result )
+{
+	double c = cos( a[ 2 ] ), s = sin( a[ 2 ] );
+	result[ 0 ] = a[ 0 ] + c * b[ 0 ] - s * b[ 1 ];
+	result[ 1 ] = a[ 1 ] + s * b[ 0 ] + c * b[ 1 ];
+	result[ 2 ] = atan2( sin( a[ 2 ] + b[ 2 ] ), cos( a[ 2 ] + b[ 2 ] ) );
+}
+
+/**
+ * Pose b in the frame of pose a
+ */
+static void
+between( const double * a, const double * b, double * result )
+{
+	double c = cos( a[ 2 ] ), s = sin( a[ 2 ] );
+	double dx = b[ 0 ] - a[ 0 ], dy = b[ 1 ] - a[ 1 ];
+	result[ 0 ] = c * dx + s * dy;
+	result[ 1 ] = - s * dx + c * dy;
+	result[ 2 ] = atan2( sin( b[ 2 ] - a[ 2 ] ), cos( b[ 2 ] - a[ 2 ] ) );
+}
+
+
+GraphSlam::GraphSlam( Brain * pBrain )
+	: Axon::Axon( pBrain )
+{
+	this->enabled = false;
+	this->resetRequested = false;
+	this->keyframeDue = false;
+	this->mapChanged = false;
+	this->lastScanTime = 0;
+	this->sinceRender = 0;
+	this->sinceLoop = SLAM_LOOP_INTERVAL;
+	this->keyCount = 0;
+	this->loopCount = 0;
+
+	OccupancyGrid * pMap = this->brain()->map();
+	this->hits.assign( pMap->width() * pMap->height(), 0 );
+	this->drawn.assign( pMap->width() * pMap->height(), OCCUPANCYGRID_FREE );
+
+	this->runSlamLoop = true;
+	this->tSlam = std::thread( & GraphSlam::slamLoop, this );
+}
+
+GraphSlam::~GraphSlam()
+{
+	{
+		std::lock_guard< std::mutex > lock( this->slamMutex );
+		this->runSlamLoop = false;
+	}
+	this->slamCondition.notify_one();
+	this->tSlam.join();
+}
+
+void
+GraphSlam::enable( bool enable )
+{
+	{
+		std::lock_guard< std::mutex > lock( this->slamMutex );
+
+		if ( enable && ! this->enabled )
+		{
+			this->resetRequested = true;
+			this->keyframeDue = true;
+			this->pending.clear();
+		}
+		this->enabled = enable;
+	}
+	this->slamCondition.notify_one();
+
+	std::cout << "GraphSlam: mapping " << ( enable ? "started" : "stopped" ) << std::endl;
+}
+
+bool
+GraphSlam::isEnabled()
+{
+	std::lock_guard< std::mutex > lock( this->slamMutex );
+	return this->enabled;
+}
+
+unsigned int
+GraphSlam::keyframes()
+{
+	std::lock_guard< std::mutex > lock( this->resultMutex );
+	return this->keyCount;
+}
+
+unsigned int
+GraphSlam::loops()
+{
+	std::lock_guard< std::mutex > lock( this->resultMutex );
+	return this->loopCount;
+}
+
+AngularCoordinate
+GraphSlam::pose()
+{
+	std::lock_guard< std::mutex > lock( this->resultMutex );
+	return this->latestPose;
+}
+
+void
+GraphSlam::analyze()
+{
+	// Copy a new drawing over, only the cells that changed so listeners of
+	// the map do little work
+	{
+		std::lock_guard< std::mutex > lock( this->resultMutex );
+		if ( this->mapChanged )
+		{
+			OccupancyGrid * pMap = this->brain()->map();
+			int width = pMap->width();
+			for ( unsigned int i = 0; i < this->drawn.size(); i++ )
+				if ( pMap->cell( i % width, i / width ) != this->drawn[ i ] )
+					pMap->setCell( i % width, i / width, this->drawn[ i ] );
+			this->mapChanged = false;
+		}
+	}
+
+	unsigned int scanTime = this->brain()->lrf()->scanTime();
+	if ( scanTime == this->lastScanTime ) return;
+	this->lastScanTime = scanTime;
+
+	PreciseAngularCoordinate pose = this->brain()->odom()->getPosition( scanTime );
+	{
+		std::lock_guard< std::mutex > lock( this->slamMutex );
+		if ( ! this->enabled ) return;
+
+		if ( ! this->keyframeDue )
+		{
+			float dx = pose.x() - this->lastKeyPose.x(), dy = pose.y() - this->lastKeyPose.y();
+			float dphi = atan2( sin( pose.phi() - this->lastKeyPose.phi() ), cos( pose.phi() - this->lastKeyPose.phi() ) );
+			if ( sqrt( dx * dx + dy * dy ) < SLAM_KEYFRAME_DISTANCE && fabs( dphi ) < SLAM_KEYFRAME_ANGLE ) return;
+		}
+	}
+
+	std::vector< Coordinate > points = this->brain()->lrf()->scanCoordinates( AngularCoordinate( 0.0, 0.0, 0.0 ) );
+	if ( points.empty() ) return;
+
+	Keyframe key;
+	key.odometry[ 0 ] = pose.x();
+	key.odometry[ 1 ] = pose.y();
+	key.odometry[ 2 ] = pose.phi();
+	unsigned int count = std::min( (unsigned int) points.size(), (unsigned int) SLAM_POINTS );
+	for ( unsigned int p = 0; p < count; p++ )
+	{
+		unsigned int i = p * points.size() / count;
+		key.x.push_back( points[ i ].x() );
+		key.y.push_back( points[ i ].y() );
+	}
+	this->lastKeyPose = pose;
+
+	{
+		std::lock_guard< std::mutex > lock( this->slamMutex );
+		this->keyframeDue = false;
+		this->pending.push_back( key );
+	}
+	this->slamCondition.notify_one();
+}
+
+void
+GraphSlam::apply()
+{}  /// Should be empty, the map is updated by analyze()
+
+// Private functions
+
+void
+GraphSlam::slamLoop()
+{
+	std::unique_lock< std::mutex > lock( this->slamMutex );
+
+	while ( true )
+	{
+		while ( this->pending.empty() && ! this->resetRequested && this->runSlamLoop )
+			this->slamCondition.wait( lock );
+		if ( ! this->runSlamLoop ) break;
+
+		if ( this->resetRequested )
+		{
+			this->resetRequested = false;
+			lock.unlock();
+			this->reset();
+			lock.lock();
+			continue;
+		}
+
+		Keyframe key = this->pending.front();
+		this->pending.pop_front();
+
+		// Matching takes a while, keep analyze() from waiting for it
+		lock.unlock();
+		this->insert( key );
+		lock.lock();
+	}
+}
+
+void
+GraphSlam::insert( const Keyframe & key )
+{
+	unsigned int node = this->keys.size();
+	this->keys.push_back( key );
+	this->keys[ node ].travelled = 0.0;
+
+	if ( node == 0 )
+	{
+		this->graph.addNode( key.odometry );
+	}
+	else
+	{
+		// Match against the last keyframes, from where the odometry says
+		double odometry[ 3 ], measurement[ 3 ], deviation[ 3 ];
+		between( this->keys[ node - 1 ].odometry, key.odometry, odometry );
+		this->reference( node - 1, ( node > SLAM_LOCAL_KEYFRAMES ) ? node - SLAM_LOCAL_KEYFRAMES : 0, node );
+
+		float fit;
+		if ( this->matcher.match( & key.x[ 0 ], & key.y[ 0 ], key.x.size(), odometry,
+					SLAM_MATCH_WINDOW, SLAM_MATCH_ANGLE_WINDOW, measurement, & fit ) )
+		{
+			deviation[ 0 ] = deviation[ 1 ] = SLAM_MATCH_DEVIATION;
+			deviation[ 2 ] = SLAM_MATCH_PHI_DEVIATION;
+		}
+		else
+		{
+			// Like the process noise of PoseFilter, growing with the motion.
+			// The match window bounds how wrong a failed match can be.
+			double length = sqrt( odometry[ 0 ] * odometry[ 0 ] + odometry[ 1 ] * odometry[ 1 ] );
+			std::copy( odometry, odometry + 3, measurement );
+			deviation[ 0 ] = deviation[ 1 ] = SLAM_MATCH_DEVIATION + SLAM_ODOMETRY_DEVIATION * length;
+			deviation[ 2 ] = SLAM_MATCH_PHI_DEVIATION + SLAM_ODOMETRY_PHI_DEVIATION * ( length + fabs( odometry[ 2 ] ) );
+		}
+
+		double previous[ 3 ], estimate[ 3 ];
+		this->graph.pose( node - 1, previous );
+		compose( previous, measurement, estimate );
+		this->graph.addNode( estimate );
+		this->graph.addEdge( node - 1, node, measurement, deviation );
+		this->keys[ node ].travelled = this->keys[ node - 1 ].travelled
+			+ sqrt( odometry[ 0 ] * odometry[ 0 ] + odometry[ 1 ] * odometry[ 1 ] );
+	}
+
+	// Describe the place, and make the keyframe that just got old enough to
+	// close loops with findable
+	unsigned int first = ( node + 1 > SLAM_DESCRIPTOR_KEYFRAMES ) ? node + 1 - SLAM_DESCRIPTOR_KEYFRAMES : 0;
+	this->gather( node, first, node + 1 );
+	this->keys[ node ].descriptor.compute( & this->referenceX[ 0 ], & this->referenceY[ 0 ], this->referenceX.size() );
+	if ( node >= SLAM_LOOP_MIN_GAP )
+		this->places.add( this->keys[ node - SLAM_LOOP_MIN_GAP ].descriptor, node - SLAM_LOOP_MIN_GAP );
+
+	bool closed = ( ++this->sinceLoop >= SLAM_LOOP_INTERVAL ) && this->closeLoops();
+	if ( closed ) this->sinceLoop = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	unsigned int rows = this->graph.optimize();
+	float milliseconds = std::chrono::duration< float, std::milli >( std::chrono::steady_clock::now() - start ).count();
+
+	if ( closed )
+		std::cout << "GraphSlam: closed a loop at keyframe " << node << ", optimized " << rows
+			<< " rows in " << milliseconds << " ms" << std::endl;
+
+	if ( closed || ++this->sinceRender >= SLAM_RENDER_INTERVAL )
+	{
+		this->render();
+		this->sinceRender = 0;
+	}
+
+	double latest[ 3 ];
+	this->graph.pose( node, latest );
+
+	std::lock_guard< std::mutex > lock( this->resultMutex );
+	this->keyCount = this->keys.size();
+	if ( closed ) this->loopCount++;
+	this->latestPose = AngularCoordinate( latest[ 0 ], latest[ 1 ], latest[ 2 ] );
+}
+
+void
+GraphSlam::gather( unsigned int frame, unsigned int from, unsigned int to )
+{
+	this->referenceX.clear();
+	this->referenceY.clear();
+
+	double origin[ 3 ], pose[ 3 ], relative[ 3 ];
+	this->graph.pose( frame, origin );
+
+	for ( unsigned int k = from; k < to; k++ )
+	{
+		this->graph.pose( k, pose );
+		between( origin, pose, relative );
+		double c = cos( relative[ 2 ] ), s = sin( relative[ 2 ] );
+
+		const Keyframe & key = this->keys[ k ];
+		for ( unsigned int i = 0; i < key.x.size(); i++ )
+		{
+			this->referenceX.push_back( relative[ 0 ] + c * key.x[ i ] - s * key.y[ i ] );
+			this->referenceY.push_back( relative[ 1 ] + s * key.x[ i ] + c * key.y[ i ] );
+		}
+	}
+}
+
+void
+GraphSlam::reference( unsigned int frame, unsigned int from, unsigned int to )
+{
+	this->gather( frame, from, to );
+	this->matcher.setReference( & this->referenceX[ 0 ], & this->referenceY[ 0 ], this->referenceX.size() );
+}
+
+bool
+GraphSlam::closeLoops()
+{
+	unsigned int node = this->keys.size() - 1;
+	const Keyframe & key = this->keys[ node ];
+
+	unsigned int ids[ SLAM_LOOP_NEAREST ];
+	float distances[ SLAM_LOOP_NEAREST ];
+	unsigned int found = this->places.nearest( key.descriptor, SLAM_LOOP_NEAREST, ids, distances );
+
+	double current[ 3 ], pose[ 3 ];
+	this->graph.pose( node, current );
+
+	unsigned int tries = 0;
+	for ( unsigned int n = 0; n < found && tries < SLAM_LOOP_CANDIDATES; n++ )
+	{
+		// Places that look alike but are further than the drift could
+		// explain are different places
+		unsigned int k = ids[ n ];
+		double driven = key.travelled - this->keys[ k ].travelled;
+		double radius = SLAM_LOOP_RADIUS + SLAM_LOOP_DRIFT * driven;
+		double turn = SLAM_LOOP_ANGLE_WINDOW + SLAM_LOOP_PHI_DRIFT * driven;
+		this->graph.pose( k, pose );
+		if ( hypot( pose[ 0 ] - current[ 0 ], pose[ 1 ] - current[ 1 ] ) > radius ) continue;
+		tries++;
+
+		this->reference( k, ( k > SLAM_LOOP_NEIGHBOURS ) ? k - SLAM_LOOP_NEIGHBOURS : 0,
+				std::min( k + SLAM_LOOP_NEIGHBOURS + 1, node ) );
+
+		// The estimate if it is within reach of the search, else the place of
+		// the candidate, turned the way the descriptors say
+		double estimate[ 3 ], guess[ 3 ], measurement[ 3 ];
+		between( pose, current, estimate );
+		std::copy( estimate, estimate + 3, guess );
+		if ( hypot( guess[ 0 ], guess[ 1 ] ) > SLAM_LOOP_WINDOW )
+		{
+			guess[ 0 ] = guess[ 1 ] = 0.0;
+			guess[ 2 ] = this->keys[ k ].descriptor.heading( key.descriptor );
+		}
+
+		float fit;
+		this->matcher.match( & key.x[ 0 ], & key.y[ 0 ], key.x.size(), guess,
+				SLAM_LOOP_WINDOW, SLAM_LOOP_ANGLE_WINDOW, measurement, & fit );
+		if ( fit < SLAM_LOOP_MIN_FIT ) continue;
+
+		// A corridor fits itself in many places, the match must agree with
+		// the estimate as far as the drift allows
+		double offPhi = atan2( sin( measurement[ 2 ] - estimate[ 2 ] ), cos( measurement[ 2 ] - estimate[ 2 ] ) );
+		if ( hypot( measurement[ 0 ] - estimate[ 0 ], measurement[ 1 ] - estimate[ 1 ] ) > radius
+				|| fabs( offPhi ) > turn )
+			continue;
+
+		double deviation[ 3 ] = { SLAM_MATCH_DEVIATION, SLAM_MATCH_DEVIATION, SLAM_MATCH_PHI_DEVIATION };
+		this->graph.addEdge( k, node, measurement, deviation );
+		return true;
+	}
+
+	return false;
+}
+
+void
+GraphSlam::render()
+{
+	// Only the size of the map is read here, which never changes
+	OccupancyGrid * pMap = this->brain()->map();
+	int width = pMap->width();
+	std::fill( this->hits.begin(), this->hits.end(), 0 );
+
+	double pose[ 3 ];
+	int x, y;
+	for ( unsigned int k = 0; k < this->keys.size(); k++ )
+	{
+		this->graph.pose( k, pose );
+		double c = cos( pose[ 2 ] ), s = sin( pose[ 2 ] );
+
+		const Keyframe & key = this->keys[ k ];
+		for ( unsigned int i = 0; i < key.x.size(); i++ )
+		{
+			Coordinate point( pose[ 0 ] + c * key.x[ i ] - s * key.y[ i ], pose[ 1 ] + s * key.x[ i ] + c * key.y[ i ] );
+			if ( ! pMap->toCell( point, & x, & y ) ) continue;
+			unsigned short & cell = this->hits[ y * width + x ];
+			if ( cell < SLAM_MIN_HITS ) cell++;
+		}
+	}
+
+	std::lock_guard< std::mutex > lock( this->resultMutex );
+	for ( unsigned int i = 0; i < this->hits.size(); i++ )
+		this->drawn[ i ] = ( this->hits[ i ] >= SLAM_MIN_HITS ) ? OCCUPANCYGRID_OCCUPIED : OCCUPANCYGRID_FREE;
+	this->mapChanged = true;
+}
+
+void
+GraphSlam::reset()
+{
+	this->graph.clear();
+	this->keys.clear();
+	this->places.clear();
+	this->sinceRender = 0;
+	this->sinceLoop = SLAM_LOOP_INTERVAL;
+
+	std::lock_guard< std::mutex > lock( this->resultMutex );
+	this->keyCount = 0;
+	this->loopCount = 0;
+}
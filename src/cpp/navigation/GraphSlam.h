@@ -0,0 +1,339 @@
+/**
+ * @file	GraphSlam.h
+ * @brief	Header file for the GraphSlam class
+ */
+#ifndef GRAPHSLAM_H
+#define GRAPHSLAM_H
+
+#include "../robotino/headers/Axon.h"
+
+#include "../geometry/AngularCoordinate.h"
+
+#include "PoseGraph.h"
+#include "ScanMatcher.h"
+#include "ScanDescriptor.h"
+#include "PlaceIndex.h"
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+class Brain;
+
+
+	// Keyframes
+
+/// Distance driven before a scan is kept as a keyframe, in meters
+#define SLAM_KEYFRAME_DISTANCE	0.3
+/// Angle turned before a scan is kept as a keyframe, in rad
+#define SLAM_KEYFRAME_ANGLE	0.3
+/// Most points kept of a keyframe scan, spread evenly over it
+#define SLAM_POINTS	180
+
+
+	// Matching
+
+/// Number of previous keyframes the newest is matched against, drawn
+/// together in the frame of the last one
+#define SLAM_LOCAL_KEYFRAMES	3
+/// Distance from the odometry searched when matching the previous keyframe,
+/// in meters
+#define SLAM_MATCH_WINDOW	0.2
+/// Angle from the odometry searched when matching the previous keyframe, in
+/// rad
+#define SLAM_MATCH_ANGLE_WINDOW	0.15
+/// Deviation of a matched pose, in meters
+#define SLAM_MATCH_DEVIATION	0.03
+/// Deviation of a matched heading, in rad
+#define SLAM_MATCH_PHI_DEVIATION	0.01
+/// Deviation of the odometry per meter driven, used when a match fails, in
+/// meters
+#define SLAM_ODOMETRY_DEVIATION	0.1
+/// Deviation of the odometry heading per meter driven and rad turned, in rad
+#define SLAM_ODOMETRY_PHI_DEVIATION	0.05
+
+
+	// Loop closing
+
+/// Keyframes drawn together for the ScanDescriptor of a keyframe, the
+/// keyframe and those before it. The laser sees 240 degrees, several
+/// keyframes fill in more of the place.
+#define SLAM_DESCRIPTOR_KEYFRAMES	5
+/// Number of places with the nearest descriptors fetched from the PlaceIndex
+/// for each keyframe
+#define SLAM_LOOP_NEAREST	10
+/// Distance between the estimated poses of two keyframes within which they
+/// may see the same place, in meters, to which SLAM_LOOP_DRIFT is added
+#define SLAM_LOOP_RADIUS	1.0
+/// Share of the distance driven between two keyframes their estimated poses
+/// may be off by. Places further apart that look alike, like the corners of
+/// a corridor, are not matched, and matches further off are not used.
+#define SLAM_LOOP_DRIFT	0.03
+/// Heading difference between two keyframes their estimates may be off by,
+/// in rad per meter driven between them, added to SLAM_LOOP_ANGLE_WINDOW
+#define SLAM_LOOP_PHI_DRIFT	0.01
+/// Keyframes that must lie between two for them to close a loop. Closer ones
+/// are linked by the matches of the keyframes in between already.
+#define SLAM_LOOP_MIN_GAP	20
+/// Keyframes added after closing a loop before looking for the next. Each
+/// loop widens the rows of the PoseGraph factor between its ends, and the
+/// next keyframe adds little the last did not say already.
+#define SLAM_LOOP_INTERVAL	5
+/// Most candidates matched for each keyframe, nearest descriptor first
+#define SLAM_LOOP_CANDIDATES	3
+/// Keyframes on either side of a candidate drawn into its reference
+#define SLAM_LOOP_NEIGHBOURS	2
+/// Distance from the guess searched when closing a loop, in meters. The
+/// drift since the loop started is unknown, so this is wider than
+/// SLAM_MATCH_WINDOW. Candidates estimated further away are searched around
+/// the pose of the candidate, turned by ScanDescriptor::heading().
+#define SLAM_LOOP_WINDOW	0.8
+/// Angle from the guess searched when closing a loop, in rad
+#define SLAM_LOOP_ANGLE_WINDOW	0.3
+/// Share of points that must fit to close a loop. A wrong loop bends the
+/// whole map, so this is stricter than SCANMATCHER_MIN_FIT. Stretches of a
+/// corridor that only look alike fit about 0.85 in simulation, the same
+/// place 0.96 and up.
+#define SLAM_LOOP_MIN_FIT	0.95
+
+
+	// Map
+
+/// Keyframes added between redrawing the map, when no loop was closed
+#define SLAM_RENDER_INTERVAL	10
+/// Number of points that must land in a cell for it to be drawn as an
+/// obstacle, so single stray readings are left out
+#define SLAM_MIN_HITS	2
+
+
+/**
+ * Builds the static map with graph based SLAM
+ *
+ * While enabled, analyze() keeps a laser scan as a keyframe every time
+ * Robotino has moved SLAM_KEYFRAME_DISTANCE or turned SLAM_KEYFRAME_ANGLE,
+ * and hands it to a worker thread with its odometry pose. The worker
+ * - matches it against the previous keyframes with a ScanMatcher, and adds
+ *   the result as an edge of a PoseGraph, or the odometry if the match
+ *   fails;
+ * - looks up the older keyframes with the nearest ScanDescriptor in a
+ *   PlaceIndex, and matches those its estimated pose is not too far from,
+ *   adding an edge for a loop this closes;
+ * - optimizes the PoseGraph, which only refactors the part a new edge
+ *   changed;
+ * - draws the points of all keyframes from their optimized poses into a
+ *   map, after a loop was closed or every SLAM_RENDER_INTERVAL keyframes.
+ *
+ * The worker never touches Brain::map(). analyze() copies the cells of a new
+ * drawing over, so the map and its listeners stay on the thread of the
+ * Brain. The map is replaced as a whole, so anything loaded before is
+ * overwritten.
+ *
+ * _Odometry is left alone: the edges between keyframes without a match are
+ * the odometry increments, which a corrected odometry would no longer give.
+ * The optimized pose of the latest keyframe is available from pose().
+ *
+ * See @link GraphSlam.h @endlink for documentation of @c \#define parameters
+ */
+class GraphSlam : public Axon
+{
+ public:
+	/**
+	 * Constructs GraphSlam and starts its worker thread
+	 *
+	 * @param	pBrain	A pointer to the owner Brain object
+	 */
+	GraphSlam( Brain * pBrain );
+
+	/**
+	 * Stops the worker thread
+	 */
+	~GraphSlam();
+
+	/**
+	 * Starts or stops mapping. Starting throws away the keyframes of an
+	 * earlier run.
+	 *
+	 * @param	enable	True to start mapping
+	 */
+	void enable( bool enable );
+
+	/**
+	 * Checks if mapping
+	 *
+	 * @return	Boolean indicating if enabled
+	 */
+	bool isEnabled();
+
+	/**
+	 * Gets the number of keyframes in the graph
+	 *
+	 * @return	Number of keyframes
+	 */
+	unsigned int keyframes();
+
+	/**
+	 * Gets the number of loops closed
+	 *
+	 * @return	Number of loop closing edges
+	 */
+	unsigned int loops();
+
+	/**
+	 * Gets the optimized pose of the latest keyframe
+	 *
+	 * @return	The pose, in the frame of the odometry
+	 */
+	AngularCoordinate pose();
+
+	void analyze();
+
+	void apply();
+
+ private:
+	/**
+	 * A scan kept for the graph
+	 */
+	struct Keyframe
+	{
+		/// Odometry pose at the scan
+		double odometry[ 3 ];
+		/// Points of the scan, in the frame of Robotino
+		std::vector< float > x, y;
+		/// Distance driven since the first keyframe, in meters
+		double travelled;
+		/// Summary of the place, set by the worker
+		ScanDescriptor descriptor;
+	};
+
+	PoseGraph
+	/// Poses of the keyframes, used by the worker only
+		graph;
+
+	ScanMatcher
+	/// Matcher of keyframes, used by the worker only
+		matcher;
+
+	std::vector< Keyframe >
+	/// Keyframes in the graph, used by the worker only
+		keys;
+
+	PlaceIndex
+	/// Descriptors of keyframes at least SLAM_LOOP_MIN_GAP old, used by the
+	/// worker only
+		places;
+
+	std::deque< Keyframe >
+	/// Keyframes waiting for the worker
+		pending;
+
+	std::mutex
+	/// Guards pending and the flags controlling the worker
+		slamMutex,
+	/// Guards the results published by the worker
+		resultMutex;
+
+	std::condition_variable
+	/// Wakes the worker
+		slamCondition;
+
+	std::thread
+	/// Thread running slamLoop()
+		tSlam;
+
+	bool
+	/// If mapping
+		enabled,
+	/// If the worker should throw away its keyframes
+		resetRequested,
+	/// If the next scan should be a keyframe, set when mapping starts
+		keyframeDue,
+	/// Keeps the worker running
+		runSlamLoop,
+	/// If drawn holds a map not copied to Brain::map() yet
+		mapChanged;
+
+	unsigned int
+	/// Time of the last scan seen by analyze()
+		lastScanTime,
+	/// Keyframes added since the map was last drawn, used by the worker
+		sinceRender,
+	/// Keyframes added since the last loop was closed, used by the worker
+		sinceLoop,
+	/// Results published by the worker
+		keyCount,
+		loopCount;
+
+	PreciseAngularCoordinate
+	/// Odometry pose of the last keyframe, used by analyze()
+		lastKeyPose;
+
+	AngularCoordinate
+	/// Optimized pose of the latest keyframe
+		latestPose;
+
+	std::vector< unsigned short >
+	/// Points landing in each map cell, used by the worker
+		hits;
+
+	std::vector< unsigned char >
+	/// The latest map drawn by the worker
+		drawn;
+
+	std::vector< float >
+	/// Points of several keyframes in the frame of one, used by the worker
+		referenceX,
+		referenceY;
+
+	/**
+	 * Waits for keyframes and adds them to the graph. Runs on tSlam.
+	 */
+	void slamLoop();
+
+	/**
+	 * Adds a keyframe to the graph, closes loops and optimizes
+	 *
+	 * @param	key	The keyframe
+	 */
+	void insert( const Keyframe & key );
+
+	/**
+	 * Draws the points of keyframes into referenceX and referenceY, in the
+	 * frame of one of them
+	 *
+	 * @param	frame	The keyframe whose frame is used
+	 * @param	from	The first keyframe drawn
+	 * @param	to	One past the last keyframe drawn
+	 */
+	void gather( unsigned int frame, unsigned int from, unsigned int to );
+
+	/**
+	 * Gathers the points of keyframes and sets them as the reference of the
+	 * matcher
+	 *
+	 * @param	frame	The keyframe whose frame is used
+	 * @param	from	The first keyframe drawn
+	 * @param	to	One past the last keyframe drawn
+	 */
+	void reference( unsigned int frame, unsigned int from, unsigned int to );
+
+	/**
+	 * Tries to close loops from the newest keyframe
+	 *
+	 * @return	True if a loop was closed
+	 */
+	bool closeLoops();
+
+	/**
+	 * Draws all keyframes from their optimized poses and publishes the map
+	 */
+	void render();
+
+	/**
+	 * Throws away all keyframes
+	 */
+	void reset();
+};
+
+#endif
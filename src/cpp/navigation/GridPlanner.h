@@ -0,0 +1,176 @@
+/**
+ * @file	GridPlanner.h
+ * @brief	Header file for the GridPlanner class
+ */
+#ifndef GRIDPLANNER_H
+#define GRIDPLANNER_H
+
+#include "../obstacle/OccupancyGrid.h"
+#include "../obstacle/InflationLayer.h"
+#include "../obstacle/kart.h"
+
+#include <vector>
+
+
+/// Added step cost per unit of inflated cost, on top of the base cost of 1.
+/// With the default the cost next to the footprint is about six times that
+/// of open space.
+#define GRIDPLANNER_COST_WEIGHT	0.02
+
+
+/**
+ * Abstract class for path searches on the inflated cost grid
+ * Inherited by the planners gridnav can use
+ *
+ * Step costs are the step length (1 or SQRT2) times cellCost() of the cell
+ * entered. Cells holding an obstacle are impassable, cells inside the
+ * footprint cost BIGCOST so a robot already too close can still get out.
+ * Diagonal steps past the corner of an impassable cell are not allowed.
+ */
+class GridPlanner
+{
+ public:
+	/**
+	 * Constructor, saves the pointer to the costs
+	 *
+	 * @param	pCosts	Pointer to the inflated costs to plan on
+	 */
+	GridPlanner( InflationLayer * pCosts )
+	{
+		this->pCosts = pCosts;
+		this->_expanded = 0;
+		this->budget = 0;
+		this->searching = false;
+
+		for ( int cost = 0; cost < 256; cost++ )
+		{
+			if ( cost >= INFLATION_LETHAL_COST )
+				this->costTable[ cost ] = -1.0;
+			else if ( cost >= INFLATION_INSCRIBED_COST )
+				this->costTable[ cost ] = BIGCOST;
+			else
+				this->costTable[ cost ] = 1.0 + cost * GRIDPLANNER_COST_WEIGHT;
+		}
+	}
+
+	virtual ~GridPlanner() {}
+
+	/**
+	 * A virtual function that must be implemented by inheriting classes.
+	 * The implementation should search for the cheapest path between two
+	 * cells and store it for path(). With a budget set, it should stop
+	 * after that many expansions, return false and set @c searching, and
+	 * carry on with the same search in the next call to the same goal.
+	 *
+	 * @param	startX	Column of the start cell
+	 * @param	startY	Row of the start cell
+	 * @param	goalX	Column of the goal cell
+	 * @param	goalY	Row of the goal cell
+	 *
+	 * @return	Boolean indicating if a path was found
+	 */
+	virtual bool plan( int startX, int startY, int goalX, int goalY ) = 0;
+
+	/**
+	 * Gets the path found by the last successful plan()
+	 *
+	 * @return	Cell indexes (y * width + x) from start to goal
+	 */
+	const std::vector< int > & path()
+	{
+		return this->_path;
+	}
+
+	/**
+	 * Gets the number of cells expanded by the last search, over all calls
+	 * to plan() it took
+	 *
+	 * @return	Number of expanded cells
+	 */
+	unsigned int expanded()
+	{
+		return this->_expanded;
+	}
+
+	/**
+	 * Limits the cells plan() expands per call. A search that runs out
+	 * returns false with isSearching() true, and goes on with the next
+	 * plan() to the same goal.
+	 *
+	 * @param	budget	Expansions per call, 0 for no limit
+	 */
+	void setBudget( unsigned int budget )
+	{
+		this->budget = budget;
+	}
+
+	/**
+	 * Checks if the last plan() ran out of its budget before it was done
+	 *
+	 * @return	Boolean indicating if the search is not done yet
+	 */
+	bool isSearching()
+	{
+		return this->searching;
+	}
+
+	/**
+	 * Drops a search that ran out of its budget, the next plan() starts a
+	 * new one
+	 */
+	void abandon()
+	{
+		this->searching = false;
+	}
+
+	/**
+	 * Gets the cost multiplier for entering a cell
+	 *
+	 * @param	x	Column
+	 * @param	y	Row
+	 *
+	 * @return	Multiplier of the step length, or a negative value if the
+	 * cell cannot be entered
+	 */
+	float cellCost( int x, int y )
+	{
+		return this->costTable[ this->pCosts->grid()->cell( x, y ) ];
+	}
+
+ protected:
+	InflationLayer
+	/// The costs to plan on
+		* pCosts;
+
+	std::vector< int >
+	/// The last path found
+		_path;
+
+	unsigned int
+	/// Cells expanded by the last search
+		_expanded,
+	/// Most cells one plan() may expand, 0 for no limit
+		budget;
+
+	bool
+	/// If the last plan() ran out of budget before the search was done
+		searching;
+
+	/**
+	 * Octile distance between two cells, the cheapest possible path cost
+	 */
+	float octile( int x0, int y0, int x1, int y1 )
+	{
+		int dx = ( x0 > x1 ) ? x0 - x1 : x1 - x0;
+		int dy = ( y0 > y1 ) ? y0 - y1 : y1 - y0;
+
+		return ( dx < dy ) ? SQRT2 * dx + ( dy - dx ) : SQRT2 * dy + ( dx - dy );
+	}
+
+ private:
+	float
+	/// cellCost() for every inflated cost value
+		costTable[ 256 ];
+};
+
+#endif
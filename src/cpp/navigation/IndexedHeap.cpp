@@ -0,0 +1,156 @@
+#include "IndexedHeap.h"
+
+#include <algorithm>
+
+
+IndexedHeap::IndexedHeap()
+{}
+
+void
+IndexedHeap::resize( int cells )
+{
+	this->heap.clear();
+	this->position.assign( cells, -1 );
+	this->key1.assign( cells, 0.0 );
+	this->key2.assign( cells, 0.0 );
+}
+
+void
+IndexedHeap::clear()
+{
+	for ( unsigned int i = 0; i < this->heap.size(); i++ )
+		this->position[ this->heap[ i ] ] = -1;
+
+	this->heap.clear();
+}
+
+bool
+IndexedHeap::empty()
+{
+	return this->heap.empty();
+}
+
+bool
+IndexedHeap::contains( int index )
+{
+	return this->position[ index ] >= 0;
+}
+
+void
+IndexedHeap::update( int index, float k1, float k2 )
+{
+	this->key1[ index ] = k1;
+	this->key2[ index ] = k2;
+
+	if ( this->position[ index ] < 0 )
+	{
+		this->heap.push_back( index );
+		this->position[ index ] = this->heap.size() - 1;
+		this->up( this->heap.size() - 1 );
+		return;
+	}
+
+	// The key may have moved either way
+	this->up( this->position[ index ] );
+	this->down( this->position[ index ] );
+}
+
+void
+IndexedHeap::remove( int index )
+{
+	int at = this->position[ index ];
+	if ( at < 0 ) return;
+
+	int last = this->heap.size() - 1;
+	this->swap( at, last );
+	this->heap.pop_back();
+	this->position[ index ] = -1;
+
+	if ( at < last )
+	{
+		this->up( at );
+		this->down( at );
+	}
+}
+
+int
+IndexedHeap::top()
+{
+	return this->heap[ 0 ];
+}
+
+float
+IndexedHeap::topK1()
+{
+	return this->key1[ this->heap[ 0 ] ];
+}
+
+float
+IndexedHeap::topK2()
+{
+	return this->key2[ this->heap[ 0 ] ];
+}
+
+int
+IndexedHeap::pop()
+{
+	int index = this->heap[ 0 ];
+	this->remove( index );
+
+	return index;
+}
+
+
+// Private functions
+
+bool
+IndexedHeap::less( int a, int b )
+{
+	int cellA = this->heap[ a ];
+	int cellB = this->heap[ b ];
+
+	if ( this->key1[ cellA ] != this->key1[ cellB ] )
+		return this->key1[ cellA ] < this->key1[ cellB ];
+
+	return this->key2[ cellA ] < this->key2[ cellB ];
+}
+
+void
+IndexedHeap::up( int at )
+{
+	while ( at > 0 )
+	{
+		int parent = ( at - 1 ) / 2;
+		if ( ! this->less( at, parent ) ) break;
+
+		this->swap( at, parent );
+		at = parent;
+	}
+}
+
+void
+IndexedHeap::down( int at )
+{
+	int size = this->heap.size();
+	while ( true )
+	{
+		int smallest = at;
+		int left = 2 * at + 1;
+		int right = left + 1;
+
+		if ( left < size && this->less( left, smallest ) ) smallest = left;
+		if ( right < size && this->less( right, smallest ) ) smallest = right;
+		if ( smallest == at ) break;
+
+		this->swap( at, smallest );
+		at = smallest;
+	}
+}
+
+void
+IndexedHeap::swap( int a, int b )
+{
+	std::swap( this->heap[ a ], this->heap[ b ] );
+	this->position[ this->heap[ a ] ] = a;
+	this->position[ this->heap[ b ] ] = b;
+}
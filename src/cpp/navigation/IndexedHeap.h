@@ -0,0 +1,118 @@
+/**
+ * @file	IndexedHeap.h
+ * @brief	Header file for the IndexedHeap class
+ */
+#ifndef INDEXEDHEAP_H
+#define INDEXEDHEAP_H
+
+#include <vector>
+
+
+/**
+ * Binary min-heap of grid cell indexes with decrease-key
+ *
+ * Every cell has a two-part key, compared first on @c k1 and then on @c k2
+ * (planners needing a single key leave @c k2 at 0). A map from cell to heap
+ * position makes update(), remove() and contains() O(1) lookups followed by
+ * an O(log n) sift.
+ *
+ * All storage is sized once by resize(), and clear() only resets the cells
+ * actually in the heap, so the heap can be reused between searches without
+ * allocating or touching the entire grid.
+ */
+class IndexedHeap
+{
+ public:
+	IndexedHeap();
+
+	/**
+	 * Sizes the heap for a number of cells and empties it
+	 *
+	 * @param	cells	Number of cells in the grid
+	 */
+	void resize( int cells );
+
+	/**
+	 * Removes all cells from the heap
+	 */
+	void clear();
+
+	/**
+	 * Checks if the heap is empty
+	 *
+	 * @return	Boolean indicating if the heap is empty
+	 */
+	bool empty();
+
+	/**
+	 * Checks if a cell is in the heap
+	 *
+	 * @param	index	Cell index
+	 *
+	 * @return	Boolean indicating if the cell is in the heap
+	 */
+	bool contains( int index );
+
+	/**
+	 * Inserts a cell, or changes its key if it is already in the heap
+	 *
+	 * @param	index	Cell index
+	 * @param	k1	Primary key
+	 * @param	k2	Secondary key, used to break ties
+	 */
+	void update( int index, float k1, float k2 = 0.0 );
+
+	/**
+	 * Removes a cell, if it is in the heap
+	 *
+	 * @param	index	Cell index
+	 */
+	void remove( int index );
+
+	/**
+	 * Gets the cell with the smallest key
+	 *
+	 * @return	Cell index, the heap must not be empty
+	 */
+	int top();
+
+	/**
+	 * Gets the primary key of the top cell
+	 */
+	float topK1();
+
+	/**
+	 * Gets the secondary key of the top cell
+	 */
+	float topK2();
+
+	/**
+	 * Removes and returns the cell with the smallest key
+	 *
+	 * @return	Cell index, the heap must not be empty
+	 */
+	int pop();
+
+ private:
+	std::vector< int >
+	/// The heap of cell indexes
+		heap,
+	/// Position of each cell in @c heap, or -1
+		position;
+
+	std::vector< float >
+	/// Primary key of each cell
+		key1,
+	/// Secondary key of each cell
+		key2;
+
+	bool less( int a, int b );
+
+	void up( int position );
+
+	void down( int position );
+
+	void swap( int a, int b );
+};
+
+#endif
@@ -0,0 +1,533 @@
+#include "MonteCarloLocalizer.h"
+
+#include "../robotino/headers/Brain.h"
+#include "../robotino/headers/_Odometry.h"
+#include "../robotino/headers/_LaserRangeFinder.h"
+
+#include "../obstacle/OccupancyGrid.h"
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+
+#ifndef _USE_MATH_DEFINES
+#define _USE_MATH_DEFINES
+#endif
+#include <math.h>
+
+
+/// Bits of the KLD bin table index. The table holds 16384 entries, well
+/// above MCL_MAX_PARTICLES so probing stays short.
+static const unsigned int MCL_BIN_BITS = 14;
+static const unsigned int MCL_BIN_TABLE = 1 << MCL_BIN_BITS;
+/// Tries at finding a free cell for each particle of a global start
+static const unsigned int MCL_START_TRIES = 100;
+
+
+MonteCarloLocalizer::MonteCarloLocalizer( Brain * pBrain )
+	: Axon::Axon( pBrain )
+{
+	this->requested = false;
+	this->guessed = false;
+	this->active = false;
+	this->tracking = false;
+	this->count = 0;
+	this->lastScanTime = 0;
+	this->convergedUpdates = 0;
+	this->movedDistance = 0.0;
+	this->movedAngle = 0.0;
+	this->meanX = this->meanY = this->meanPhi = 0.0;
+	this->deviationXY = this->deviationPhi = 0.0;
+	this->effectiveCount = 0.0;
+	this->particleTime = 0.0;
+	this->beams = 0;
+	this->binStamp = 0;
+
+	// Room for every particle, so the cycle does not allocate
+	this->particleX.resize( MCL_MAX_PARTICLES );
+	this->particleY.resize( MCL_MAX_PARTICLES );
+	this->particlePhi.resize( MCL_MAX_PARTICLES );
+	this->nextX.resize( MCL_MAX_PARTICLES );
+	this->nextY.resize( MCL_MAX_PARTICLES );
+	this->nextPhi.resize( MCL_MAX_PARTICLES );
+	this->logWeight.resize( MCL_MAX_PARTICLES );
+	this->cumulative.resize( MCL_MAX_PARTICLES );
+	this->cellIndex.resize( MCL_BEAMS );
+	this->binKeys.assign( MCL_BIN_TABLE, 0 );
+	this->binStamps.assign( MCL_BIN_TABLE, 0 );
+}
+
+void
+MonteCarloLocalizer::localize()
+{
+	std::lock_guard< std::mutex > lock( this->localizerMutex );
+	this->requested = true;
+	this->guessed = false;
+}
+
+void
+MonteCarloLocalizer::localize( AngularCoordinate guess )
+{
+	std::lock_guard< std::mutex > lock( this->localizerMutex );
+	this->requested = true;
+	this->guessed = true;
+	this->requestedGuess = guess;
+}
+
+bool
+MonteCarloLocalizer::isActive()
+{
+	std::lock_guard< std::mutex > lock( this->localizerMutex );
+	return this->active || this->requested;
+}
+
+bool
+MonteCarloLocalizer::isTracking()
+{
+	std::lock_guard< std::mutex > lock( this->localizerMutex );
+	return this->tracking;
+}
+
+void
+MonteCarloLocalizer::cancel()
+{
+	std::lock_guard< std::mutex > lock( this->localizerMutex );
+	this->requested = false;
+	this->active = false;
+	this->tracking = false;
+}
+
+AngularCoordinate
+MonteCarloLocalizer::estimate()
+{
+	std::lock_guard< std::mutex > lock( this->localizerMutex );
+	return AngularCoordinate( this->meanX, this->meanY, this->meanPhi );
+}
+
+float
+MonteCarloLocalizer::deviation()
+{
+	std::lock_guard< std::mutex > lock( this->localizerMutex );
+	return this->deviationXY;
+}
+
+unsigned int
+MonteCarloLocalizer::particles()
+{
+	std::lock_guard< std::mutex > lock( this->localizerMutex );
+	return this->count;
+}
+
+void
+MonteCarloLocalizer::analyze()
+{
+	std::lock_guard< std::mutex > lock( this->localizerMutex );
+
+	// Started here, where the map is not being written
+	if ( this->requested )
+	{
+		this->requested = false;
+		this->start();
+	}
+
+	if ( ! this->active ) return;
+
+	unsigned int scanTime = this->brain()->lrf()->scanTime();
+	if ( scanTime == this->lastScanTime ) return;
+	this->lastScanTime = scanTime;
+
+	// Move the particles by the odometry since the last scan, in the frame
+	// Robotino had then
+	PreciseAngularCoordinate pose = this->brain()->odom()->getPosition( scanTime );
+	float c = cos( this->lastPose.phi() ), s = sin( this->lastPose.phi() );
+	float worldX = pose.x() - this->lastPose.x();
+	float worldY = pose.y() - this->lastPose.y();
+	float dx = c * worldX + s * worldY;
+	float dy = - s * worldX + c * worldY;
+	float dphi = atan2( sin( pose.phi() - this->lastPose.phi() ), cos( pose.phi() - this->lastPose.phi() ) );
+	this->lastPose = pose;
+
+	// A jump means the odometry was set, not driven, see _Odometry
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if ( sqrt( dx * dx + dy * dy ) <= ODOMETRY_MAX_STEP && fabs( dphi ) <= ODOMETRY_MAX_TURN )
+	{
+		this->predict( dx, dy, dphi );
+		this->movedDistance += sqrt( dx * dx + dy * dy );
+		this->movedAngle += fabs( dphi );
+	}
+	if ( this->movedDistance < MCL_UPDATE_DISTANCE && this->movedAngle < MCL_UPDATE_ANGLE ) return;
+
+	this->selectBeams();
+	if ( this->beams == 0 ) return;
+	this->movedDistance = 0.0;
+	this->movedAngle = 0.0;
+
+	this->weigh();
+	this->summarize();
+
+	float seconds = std::chrono::duration< float >( std::chrono::steady_clock::now() - start ).count();
+	float perParticle = seconds / this->count;
+	this->particleTime = ( this->particleTime > 0.0 ) ? 0.8 * this->particleTime + 0.2 * perParticle : perParticle;
+
+	if ( this->deviationXY < MCL_CONVERGED_DEVIATION && this->deviationPhi < MCL_CONVERGED_PHI_DEVIATION )
+		this->convergedUpdates++;
+	else
+		this->convergedUpdates = 0;
+
+	if ( this->convergedUpdates >= MCL_CONVERGED_UPDATES )
+	{
+		// Particles agreeing on a pose the scan does not fit found a place
+		// that only looks alike
+		if ( this->fit() < MCL_MIN_FIT )
+		{
+			std::cout << "MonteCarloLocalizer: the scan does not fit " << this->meanX << ", " << this->meanY
+				<< ", starting over" << std::endl;
+			this->tracking = false;
+			this->spread();
+			return;
+		}
+
+		if ( ! this->tracking )
+		{
+			// The estimate is where Robotino was at the scan, carry it on by the
+			// odometry since
+			PreciseAngularCoordinate now = this->brain()->odom()->getPosition();
+			c = cos( pose.phi() );
+			s = sin( pose.phi() );
+			worldX = now.x() - pose.x();
+			worldY = now.y() - pose.y();
+			dx = c * worldX + s * worldY;
+			dy = - s * worldX + c * worldY;
+			dphi = now.phi() - pose.phi();
+
+			c = cos( this->meanPhi );
+			s = sin( this->meanPhi );
+			double x = this->meanX + c * dx - s * dy;
+			double y = this->meanY + s * dx + c * dy;
+			double phi = atan2( sin( this->meanPhi + dphi ), cos( this->meanPhi + dphi ) );
+
+			// Too far off for the filter to accept as a fix. Readings from
+			// before Robotino applies it are dropped by _Odometry.
+			this->brain()->odom()->set( x, y, phi, false );
+			this->tracking = true;
+
+			// The odometry is in the frame of the map now, where the particles are
+			this->lastPose = PreciseAngularCoordinate( this->meanX, this->meanY, this->meanPhi );
+
+			std::cout << "MonteCarloLocalizer: localized at " << x << ", " << y << ", " << phi
+				<< " (deviation " << this->deviationXY << " m, " << this->deviationPhi << " rad), tracking" << std::endl;
+			return;
+		}
+
+		// Close to the odometry by now. The filter weighs the estimate
+		// against it and moves it on from the time of the scan.
+		this->brain()->odom()->fixPose( PreciseAngularCoordinate( this->meanX, this->meanY, this->meanPhi ), scanTime );
+	}
+
+	// Resampling throws away particles, only do it when most of the weight
+	// sits on a few of them
+	if ( this->effectiveCount < MCL_RESAMPLE_SHARE * this->count )
+		this->resample();
+}
+
+void
+MonteCarloLocalizer::apply()
+{}  /// Should be empty, the pose is handed to _Odometry by analyze()
+
+// Private functions
+
+void
+MonteCarloLocalizer::start()
+{
+	if ( ! this->prepare() ) return;
+
+	if ( ! this->guessed )
+	{
+		this->spread();
+		std::cout << "MonteCarloLocalizer: localizing with " << this->count << " particles" << std::endl;
+		return;
+	}
+
+	std::normal_distribution< float > gauss( 0.0, 1.0 );
+	AngularCoordinate guess = this->requestedGuess;
+
+	this->count = this->budget();
+	for ( unsigned int i = 0; i < this->count; i++ )
+	{
+		this->particleX[ i ] = guess.x() + MCL_START_DEVIATION * gauss( this->random );
+		this->particleY[ i ] = guess.y() + MCL_START_DEVIATION * gauss( this->random );
+		this->particlePhi[ i ] = guess.phi() + MCL_START_PHI_DEVIATION * gauss( this->random );
+	}
+
+	std::cout << "MonteCarloLocalizer: localizing around " << guess.x() << ", " << guess.y()
+		<< " with " << this->count << " particles" << std::endl;
+}
+
+bool
+MonteCarloLocalizer::prepare()
+{
+	if ( this->likelihood.build( this->brain()->map() ) == 0 )
+	{
+		std::cout << "MonteCarloLocalizer: the map is empty, nothing to localize against" << std::endl;
+		this->active = false;
+		return false;
+	}
+
+	this->active = true;
+	this->tracking = false;
+	this->convergedUpdates = 0;
+	std::fill( this->logWeight.begin(), this->logWeight.end(), 0.0 );
+	this->lastScanTime = 0;
+	this->lastPose = this->brain()->odom()->getPosition();
+
+	// Weigh the particles on the first scan
+	this->movedDistance = MCL_UPDATE_DISTANCE;
+	this->movedAngle = 0.0;
+	return true;
+}
+
+void
+MonteCarloLocalizer::spread()
+{
+	int x0, y0, x1, y1;
+	this->likelihood.bounds( & x0, & y0, & x1, & y1 );
+	OccupancyGrid * pMap = this->brain()->map();
+
+	std::uniform_real_distribution< float > uniform( 0.0, 1.0 );
+
+	// Anywhere Robotino could stand within the mapped area, facing anywhere
+	this->count = this->budget();
+	for ( unsigned int i = 0; i < this->count; i++ )
+	{
+		int x = x0, y = y0;
+		for ( unsigned int attempt = 0; attempt < MCL_START_TRIES; attempt++ )
+		{
+			x = x0 + (int) ( uniform( this->random ) * ( x1 - x0 + 1 ) );
+			y = y0 + (int) ( uniform( this->random ) * ( y1 - y0 + 1 ) );
+			if ( pMap->cell( x, y ) < OCCUPANCYGRID_OBSTACLE_THRESHOLD ) break;
+		}
+
+		this->particleX[ i ] = pMap->origin().x() + ( x + uniform( this->random ) ) * pMap->resolution();
+		this->particleY[ i ] = pMap->origin().y() + ( y + uniform( this->random ) ) * pMap->resolution();
+		this->particlePhi[ i ] = ( 2.0 * uniform( this->random ) - 1.0 ) * M_PI;
+	}
+
+	std::fill( this->logWeight.begin(), this->logWeight.end(), 0.0 );
+	this->convergedUpdates = 0;
+}
+
+void
+MonteCarloLocalizer::predict( float dx, float dy, float dphi )
+{
+	// The variance grows with the distance driven and turned, like in
+	// PoseFilter, so standing still adds no noise
+	float length = sqrt( dx * dx + dy * dy );
+	float translation = MCL_TRANSLATION_NOISE * sqrt( length );
+	float rotation = sqrt( MCL_ROTATION_NOISE * MCL_ROTATION_NOISE * fabs( dphi )
+			+ MCL_DRIFT_NOISE * MCL_DRIFT_NOISE * length );
+
+	std::normal_distribution< float > gauss( 0.0, 1.0 );
+
+	for ( unsigned int i = 0; i < this->count; i++ )
+	{
+		float moveX = dx + translation * gauss( this->random );
+		float moveY = dy + translation * gauss( this->random );
+		float c = cos( this->particlePhi[ i ] ), s = sin( this->particlePhi[ i ] );
+
+		this->particleX[ i ] += c * moveX - s * moveY;
+		this->particleY[ i ] += s * moveX + c * moveY;
+		this->particlePhi[ i ] += dphi + rotation * gauss( this->random );
+	}
+}
+
+void
+MonteCarloLocalizer::selectBeams()
+{
+	std::vector< Coordinate > points = this->brain()->lrf()->scanCoordinates( AngularCoordinate( 0.0, 0.0, 0.0 ) );
+
+	// Evenly spread over the scan, in cells of the field so weigh() saves a
+	// multiplication per reading
+	float inverse = 1.0 / this->likelihood.resolution();
+	this->beams = std::min( (unsigned int) points.size(), (unsigned int) MCL_BEAMS );
+	for ( unsigned int b = 0; b < this->beams; b++ )
+	{
+		unsigned int i = b * points.size() / this->beams;
+		this->beamX[ b ] = points[ i ].x() * inverse;
+		this->beamY[ b ] = points[ i ].y() * inverse;
+	}
+}
+
+void
+MonteCarloLocalizer::weigh()
+{
+	const float * field = this->likelihood.values();
+	int width = this->likelihood.width();
+	float inverse = 1.0 / this->likelihood.resolution();
+	float originX = this->likelihood.origin().x(), originY = this->likelihood.origin().y();
+	float lastColumn = width - 1, lastRow = this->likelihood.height() - 1;
+
+	// Locals, so the compiler knows the stores to index do not change them
+	unsigned int beams = this->beams;
+	const float * beamX = this->beamX;
+	const float * beamY = this->beamY;
+	int * index = & this->cellIndex[ 0 ];
+
+	for ( unsigned int i = 0; i < this->count; i++ )
+	{
+		float c = cos( this->particlePhi[ i ] ), s = sin( this->particlePhi[ i ] );
+		float x = ( this->particleX[ i ] - originX ) * inverse;
+		float y = ( this->particleY[ i ] - originY ) * inverse;
+
+		// End points of all readings, clamped into the field so points off
+		// the map land on its border. No branches, so this runs as SIMD.
+		for ( unsigned int b = 0; b < beams; b++ )
+		{
+			float column = x + c * beamX[ b ] - s * beamY[ b ];
+			float row = y + s * beamX[ b ] + c * beamY[ b ];
+			column = std::min( std::max( column, 0.0f ), lastColumn );
+			row = std::min( std::max( row, 0.0f ), lastRow );
+			index[ b ] = (int) row * width + (int) column;
+		}
+
+		float sum = 0.0;
+		for ( unsigned int b = 0; b < beams; b++ ) sum += field[ index[ b ] ];
+
+		this->logWeight[ i ] += MCL_BEAM_WEIGHT * sum;
+	}
+}
+
+void
+MonteCarloLocalizer::summarize()
+{
+	float best = * std::max_element( this->logWeight.begin(), this->logWeight.begin() + this->count );
+
+	double total = 0.0, sumSquares = 0.0, sumX = 0.0, sumY = 0.0, sumCos = 0.0, sumSin = 0.0;
+	for ( unsigned int i = 0; i < this->count; i++ )
+	{
+		// Keep the best at 0, so the sums over several scans do not run off
+		this->logWeight[ i ] -= best;
+		double weight = exp( this->logWeight[ i ] );
+		total += weight;
+		sumSquares += weight * weight;
+		this->cumulative[ i ] = total;
+		sumX += weight * this->particleX[ i ];
+		sumY += weight * this->particleY[ i ];
+		sumCos += weight * cos( this->particlePhi[ i ] );
+		sumSin += weight * sin( this->particlePhi[ i ] );
+	}
+
+	this->meanX = sumX / total;
+	this->meanY = sumY / total;
+	this->meanPhi = atan2( sumSin, sumCos );
+
+	double varianceX = 0.0, varianceY = 0.0;
+	for ( unsigned int i = 0; i < this->count; i++ )
+	{
+		double weight = exp( this->logWeight[ i ] );
+		varianceX += weight * ( this->particleX[ i ] - this->meanX ) * ( this->particleX[ i ] - this->meanX );
+		varianceY += weight * ( this->particleY[ i ] - this->meanY ) * ( this->particleY[ i ] - this->meanY );
+	}
+	this->deviationXY = sqrt( std::max( varianceX, varianceY ) / total );
+
+	// Circular deviation from the length of the mean heading vector
+	double length = std::min( sqrt( sumCos * sumCos + sumSin * sumSin ) / total, 1.0 );
+	this->deviationPhi = ( length > 0.0 ) ? sqrt( - 2.0 * log( length ) ) : M_PI;
+
+	this->effectiveCount = total * total / sumSquares;
+}
+
+float
+MonteCarloLocalizer::fit()
+{
+	float resolution = this->likelihood.resolution();
+	float c = cos( this->meanPhi ) * resolution, s = sin( this->meanPhi ) * resolution;
+	float limit = this->likelihood.value( MCL_FIT_DISTANCE );
+
+	unsigned int close = 0;
+	for ( unsigned int b = 0; b < this->beams; b++ )
+	{
+		Coordinate point(
+				this->meanX + c * this->beamX[ b ] - s * this->beamY[ b ],
+				this->meanY + s * this->beamX[ b ] + c * this->beamY[ b ] );
+		if ( this->likelihood.value( point ) >= limit ) close++;
+	}
+
+	return (float) close / this->beams;
+}
+
+void
+MonteCarloLocalizer::resample()
+{
+	unsigned int limit = this->budget();
+	std::uniform_real_distribution< float > uniform( 0.0, this->cumulative[ this->count - 1 ] );
+	this->binStamp++;
+
+	unsigned int drawn = 0, bins = 0;
+	while ( drawn < limit )
+	{
+		unsigned int i = std::upper_bound( this->cumulative.begin(), this->cumulative.begin() + this->count,
+				uniform( this->random ) ) - this->cumulative.begin();
+		i = std::min( i, this->count - 1 );
+
+		this->nextX[ drawn ] = this->particleX[ i ];
+		this->nextY[ drawn ] = this->particleY[ i ];
+		this->nextPhi[ drawn ] = atan2( sin( this->particlePhi[ i ] ), cos( this->particlePhi[ i ] ) );
+		drawn++;
+
+		if ( this->occupyBin( this->nextX[ drawn - 1 ], this->nextY[ drawn - 1 ], this->nextPhi[ drawn - 1 ] ) )
+			bins++;
+
+		if ( drawn >= MCL_MIN_PARTICLES && drawn >= MonteCarloLocalizer::kldLimit( bins ) ) break;
+	}
+
+	this->particleX.swap( this->nextX );
+	this->particleY.swap( this->nextY );
+	this->particlePhi.swap( this->nextPhi );
+	this->count = drawn;
+	std::fill( this->logWeight.begin(), this->logWeight.begin() + this->count, 0.0 );
+}
+
+unsigned int
+MonteCarloLocalizer::budget()
+{
+	// Unknown before the first weighing, then as many as fit at the
+	// measured time each
+	if ( this->particleTime <= 0.0 ) return MCL_MAX_PARTICLES;
+
+	float seconds = MCL_BUDGET * BRAIN_LOOP_TIME / 1000.0;
+	unsigned int limit = std::min( (unsigned int) MCL_MAX_PARTICLES, (unsigned int) ( seconds / this->particleTime ) );
+	return std::max( limit, (unsigned int) MCL_MIN_PARTICLES );
+}
+
+bool
+MonteCarloLocalizer::occupyBin( float x, float y, float phi )
+{
+	// Ten bits of each bin index wrap at 200 m and well past a full turn
+	unsigned int key = ( (unsigned int) (int) floor( x / MCL_BIN_SIZE ) & 0x3FF )
+		| ( ( (unsigned int) (int) floor( y / MCL_BIN_SIZE ) & 0x3FF ) << 10 )
+		| ( ( (unsigned int) (int) floor( phi / MCL_BIN_ANGLE ) & 0x3FF ) << 20 );
+
+	// Fibonacci hashing, the high bits of the product are the best mixed
+	unsigned int slot = ( key * 2654435761u ) >> ( 32 - MCL_BIN_BITS );
+	while ( this->binStamps[ slot ] == this->binStamp )
+	{
+		if ( this->binKeys[ slot ] == key + 1 ) return false;
+		slot = ( slot + 1 ) & ( MCL_BIN_TABLE - 1 );
+	}
+
+	this->binStamps[ slot ] = this->binStamp;
+	this->binKeys[ slot ] = key + 1;
+	return true;
+}
+
+unsigned int
+MonteCarloLocalizer::kldLimit( unsigned int bins )
+{
+	if ( bins < 2 ) return 1;
+
+	// Wilson-Hilferty approximation of the chi-square quantile
+	double k = bins - 1;
+	double a = 2.0 / ( 9.0 * k );
+	double b = 1.0 - a + sqrt( a ) * MCL_KLD_QUANTILE;
+	return (unsigned int) ceil( k / ( 2.0 * MCL_KLD_ERROR ) * b * b * b );
+}
@@ -0,0 +1,373 @@
+/**
+ * @file	MonteCarloLocalizer.h
+ * @brief	Header file for the MonteCarloLocalizer class
+ */
+#ifndef MONTECARLOLOCALIZER_H
+#define MONTECARLOLOCALIZER_H
+
+#include "../robotino/headers/Axon.h"
+
+#include "../geometry/AngularCoordinate.h"
+#include "../obstacle/LikelihoodField.h"
+
+#include <vector>
+#include <mutex>
+#include <random>
+
+class Brain;
+
+
+	// Particles
+
+/// Fewest particles kept
+#define MCL_MIN_PARTICLES	100
+/// Most particles kept, all arrays are allocated for this many
+#define MCL_MAX_PARTICLES	10000
+/// Share of BRAIN_LOOP_TIME an update of the particles by a scan may use.
+/// The particle count is capped to what fits, from the measured time per
+/// particle.
+#define MCL_BUDGET	0.3
+/// Error allowed between the particles and the true distribution, the
+/// epsilon of KLD sampling
+#define MCL_KLD_ERROR	0.05
+/// Upper standard normal quantile of the probability the error stays below
+/// MCL_KLD_ERROR, 2.33 is 99 %
+#define MCL_KLD_QUANTILE	2.33
+/// Effective share of particles below which they are resampled. Above it
+/// the weights are carried over to the next scan instead, which keeps
+/// particles from dying out while the cloud is still spread out.
+#define MCL_RESAMPLE_SHARE	0.5
+/// Edge length of a KLD sampling bin, in meters
+#define MCL_BIN_SIZE	0.2
+/// Angle of a KLD sampling bin, in rad
+#define MCL_BIN_ANGLE	0.175
+
+
+	// Motion
+
+/// Deviation added to a particle after driving a meter, in meters. Like
+/// POSEFILTER_TRANSLATION_NOISE the variance grows with the distance.
+#define MCL_TRANSLATION_NOISE	0.1
+/// Deviation added to the heading after turning a rad, in rad
+#define MCL_ROTATION_NOISE	0.1
+/// Deviation added to the heading after driving a meter, in rad
+#define MCL_DRIFT_NOISE	0.05
+/// Distance driven before the particles are weighed again, in meters.
+/// Weighing the same view twice would make the particles overconfident.
+#define MCL_UPDATE_DISTANCE	0.05
+/// Angle turned before the particles are weighed again, in rad
+#define MCL_UPDATE_ANGLE	0.05
+
+
+	// Measurement
+
+/// Number of laser readings used per scan, spread evenly over the scan
+#define MCL_BEAMS	40
+/// Power the likelihood of each reading is raised to. Neighbouring readings
+/// are not independent, below 1 keeps them from counting several times.
+#define MCL_BEAM_WEIGHT	0.1
+
+
+	// Start and convergence
+
+/// Deviation of the particles around a guessed position, in meters
+#define MCL_START_DEVIATION	0.3
+/// Deviation of the particles around a guessed heading, in rad
+#define MCL_START_PHI_DEVIATION	0.3
+/// Deviation of the particle positions below which Robotino counts as
+/// localized, in meters
+#define MCL_CONVERGED_DEVIATION	0.1
+/// Deviation of the particle headings below which Robotino counts as
+/// localized, in rad
+#define MCL_CONVERGED_PHI_DEVIATION	0.1
+/// Number of weighings in a row the deviations must stay below the limits
+/// before the pose is handed to _Odometry, and while tracking before it
+/// corrects the odometry
+#define MCL_CONVERGED_UPDATES	6
+/// Distance from the map within which a reading counts as fitting, in meters
+#define MCL_FIT_DISTANCE	0.2
+/// Share of readings that must fit the map from the converged pose. Below
+/// it the particles settled on a place that only looks alike, and
+/// localization starts over.
+#define MCL_MIN_FIT	0.9
+
+
+/**
+ * Monte Carlo localization against the static map
+ *
+ * After localize() every laser scan weighs a cloud of particles, each a
+ * possible pose of Robotino, by how well the scan fits the map from there.
+ * Between scans the particles move by the odometry, with noise added.
+ * Once the particles agree on a pose for MCL_CONVERGED_UPDATES weighings in
+ * a row, the pose is handed to _Odometry::set().
+ *
+ * Localization then goes on tracking. While the particles agree and the
+ * scan fits, every weighing hands their pose to _Odometry::fixPose(), which
+ * weighs it against the odometry and learns the scale and heading bias of
+ * the wheels from it. The cloud stays small then, so tracking costs little.
+ * A jump of the odometry, like after set(), does not move the particles.
+ *
+ * - The map is turned into a LikelihoodField once per localize(), so
+ *   weighing a reading is one lookup.
+ * - Only MCL_BEAMS readings of each scan are used.
+ * - Particles are kept as separate arrays of x, y and heading. The end
+ *   points of all readings for a particle are found in one branch-free loop
+ *   over arrays, which the compiler turns into SIMD instructions, before
+ *   the lookups are summed.
+ * - Resampling uses KLD sampling: particles are drawn until there are
+ *   enough to cover the ( x, y, heading ) bins they fall in, so a spread out
+ *   cloud keeps many particles and a converged one few. The count is capped
+ *   by MCL_BUDGET, from the measured time per particle.
+ *
+ * The particle arrays are allocated once, for MCL_MAX_PARTICLES, at
+ * construction.
+ *
+ * See @link MonteCarloLocalizer.h @endlink for documentation of @c \#define
+ * parameters
+ */
+class MonteCarloLocalizer : public Axon
+{
+ public:
+	/**
+	 * Constructs MonteCarloLocalizer
+	 *
+	 * @param	pBrain	A pointer to the owner Brain object
+	 */
+	MonteCarloLocalizer( Brain * pBrain );
+
+	/**
+	 * Starts localizing with no idea where Robotino is. Particles are spread
+	 * over all free cells within the bounds of the obstacles in the map.
+	 *
+	 * The next analyze() starts, as the map is read and written on the main
+	 * loop. It tells if the map has no obstacles to localize against.
+	 */
+	void localize();
+
+	/**
+	 * Starts localizing around a guessed pose, like localize()
+	 *
+	 * @param	guess	The guessed position and heading
+	 */
+	void localize( AngularCoordinate guess );
+
+	/**
+	 * Checks if localizing or tracking, or about to start
+	 *
+	 * @return	Boolean indicating if active
+	 */
+	bool isActive();
+
+	/**
+	 * Checks if localized, and correcting the odometry
+	 *
+	 * @return	Boolean indicating if tracking
+	 */
+	bool isTracking();
+
+	/**
+	 * Stops localizing or tracking, leaving _Odometry as it is
+	 */
+	void cancel();
+
+	/**
+	 * Gets the weighted mean of the particles
+	 *
+	 * @return	The estimated position and heading
+	 */
+	AngularCoordinate estimate();
+
+	/**
+	 * Gets the deviation of the particle positions
+	 *
+	 * @return	Square root of the larger variance of x and y, in meters
+	 */
+	float deviation();
+
+	/**
+	 * Gets the number of particles
+	 *
+	 * @return	Number of particles
+	 */
+	unsigned int particles();
+
+	void analyze();
+
+	void apply();
+
+ private:
+	LikelihoodField
+	/// The static map as log-likelihoods of readings
+		likelihood;
+
+	std::mutex
+	/// Guards everything, as localize() is called by other threads
+		localizerMutex;
+
+	bool
+	/// If localize() was called since the last analyze()
+		requested,
+	/// If the request is around @c requestedGuess
+		guessed,
+	/// If localizing or tracking
+		active,
+	/// If localized, handing the pose to _Odometry::fixPose()
+		tracking;
+
+	unsigned int
+	/// Number of particles
+		count,
+	/// Time of the last scan used
+		lastScanTime,
+	/// Weighings in a row the particles have agreed
+		convergedUpdates;
+
+	PreciseAngularCoordinate
+	/// Odometry pose at the last scan used
+		lastPose;
+
+	AngularCoordinate
+	/// Pose guessed by the last localize()
+		requestedGuess;
+
+	float
+	/// Distance and angle moved since the last weighing
+		movedDistance,
+		movedAngle,
+	/// Weighted mean of the particles
+		meanX,
+		meanY,
+		meanPhi,
+	/// Deviation of the particle positions and headings
+		deviationXY,
+		deviationPhi,
+	/// Number of particles carrying the weight, 1 / sum of squared
+	/// normalized weights
+		effectiveCount,
+	/// Measured time to move, weigh and sum up a particle, in seconds
+		particleTime,
+	/// End points of the readings used, in Robotinos frame, in cells
+		beamX[ MCL_BEAMS ],
+		beamY[ MCL_BEAMS ];
+
+	unsigned int
+	/// Number of readings used from the last scan
+		beams;
+
+	std::vector< float >
+	/// Particle poses
+		particleX,
+		particleY,
+		particlePhi,
+	/// Particle poses being drawn by resample()
+		nextX,
+		nextY,
+		nextPhi,
+	/// Log-likelihood of the scans since the last resampling, for each
+	/// particle
+		logWeight,
+	/// Running sum of the normalized weights, for drawing particles
+		cumulative;
+
+	std::vector< int >
+	/// Field index of every reading of a particle
+		cellIndex;
+
+	std::vector< unsigned int >
+	/// Open addressing table of the KLD bins occupied, holds key + 1
+		binKeys,
+	/// The resample() call each bin entry belongs to, so the table need not
+	/// be cleared
+		binStamps;
+
+	unsigned int
+	/// Number of the current resample() call
+		binStamp;
+
+	std::mt19937
+	/// Random number generator for noise and drawing
+		random;
+
+	/**
+	 * Starts localizing as requested by localize()
+	 */
+	void start();
+
+	/**
+	 * Builds the likelihood field and resets the convergence tracking
+	 *
+	 * @return	False if the map has no obstacles
+	 */
+	bool prepare();
+
+	/**
+	 * Spreads as many particles as budget() allows over the free cells
+	 * within the bounds of the obstacles, facing anywhere
+	 */
+	void spread();
+
+	/**
+	 * Moves every particle by an odometry increment, with noise
+	 *
+	 * @param	dx	Distance driven forward
+	 * @param	dy	Distance driven to the left
+	 * @param	dphi	Angle turned
+	 */
+	void predict( float dx, float dy, float dphi );
+
+	/**
+	 * Picks the readings to use from the latest scan
+	 */
+	void selectBeams();
+
+	/**
+	 * Adds the log-likelihood of the selected readings to every particle
+	 */
+	void weigh();
+
+	/**
+	 * Works out the weighted mean, deviation and effective count of the
+	 * particles
+	 */
+	void summarize();
+
+	/**
+	 * Gets how well the selected readings fit the map from the mean pose
+	 *
+	 * @return	Share of readings within MCL_FIT_DISTANCE of an obstacle
+	 */
+	float fit();
+
+	/**
+	 * Draws a new set of particles by their weights, as many as KLD
+	 * sampling asks for
+	 */
+	void resample();
+
+	/**
+	 * Gets the most particles that can be weighed within MCL_BUDGET
+	 *
+	 * @return	The number of particles, from MCL_MIN_PARTICLES to
+	 * MCL_MAX_PARTICLES
+	 */
+	unsigned int budget();
+
+	/**
+	 * Marks the bin of a pose as occupied
+	 *
+	 * @return	True if the bin was empty
+	 */
+	bool occupyBin( float x, float y, float phi );
+
+	/**
+	 * Gets the number of particles KLD sampling needs for a number of
+	 * occupied bins
+	 *
+	 * @param	bins	The number of bins
+	 *
+	 * @return	The number of particles
+	 */
+	static unsigned int kldLimit( unsigned int bins );
+};
+
+#endif
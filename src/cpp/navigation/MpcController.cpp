@@ -0,0 +1,218 @@
+#include "MpcController.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+
+
+MpcController::MpcController()
+{
+	const int n = MPC_HORIZON;
+	const float h = MPC_STEP;
+
+	// Weight of the position after each step, and the sum of the weights
+	// from each step on, which is how much a speed moves the cost
+	float weight[ MPC_HORIZON ], tail[ MPC_HORIZON ];
+	for ( int i = 0; i < n; i++ )
+		weight[ i ] = ( i == n - 1 ) ? MPC_WEIGHT_TERMINAL : MPC_WEIGHT_POSITION;
+	tail[ n - 1 ] = weight[ n - 1 ];
+	for ( int i = n - 2; i >= 0; i-- )
+		tail[ i ] = tail[ i + 1 ] + weight[ i ];
+
+	// P = 2 ( h^2 L'QL + r I + s D'D ), where L sums the speeds into
+	// positions and D takes the differences between steps
+	for ( int a = 0; a < n; a++ )
+	{
+		this->positionGradient[ a ] = 2.0 * h * tail[ a ];
+
+		for ( int b = 0; b < n; b++ )
+		{
+			float p = h * h * tail[ std::max( a, b ) ];
+			if ( a == b ) p += MPC_WEIGHT_SPEED + MPC_WEIGHT_CHANGE * ( ( a == n - 1 ) ? 1.0 : 2.0 );
+			if ( abs( a - b ) == 1 ) p -= MPC_WEIGHT_CHANGE;
+			this->cost[ a * n + b ] = 2.0 * p;
+		}
+	}
+
+	// K = P + sigma I + rho A'A, with A = [ I; D ]
+	float k[ MPC_HORIZON * MPC_HORIZON ];
+	for ( int a = 0; a < n; a++ )
+	{
+		for ( int b = 0; b < n; b++ )
+		{
+			float value = this->cost[ a * n + b ];
+			if ( a == b ) value += MPC_SIGMA + MPC_RHO * ( 1.0 + ( ( a == n - 1 ) ? 1.0 : 2.0 ) );
+			if ( abs( a - b ) == 1 ) value -= MPC_RHO;
+			k[ a * n + b ] = value;
+		}
+	}
+
+	// Cholesky, K = factor factor'
+	std::fill( this->factor, this->factor + n * n, 0.0f );
+	for ( int j = 0; j < n; j++ )
+	{
+		float sum = k[ j * n + j ];
+		for ( int i = 0; i < j; i++ ) sum -= this->factor[ j * n + i ] * this->factor[ j * n + i ];
+		this->factor[ j * n + j ] = sqrt( sum );
+
+		for ( int r = j + 1; r < n; r++ )
+		{
+			float value = k[ r * n + j ];
+			for ( int i = 0; i < j; i++ ) value -= this->factor[ r * n + i ] * this->factor[ j * n + i ];
+			this->factor[ r * n + j ] = value / this->factor[ j * n + j ];
+		}
+	}
+
+	this->reset();
+}
+
+void
+MpcController::reset()
+{
+	for ( int axis = 0; axis < 3; axis++ )
+	{
+		std::fill( this->warmX[ axis ], this->warmX[ axis ] + MPC_HORIZON, 0.0f );
+		std::fill( this->warmZ[ axis ], this->warmZ[ axis ] + 2 * MPC_HORIZON, 0.0f );
+		std::fill( this->warmY[ axis ], this->warmY[ axis ] + 2 * MPC_HORIZON, 0.0f );
+	}
+	this->_iterations = 0;
+}
+
+bool
+MpcController::control( const float * error, const float * current, const float * maxSpeed,
+		const float * maxAccelleration, float budget, float * speed )
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	bool converged = true;
+	this->_iterations = 0;
+
+	for ( unsigned int axis = 0; axis < 3; axis++ )
+	{
+		// Each axis gets its share of the budget, and what earlier axes
+		// left over
+		std::chrono::steady_clock::time_point deadline = start
+			+ std::chrono::microseconds( (long) ( budget * 1.0e6 * ( axis + 1 ) / 3 ) );
+
+		float maxChange = maxAccelleration[ axis ] * MPC_STEP;
+		if ( ! this->solve( axis, error[ axis ], current[ axis ], maxSpeed[ axis ], maxChange, deadline ) )
+			converged = false;
+
+		// The first speed, within the bounds even if not converged. The
+		// speed bound wins if they disagree.
+		float value = this->warmX[ axis ][ 0 ];
+		value = std::max( current[ axis ] - maxChange, std::min( current[ axis ] + maxChange, value ) );
+		speed[ axis ] = std::max( - maxSpeed[ axis ], std::min( maxSpeed[ axis ], value ) );
+	}
+
+	return converged;
+}
+
+unsigned int
+MpcController::iterations()
+{
+	return this->_iterations;
+}
+
+
+// Private functions
+
+bool
+MpcController::solve( unsigned int axis, float error, float current, float maxSpeed, float maxChange,
+		std::chrono::steady_clock::time_point deadline )
+{
+	const int n = MPC_HORIZON;
+	float * x = this->warmX[ axis ];
+	float * z = this->warmZ[ axis ];
+	float * y = this->warmY[ axis ];
+
+	// Warm start from the last solution, one step on
+	for ( int i = 0; i + 1 < n; i++ )
+	{
+		x[ i ] = x[ i + 1 ];
+		z[ i ] = z[ i + 1 ];
+		y[ i ] = y[ i + 1 ];
+		z[ n + i ] = z[ n + i + 1 ];
+		y[ n + i ] = y[ n + i + 1 ];
+	}
+
+	// Linear cost, the first change of speed is from the current speed
+	float q[ MPC_HORIZON ];
+	for ( int i = 0; i < n; i++ ) q[ i ] = this->positionGradient[ i ] * error;
+	q[ 0 ] -= 2.0 * MPC_WEIGHT_CHANGE * current;
+
+	// Bounds of A x: speeds, then changes of speed
+	float lower[ 2 * MPC_HORIZON ], upper[ 2 * MPC_HORIZON ];
+	for ( int i = 0; i < n; i++ )
+	{
+		lower[ i ] = - maxSpeed;
+		upper[ i ] = maxSpeed;
+		lower[ n + i ] = - maxChange;
+		upper[ n + i ] = maxChange;
+	}
+	lower[ n ] += current;
+	upper[ n ] += current;
+
+	float rhs[ MPC_HORIZON ], v[ 2 * MPC_HORIZON ];
+	for ( int iteration = 0; iteration < MPC_MAX_ITERATIONS; iteration++ )
+	{
+		if ( std::chrono::steady_clock::now() >= deadline ) return false;
+		this->_iterations++;
+
+		// x~ = K^-1 ( sigma x - q + A' ( rho z - y ) )
+		for ( int i = 0; i < 2 * n; i++ ) v[ i ] = MPC_RHO * z[ i ] - y[ i ];
+		for ( int i = 0; i < n; i++ )
+			rhs[ i ] = MPC_SIGMA * x[ i ] - q[ i ] + v[ i ] + v[ n + i ] - ( ( i + 1 < n ) ? v[ n + i + 1 ] : 0.0f );
+		this->backSubstitute( rhs );
+
+		// Relaxed update of x, then z projected on the bounds, then the duals
+		float primal = 0.0;
+		for ( int i = 0; i < 2 * n; i++ )
+		{
+			float ax = ( i < n ) ? rhs[ i ] : rhs[ i - n ] - ( ( i > n ) ? rhs[ i - n - 1 ] : 0.0f );
+			float relaxed = MPC_ALPHA * ax + ( 1.0 - MPC_ALPHA ) * z[ i ];
+			float projected = std::max( lower[ i ], std::min( upper[ i ], (float) ( relaxed + y[ i ] / MPC_RHO ) ) );
+			y[ i ] += MPC_RHO * ( relaxed - projected );
+			z[ i ] = projected;
+		}
+		for ( int i = 0; i < n; i++ )
+			x[ i ] = MPC_ALPHA * rhs[ i ] + ( 1.0 - MPC_ALPHA ) * x[ i ];
+
+		// Residuals, || A x - z || and || P x + q + A' y ||
+		for ( int i = 0; i < 2 * n; i++ )
+		{
+			float ax = ( i < n ) ? x[ i ] : x[ i - n ] - ( ( i > n ) ? x[ i - n - 1 ] : 0.0f );
+			primal = std::max( primal, (float) fabs( ax - z[ i ] ) );
+		}
+
+		float dual = 0.0;
+		for ( int i = 0; i < n; i++ )
+		{
+			float value = q[ i ] + y[ i ] + y[ n + i ] - ( ( i + 1 < n ) ? y[ n + i + 1 ] : 0.0f );
+			for ( int j = 0; j < n; j++ ) value += this->cost[ i * n + j ] * x[ j ];
+			dual = std::max( dual, (float) fabs( value ) );
+		}
+
+		if ( primal < MPC_TOLERANCE && dual < MPC_TOLERANCE ) return true;
+	}
+
+	return false;
+}
+
+void
+MpcController::backSubstitute( float * b )
+{
+	const int n = MPC_HORIZON;
+
+	for ( int i = 0; i < n; i++ )
+	{
+		for ( int j = 0; j < i; j++ ) b[ i ] -= this->factor[ i * n + j ] * b[ j ];
+		b[ i ] /= this->factor[ i * n + i ];
+	}
+
+	for ( int i = n - 1; i >= 0; i-- )
+	{
+		for ( int j = i + 1; j < n; j++ ) b[ i ] -= this->factor[ j * n + i ] * b[ j ];
+		b[ i ] /= this->factor[ i * n + i ];
+	}
+}
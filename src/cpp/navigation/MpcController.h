@@ -0,0 +1,157 @@
+/**
+ * @file	MpcController.h
+ * @brief	Header file for the MpcController class
+ */
+#ifndef MPCCONTROLLER_H
+#define MPCCONTROLLER_H
+
+#include <chrono>
+
+
+	// Model
+
+/// Number of steps predicted
+#define MPC_HORIZON	20
+/// Duration of a predicted step, in seconds. Matches BRAIN_LOOP_TIME, so the
+/// first step is the cycle the command is driven for.
+#define MPC_STEP	0.05
+
+
+	// Cost
+
+/// Weight of the distance to the goal at every step
+#define MPC_WEIGHT_POSITION	1.0
+/// Weight of the distance to the goal at the last step
+#define MPC_WEIGHT_TERMINAL	10.0
+/// Weight of the speed at every step
+#define MPC_WEIGHT_SPEED	0.05
+/// Weight of the change in speed between steps
+#define MPC_WEIGHT_CHANGE	0.1
+
+
+	// Solver
+
+/// Penalty parameter of the ADMM iterations
+#define MPC_RHO	1.0
+/// Regularization of the ADMM iterations
+#define MPC_SIGMA	1.0e-6
+/// Relaxation of the ADMM iterations
+#define MPC_ALPHA	1.6
+/// Residual at which a solution is accepted
+#define MPC_TOLERANCE	1.0e-4
+/// The most iterations done for one axis in one cycle
+#define MPC_MAX_ITERATIONS	100
+
+
+/**
+ * Model predictive controller for the holonomic drive
+ *
+ * Every cycle the speeds for the next MPC_HORIZON steps are optimized for
+ * each of x, y and heading in the world frame. The cost is the weighted
+ * squared distance to the goal along the way, the speeds, and the changes
+ * of speed. Speeds are bounded, and so is the change between steps, which
+ * makes it an accelleration bound. The first speed is then driven for a
+ * cycle, and the next cycle starts over from where Robotino got to.
+ *
+ * An axis moving at constant speed over a step is a linear model, so the
+ * problem is a quadratic program of MPC_HORIZON variables per axis. It is
+ * solved with ADMM iterations on fixed-size arrays:
+ * - The matrix to factor only depends on the weights, so its Cholesky
+ *   factor is worked out once in the constructor and every iteration is
+ *   two triangular solves.
+ * - Every solve is warm started from the previous solution, shifted one
+ *   step ahead, so few iterations are needed in steady motion.
+ * - Iterations stop at a deadline. The speed returned is always projected
+ *   onto the bounds, so an early stop gives a less optimal but still
+ *   admissible command.
+ *
+ * The wheel limits are not part of the program. _OmniDrive scales the
+ * command with OmniKinematics::saturate() afterwards.
+ *
+ * See @link MpcController.h @endlink for documentation of @c \#define
+ * parameters
+ */
+class MpcController
+{
+ public:
+	/**
+	 * Constructs MpcController and factors the system matrix
+	 */
+	MpcController();
+
+	/**
+	 * Forgets the warm starts, for when the goal or the motion changed
+	 * abruptly
+	 */
+	void reset();
+
+	/**
+	 * Calculates the speeds to drive at for the next cycle
+	 *
+	 * @param	error	Position minus goal for x, y and heading, in the world
+	 * frame, with the heading difference wrapped to [ -pi, pi ]
+	 * @param	current	Speeds driven in the last cycle, x, y and omega in the
+	 * world frame
+	 * @param	maxSpeed	Speed bound for x, y and omega
+	 * @param	maxAccelleration	Accelleration bound for x, y and omega
+	 * @param	budget	Time allowed for the calculation, in seconds
+	 * @param	speed	Set to the speeds, x, y and omega in the world frame
+	 *
+	 * @return	False if the deadline or MPC_MAX_ITERATIONS stopped the
+	 * iterations before the tolerance was reached
+	 */
+	bool control( const float * error, const float * current, const float * maxSpeed,
+			const float * maxAccelleration, float budget, float * speed );
+
+	/**
+	 * Gets the number of iterations used by the last call to control()
+	 *
+	 * @return	Iterations, summed over the axes
+	 */
+	unsigned int iterations();
+
+ private:
+	float
+	/// Cholesky factor of P + sigma I + rho A'A, lower triangle, row major
+		factor[ MPC_HORIZON * MPC_HORIZON ],
+	/// The quadratic cost matrix P, row major
+		cost[ MPC_HORIZON * MPC_HORIZON ],
+	/// Linear cost of the position error, per meter of error
+		positionGradient[ MPC_HORIZON ],
+	/// Warm start speeds for each axis
+		warmX[ 3 ][ MPC_HORIZON ],
+	/// Warm start constraint values for each axis
+		warmZ[ 3 ][ 2 * MPC_HORIZON ],
+	/// Warm start dual values for each axis
+		warmY[ 3 ][ 2 * MPC_HORIZON ];
+
+	unsigned int
+	/// Iterations used by the last call to control()
+		_iterations;
+
+	/**
+	 * Solves the program for one axis, starting from and updating its warm
+	 * start
+	 *
+	 * @param	axis	0 for x, 1 for y and 2 for heading
+	 * @param	error	Position minus goal
+	 * @param	current	The speed driven in the last cycle
+	 * @param	maxSpeed	Speed bound
+	 * @param	maxChange	Bound of the change in speed over a step
+	 * @param	deadline	Time to stop iterating at
+	 *
+	 * @return	False if stopped by the deadline or MPC_MAX_ITERATIONS
+	 * before converging
+	 */
+	bool solve( unsigned int axis, float error, float current, float maxSpeed, float maxChange,
+			std::chrono::steady_clock::time_point deadline );
+
+	/**
+	 * Solves factor * factor' * x = b in place
+	 *
+	 * @param	b	Right hand side, set to the solution
+	 */
+	void backSubstitute( float * b );
+};
+
+#endif
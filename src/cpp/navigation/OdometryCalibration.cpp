@@ -0,0 +1,233 @@
+#include "OdometryCalibration.h"
+
+#include <fstream>
+#include <iomanip>
+#include <math.h>
+
+
+OdometryCalibration::OdometryCalibration()
+{
+	this->reset();
+}
+
+void
+OdometryCalibration::reset()
+{
+	this->scaleParameters[ 0 ] = 1.0;
+	this->scaleParameters[ 1 ] = 0.0;
+	this->turnParameters[ 0 ] = 0.0;
+	this->turnParameters[ 1 ] = 0.0;
+
+	for ( unsigned int i = 0; i < 4; i++ )
+	{
+		this->scaleCovariance[ i ] = ( i % 3 == 0 ) ? ODOMETRYCALIBRATION_INITIAL_VARIANCE : 0.0;
+		this->turnCovariance[ i ] = ( i % 3 == 0 ) ? ODOMETRYCALIBRATION_INITIAL_VARIANCE : 0.0;
+	}
+
+	this->anchored = false;
+	this->abandon();
+}
+
+void
+OdometryCalibration::correct( double & dx, double & dy, double & dphi, float speed )
+{
+	double length = sqrt( dx * dx + dy * dy );
+	double scale = this->scale( speed );
+
+	dx *= scale;
+	dy *= scale;
+	dphi += this->turnParameters[ 0 ] * dphi + this->turnParameters[ 1 ] * length;
+}
+
+void
+OdometryCalibration::accumulate( double dx, double dy, double dphi, double heading, float speed )
+{
+	double c = cos( heading ), s = sin( heading );
+	double worldX = c * dx - s * dy;
+	double worldY = s * dx + c * dy;
+
+	this->sumX += worldX;
+	this->sumY += worldY;
+	this->speedX += worldX * speed;
+	this->speedY += worldY * speed;
+	this->turn += dphi;
+	this->length += sqrt( dx * dx + dy * dy );
+}
+
+bool
+OdometryCalibration::fixPosition( double x, double y )
+{
+	return this->fix( x, y, 0.0, false );
+}
+
+bool
+OdometryCalibration::fixPose( double x, double y, double phi )
+{
+	return this->fix( x, y, phi, true );
+}
+
+void
+OdometryCalibration::abandon()
+{
+	this->sumX = 0.0;
+	this->sumY = 0.0;
+	this->speedX = 0.0;
+	this->speedY = 0.0;
+	this->turn = 0.0;
+	this->length = 0.0;
+	this->anchored = false;
+}
+
+bool
+OdometryCalibration::load( const char * fileName )
+{
+	std::ifstream file( fileName );
+	double values[ 12 ];
+	for ( unsigned int i = 0; i < 12; i++ ) file >> values[ i ];
+	if ( ! file ) return false;
+
+	// A scale far off means a broken file, not a learned odometry
+	if ( values[ 0 ] < 0.5 || values[ 0 ] > 1.5 ) return false;
+
+	for ( unsigned int i = 0; i < 2; i++ )
+	{
+		this->scaleParameters[ i ] = values[ i ];
+		this->turnParameters[ i ] = values[ 2 + i ];
+	}
+	for ( unsigned int i = 0; i < 4; i++ )
+	{
+		this->scaleCovariance[ i ] = values[ 4 + i ];
+		this->turnCovariance[ i ] = values[ 8 + i ];
+	}
+	return true;
+}
+
+bool
+OdometryCalibration::save( const char * fileName )
+{
+	std::ofstream file( fileName );
+	file << std::setprecision( 12 )
+		<< this->scaleParameters[ 0 ] << ' ' << this->scaleParameters[ 1 ] << ' '
+		<< this->turnParameters[ 0 ] << ' ' << this->turnParameters[ 1 ] << '\n';
+	for ( unsigned int i = 0; i < 4; i++ ) file << this->scaleCovariance[ i ] << ' ';
+	for ( unsigned int i = 0; i < 4; i++ ) file << this->turnCovariance[ i ] << ' ';
+	file << std::endl;
+
+	return (bool) file;
+}
+
+float
+OdometryCalibration::scale( float speed )
+{
+	return this->scaleParameters[ 0 ] + this->scaleParameters[ 1 ] * speed;
+}
+
+float
+OdometryCalibration::drift()
+{
+	return this->turnParameters[ 1 ];
+}
+
+// Private functions
+
+bool
+OdometryCalibration::fix( double x, double y, double phi, bool hasPhi )
+{
+	bool learned = false;
+
+	if ( this->anchored && this->length <= ODOMETRYCALIBRATION_MAX_MOTION
+			&& fabs( this->turn ) <= ODOMETRYCALIBRATION_MAX_MOTION )
+	{
+		// Driven distance is a * |sum| + b * the speed weighted sum along
+		// it. Lengths are compared, so a heading error does not pass for a
+		// scale error.
+		double distance = sqrt( this->sumX * this->sumX + this->sumY * this->sumY );
+		if ( distance >= ODOMETRYCALIBRATION_MIN_DISTANCE )
+		{
+			double measured = sqrt( ( x - this->anchorX ) * ( x - this->anchorX ) + ( y - this->anchorY ) * ( y - this->anchorY ) );
+			const double regressor[ 2 ] = {
+				distance,
+				( this->speedX * this->sumX + this->speedY * this->sumY ) / distance };
+			double predicted = this->scaleParameters[ 0 ] * regressor[ 0 ] + this->scaleParameters[ 1 ] * regressor[ 1 ];
+
+			if ( fabs( measured - predicted ) <= ODOMETRYCALIBRATION_MAX_RESIDUAL )
+			{
+				OdometryCalibration::forget( this->scaleCovariance );
+				OdometryCalibration::update( this->scaleParameters, this->scaleCovariance, regressor, measured );
+				learned = true;
+			}
+		}
+
+		// The heading missed by c * turn + d * distance
+		if ( hasPhi && this->anchorHasPhi && this->length + fabs( this->turn ) >= ODOMETRYCALIBRATION_MIN_MOTION )
+		{
+			double missed = phi - this->anchorPhi - this->turn;
+			missed = atan2( sin( missed ), cos( missed ) );
+			const double regressor[ 2 ] = { this->turn, this->length };
+			double predicted = this->turnParameters[ 0 ] * regressor[ 0 ] + this->turnParameters[ 1 ] * regressor[ 1 ];
+
+			if ( fabs( missed - predicted ) <= ODOMETRYCALIBRATION_MAX_RESIDUAL )
+			{
+				OdometryCalibration::forget( this->turnCovariance );
+				OdometryCalibration::update( this->turnParameters, this->turnCovariance, regressor, missed );
+				learned = true;
+			}
+		}
+	}
+
+	this->anchor( x, y, phi, hasPhi );
+	return learned;
+}
+
+void
+OdometryCalibration::anchor( double x, double y, double phi, bool hasPhi )
+{
+	this->abandon();
+	this->anchorX = x;
+	this->anchorY = y;
+	this->anchorPhi = phi;
+	this->anchorHasPhi = hasPhi;
+	this->anchored = true;
+}
+
+void
+OdometryCalibration::update( double * parameters, double * covariance, const double * regressor, double target )
+{
+	// Gain k = P r / ( noise + r' P r )
+	double pr[ 2 ] = {
+		covariance[ 0 ] * regressor[ 0 ] + covariance[ 1 ] * regressor[ 1 ],
+		covariance[ 2 ] * regressor[ 0 ] + covariance[ 3 ] * regressor[ 1 ] };
+	double denominator = ODOMETRYCALIBRATION_NOISE * ODOMETRYCALIBRATION_NOISE
+		+ regressor[ 0 ] * pr[ 0 ] + regressor[ 1 ] * pr[ 1 ];
+	double gain[ 2 ] = { pr[ 0 ] / denominator, pr[ 1 ] / denominator };
+
+	double error = target - ( regressor[ 0 ] * parameters[ 0 ] + regressor[ 1 ] * parameters[ 1 ] );
+	parameters[ 0 ] += gain[ 0 ] * error;
+	parameters[ 1 ] += gain[ 1 ] * error;
+
+	// P -= k r' P, kept symmetric
+	covariance[ 0 ] -= gain[ 0 ] * pr[ 0 ];
+	covariance[ 1 ] -= gain[ 0 ] * pr[ 1 ];
+	covariance[ 3 ] -= gain[ 1 ] * pr[ 1 ];
+	covariance[ 2 ] = covariance[ 1 ];
+}
+
+void
+OdometryCalibration::forget( double * covariance )
+{
+	for ( unsigned int i = 0; i < 4; i++ ) covariance[ i ] /= ODOMETRYCALIBRATION_FORGETTING;
+
+	// Without motion teaching anything the covariance would grow without
+	// bound, and the next segment would throw the parameters around
+	for ( unsigned int i = 0; i < 2; i++ )
+	{
+		double diagonal = covariance[ i * 3 ];
+		if ( diagonal <= ODOMETRYCALIBRATION_INITIAL_VARIANCE ) continue;
+
+		double factor = sqrt( ODOMETRYCALIBRATION_INITIAL_VARIANCE / diagonal );
+		covariance[ i * 2 + 0 ] *= factor;
+		covariance[ 0 * 2 + i ] *= factor;
+		covariance[ i * 2 + 1 ] *= factor;
+		covariance[ 1 * 2 + i ] *= factor;
+	}
+}
@@ -0,0 +1,206 @@
+/**
+ * @file	OdometryCalibration.h
+ * @brief	Header file for the OdometryCalibration class
+ */
+#ifndef ODOMETRYCALIBRATION_H
+#define ODOMETRYCALIBRATION_H
+
+
+/// Weight kept by older segments for every new one. Lower values follow
+/// changes, like a new floor, faster but are noisier.
+#define ODOMETRYCALIBRATION_FORGETTING	0.995
+/// Variance of the parameters when nothing is learned yet, and the most they
+/// may grow to when Robotino does not move in ways that teach anything
+#define ODOMETRYCALIBRATION_INITIAL_VARIANCE	0.1
+/// Shortest distance between two fixes to learn the scale from, in meters
+#define ODOMETRYCALIBRATION_MIN_DISTANCE	0.3
+/// Least driving or turning between two fixes to learn the heading from, in
+/// meters plus rad
+#define ODOMETRYCALIBRATION_MIN_MOTION	0.5
+/// Longest distance or turn between two fixes, longer segments are dropped as
+/// the fixes are too far apart to pair
+#define ODOMETRYCALIBRATION_MAX_MOTION	5.0
+/// Deviation of the motion between two fixes, in meters or rad, from the
+/// deviation of the fixes
+#define ODOMETRYCALIBRATION_NOISE	0.05
+/// Largest difference between the motion measured by two fixes and the
+/// motion predicted, in meters or rad. Larger differences are taken as a bad
+/// fix and not learned from.
+#define ODOMETRYCALIBRATION_MAX_RESIDUAL	0.15
+
+
+/**
+ * Online calibration of Robotinos odometry
+ *
+ * Learns how far and how much Robotino really moves for what the odometry
+ * reports, from pairs of absolute fixes and the odometry in between:
+ * - The scale of driving is a + b * speed, as the wheels slip more at speed.
+ * - The heading error is c * turn + d * distance, the rotation reading too
+ *   much or too little, and drift while driving.
+ *
+ * Both are linear in their parameters, so they are learned by recursive
+ * least squares with forgetting. Every reading costs a few additions in
+ * accumulate(), and every fix a 2 by 2 update. The parameters can be saved
+ * and loaded, so what is learned survives a restart.
+ *
+ * See @link OdometryCalibration.h @endlink for documentation of @c \#define
+ * parameters
+ */
+class OdometryCalibration
+{
+ public:
+	/**
+	 * Constructs OdometryCalibration, with the odometry taken as right
+	 */
+	OdometryCalibration();
+
+	/**
+	 * Forgets everything learned
+	 */
+	void reset();
+
+	/**
+	 * Corrects an odometry increment by what is learned
+	 *
+	 * @param	dx	Forward distance, corrected
+	 * @param	dy	Leftward distance, corrected
+	 * @param	dphi	Turn, corrected
+	 * @param	speed	Speed during the increment, in m/s
+	 */
+	void correct( double & dx, double & dy, double & dphi, float speed );
+
+	/**
+	 * Adds an uncorrected odometry increment to the motion since the last fix
+	 *
+	 * @param	dx	Forward distance
+	 * @param	dy	Leftward distance
+	 * @param	dphi	Turn
+	 * @param	heading	Heading at the start of the increment
+	 * @param	speed	Speed during the increment, in m/s
+	 */
+	void accumulate( double dx, double dy, double dphi, double heading, float speed );
+
+	/**
+	 * Learns from a position fix, if there was one before to pair it with
+	 *
+	 * @param	x	Fixed x value, now
+	 * @param	y	Fixed y value, now
+	 *
+	 * @return	True if the parameters changed
+	 */
+	bool fixPosition( double x, double y );
+
+	/**
+	 * Learns from a position and heading fix, like fixPosition()
+	 *
+	 * @param	x	Fixed x value, now
+	 * @param	y	Fixed y value, now
+	 * @param	phi	Fixed heading, now
+	 *
+	 * @return	True if the parameters changed
+	 */
+	bool fixPose( double x, double y, double phi );
+
+	/**
+	 * Drops the motion since the last fix, for when the pose jumped
+	 */
+	void abandon();
+
+	/**
+	 * Loads parameters saved by save()
+	 *
+	 * @param	fileName	The file to read
+	 *
+	 * @return	False if there was no valid file, the parameters are then
+	 * unchanged
+	 */
+	bool load( const char * fileName );
+
+	/**
+	 * Saves the parameters
+	 *
+	 * @param	fileName	The file to write
+	 *
+	 * @return	False if it could not be written
+	 */
+	bool save( const char * fileName );
+
+	/**
+	 * Gets the scale of driving at a speed
+	 *
+	 * @param	speed	The speed, in m/s
+	 *
+	 * @return	Real distance per distance read
+	 */
+	float scale( float speed );
+
+	/**
+	 * Gets the heading drift while driving
+	 *
+	 * @return	Heading error per meter driven, in rad
+	 */
+	float drift();
+
+ private:
+	double
+	/// Scale a and speed dependency b
+		scaleParameters[ 2 ],
+	/// Covariance of scaleParameters, row major
+		scaleCovariance[ 2 * 2 ],
+	/// Turn scale error c and drift d
+		turnParameters[ 2 ],
+	/// Covariance of turnParameters, row major
+		turnCovariance[ 2 * 2 ],
+	/// Sum of the increments since the last fix, in the world frame
+		sumX,
+		sumY,
+	/// Sum of the increments times their speed, in the world frame
+		speedX,
+		speedY,
+	/// Sum of the turns since the last fix
+		turn,
+	/// Sum of the distances since the last fix
+		length,
+	/// The last fix
+		anchorX,
+		anchorY,
+		anchorPhi;
+
+	bool
+	/// If there is a fix to pair the next one with
+		anchored,
+	/// If that fix has a heading
+		anchorHasPhi;
+
+	/**
+	 * Learns from the fix, then makes it the new anchor
+	 *
+	 * @return	True if the parameters changed
+	 */
+	bool fix( double x, double y, double phi, bool hasPhi );
+
+	/**
+	 * Starts counting motion from a new fix
+	 */
+	void anchor( double x, double y, double phi, bool hasPhi );
+
+	/**
+	 * Does one recursive least squares step for target = regressor * parameters
+	 *
+	 * @param	parameters	The two parameters, updated
+	 * @param	covariance	Their covariance, updated
+	 * @param	regressor	The two regressors
+	 * @param	target	The measured value
+	 */
+	static void update( double * parameters, double * covariance, const double * regressor, double target );
+
+	/**
+	 * Applies the forgetting factor, without letting the covariance grow
+	 * past ODOMETRYCALIBRATION_INITIAL_VARIANCE
+	 *
+	 * @param	covariance	The covariance, updated
+	 */
+	static void forget( double * covariance );
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "OmniKinematics.h"
+
+#ifndef _USE_MATH_DEFINES
+#define _USE_MATH_DEFINES
+#endif
+#include <math.h>
+
+
+OmniKinematics::OmniKinematics()
+{
+	const float angles[ OMNIKINEMATICS_WHEELS ] = { 150.0, 270.0, 30.0 };
+	for ( unsigned int i = 0; i < OMNIKINEMATICS_WHEELS; i++ )
+	{
+		this->directionX[ i ] = cos( angles[ i ] * M_PI / 180.0 );
+		this->directionY[ i ] = sin( angles[ i ] * M_PI / 180.0 );
+	}
+
+	this->_maxWheelSpeed = OmniKinematics::wheelSpeed( OMNIKINEMATICS_MAX_MOTOR_SPEED );
+}
+
+void
+OmniKinematics::inverse( float xSpeed, float ySpeed, float omega, float * wheelSpeeds )
+{
+	for ( unsigned int i = 0; i < OMNIKINEMATICS_WHEELS; i++ )
+		wheelSpeeds[ i ] = this->directionX[ i ] * xSpeed + this->directionY[ i ] * ySpeed
+			+ OMNIKINEMATICS_ROBOT_RADIUS * omega;
+}
+
+void
+OmniKinematics::forward( const float * wheelSpeeds, float * xSpeed, float * ySpeed, float * omega )
+{
+	// The driving directions are 120 degrees apart, so the inverse is the
+	// transpose scaled by 2 / 3, and the rotation is the mean wheel speed
+	float x = 0.0, y = 0.0, sum = 0.0;
+	for ( unsigned int i = 0; i < OMNIKINEMATICS_WHEELS; i++ )
+	{
+		x += this->directionX[ i ] * wheelSpeeds[ i ];
+		y += this->directionY[ i ] * wheelSpeeds[ i ];
+		sum += wheelSpeeds[ i ];
+	}
+
+	* xSpeed = x * 2.0 / OMNIKINEMATICS_WHEELS;
+	* ySpeed = y * 2.0 / OMNIKINEMATICS_WHEELS;
+	* omega = sum / ( OMNIKINEMATICS_WHEELS * OMNIKINEMATICS_ROBOT_RADIUS );
+}
+
+float
+OmniKinematics::saturate( float & xSpeed, float & ySpeed, float & omega )
+{
+	float wheelSpeeds[ OMNIKINEMATICS_WHEELS ];
+	this->inverse( xSpeed, ySpeed, omega, wheelSpeeds );
+
+	float fastest = 0.0;
+	for ( unsigned int i = 0; i < OMNIKINEMATICS_WHEELS; i++ )
+		if ( fabs( wheelSpeeds[ i ] ) > fastest ) fastest = fabs( wheelSpeeds[ i ] );
+
+	if ( fastest <= this->_maxWheelSpeed ) return 1.0;
+
+	float factor = this->_maxWheelSpeed / fastest;
+	xSpeed *= factor;
+	ySpeed *= factor;
+	omega *= factor;
+
+	return factor;
+}
+
+float
+OmniKinematics::wheelSpeed( float rpm )
+{
+	return rpm / OMNIKINEMATICS_GEAR * 2.0 * M_PI * OMNIKINEMATICS_WHEEL_RADIUS / 60.0;
+}
+
+float
+OmniKinematics::maxWheelSpeed()
+{
+	return this->_maxWheelSpeed;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file	OmniKinematics.h
+ * @brief	Header file for the OmniKinematics class
+ */
+#ifndef OMNIKINEMATICS_H
+#define OMNIKINEMATICS_H
+
+
+/// Number of wheels of the drive
+#define OMNIKINEMATICS_WHEELS	3
+/// Distance from the center of Robotino to the wheels, in meters
+#define OMNIKINEMATICS_ROBOT_RADIUS	0.125
+/// Radius of the wheels, in meters
+#define OMNIKINEMATICS_WHEEL_RADIUS	0.04
+/// Gear ratio between motor and wheel
+#define OMNIKINEMATICS_GEAR	16.0
+/// The highest motor speed commanded, in rpm. Robotinos motors reach about
+/// 3600 rpm, this leaves a margin for the motor controllers to regulate.
+#define OMNIKINEMATICS_MAX_MOTOR_SPEED	3000.0
+
+
+/**
+ * Kinematics of Robotinos three wheel omnidirectional drive
+ *
+ * The wheels are mounted OMNIKINEMATICS_ROBOT_RADIUS from the center, driving
+ * in the directions 150, 270 and 30 degrees from the x axis. The speed of a
+ * wheel along its driving direction is the robot speed projected onto that
+ * direction plus the rotation times the radius.
+ *
+ * Speeds of Robotino are in m/s and rad/s in its own frame, wheel speeds are
+ * in m/s at the rim.
+ *
+ * See @link OmniKinematics.h @endlink for documentation of @c \#define
+ * parameters
+ */
+class OmniKinematics
+{
+ public:
+	OmniKinematics();
+
+	/**
+	 * Calculates the wheel speeds needed for a movement
+	 *
+	 * @param	xSpeed	Speed in x direction
+	 * @param	ySpeed	Speed in y direction
+	 * @param	omega	Rotation speed
+	 * @param	wheelSpeeds	Set to the speed of each wheel
+	 */
+	void inverse( float xSpeed, float ySpeed, float omega, float * wheelSpeeds );
+
+	/**
+	 * Calculates the movement resulting from wheel speeds
+	 *
+	 * @param	wheelSpeeds	The speed of each wheel
+	 * @param	xSpeed	Set to the speed in x direction
+	 * @param	ySpeed	Set to the speed in y direction
+	 * @param	omega	Set to the rotation speed
+	 */
+	void forward( const float * wheelSpeeds, float * xSpeed, float * ySpeed, float * omega );
+
+	/**
+	 * Scales a movement down uniformly until no wheel exceeds its top
+	 * speed, keeping the direction of both driving and turning
+	 *
+	 * @param	xSpeed	Speed in x direction, scaled
+	 * @param	ySpeed	Speed in y direction, scaled
+	 * @param	omega	Rotation speed, scaled
+	 *
+	 * @return	The factor applied, 1 if no wheel was saturated
+	 */
+	float saturate( float & xSpeed, float & ySpeed, float & omega );
+
+	/**
+	 * Converts a motor speed to a wheel speed
+	 *
+	 * @param	rpm	Motor speed, in rpm
+	 *
+	 * @return	Speed of the wheel at the rim, in m/s
+	 */
+	static float wheelSpeed( float rpm );
+
+	/**
+	 * Gets the top speed of the wheels
+	 *
+	 * @return	Speed at the rim, in m/s
+	 */
+	float maxWheelSpeed();
+
+ private:
+	float
+	/// x component of each wheels driving direction
+		directionX[ OMNIKINEMATICS_WHEELS ],
+	/// y component of each wheels driving direction
+		directionY[ OMNIKINEMATICS_WHEELS ],
+	/// Top speed of the wheels, at the rim
+		_maxWheelSpeed;
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include "PlaceIndex.h"
+
+#include <algorithm>
+#include <queue>
+
+
+/**
+ * Orders descriptors by one value, for splitting a branch
+ */
+struct PlaceIndexCompare
+{
+	const float * values;
+	int dimension;
+
+	bool operator()( unsigned int a, unsigned int b ) const
+	{
+		return this->values[ a * SCANDESCRIPTOR_SIZE + this->dimension ]
+			< this->values[ b * SCANDESCRIPTOR_SIZE + this->dimension ];
+	}
+};
+
+
+PlaceIndex::PlaceIndex()
+{
+	this->indexed = 0;
+}
+
+void
+PlaceIndex::clear()
+{
+	this->values.clear();
+	this->ids.clear();
+	this->order.clear();
+	this->tree.clear();
+	this->indexed = 0;
+}
+
+void
+PlaceIndex::add( const ScanDescriptor & descriptor, unsigned int id )
+{
+	this->values.insert( this->values.end(), descriptor.values(), descriptor.values() + SCANDESCRIPTOR_SIZE );
+	this->ids.push_back( id );
+
+	if ( this->size() - this->indexed >= PLACEINDEX_REBUILD ) this->build();
+}
+
+unsigned int
+PlaceIndex::nearest( const ScanDescriptor & descriptor, unsigned int count, unsigned int * ids, float * distances )
+{
+	const float * query = descriptor.values();
+	unsigned int found = 0;
+	if ( count == 0 ) return 0;
+
+	// Branches not taken, by the squared distance of the query to their
+	// split, nearest on top
+	typedef std::pair< float, unsigned int > Branch;
+	std::priority_queue< Branch, std::vector< Branch >, std::greater< Branch > > branches;
+	if ( ! this->tree.empty() ) branches.push( Branch( 0.0, 0 ) );
+
+	unsigned int checks = 0;
+	while ( ! branches.empty() && checks < PLACEINDEX_CHECKS )
+	{
+		Branch branch = branches.top();
+		branches.pop();
+		if ( found == count && branch.first > distances[ found - 1 ] ) break;
+
+		// Down to the leaf on the side of the query, remembering the others
+		unsigned int node = branch.second;
+		while ( this->tree[ node ].left != 0 )
+		{
+			const Node & split = this->tree[ node ];
+			float offset = query[ split.dimension ] - split.split;
+			branches.push( Branch( std::max( branch.first, offset * offset ), ( offset < 0.0 ) ? split.right : split.left ) );
+			node = ( offset < 0.0 ) ? split.left : split.right;
+		}
+
+		for ( unsigned int i = this->tree[ node ].begin; i < this->tree[ node ].end; i++ )
+			this->consider( this->order[ i ], this->distance( query, this->order[ i ] ), count, & found, ids, distances );
+		checks += this->tree[ node ].end - this->tree[ node ].begin;
+	}
+
+	// Places added since the tree was built
+	for ( unsigned int i = this->indexed; i < this->size(); i++ )
+		this->consider( i, this->distance( query, i ), count, & found, ids, distances );
+
+	// Hand out ids instead of positions
+	for ( unsigned int i = 0; i < found; i++ )
+		ids[ i ] = this->ids[ ids[ i ] ];
+
+	return found;
+}
+
+unsigned int
+PlaceIndex::size()
+{
+	return this->ids.size();
+}
+
+// Private functions
+
+void
+PlaceIndex::build()
+{
+	this->order.resize( this->size() );
+	for ( unsigned int i = 0; i < this->order.size(); i++ )
+		this->order[ i ] = i;
+
+	this->tree.clear();
+	this->tree.reserve( 2 * this->size() / PLACEINDEX_LEAF_SIZE + 1 );
+	this->build( 0, this->size() );
+	this->indexed = this->size();
+}
+
+unsigned int
+PlaceIndex::build( unsigned int begin, unsigned int end )
+{
+	unsigned int node = this->tree.size();
+	Node leaf = { 0, 0.0, 0, 0, begin, end };
+	this->tree.push_back( leaf );
+	if ( end - begin <= PLACEINDEX_LEAF_SIZE ) return node;
+
+	// Split the value that spreads most at its median
+	int dimension = 0;
+	float widest = -1.0;
+	for ( int d = 0; d < SCANDESCRIPTOR_SIZE; d++ )
+	{
+		float low = this->values[ this->order[ begin ] * SCANDESCRIPTOR_SIZE + d ], high = low;
+		for ( unsigned int i = begin + 1; i < end; i++ )
+		{
+			float value = this->values[ this->order[ i ] * SCANDESCRIPTOR_SIZE + d ];
+			low = std::min( low, value );
+			high = std::max( high, value );
+		}
+		if ( high - low > widest )
+		{
+			widest = high - low;
+			dimension = d;
+		}
+	}
+
+	unsigned int middle = ( begin + end ) / 2;
+	PlaceIndexCompare compare = { & this->values[ 0 ], dimension };
+	std::nth_element( this->order.begin() + begin, this->order.begin() + middle, this->order.begin() + end, compare );
+
+	// Children are added behind, so the node is set after building them
+	unsigned int left = this->build( begin, middle );
+	unsigned int right = this->build( middle, end );
+	Node & split = this->tree[ node ];
+	split.dimension = dimension;
+	split.split = this->values[ this->order[ middle ] * SCANDESCRIPTOR_SIZE + dimension ];
+	split.left = left;
+	split.right = right;
+
+	return node;
+}
+
+float
+PlaceIndex::distance( const float * query, unsigned int descriptor )
+{
+	const float * values = & this->values[ descriptor * SCANDESCRIPTOR_SIZE ];
+	float sum = 0.0;
+	for ( int d = 0; d < SCANDESCRIPTOR_SIZE; d++ )
+		sum += ( query[ d ] - values[ d ] ) * ( query[ d ] - values[ d ] );
+	return sum;
+}
+
+void
+PlaceIndex::consider( unsigned int descriptor, float distance, unsigned int count,
+		unsigned int * found, unsigned int * ids, float * distances )
+{
+	if ( * found == count && distance >= distances[ count - 1 ] ) return;
+
+	// Insertion into the sorted list, dropping the farthest when full
+	unsigned int i = ( * found < count ) ? ( * found )++ : count - 1;
+	for ( ; i > 0 && distances[ i - 1 ] > distance; i-- )
+	{
+		ids[ i ] = ids[ i - 1 ];
+		distances[ i ] = distances[ i - 1 ];
+	}
+	ids[ i ] = descriptor;
+	distances[ i ] = distance;
+}
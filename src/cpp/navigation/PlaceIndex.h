@@ -0,0 +1,133 @@
+/**
+ * @file	PlaceIndex.h
+ * @brief	Header file for the PlaceIndex class
+ */
+#ifndef PLACEINDEX_H
+#define PLACEINDEX_H
+
+#include "ScanDescriptor.h"
+
+#include <vector>
+
+
+/// Most descriptors in a leaf of the tree
+#define PLACEINDEX_LEAF_SIZE	8
+/// Most descriptors of the tree compared per query. The nearest branches
+/// are searched first, so this bounds the time of a query at a small loss
+/// of exactness.
+#define PLACEINDEX_CHECKS	512
+/// Descriptors added since the tree was built above which it is built
+/// again. Until then they are compared one by one.
+#define PLACEINDEX_REBUILD	256
+
+
+/**
+ * Finds the places whose ScanDescriptor values are nearest to a query
+ *
+ * The descriptors are kept in a k-d tree, split at the median of the value
+ * that varies most. A query walks down to the leaf of the query and then
+ * visits the other branches nearest first, best bin first, until
+ * PLACEINDEX_CHECKS descriptors were compared. Places added since the tree
+ * was last built are compared one by one, and the tree is built anew once
+ * PLACEINDEX_REBUILD of them have piled up.
+ *
+ * See @link PlaceIndex.h @endlink for documentation of @c \#define parameters
+ */
+class PlaceIndex
+{
+ public:
+	/**
+	 * Constructs an empty PlaceIndex
+	 */
+	PlaceIndex();
+
+	/**
+	 * Removes all places
+	 */
+	void clear();
+
+	/**
+	 * Adds a place
+	 *
+	 * @param	descriptor	Its descriptor
+	 * @param	id	Number returned by nearest() for it
+	 */
+	void add( const ScanDescriptor & descriptor, unsigned int id );
+
+	/**
+	 * Finds the places nearest to a descriptor
+	 *
+	 * @param	descriptor	The descriptor
+	 * @param	count	Most places to find
+	 * @param	ids	Set to the ids of the places, nearest first
+	 * @param	distances	Set to their squared distances
+	 *
+	 * @return	Number of places found
+	 */
+	unsigned int nearest( const ScanDescriptor & descriptor, unsigned int count, unsigned int * ids, float * distances );
+
+	/**
+	 * Gets the number of places
+	 *
+	 * @return	Number of places
+	 */
+	unsigned int size();
+
+ private:
+	/**
+	 * A branch of the tree, a leaf if left is 0
+	 */
+	struct Node
+	{
+		/// Value split at, and where
+		int dimension;
+		float split;
+		/// Children
+		unsigned int left, right;
+		/// Range of order covered by a leaf
+		unsigned int begin, end;
+	};
+
+	std::vector< float >
+	/// Values of all descriptors, SCANDESCRIPTOR_SIZE each
+		values;
+
+	std::vector< unsigned int >
+	/// Id of each descriptor
+		ids,
+	/// Descriptors in the order of the leaves of the tree
+		order;
+
+	std::vector< Node >
+	/// The tree, its root first
+		tree;
+
+	unsigned int
+	/// Number of descriptors in the tree, the rest are compared one by one
+		indexed;
+
+	/**
+	 * Builds the tree over all descriptors
+	 */
+	void build();
+
+	/**
+	 * Builds a branch over a range of order
+	 *
+	 * @return	The number of the branch
+	 */
+	unsigned int build( unsigned int begin, unsigned int end );
+
+	/**
+	 * Gets the squared distance between a query and a descriptor
+	 */
+	float distance( const float * query, unsigned int descriptor );
+
+	/**
+	 * Keeps a descriptor among the nearest found if near enough
+	 */
+	void consider( unsigned int descriptor, float distance, unsigned int count,
+			unsigned int * found, unsigned int * ids, float * distances );
+};
+
+#endif
@@ -0,0 +1,264 @@
+#include "PoseFilter.h"
+
+#include <algorithm>
+
+#ifndef _USE_MATH_DEFINES
+#define _USE_MATH_DEFINES
+#endif
+#include <math.h>
+
+
+PoseFilter::PoseFilter()
+{
+	this->reset( 0.0, 0.0, 0.0 );
+}
+
+void
+PoseFilter::reset( double x, double y, double phi )
+{
+	std::fill( this->state, this->state + 6, 0.0 );
+	this->state[ 0 ] = x;
+	this->state[ 1 ] = y;
+	this->state[ 2 ] = PoseFilter::wrap( phi );
+
+	std::fill( this->covariance, this->covariance + 6 * 6, 0.0 );
+	for ( unsigned int i = 0; i < 3; i++ )
+		this->covariance[ i * 6 + i ] = POSEFILTER_RESET_DEVIATION * POSEFILTER_RESET_DEVIATION;
+	this->covariance[ 3 * 6 + 3 ] = this->covariance[ 4 * 6 + 4 ] = POSEFILTER_SPEED_DEVIATION * POSEFILTER_SPEED_DEVIATION;
+	this->covariance[ 5 * 6 + 5 ] = POSEFILTER_OMEGA_DEVIATION * POSEFILTER_OMEGA_DEVIATION;
+}
+
+void
+PoseFilter::predict( double dx, double dy, double dphi, float dt, float noise )
+{
+	double c = cos( this->state[ 2 ] ), s = sin( this->state[ 2 ] );
+
+	// Move the pose, the speeds are kept
+	double moveX = c * dx - s * dy;
+	double moveY = s * dx + c * dy;
+	this->state[ 0 ] += moveX;
+	this->state[ 1 ] += moveY;
+	this->state[ 2 ] = PoseFilter::wrap( this->state[ 2 ] + dphi );
+
+	// The jacobian is the identity, except for how the heading turns the
+	// move: P = F P F'. Only rows and columns 0 and 1 change.
+	double * p = this->covariance;
+	double f0 = - moveY, f1 = moveX;
+	for ( unsigned int j = 0; j < 6; j++ )
+	{
+		p[ 0 * 6 + j ] += f0 * p[ 2 * 6 + j ];
+		p[ 1 * 6 + j ] += f1 * p[ 2 * 6 + j ];
+	}
+	for ( unsigned int i = 0; i < 6; i++ )
+	{
+		p[ i * 6 + 0 ] += f0 * p[ i * 6 + 2 ];
+		p[ i * 6 + 1 ] += f1 * p[ i * 6 + 2 ];
+	}
+
+	// The variance grows in proportion to the distance driven and turned,
+	// and to the time the speeds may have changed in, however the readings
+	// are spaced
+	double length = sqrt( dx * dx + dy * dy );
+	double translation = POSEFILTER_TRANSLATION_NOISE * POSEFILTER_TRANSLATION_NOISE * length;
+	double rotation = POSEFILTER_ROTATION_NOISE * POSEFILTER_ROTATION_NOISE * fabs( dphi )
+		+ POSEFILTER_DRIFT_NOISE * POSEFILTER_DRIFT_NOISE * length;
+	double accelleration = POSEFILTER_ACCELLERATION_NOISE * POSEFILTER_ACCELLERATION_NOISE * dt;
+	double rotateAccelleration = POSEFILTER_ROTATE_ACCELLERATION_NOISE * POSEFILTER_ROTATE_ACCELLERATION_NOISE * dt;
+
+	translation *= noise * noise;
+	rotation *= noise * noise;
+
+	p[ 0 * 6 + 0 ] += translation;
+	p[ 1 * 6 + 1 ] += translation;
+	p[ 2 * 6 + 2 ] += rotation;
+	p[ 3 * 6 + 3 ] += accelleration;
+	p[ 4 * 6 + 4 ] += accelleration;
+	p[ 5 * 6 + 5 ] += rotateAccelleration;
+}
+
+void
+PoseFilter::correctSpeed( float vx, float vy, float omega )
+{
+	double jacobian[ 3 * 6 ] = { 0.0 };
+	double innovation[ 3 ], variance[ 3 ];
+	const double measured[ 3 ] = { vx, vy, omega };
+
+	for ( unsigned int i = 0; i < 3; i++ )
+	{
+		jacobian[ i * 6 + 3 + i ] = 1.0;
+		innovation[ i ] = measured[ i ] - this->state[ 3 + i ];
+	}
+	variance[ 0 ] = variance[ 1 ] = POSEFILTER_SPEED_DEVIATION * POSEFILTER_SPEED_DEVIATION;
+	variance[ 2 ] = POSEFILTER_OMEGA_DEVIATION * POSEFILTER_OMEGA_DEVIATION;
+
+	// The odometry is all the speeds are known from, so it is never rejected
+	this->correct( 3, jacobian, innovation, variance, false );
+}
+
+bool
+PoseFilter::correctPosition( double x, double y, float deviation, float age )
+{
+	const double measured[ 2 ] = { x, y };
+	const double variance[ 2 ] = { deviation * deviation, deviation * deviation };
+	return this->correctFix( 2, measured, variance, age );
+}
+
+bool
+PoseFilter::correctPose( double x, double y, double phi, float deviation, float phiDeviation, float age )
+{
+	const double measured[ 3 ] = { x, y, phi };
+	const double variance[ 3 ] = { deviation * deviation, deviation * deviation, phiDeviation * phiDeviation };
+	return this->correctFix( 3, measured, variance, age );
+}
+
+double
+PoseFilter::x()
+{
+	return this->state[ 0 ];
+}
+
+double
+PoseFilter::y()
+{
+	return this->state[ 1 ];
+}
+
+double
+PoseFilter::phi()
+{
+	return this->state[ 2 ];
+}
+
+void
+PoseFilter::speed( float * vx, float * vy, float * omega )
+{
+	* vx = this->state[ 3 ];
+	* vy = this->state[ 4 ];
+	* omega = this->state[ 5 ];
+}
+
+float
+PoseFilter::positionDeviation()
+{
+	return sqrt( std::max( this->covariance[ 0 * 6 + 0 ], this->covariance[ 1 * 6 + 1 ] ) );
+}
+
+// Private functions
+
+bool
+PoseFilter::correct( unsigned int count, const double * jacobian, const double * innovation,
+		const double * variance, bool gated )
+{
+	const double gate[ 3 ] = POSEFILTER_GATE;
+	const double * p = this->covariance;
+
+	// PH' and the innovation covariance S = H P H' + R
+	double ph[ 6 * 3 ], s[ 3 * 3 ];
+	for ( unsigned int i = 0; i < 6; i++ )
+		for ( unsigned int k = 0; k < count; k++ )
+		{
+			double sum = 0.0;
+			for ( unsigned int j = 0; j < 6; j++ ) sum += p[ i * 6 + j ] * jacobian[ k * 6 + j ];
+			ph[ i * 3 + k ] = sum;
+		}
+	for ( unsigned int k = 0; k < count; k++ )
+		for ( unsigned int l = 0; l < count; l++ )
+		{
+			double sum = ( k == l ) ? variance[ k ] : 0.0;
+			for ( unsigned int j = 0; j < 6; j++ ) sum += jacobian[ k * 6 + j ] * ph[ j * 3 + l ];
+			s[ k * 3 + l ] = sum;
+		}
+
+	// Invert S by Gauss-Jordan elimination, it is positive definite so no
+	// pivoting is needed
+	double inverse[ 3 * 3 ] = { 0.0 };
+	for ( unsigned int k = 0; k < count; k++ ) inverse[ k * 3 + k ] = 1.0;
+	for ( unsigned int k = 0; k < count; k++ )
+	{
+		double pivot = s[ k * 3 + k ];
+		if ( pivot <= 0.0 ) return false;
+		for ( unsigned int l = 0; l < count; l++ )
+		{
+			s[ k * 3 + l ] /= pivot;
+			inverse[ k * 3 + l ] /= pivot;
+		}
+		for ( unsigned int r = 0; r < count; r++ )
+		{
+			if ( r == k ) continue;
+			double factor = s[ r * 3 + k ];
+			for ( unsigned int l = 0; l < count; l++ )
+			{
+				s[ r * 3 + l ] -= factor * s[ k * 3 + l ];
+				inverse[ r * 3 + l ] -= factor * inverse[ k * 3 + l ];
+			}
+		}
+	}
+
+	// Reject outliers by the Mahalanobis distance
+	double distance = 0.0;
+	for ( unsigned int k = 0; k < count; k++ )
+		for ( unsigned int l = 0; l < count; l++ )
+			distance += innovation[ k ] * inverse[ k * 3 + l ] * innovation[ l ];
+	if ( gated && distance > gate[ count - 1 ] ) return false;
+
+	// Gain K = P H' S^-1, then x += K v and P -= K H P
+	double gain[ 6 * 3 ];
+	for ( unsigned int i = 0; i < 6; i++ )
+		for ( unsigned int l = 0; l < count; l++ )
+		{
+			double sum = 0.0;
+			for ( unsigned int k = 0; k < count; k++ ) sum += ph[ i * 3 + k ] * inverse[ k * 3 + l ];
+			gain[ i * 3 + l ] = sum;
+		}
+
+	for ( unsigned int i = 0; i < 6; i++ )
+		for ( unsigned int k = 0; k < count; k++ )
+			this->state[ i ] += gain[ i * 3 + k ] * innovation[ k ];
+	this->state[ 2 ] = PoseFilter::wrap( this->state[ 2 ] );
+
+	for ( unsigned int i = 0; i < 6; i++ )
+		for ( unsigned int j = i; j < 6; j++ )
+		{
+			double sum = 0.0;
+			for ( unsigned int k = 0; k < count; k++ ) sum += gain[ i * 3 + k ] * ph[ j * 3 + k ];
+			this->covariance[ i * 6 + j ] -= sum;
+			this->covariance[ j * 6 + i ] = this->covariance[ i * 6 + j ];
+		}
+
+	return true;
+}
+
+bool
+PoseFilter::correctFix( unsigned int count, const double * measured, const double * variance, float age )
+{
+	if ( age < 0.0 || age > POSEFILTER_MAX_AGE ) return false;
+
+	// Where Robotino was when the fix was taken, driving back at the current
+	// speeds
+	double c = cos( this->state[ 2 ] ), s = sin( this->state[ 2 ] );
+	double vx = this->state[ 3 ], vy = this->state[ 4 ];
+	double worldVx = c * vx - s * vy;
+	double worldVy = s * vx + c * vy;
+
+	double predicted[ 3 ] = {
+		this->state[ 0 ] - age * worldVx,
+		this->state[ 1 ] - age * worldVy,
+		this->state[ 2 ] - age * this->state[ 5 ] };
+
+	double jacobian[ 3 * 6 ] = {
+		1.0, 0.0, age * worldVy, - age * c, age * s, 0.0,
+		0.0, 1.0, - age * worldVx, - age * s, - age * c, 0.0,
+		0.0, 0.0, 1.0, 0.0, 0.0, - age };
+
+	double innovation[ 3 ];
+	for ( unsigned int k = 0; k < count; k++ ) innovation[ k ] = measured[ k ] - predicted[ k ];
+	if ( count > 2 ) innovation[ 2 ] = PoseFilter::wrap( innovation[ 2 ] );
+
+	return this->correct( count, jacobian, innovation, variance, true );
+}
+
+double
+PoseFilter::wrap( double angle )
+{
+	return atan2( sin( angle ), cos( angle ) );
+}
@@ -0,0 +1,208 @@
+/**
+ * @file	PoseFilter.h
+ * @brief	Header file for the PoseFilter class
+ */
+#ifndef POSEFILTER_H
+#define POSEFILTER_H
+
+
+	// Process noise
+	// The errors add up like a random walk, so each is the deviation after
+	// one unit of driving, turning or time. After four units it is double.
+
+/// Deviation of the odometry after driving a meter, in meters
+#define POSEFILTER_TRANSLATION_NOISE	0.1
+/// Deviation of the odometry heading after turning a rad, in rad
+#define POSEFILTER_ROTATION_NOISE	0.1
+/// Deviation of the odometry heading after driving a meter, in rad. Driving
+/// sideways on omni wheels slips, and turns Robotino without the odometry
+/// noticing.
+#define POSEFILTER_DRIFT_NOISE	0.05
+/// Change of x and y speed after a second, in m/s
+#define POSEFILTER_ACCELLERATION_NOISE	0.5
+/// Change of the rotation speed after a second, in rad/s
+#define POSEFILTER_ROTATE_ACCELLERATION_NOISE	2.0
+
+
+	// Measurements
+
+/// Deviation of the x and y speed measured by the odometry, in m/s
+#define POSEFILTER_SPEED_DEVIATION	0.02
+/// Deviation of the rotation speed measured by the odometry, in rad/s
+#define POSEFILTER_OMEGA_DEVIATION	0.05
+/// Deviation of the pose after reset(), in meters and rad
+#define POSEFILTER_RESET_DEVIATION	0.01
+/// Oldest measurement accepted, in seconds
+#define POSEFILTER_MAX_AGE	1.0
+/// Squared Mahalanobis distance above which a measurement is rejected as an
+/// outlier, per number of measured values. These are the 99 % points of the
+/// chi-square distribution.
+#define POSEFILTER_GATE	{ 6.63, 9.21, 11.34 }
+
+
+/**
+ * Extended Kalman filter for Robotinos pose
+ *
+ * The state is the position x, y and heading in the odometry frame, and the
+ * speeds vx, vy and omega in Robotinos own frame, like the odometry reports
+ * them.
+ *
+ * - predict() moves the pose by an odometry increment. The uncertainty
+ *   grows with the distance driven and turned.
+ * - correctSpeed() updates the speeds from the odometry.
+ * - correctPosition() and correctPose() take absolute fixes, from the Kinect
+ *   or from matching laser scans. A fix taken some time ago is compared with
+ *   where Robotino was then, found by driving back at the current speeds, so
+ *   the delay of the measurement does not pull the pose back. Fixes too far
+ *   from the estimate for its uncertainty are rejected.
+ *
+ * All matrices are fixed-size arrays, nothing is allocated after
+ * construction.
+ *
+ * See @link PoseFilter.h @endlink for documentation of @c \#define
+ * parameters
+ */
+class PoseFilter
+{
+ public:
+	/**
+	 * Constructs PoseFilter at the origin, standing still
+	 */
+	PoseFilter();
+
+	/**
+	 * Sets the pose and stops, forgetting the uncertainty built up
+	 *
+	 * @param	x	The new x value
+	 * @param	y	The new y value
+	 * @param	phi	The new heading
+	 */
+	void reset( double x, double y, double phi );
+
+	/**
+	 * Moves the pose by an odometry increment
+	 *
+	 * @param	dx	Distance driven forward, in the frame at the start of
+	 * the increment
+	 * @param	dy	Distance driven to the left, in the same frame
+	 * @param	dphi	Angle turned
+	 * @param	dt	Duration of the increment, in seconds
+	 * @param	noise	Factor the deviations of driving and turning are
+	 * multiplied by, above 1 while the wheels slip
+	 */
+	void predict( double dx, double dy, double dphi, float dt, float noise = 1.0 );
+
+	/**
+	 * Corrects the speeds with the ones measured by the odometry
+	 *
+	 * @param	vx	Forward speed
+	 * @param	vy	Leftward speed
+	 * @param	omega	Rotation speed
+	 */
+	void correctSpeed( float vx, float vy, float omega );
+
+	/**
+	 * Corrects the position with an absolute fix
+	 *
+	 * @param	x	Measured x value
+	 * @param	y	Measured y value
+	 * @param	deviation	Deviation of the measurement, in meters
+	 * @param	age	Time since the measurement was taken, in seconds
+	 *
+	 * @return	False if the fix was rejected as too old or an outlier
+	 */
+	bool correctPosition( double x, double y, float deviation, float age );
+
+	/**
+	 * Corrects the pose with an absolute fix
+	 *
+	 * @param	x	Measured x value
+	 * @param	y	Measured y value
+	 * @param	phi	Measured heading
+	 * @param	deviation	Deviation of the position, in meters
+	 * @param	phiDeviation	Deviation of the heading, in rad
+	 * @param	age	Time since the measurement was taken, in seconds
+	 *
+	 * @return	False if the fix was rejected as too old or an outlier
+	 */
+	bool correctPose( double x, double y, double phi, float deviation, float phiDeviation, float age );
+
+	/**
+	 * Gets the estimated x value
+	 *
+	 * @return	x
+	 */
+	double x();
+
+	/**
+	 * Gets the estimated y value
+	 *
+	 * @return	y
+	 */
+	double y();
+
+	/**
+	 * Gets the estimated heading
+	 *
+	 * @return	Heading, in [ -pi, pi ]
+	 */
+	double phi();
+
+	/**
+	 * Gets the estimated speeds
+	 *
+	 * @param	vx	Set to the forward speed
+	 * @param	vy	Set to the leftward speed
+	 * @param	omega	Set to the rotation speed
+	 */
+	void speed( float * vx, float * vy, float * omega );
+
+	/**
+	 * Gets the estimated deviation of the position
+	 *
+	 * @return	Square root of the larger variance of x and y, in meters
+	 */
+	float positionDeviation();
+
+ private:
+	double
+	/// Estimated x, y, phi, vx, vy and omega
+		state[ 6 ],
+	/// Covariance of the estimate, row major
+		covariance[ 6 * 6 ];
+
+	/**
+	 * Corrects the state with a measurement of some of its values, at most
+	 * three
+	 *
+	 * @param	count	Number of values measured
+	 * @param	jacobian	Derivative of each measured value by the state,
+	 * count rows of 6, row major
+	 * @param	innovation	Measured minus predicted value for each
+	 * @param	variance	Variance of each measured value
+	 * @param	gated	True to reject outliers
+	 *
+	 * @return	False if rejected as an outlier
+	 */
+	bool correct( unsigned int count, const double * jacobian, const double * innovation,
+			const double * variance, bool gated );
+
+	/**
+	 * Corrects the pose with a fix taken age seconds ago, the heading only if
+	 * count is 3
+	 *
+	 * @return	False if rejected
+	 */
+	bool correctFix( unsigned int count, const double * measured, const double * variance, float age );
+
+	/**
+	 * Wraps an angle to [ -pi, pi ]
+	 *
+	 * @param	angle	The angle, in rad
+	 *
+	 * @return	The wrapped angle
+	 */
+	static double wrap( double angle );
+};
+
+#endif
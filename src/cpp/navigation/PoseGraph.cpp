@@ -0,0 +1,362 @@
+#include "PoseGraph.h"
+
+#ifndef _USE_MATH_DEFINES
+#define _USE_MATH_DEFINES
+#endif
+#include <math.h>
+#include <algorithm>
+
+
+/// Smallest pivot of the factor, keeps a node without edges from dividing
+/// by zero
+static const double POSEGRAPH_MIN_PIVOT = 1e-9;
+
+
+// 3 by 3 blocks, row major
+
+/**
+ * result += a^T * diag( w ) * b
+ */
+static void
+addWeighted( double * result, const double * a, const double * w, const double * b )
+{
+	for ( int r = 0; r < 3; r++ )
+		for ( int c = 0; c < 3; c++ )
+			result[ r * 3 + c ] += a[ r ] * w[ 0 ] * b[ c ] + a[ 3 + r ] * w[ 1 ] * b[ 3 + c ] + a[ 6 + r ] * w[ 2 ] * b[ 6 + c ];
+}
+
+/**
+ * result -= a * b^T
+ */
+static void
+subtractOuter( double * result, const double * a, const double * b )
+{
+	for ( int r = 0; r < 3; r++ )
+		for ( int c = 0; c < 3; c++ )
+			result[ r * 3 + c ] -= a[ r * 3 ] * b[ c * 3 ] + a[ r * 3 + 1 ] * b[ c * 3 + 1 ] + a[ r * 3 + 2 ] * b[ c * 3 + 2 ];
+}
+
+/**
+ * Replaces a symmetric block by its lower Cholesky factor
+ */
+static void
+choleskyBlock( double * m )
+{
+	m[ 0 ] = sqrt( std::max( m[ 0 ], POSEGRAPH_MIN_PIVOT ) );
+	m[ 3 ] /= m[ 0 ];
+	m[ 6 ] /= m[ 0 ];
+	m[ 4 ] = sqrt( std::max( m[ 4 ] - m[ 3 ] * m[ 3 ], POSEGRAPH_MIN_PIVOT ) );
+	m[ 7 ] = ( m[ 7 ] - m[ 6 ] * m[ 3 ] ) / m[ 4 ];
+	m[ 8 ] = sqrt( std::max( m[ 8 ] - m[ 6 ] * m[ 6 ] - m[ 7 ] * m[ 7 ], POSEGRAPH_MIN_PIVOT ) );
+	m[ 1 ] = m[ 2 ] = m[ 5 ] = 0.0;
+}
+
+/**
+ * Replaces m by m * l^-T, for l a lower factor
+ */
+static void
+divideTransposed( double * m, const double * l )
+{
+	for ( int r = 0; r < 3; r++ )
+	{
+		double * row = m + r * 3;
+		row[ 0 ] = row[ 0 ] / l[ 0 ];
+		row[ 1 ] = ( row[ 1 ] - l[ 3 ] * row[ 0 ] ) / l[ 4 ];
+		row[ 2 ] = ( row[ 2 ] - l[ 6 ] * row[ 0 ] - l[ 7 ] * row[ 1 ] ) / l[ 8 ];
+	}
+}
+
+
+PoseGraph::PoseGraph()
+{
+	this->dirty = 0;
+}
+
+void
+PoseGraph::clear()
+{
+	this->edgeList.clear();
+	this->incident.clear();
+	this->linearization.clear();
+	this->delta.clear();
+	this->gradient.clear();
+	this->anchor.clear();
+	this->first.clear();
+	this->hessian.clear();
+	this->factor.clear();
+	this->dirty = 0;
+}
+
+unsigned int
+PoseGraph::addNode( const double * pose )
+{
+	unsigned int node = this->size();
+
+	this->incident.push_back( std::vector< unsigned int >() );
+	this->linearization.insert( this->linearization.end(), pose, pose + 3 );
+	this->delta.insert( this->delta.end(), 3, 0.0 );
+	this->gradient.insert( this->gradient.end(), 3, 0.0 );
+	this->first.push_back( node );
+	this->hessian.push_back( std::vector< double >( 9, 0.0 ) );
+	this->factor.push_back( std::vector< double >( 9, 0.0 ) );
+	if ( node == 0 ) this->anchor.assign( pose, pose + 3 );
+
+	this->assemble( node );
+	this->dirty = std::min( this->dirty, node );
+	return node;
+}
+
+void
+PoseGraph::addEdge( unsigned int from, unsigned int to, const double * measurement, const double * deviation )
+{
+	Edge edge;
+	edge.from = from;
+	edge.to = to;
+	for ( int i = 0; i < 3; i++ )
+	{
+		edge.measurement[ i ] = measurement[ i ];
+		edge.information[ i ] = 1.0 / ( deviation[ i ] * deviation[ i ] );
+	}
+	this->linearize( edge );
+
+	this->edgeList.push_back( edge );
+	this->incident[ from ].push_back( this->edgeList.size() - 1 );
+	this->incident[ to ].push_back( this->edgeList.size() - 1 );
+
+	// Widen the envelope of the newer node to reach the older one
+	unsigned int older = std::min( from, to ), newer = std::max( from, to );
+	if ( older < this->first[ newer ] )
+	{
+		this->first[ newer ] = older;
+		this->hessian[ newer ].resize( ( newer - older + 1 ) * 9 );
+		this->factor[ newer ].resize( ( newer - older + 1 ) * 9 );
+	}
+
+	this->assemble( from );
+	this->assemble( to );
+	this->dirty = std::min( this->dirty, older );
+}
+
+unsigned int
+PoseGraph::optimize()
+{
+	unsigned int rows = 0;
+	std::vector< bool > stale;
+
+	for ( unsigned int iteration = 0; iteration < POSEGRAPH_ITERATIONS; iteration++ )
+	{
+		rows += this->factorize();
+		this->solve();
+		if ( iteration + 1 == POSEGRAPH_ITERATIONS ) break;
+
+		// Move the linearization point of nodes the solution moved far, so
+		// the solution stays consistent with the poses it is applied to
+		stale.assign( this->edgeList.size(), false );
+		bool moved = false;
+		for ( unsigned int node = 0; node < this->size(); node++ )
+		{
+			double * step = & this->delta[ node * 3 ];
+			if ( fabs( step[ 0 ] ) < POSEGRAPH_RELINEARIZE && fabs( step[ 1 ] ) < POSEGRAPH_RELINEARIZE
+					&& fabs( step[ 2 ] ) < POSEGRAPH_RELINEARIZE )
+				continue;
+
+			double * point = & this->linearization[ node * 3 ];
+			point[ 0 ] += step[ 0 ];
+			point[ 1 ] += step[ 1 ];
+			point[ 2 ] = wrap( point[ 2 ] + step[ 2 ] );
+			for ( unsigned int e = 0; e < this->incident[ node ].size(); e++ )
+				stale[ this->incident[ node ][ e ] ] = true;
+			moved = true;
+		}
+		if ( ! moved ) break;
+
+		std::vector< bool > changed( this->size(), false );
+		for ( unsigned int e = 0; e < this->edgeList.size(); e++ )
+		{
+			if ( ! stale[ e ] ) continue;
+			this->linearize( this->edgeList[ e ] );
+			changed[ this->edgeList[ e ].from ] = true;
+			changed[ this->edgeList[ e ].to ] = true;
+		}
+
+		for ( unsigned int node = 0; node < this->size(); node++ )
+		{
+			if ( ! changed[ node ] ) continue;
+			this->assemble( node );
+			this->dirty = std::min( this->dirty, node );
+		}
+	}
+
+	return rows;
+}
+
+void
+PoseGraph::pose( unsigned int node, double * pose )
+{
+	pose[ 0 ] = this->linearization[ node * 3 ] + this->delta[ node * 3 ];
+	pose[ 1 ] = this->linearization[ node * 3 + 1 ] + this->delta[ node * 3 + 1 ];
+	pose[ 2 ] = wrap( this->linearization[ node * 3 + 2 ] + this->delta[ node * 3 + 2 ] );
+}
+
+unsigned int
+PoseGraph::size()
+{
+	return this->first.size();
+}
+
+unsigned int
+PoseGraph::edges()
+{
+	return this->edgeList.size();
+}
+
+// Private functions
+
+void
+PoseGraph::linearize( Edge & edge )
+{
+	const double * a = & this->linearization[ edge.from * 3 ];
+	const double * b = & this->linearization[ edge.to * 3 ];
+	double c = cos( a[ 2 ] ), s = sin( a[ 2 ] );
+	double dx = b[ 0 ] - a[ 0 ], dy = b[ 1 ] - a[ 1 ];
+
+	// Pose of "to" in the frame of "from", minus the measurement
+	edge.error[ 0 ] = c * dx + s * dy - edge.measurement[ 0 ];
+	edge.error[ 1 ] = - s * dx + c * dy - edge.measurement[ 1 ];
+	edge.error[ 2 ] = wrap( b[ 2 ] - a[ 2 ] - edge.measurement[ 2 ] );
+
+	double from[ 9 ] = {
+		- c, - s, - s * dx + c * dy,
+		s, - c, - c * dx - s * dy,
+		0.0, 0.0, - 1.0 };
+	double to[ 9 ] = {
+		c, s, 0.0,
+		- s, c, 0.0,
+		0.0, 0.0, 1.0 };
+	std::copy( from, from + 9, edge.jacobianFrom );
+	std::copy( to, to + 9, edge.jacobianTo );
+}
+
+void
+PoseGraph::assemble( unsigned int row )
+{
+	std::fill( this->hessian[ row ].begin(), this->hessian[ row ].end(), 0.0 );
+	double * diagonal = this->block( this->hessian, row, row );
+	double * g = & this->gradient[ row * 3 ];
+	g[ 0 ] = g[ 1 ] = g[ 2 ] = 0.0;
+
+	for ( unsigned int i = 0; i < this->incident[ row ].size(); i++ )
+	{
+		Edge & edge = this->edgeList[ this->incident[ row ][ i ] ];
+		bool isFrom = ( edge.from == row );
+		const double * own = isFrom ? edge.jacobianFrom : edge.jacobianTo;
+		const double * other = isFrom ? edge.jacobianTo : edge.jacobianFrom;
+		unsigned int otherNode = isFrom ? edge.to : edge.from;
+
+		addWeighted( diagonal, own, edge.information, own );
+		for ( int r = 0; r < 3; r++ )
+			g[ r ] += own[ r ] * edge.information[ 0 ] * edge.error[ 0 ]
+				+ own[ 3 + r ] * edge.information[ 1 ] * edge.error[ 1 ]
+				+ own[ 6 + r ] * edge.information[ 2 ] * edge.error[ 2 ];
+
+		// Only the lower triangle is kept
+		if ( otherNode < row )
+			addWeighted( this->block( this->hessian, row, otherNode ), own, edge.information, other );
+	}
+
+	if ( row == 0 )
+	{
+		double information = 1.0 / ( POSEGRAPH_ANCHOR_DEVIATION * POSEGRAPH_ANCHOR_DEVIATION );
+		const double * point = & this->linearization[ 0 ];
+		diagonal[ 0 ] += information;
+		diagonal[ 4 ] += information;
+		diagonal[ 8 ] += information;
+		g[ 0 ] += information * ( point[ 0 ] - this->anchor[ 0 ] );
+		g[ 1 ] += information * ( point[ 1 ] - this->anchor[ 1 ] );
+		g[ 2 ] += information * wrap( point[ 2 ] - this->anchor[ 2 ] );
+	}
+}
+
+unsigned int
+PoseGraph::factorize()
+{
+	unsigned int start = this->dirty;
+
+	for ( unsigned int row = start; row < this->size(); row++ )
+	{
+		std::copy( this->hessian[ row ].begin(), this->hessian[ row ].end(), this->factor[ row ].begin() );
+
+		for ( unsigned int column = this->first[ row ]; column <= row; column++ )
+		{
+			double * target = this->block( this->factor, row, column );
+
+			// Blocks left of both envelopes are zero
+			for ( unsigned int k = std::max( this->first[ row ], this->first[ column ] ); k < column; k++ )
+				subtractOuter( target, this->block( this->factor, row, k ), this->block( this->factor, column, k ) );
+
+			if ( column < row )
+				divideTransposed( target, this->block( this->factor, column, column ) );
+			else
+				choleskyBlock( target );
+		}
+	}
+
+	this->dirty = this->size();
+	return this->size() - start;
+}
+
+void
+PoseGraph::solve()
+{
+	unsigned int n = this->size();
+
+	// L y = -g
+	for ( unsigned int row = 0; row < n; row++ )
+	{
+		double y[ 3 ] = { - this->gradient[ row * 3 ], - this->gradient[ row * 3 + 1 ], - this->gradient[ row * 3 + 2 ] };
+		for ( unsigned int k = this->first[ row ]; k < row; k++ )
+		{
+			const double * l = this->block( this->factor, row, k );
+			const double * x = & this->delta[ k * 3 ];
+			for ( int r = 0; r < 3; r++ )
+				y[ r ] -= l[ r * 3 ] * x[ 0 ] + l[ r * 3 + 1 ] * x[ 1 ] + l[ r * 3 + 2 ] * x[ 2 ];
+		}
+
+		const double * l = this->block( this->factor, row, row );
+		double * x = & this->delta[ row * 3 ];
+		x[ 0 ] = y[ 0 ] / l[ 0 ];
+		x[ 1 ] = ( y[ 1 ] - l[ 3 ] * x[ 0 ] ) / l[ 4 ];
+		x[ 2 ] = ( y[ 2 ] - l[ 6 ] * x[ 0 ] - l[ 7 ] * x[ 1 ] ) / l[ 8 ];
+	}
+
+	// L^T delta = y, row by row from the end, pushing each solved block up
+	// into the rows of its envelope
+	for ( unsigned int row = n; row-- > 0; )
+	{
+		const double * l = this->block( this->factor, row, row );
+		double * x = & this->delta[ row * 3 ];
+		x[ 2 ] = x[ 2 ] / l[ 8 ];
+		x[ 1 ] = ( x[ 1 ] - l[ 7 ] * x[ 2 ] ) / l[ 4 ];
+		x[ 0 ] = ( x[ 0 ] - l[ 3 ] * x[ 1 ] - l[ 6 ] * x[ 2 ] ) / l[ 0 ];
+
+		for ( unsigned int k = this->first[ row ]; k < row; k++ )
+		{
+			const double * b = this->block( this->factor, row, k );
+			double * y = & this->delta[ k * 3 ];
+			for ( int c = 0; c < 3; c++ )
+				y[ c ] -= b[ c ] * x[ 0 ] + b[ 3 + c ] * x[ 1 ] + b[ 6 + c ] * x[ 2 ];
+		}
+	}
+}
+
+double *
+PoseGraph::block( std::vector< std::vector< double > > & rows, unsigned int row, unsigned int column )
+{
+	return & rows[ row ][ ( column - this->first[ row ] ) * 9 ];
+}
+
+double
+PoseGraph::wrap( double angle )
+{
+	return atan2( sin( angle ), cos( angle ) );
+}
@@ -0,0 +1,196 @@
+/**
+ * @file	PoseGraph.h
+ * @brief	Header file for the PoseGraph class
+ */
+#ifndef POSEGRAPH_H
+#define POSEGRAPH_H
+
+#include <vector>
+
+
+/// Change of a pose in the solution, in meters or rad, above which its
+/// constraints are linearized again at the new pose
+#define POSEGRAPH_RELINEARIZE	0.01
+/// Most rounds of relinearizing and solving per optimize()
+#define POSEGRAPH_ITERATIONS	10
+/// Deviation holding the first pose in place, in meters and rad
+#define POSEGRAPH_ANCHOR_DEVIATION	0.001
+
+
+/**
+ * Graph of Robotinos poses and the measured motion between them, optimized
+ * by Gauss-Newton
+ *
+ * Every edge says how far node "to" is from node "from", in the frame of
+ * "from", with a deviation for each of x, y and heading. optimize() finds
+ * the poses that fit all edges best.
+ *
+ * The normal equations are factored by a block Cholesky on their envelope:
+ * row i holds the 3 by 3 blocks from the oldest node connected to node i up
+ * to i itself. Nodes are numbered in the order they are added, so a chain
+ * of odometry edges keeps rows two blocks wide, and a loop closure widens
+ * only the row of its newest node. Fill-in stays inside the envelope.
+ *
+ * The work is incremental, like iSAM:
+ * - Each edge is linearized at the poses its nodes had then, and only
+ *   linearized again when one of them moves more than
+ *   POSEGRAPH_RELINEARIZE.
+ * - A row of the factor depends only on the rows above it. Only rows from
+ *   the oldest node whose edges changed are factored again. Adding a node
+ *   with an edge to the previous one costs one row, and a loop closure
+ *   costs the rows from the oldest node it connects.
+ *
+ * See @link PoseGraph.h @endlink for documentation of @c \#define parameters
+ */
+class PoseGraph
+{
+ public:
+	/**
+	 * Constructs an empty PoseGraph
+	 */
+	PoseGraph();
+
+	/**
+	 * Removes all nodes and edges
+	 */
+	void clear();
+
+	/**
+	 * Adds a node. The first node is held in place.
+	 *
+	 * @param	pose	Initial x, y and heading
+	 *
+	 * @return	The number of the node
+	 */
+	unsigned int addNode( const double * pose );
+
+	/**
+	 * Adds a measurement of the motion between two nodes
+	 *
+	 * @param	from	The node the motion is measured from
+	 * @param	to	The node the motion is measured to
+	 * @param	measurement	x, y and heading of "to" in the frame of "from"
+	 * @param	deviation	Deviation of each of x, y and heading
+	 */
+	void addEdge( unsigned int from, unsigned int to, const double * measurement, const double * deviation );
+
+	/**
+	 * Moves the poses to fit the edges, relinearizing and refactoring only
+	 * what changed
+	 *
+	 * @return	Number of rows of the factor computed
+	 */
+	unsigned int optimize();
+
+	/**
+	 * Gets the optimized pose of a node
+	 *
+	 * @param	node	The number of the node
+	 * @param	pose	Set to x, y and heading
+	 */
+	void pose( unsigned int node, double * pose );
+
+	/**
+	 * Gets the number of nodes
+	 *
+	 * @return	Number of nodes
+	 */
+	unsigned int size();
+
+	/**
+	 * Gets the number of edges
+	 *
+	 * @return	Number of edges
+	 */
+	unsigned int edges();
+
+ private:
+	/**
+	 * A measurement between two nodes, with its linearization
+	 */
+	struct Edge
+	{
+		unsigned int from, to;
+		double measurement[ 3 ];
+		/// Inverse variance of each measured value
+		double information[ 3 ];
+		/// Error and its derivatives by the poses of from and to, row
+		/// major, at the linearization points
+		double error[ 3 ];
+		double jacobianFrom[ 9 ];
+		double jacobianTo[ 9 ];
+	};
+
+	std::vector< Edge >
+	/// All edges
+		edgeList;
+
+	std::vector< std::vector< unsigned int > >
+	/// Edges of each node
+		incident;
+
+	std::vector< double >
+	/// Pose each node is linearized at, 3 per node
+		linearization,
+	/// Solution of the normal equations, the change from the linearization
+	/// point, 3 per node
+		delta,
+	/// Gradient of the normal equations, 3 per node
+		gradient,
+	/// Pose of the first node when it was added
+		anchor;
+
+	std::vector< unsigned int >
+	/// Oldest node in the envelope of each row
+		first;
+
+	std::vector< std::vector< double > >
+	/// Blocks of each row of the normal matrix, from first to the diagonal,
+	/// 9 per block, row major
+		hessian,
+	/// Blocks of each row of the Cholesky factor, like hessian
+		factor;
+
+	unsigned int
+	/// Oldest row changed since the last factorization
+		dirty;
+
+	/**
+	 * Works out the error and jacobians of an edge at the linearization
+	 * points
+	 */
+	void linearize( Edge & edge );
+
+	/**
+	 * Builds a row of the normal equations from the edges of its node
+	 *
+	 * @param	row	The number of the node
+	 */
+	void assemble( unsigned int row );
+
+	/**
+	 * Factors rows from dirty on
+	 *
+	 * @return	Number of rows factored
+	 */
+	unsigned int factorize();
+
+	/**
+	 * Solves for delta with the factor
+	 */
+	void solve();
+
+	/**
+	 * Gets a block of a row of the factor
+	 *
+	 * @return	Pointer to the 9 values
+	 */
+	double * block( std::vector< std::vector< double > > & rows, unsigned int row, unsigned int column );
+
+	/**
+	 * Wraps an angle to [ -pi, pi ]
+	 */
+	static double wrap( double angle );
+};
+
+#endif
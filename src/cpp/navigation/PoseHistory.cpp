@@ -0,0 +1,140 @@
+#include "PoseHistory.h"
+
+#include <math.h>
+
+
+PoseHistory::PoseHistory()
+{
+	for ( unsigned int i = 0; i < POSEHISTORY_SIZE; i++ )
+		this->entries[ i ].version.store( 0 );
+
+	this->count.store( 0 );
+	this->first.store( 0 );
+}
+
+void
+PoseHistory::add( unsigned int time, const double * pose, const float * speed )
+{
+	unsigned int index = this->count.load( std::memory_order_relaxed );
+	Entry & entry = this->entries[ index % POSEHISTORY_SIZE ];
+
+	// Odd while written, so readers of the old pose notice
+	unsigned int version = entry.version.load( std::memory_order_relaxed );
+	entry.version.store( version + 1, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_release );
+
+	entry.time.store( time, std::memory_order_relaxed );
+	for ( unsigned int i = 0; i < 3; i++ )
+	{
+		entry.pose[ i ].store( pose[ i ], std::memory_order_relaxed );
+		entry.speed[ i ].store( speed[ i ], std::memory_order_relaxed );
+	}
+
+	entry.version.store( version + 2, std::memory_order_release );
+	this->count.store( index + 1, std::memory_order_release );
+}
+
+void
+PoseHistory::clear()
+{
+	this->first.store( this->count.load( std::memory_order_relaxed ), std::memory_order_release );
+}
+
+bool
+PoseHistory::lookup( unsigned int time, double * pose, float * speed )
+{
+	for ( unsigned int attempt = 0; attempt < POSEHISTORY_RETRIES; attempt++ )
+	{
+		// The entry after the newest may be written any time, leave it
+		unsigned int end = this->count.load( std::memory_order_acquire );
+		unsigned int begin = this->first.load( std::memory_order_acquire );
+		if ( end >= POSEHISTORY_SIZE && begin < end - ( POSEHISTORY_SIZE - 1 ) )
+			begin = end - ( POSEHISTORY_SIZE - 1 );
+		if ( begin >= end ) return false;
+
+		unsigned int low = begin, high = end - 1;
+		unsigned int lowTime, highTime;
+		double lowPose[ 3 ], highPose[ 3 ];
+		float lowSpeed[ 3 ], highSpeed[ 3 ];
+
+		// Newer than the newest, extrapolate a little
+		if ( ! this->read( high, & highTime, highPose, highSpeed ) ) continue;
+		if ( time >= highTime )
+		{
+			if ( time - highTime > POSEHISTORY_MAX_EXTRAPOLATION ) return false;
+
+			float dt = ( time - highTime ) / 1000.0;
+			double c = cos( highPose[ 2 ] ), s = sin( highPose[ 2 ] );
+			pose[ 0 ] = highPose[ 0 ] + ( c * highSpeed[ 0 ] - s * highSpeed[ 1 ] ) * dt;
+			pose[ 1 ] = highPose[ 1 ] + ( s * highSpeed[ 0 ] + c * highSpeed[ 1 ] ) * dt;
+			pose[ 2 ] = highPose[ 2 ] + highSpeed[ 2 ] * dt;
+			pose[ 2 ] = atan2( sin( pose[ 2 ] ), cos( pose[ 2 ] ) );
+			if ( speed )
+				for ( unsigned int i = 0; i < 3; i++ ) speed[ i ] = highSpeed[ i ];
+			return true;
+		}
+
+		if ( ! this->read( low, & lowTime, 0, 0 ) ) continue;
+		if ( time < lowTime ) return false;
+
+		// Narrow down to the two entries around the time, keeping
+		// lowTime <= time < highTime
+		bool overwritten = false;
+		while ( high - low > 1 )
+		{
+			unsigned int middle = low + ( high - low ) / 2;
+			unsigned int middleTime;
+			if ( ! this->read( middle, & middleTime, 0, 0 ) )
+			{
+				overwritten = true;
+				break;
+			}
+
+			if ( middleTime <= time ) low = middle;
+			else high = middle;
+		}
+		if ( overwritten ) continue;
+
+		if ( ! this->read( low, & lowTime, lowPose, lowSpeed ) ) continue;
+		if ( ! this->read( high, & highTime, highPose, highSpeed ) ) continue;
+
+		double fraction = (double) ( time - lowTime ) / ( highTime - lowTime );
+		double turn = atan2( sin( highPose[ 2 ] - lowPose[ 2 ] ), cos( highPose[ 2 ] - lowPose[ 2 ] ) );
+
+		pose[ 0 ] = lowPose[ 0 ] + fraction * ( highPose[ 0 ] - lowPose[ 0 ] );
+		pose[ 1 ] = lowPose[ 1 ] + fraction * ( highPose[ 1 ] - lowPose[ 1 ] );
+		pose[ 2 ] = lowPose[ 2 ] + fraction * turn;
+		pose[ 2 ] = atan2( sin( pose[ 2 ] ), cos( pose[ 2 ] ) );
+		if ( speed )
+			for ( unsigned int i = 0; i < 3; i++ )
+				speed[ i ] = lowSpeed[ i ] + fraction * ( highSpeed[ i ] - lowSpeed[ i ] );
+		return true;
+	}
+
+	return false;
+}
+
+// Private functions
+
+bool
+PoseHistory::read( unsigned int index, unsigned int * time, double * pose, float * speed )
+{
+	const Entry & entry = this->entries[ index % POSEHISTORY_SIZE ];
+
+	unsigned int version = entry.version.load( std::memory_order_acquire );
+	if ( version & 1 ) return false;
+
+	* time = entry.time.load( std::memory_order_relaxed );
+	for ( unsigned int i = 0; i < 3; i++ )
+	{
+		if ( pose ) pose[ i ] = entry.pose[ i ].load( std::memory_order_relaxed );
+		if ( speed ) speed[ i ] = entry.speed[ i ].load( std::memory_order_relaxed );
+	}
+
+	std::atomic_thread_fence( std::memory_order_acquire );
+	if ( entry.version.load( std::memory_order_relaxed ) != version ) return false;
+
+	// The entry may have been written over completely since the index was
+	// valid, then it holds a newer pose
+	return this->count.load( std::memory_order_acquire ) - index < POSEHISTORY_SIZE;
+}
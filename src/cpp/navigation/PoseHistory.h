@@ -0,0 +1,108 @@
+/**
+ * @file	PoseHistory.h
+ * @brief	Header file for the PoseHistory class
+ */
+#ifndef POSEHISTORY_H
+#define POSEHISTORY_H
+
+#include <atomic>
+
+
+/// Number of poses kept. With odometry readings every 10 to 50 ms this covers
+/// 2.5 to 12 seconds.
+#define POSEHISTORY_SIZE	256
+/// Longest time a pose is extrapolated past the newest one, in msecs
+#define POSEHISTORY_MAX_EXTRAPOLATION	100
+/// Times a lookup starts over when the poses it read were overwritten
+#define POSEHISTORY_RETRIES	4
+
+
+/**
+ * Timestamped history of Robotinos pose and speed
+ *
+ * Measurements like Kinect positions and laser scans arrive some time after
+ * they were taken. lookup() gives the pose at that time, interpolated between
+ * the two poses around it in O(log n), so they can be paired with where
+ * Robotino actually was.
+ *
+ * One thread adds poses, any number of threads look them up, and none of
+ * them wait for a lock. Poses are kept in a ring of POSEHISTORY_SIZE
+ * entries. Each entry has a version that is odd while it is written, so a
+ * lookup that read an entry being overwritten notices and starts over.
+ *
+ * See @link PoseHistory.h @endlink for documentation of @c \#define
+ * parameters
+ */
+class PoseHistory
+{
+ public:
+	PoseHistory();
+
+	/**
+	 * Adds the newest pose. Times must not decrease. Only one thread may add.
+	 *
+	 * @param	time	Time of the pose, in msecs
+	 * @param	pose	x, y and heading
+	 * @param	speed	vx, vy and omega, in Robotinos frame
+	 */
+	void add( unsigned int time, const double * pose, const float * speed );
+
+	/**
+	 * Forgets all poses, for when the pose jumped. Only the thread adding
+	 * poses may clear.
+	 */
+	void clear();
+
+	/**
+	 * Gets the pose at a time
+	 *
+	 * Between two poses the position, heading and speed are interpolated.
+	 * After the newest pose it is extrapolated at the newest speeds, for at
+	 * most POSEHISTORY_MAX_EXTRAPOLATION msecs.
+	 *
+	 * @param	time	The time, in msecs
+	 * @param	pose	Set to x, y and heading
+	 * @param	speed	Set to vx, vy and omega, unless null
+	 *
+	 * @return	False if the time is not covered
+	 */
+	bool lookup( unsigned int time, double * pose, float * speed = 0 );
+
+ private:
+	/**
+	 * A pose with its time, every value atomic so it may be read while
+	 * written
+	 */
+	struct Entry
+	{
+		/// Odd while being written, raised by 2 for every write
+		std::atomic< unsigned int > version;
+		std::atomic< unsigned int > time;
+		std::atomic< double > pose[ 3 ];
+		std::atomic< float > speed[ 3 ];
+	};
+
+	Entry
+	/// The ring of poses
+		entries[ POSEHISTORY_SIZE ];
+
+	std::atomic< unsigned int >
+	/// Number of poses ever added
+		count,
+	/// Number of poses added before the last clear()
+		first;
+
+	/**
+	 * Reads an entry, unless it is being written
+	 *
+	 * @param	index	Number of the pose, counted like count
+	 * @param	time	Set to the time
+	 * @param	pose	Set to the pose, unless null
+	 * @param	speed	Set to the speed, unless null
+	 *
+	 * @return	False if the entry was written while read
+	 */
+	bool read( unsigned int index, unsigned int * time, double * pose, float * speed );
+};
+
+#endif
@@ -0,0 +1,155 @@
+#include "PurePursuit.h"
+
+#include <math.h>
+#include <algorithm>
+
+
+PurePursuit::PurePursuit()
+{
+	this->segment = 0;
+	this->progress = 0.0;
+	this->active = false;
+}
+
+void
+PurePursuit::setPath( std::vector< Coordinate > path )
+{
+	this->path = path;
+	this->distance.assign( path.size(), 0.0 );
+	for ( unsigned int i = 1; i < path.size(); i++ )
+		this->distance[ i ] = this->distance[ i - 1 ] + this->path[ i - 1 ].getVector( this->path[ i ] ).magnitude();
+
+	this->segment = 0;
+	this->progress = 0.0;
+	this->active = ! path.empty();
+	if ( this->active ) this->_lookahead = this->path[ 0 ];
+}
+
+void
+PurePursuit::clear()
+{
+	this->active = false;
+}
+
+bool
+PurePursuit::isActive()
+{
+	return this->active;
+}
+
+unsigned int
+PurePursuit::verticesLeft()
+{
+	if ( ! this->active ) return 0;
+	return this->path.size() - this->segment - 1;
+}
+
+Coordinate
+PurePursuit::end()
+{
+	return this->path.back();
+}
+
+Coordinate
+PurePursuit::lookahead()
+{
+	return this->_lookahead;
+}
+
+Vector
+PurePursuit::velocity( Coordinate position, Vector currentVelocity )
+{
+	if ( ! this->active ) return Vector();
+
+	float along = this->closest( position );
+	float left = this->distance.back() - along;
+
+	// Done when at the end, not when the closest point is, in case the path
+	// ends behind an obstacle we were pushed away from
+	if ( left < PUREPURSUIT_END_DISTANCE
+			&& position.getVector( this->path.back() ).magnitude() < PUREPURSUIT_END_DISTANCE )
+	{
+		this->active = false;
+		return Vector();
+	}
+
+	float lookahead = PUREPURSUIT_LOOKAHEAD_MIN + PUREPURSUIT_LOOKAHEAD_GAIN * currentVelocity.magnitude();
+	if ( lookahead > PUREPURSUIT_LOOKAHEAD_MAX ) lookahead = PUREPURSUIT_LOOKAHEAD_MAX;
+
+	this->_lookahead = this->pointAt( along + lookahead );
+	Vector target = position.getVector( this->_lookahead );
+
+	// Curvature of the arc turning the current velocity onto the lookahead
+	// point: 2 sin( alpha ) / L
+	float speed = PUREPURSUIT_MAX_SPEED;
+	if ( currentVelocity.magnitude() > 0.0 && target.magnitude() > 0.0 )
+	{
+		float alpha = currentVelocity.deltaAngle( target ).phi();
+		float curvature = 2.0 * fabs( sin( alpha ) ) / target.magnitude();
+		if ( curvature > 0.0 )
+			speed = std::min( speed, (float) sqrt( PUREPURSUIT_MAX_LATERAL_ACCELERATION / curvature ) );
+	}
+
+	// Be able to stop at the end
+	float endDistance = std::max( left, target.magnitude() );
+	speed = std::min( speed, (float) sqrt( 2.0 * PUREPURSUIT_MAX_DECELLERATION * endDistance ) );
+	speed = std::max( speed, (float) PUREPURSUIT_MIN_SPEED );
+
+	return Vector( speed, target.phi() );
+}
+
+
+// Private functions
+
+float
+PurePursuit::closest( Coordinate position )
+{
+	float bestDistance = -1.0;
+	float bestAlong = this->progress;
+	unsigned int bestSegment = this->segment;
+
+	float px = position.x(), py = position.y();
+
+	for ( unsigned int i = this->segment; i + 1 < this->path.size(); i++ )
+	{
+		// Paths may loop back close to themselves, stay near the progress made
+		if ( i > this->segment && this->distance[ i ] > this->progress + PUREPURSUIT_LOOKAHEAD_MAX ) break;
+
+		float ax = this->path[ i ].x(), ay = this->path[ i ].y();
+		float dx = this->path[ i + 1 ].x() - ax, dy = this->path[ i + 1 ].y() - ay;
+		float length2 = dx * dx + dy * dy;
+
+		float t = ( length2 > 0.0 ) ? ( ( px - ax ) * dx + ( py - ay ) * dy ) / length2 : 0.0;
+		t = std::max( 0.0f, std::min( 1.0f, t ) );
+
+		float cx = ax + t * dx - px, cy = ay + t * dy - py;
+		float d = cx * cx + cy * cy;
+
+		if ( bestDistance < 0.0 || d < bestDistance )
+		{
+			bestDistance = d;
+			bestSegment = i;
+			bestAlong = this->distance[ i ] + t * sqrt( length2 );
+		}
+	}
+
+	this->segment = bestSegment;
+	this->progress = bestAlong;
+	return bestAlong;
+}
+
+Coordinate
+PurePursuit::pointAt( float along )
+{
+	if ( along >= this->distance.back() ) return this->path.back();
+
+	unsigned int i = this->segment;
+	while ( i + 2 < this->path.size() && this->distance[ i + 1 ] < along ) i++;
+
+	float length = this->distance[ i + 1 ] - this->distance[ i ];
+	float t = ( length > 0.0 ) ? ( along - this->distance[ i ] ) / length : 0.0;
+
+	return Coordinate(
+			this->path[ i ].x() + t * ( this->path[ i + 1 ].x() - this->path[ i ].x() ),
+			this->path[ i ].y() + t * ( this->path[ i + 1 ].y() - this->path[ i ].y() ) );
+}
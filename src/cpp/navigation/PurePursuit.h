@@ -0,0 +1,153 @@
+/**
+ * @file	PurePursuit.h
+ * @brief	Header file for the PurePursuit class
+ */
+#ifndef PUREPURSUIT_H
+#define PUREPURSUIT_H
+
+#include "../geometry/Coordinate.h"
+#include "../geometry/Vector.h"
+
+#include <vector>
+
+
+/// Lookahead distance at standstill, in meters
+#define PUREPURSUIT_LOOKAHEAD_MIN	0.15
+/// Lookahead distance added per m/s of speed, in seconds
+#define PUREPURSUIT_LOOKAHEAD_GAIN	1.0
+/// The longest lookahead distance, in meters
+#define PUREPURSUIT_LOOKAHEAD_MAX	0.5
+/// The maximum speed along the path, in m/s
+#define PUREPURSUIT_MAX_SPEED	0.3
+/// The minimum speed along the path, in m/s, until the end is reached
+#define PUREPURSUIT_MIN_SPEED	0.05
+/// The maximum acceleration towards the center of a curve, in m/s^2.
+/// Speed in a curve is limited to sqrt( this / curvature ).
+#define PUREPURSUIT_MAX_LATERAL_ACCELERATION	0.3
+/// The decelleration used for stopping at the end of the path, in m/s^2
+#define PUREPURSUIT_MAX_DECELLERATION	0.4
+/// Distance to the end of the path that counts as arrived, in meters
+#define PUREPURSUIT_END_DISTANCE	0.02
+
+
+/**
+ * Pure pursuit path follower for the holonomic drive
+ *
+ * Tracks a polyline by heading for a point a lookahead distance further
+ * along the path than the closest point, the lookahead growing with speed.
+ * Since Robotino can drive in any direction the velocity simply points at
+ * the lookahead point, which rounds off the vertices instead of stopping at
+ * them.
+ *
+ * The speed is limited by the curvature of the arc from the current
+ * velocity to the lookahead point, keeping the lateral acceleration below
+ * PUREPURSUIT_MAX_LATERAL_ACCELERATION, and by the distance left to the end
+ * of the path.
+ *
+ * See @link PurePursuit.h @endlink for documentation of @c \#define
+ * parameters
+ */
+class PurePursuit
+{
+ public:
+	PurePursuit();
+
+	/**
+	 * Sets a new path to follow, starting from its beginning
+	 *
+	 * @param	path	Vertexes of the polyline, at least one
+	 */
+	void setPath( std::vector< Coordinate > path );
+
+	/**
+	 * Drops the current path
+	 */
+	void clear();
+
+	/**
+	 * Checks if a path is set and its end has not been reached
+	 *
+	 * @return	Boolean indicating if following a path
+	 */
+	bool isActive();
+
+	/**
+	 * Gets the number of path vertexes not yet passed
+	 *
+	 * @return	Number of vertexes ahead, 0 when no path is followed
+	 */
+	unsigned int verticesLeft();
+
+	/**
+	 * Gets the last vertex of the path
+	 *
+	 * @return	The end of the path
+	 */
+	Coordinate end();
+
+	/**
+	 * Gets the lookahead point of the last call to velocity()
+	 *
+	 * @return	The lookahead point
+	 */
+	Coordinate lookahead();
+
+	/**
+	 * Calculates the velocity to follow the path with, and moves on along
+	 * the path. When the end is reached the path is no longer active and the
+	 * velocity is 0.
+	 *
+	 * @param	position	Current position
+	 * @param	currentVelocity	Current velocity, in the world frame
+	 *
+	 * @return	The velocity to drive at, in the world frame
+	 */
+	Vector velocity( Coordinate position, Vector currentVelocity );
+
+ private:
+	std::vector< Coordinate >
+	/// Vertexes of the path
+		path;
+
+	std::vector< float >
+	/// Distance along the path to each vertex
+		distance;
+
+	unsigned int
+	/// Index of the segment the closest point is on
+		segment;
+
+	float
+	/// Distance along the path to the closest point
+		progress;
+
+	bool
+	/// If a path is followed
+		active;
+
+	Coordinate
+	/// The last lookahead point
+		_lookahead;
+
+	/**
+	 * Finds the point on the path closest to a position, looking only
+	 * forward from the current segment and not further than the longest
+	 * lookahead past @c progress, and moves @c segment and @c progress to it
+	 *
+	 * @param	position	The position
+	 *
+	 * @return	Distance along the path to the closest point
+	 */
+	float closest( Coordinate position );
+
+	/**
+	 * Gets the point at a distance along the path
+	 *
+	 * @param	along	Distance along the path, clamped to the path
+	 *
+	 * @return	The point
+	 */
+	Coordinate pointAt( float along );
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "ScanDescriptor.h"
+
+#ifndef _USE_MATH_DEFINES
+#define _USE_MATH_DEFINES
+#endif
+#include <math.h>
+#include <algorithm>
+
+
+ScanDescriptor::ScanDescriptor()
+{
+	std::fill( this->rings, this->rings + SCANDESCRIPTOR_SIZE, 0.0f );
+	std::fill( this->sectors, this->sectors + SCANDESCRIPTOR_SECTORS, 0.0f );
+}
+
+void
+ScanDescriptor::compute( const float * x, const float * y, unsigned int count )
+{
+	std::fill( this->rings, this->rings + SCANDESCRIPTOR_SIZE, 0.0f );
+	std::fill( this->sectors, this->sectors + SCANDESCRIPTOR_SECTORS, 0.0f );
+
+	// Bit per sector of each ring, 72 sectors fit in three words
+	static const int WORDS = ( SCANDESCRIPTOR_SECTORS + 31 ) / 32;
+	unsigned int occupied[ SCANDESCRIPTOR_RINGS ][ WORDS ] = { { 0 } };
+
+	unsigned int counted = 0;
+	for ( unsigned int i = 0; i < count; i++ )
+	{
+		int ring = (int) ( sqrt( x[ i ] * x[ i ] + y[ i ] * y[ i ] ) / SCANDESCRIPTOR_RING_WIDTH );
+		if ( ring >= SCANDESCRIPTOR_RINGS ) continue;
+
+		int sector = (int) ( ( atan2( y[ i ], x[ i ] ) + M_PI ) / ( 2.0 * M_PI ) * SCANDESCRIPTOR_SECTORS );
+		sector = std::min( sector, SCANDESCRIPTOR_SECTORS - 1 );
+
+		this->rings[ ring ] += 1.0;
+		this->sectors[ sector ] += 1.0;
+		occupied[ ring ][ sector / 32 ] |= 1u << ( sector % 32 );
+		counted++;
+	}
+	if ( counted == 0 ) return;
+
+	for ( int ring = 0; ring < SCANDESCRIPTOR_RINGS; ring++ )
+	{
+		unsigned int sectors = 0;
+		for ( int word = 0; word < WORDS; word++ )
+			for ( unsigned int bits = occupied[ ring ][ word ]; bits != 0; bits &= bits - 1 )
+				sectors++;
+
+		this->rings[ ring ] /= counted;
+		this->rings[ SCANDESCRIPTOR_RINGS + ring ] = (float) sectors / SCANDESCRIPTOR_SECTORS;
+	}
+	for ( int sector = 0; sector < SCANDESCRIPTOR_SECTORS; sector++ )
+		this->sectors[ sector ] /= counted;
+}
+
+const float *
+ScanDescriptor::values() const
+{
+	return this->rings;
+}
+
+float
+ScanDescriptor::heading( const ScanDescriptor & other ) const
+{
+	// Circular correlation of the sector histograms, turning other by a
+	// sector at a time
+	int bestShift = 0;
+	float best = -1.0;
+	for ( int shift = 0; shift < SCANDESCRIPTOR_SECTORS; shift++ )
+	{
+		// Normalized over the sectors both see, as the laser does not see
+		// behind Robotino and a turn shifts what each misses
+		float sum = 0.0, thisSquares = 0.0, otherSquares = 0.0;
+		for ( int sector = 0; sector < SCANDESCRIPTOR_SECTORS; sector++ )
+		{
+			float a = this->sectors[ sector ];
+			float b = other.sectors[ ( sector - shift + SCANDESCRIPTOR_SECTORS ) % SCANDESCRIPTOR_SECTORS ];
+			if ( a == 0.0 || b == 0.0 ) continue;
+			sum += a * b;
+			thisSquares += a * a;
+			otherSquares += b * b;
+		}
+		if ( sum == 0.0 ) continue;
+		sum /= sqrt( thisSquares * otherSquares );
+
+		if ( sum > best )
+		{
+			best = sum;
+			bestShift = shift;
+		}
+	}
+
+	float angle = bestShift * 2.0 * M_PI / SCANDESCRIPTOR_SECTORS;
+	return ( angle > M_PI ) ? angle - 2.0 * M_PI : angle;
+}
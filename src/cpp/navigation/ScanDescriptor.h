@@ -0,0 +1,79 @@
+/**
+ * @file	ScanDescriptor.h
+ * @brief	Header file for the ScanDescriptor class
+ */
+#ifndef SCANDESCRIPTOR_H
+#define SCANDESCRIPTOR_H
+
+
+/// Number of rings around Robotino the points are counted in
+#define SCANDESCRIPTOR_RINGS	16
+/// Width of a ring, in meters. 16 rings of 0.35 m reach the 5.6 m of the
+/// laser.
+#define SCANDESCRIPTOR_RING_WIDTH	0.35
+/// Number of angular sectors, for rings and the heading histogram
+#define SCANDESCRIPTOR_SECTORS	72
+/// Number of values of a descriptor: the share of points and the share of
+/// occupied sectors of each ring
+#define SCANDESCRIPTOR_SIZE	( 2 * SCANDESCRIPTOR_RINGS )
+
+
+/**
+ * Compact summary of the points around a place, for recognizing it again
+ *
+ * values() holds, for every ring around Robotino, the share of the points
+ * falling in it and the share of its sectors holding any point. Turning on
+ * the spot moves points between sectors but not between rings, so the
+ * values do not depend on the heading, and places can be compared by the
+ * distance between their values alone.
+ *
+ * The share of points in each sector is kept apart, for heading() to find
+ * the turn between two descriptors of the same place.
+ *
+ * See @link ScanDescriptor.h @endlink for documentation of @c \#define
+ * parameters
+ */
+class ScanDescriptor
+{
+ public:
+	/**
+	 * Constructs an empty ScanDescriptor
+	 */
+	ScanDescriptor();
+
+	/**
+	 * Works out the descriptor of points around a place
+	 *
+	 * @param	x	x of the points, in the frame of the place
+	 * @param	y	y of the points
+	 * @param	count	Number of points
+	 */
+	void compute( const float * x, const float * y, unsigned int count );
+
+	/**
+	 * Gets the values that do not depend on the heading
+	 *
+	 * @return	Pointer to SCANDESCRIPTOR_SIZE values
+	 */
+	const float * values() const;
+
+	/**
+	 * Gets the turn that lines up another descriptor of the same place with
+	 * this one
+	 *
+	 * @param	other	The other descriptor
+	 *
+	 * @return	Angle to turn the frame of other by to get the frame of this,
+	 * in rad, to the nearest sector
+	 */
+	float heading( const ScanDescriptor & other ) const;
+
+ private:
+	float
+	/// Share of points and of occupied sectors of each ring
+		rings[ SCANDESCRIPTOR_SIZE ],
+	/// Share of points in each sector
+		sectors[ SCANDESCRIPTOR_SECTORS ];
+};
+
+#endif
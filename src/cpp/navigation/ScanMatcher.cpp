@@ -0,0 +1,163 @@
+#include "ScanMatcher.h"
+
+#include <math.h>
+#include <algorithm>
+#include <limits>
+
+
+ScanMatcher::ScanMatcher()
+	: grid(
+			(int) ( SCANMATCHER_SIZE / OCCUPANCYGRID_RESOLUTION ),
+			(int) ( SCANMATCHER_SIZE / OCCUPANCYGRID_RESOLUTION ),
+			OCCUPANCYGRID_RESOLUTION,
+			Coordinate( - SCANMATCHER_SIZE / 2.0, - SCANMATCHER_SIZE / 2.0 ) ),
+	  likelihood( SCANMATCHER_SIGMA, SCANMATCHER_MAX_DISTANCE, LIKELIHOODFIELD_HIT_WEIGHT )
+{}
+
+void
+ScanMatcher::setReference( const float * x, const float * y, unsigned int count, float join )
+{
+	int width = this->grid.width();
+	for ( unsigned int i = 0; i < this->drawn.size(); i++ )
+		this->grid.setCell( this->drawn[ i ] % width, this->drawn[ i ] / width, OCCUPANCYGRID_FREE );
+	this->drawn.clear();
+
+	int column, row;
+	float step = this->grid.resolution() / 2.0;
+	for ( unsigned int i = 0; i < count; i++ )
+	{
+		// Half cell steps from the point before, so the line has no holes
+		int steps = 0;
+		if ( i > 0 )
+		{
+			float length = sqrt( ( x[ i ] - x[ i - 1 ] ) * ( x[ i ] - x[ i - 1 ] ) + ( y[ i ] - y[ i - 1 ] ) * ( y[ i ] - y[ i - 1 ] ) );
+			if ( length <= join ) steps = (int) ( length / step );
+		}
+
+		for ( int s = steps; s >= 0; s-- )
+		{
+			float share = (float) s / ( steps + 1 );
+			Coordinate point = ( s == 0 ) ? Coordinate( x[ i ], y[ i ] )
+				: Coordinate( x[ i ] + share * ( x[ i - 1 ] - x[ i ] ), y[ i ] + share * ( y[ i - 1 ] - y[ i ] ) );
+			if ( ! this->grid.toCell( point, & column, & row ) ) continue;
+			if ( this->grid.cell( column, row ) == OCCUPANCYGRID_OCCUPIED ) continue;
+			this->grid.setCell( column, row, OCCUPANCYGRID_OCCUPIED );
+			this->drawn.push_back( row * width + column );
+		}
+	}
+
+	this->likelihood.build( & this->grid );
+}
+
+bool
+ScanMatcher::match( const float * x, const float * y, unsigned int count, const double * guess,
+		float window, float angleWindow, double * pose, float * fit )
+{
+	* fit = 0.0;
+	pose[ 0 ] = guess[ 0 ];
+	pose[ 1 ] = guess[ 1 ];
+	pose[ 2 ] = guess[ 2 ];
+	if ( count == 0 || this->drawn.empty() ) return false;
+	this->guessX = guess[ 0 ];
+	this->guessY = guess[ 1 ];
+	this->guessPhi = guess[ 2 ];
+
+	this->offsetColumn.resize( count );
+	this->offsetRow.resize( count );
+
+	// Every cell and heading step of the window
+	float step = this->likelihood.resolution();
+	float angleStep = SCANMATCHER_ANGLE_STEP;
+	int cells = (int) ceil( window / step );
+	int angles = (int) ceil( angleWindow / angleStep );
+	float best = - std::numeric_limits< float >::max();
+
+	for ( int a = - angles; a <= angles; a++ )
+	{
+		double phi = guess[ 2 ] + a * angleStep;
+		if ( this->search( x, y, count, guess[ 0 ], guess[ 1 ], phi, cells, step, & pose[ 0 ], & pose[ 1 ], & best ) )
+			pose[ 2 ] = phi;
+	}
+
+	// Then the neighbours of the best pose, closer each time
+	for ( int level = 0; level < SCANMATCHER_REFINEMENTS; level++ )
+	{
+		step /= 2.0;
+		angleStep /= 2.0;
+		double centerX = pose[ 0 ], centerY = pose[ 1 ], centerPhi = pose[ 2 ];
+
+		for ( int a = -1; a <= 1; a++ )
+		{
+			double phi = centerPhi + a * angleStep;
+			if ( this->search( x, y, count, centerX, centerY, phi, 1, step, & pose[ 0 ], & pose[ 1 ], & best ) )
+				pose[ 2 ] = phi;
+		}
+	}
+
+	float c = cos( pose[ 2 ] ), s = sin( pose[ 2 ] );
+	float limit = this->likelihood.value( (float) SCANMATCHER_FIT_DISTANCE );
+	unsigned int close = 0;
+	for ( unsigned int i = 0; i < count; i++ )
+	{
+		Coordinate point( pose[ 0 ] + c * x[ i ] - s * y[ i ], pose[ 1 ] + s * x[ i ] + c * y[ i ] );
+		if ( this->likelihood.value( point ) >= limit ) close++;
+	}
+	* fit = (float) close / count;
+
+	return * fit >= SCANMATCHER_MIN_FIT;
+}
+
+// Private functions
+
+bool
+ScanMatcher::search( const float * x, const float * y, unsigned int count, double centerX, double centerY,
+		double phi, int cells, float step, double * bestX, double * bestY, float * best )
+{
+	const float * field = this->likelihood.values();
+	int width = this->likelihood.width();
+	float inverse = 1.0 / this->likelihood.resolution();
+	float lastColumn = width - 1, lastRow = this->likelihood.height() - 1;
+
+	// Rotating the points once per heading leaves a shift per position
+	float c = cos( phi ) * inverse, s = sin( phi ) * inverse;
+	for ( unsigned int i = 0; i < count; i++ )
+	{
+		this->offsetColumn[ i ] = c * x[ i ] - s * y[ i ];
+		this->offsetRow[ i ] = s * x[ i ] + c * y[ i ];
+	}
+
+	// Mean log-likelihood, so the penalty weighs the same for any count
+	float inverseCount = 1.0 / count;
+	float turn = phi - this->guessPhi;
+	float turnPenalty = SCANMATCHER_GUESS_PENALTY * turn * turn;
+
+	bool found = false;
+	for ( int dy = - cells; dy <= cells; dy++ )
+		for ( int dx = - cells; dx <= cells; dx++ )
+		{
+			double poseX = centerX + dx * step, poseY = centerY + dy * step;
+			float baseColumn = ( poseX - this->likelihood.origin().x() ) * inverse;
+			float baseRow = ( poseY - this->likelihood.origin().y() ) * inverse;
+
+			float score = 0.0;
+			for ( unsigned int i = 0; i < count; i++ )
+			{
+				float column = std::min( std::max( baseColumn + this->offsetColumn[ i ], 0.0f ), lastColumn );
+				float row = std::min( std::max( baseRow + this->offsetRow[ i ], 0.0f ), lastRow );
+				score += field[ (int) row * width + (int) column ];
+			}
+
+			float offX = poseX - this->guessX, offY = poseY - this->guessY;
+			score = score * inverseCount - turnPenalty - SCANMATCHER_GUESS_PENALTY * ( offX * offX + offY * offY );
+
+			if ( score > * best )
+			{
+				* best = score;
+				* bestX = poseX;
+				* bestY = poseY;
+				found = true;
+			}
+		}
+
+	return found;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file	ScanMatcher.h
+ * @brief	Header file for the ScanMatcher class
+ */
+#ifndef SCANMATCHER_H
+#define SCANMATCHER_H
+
+#include "../obstacle/OccupancyGrid.h"
+#include "../obstacle/LikelihoodField.h"
+
+#include <vector>
+
+
+/// Edge length of the grid the reference scan is drawn into, in meters.
+/// Laser readings reach 5.6 m, so this holds a scan from any pose within it.
+#define SCANMATCHER_SIZE	12.0
+/// Deviation of a point from the reference, in meters. Narrower than
+/// LIKELIHOODFIELD_SIGMA, as both scans see the same things.
+#define SCANMATCHER_SIGMA	0.05
+/// Distance to the reference above which all points score the same, in
+/// meters
+#define SCANMATCHER_MAX_DISTANCE	0.25
+/// Heading step of the coarse search, in rad. At 5 m a step moves the
+/// farthest points by 0.1 m, about the width of the likelihood peak.
+#define SCANMATCHER_ANGLE_STEP	0.02
+/// Number of times the coarse step is halved around the best pose
+#define SCANMATCHER_REFINEMENTS	3
+/// Taken off the mean log-likelihood of the points per squared meter and
+/// rad from the guess. Small against a real peak, but along a corridor,
+/// where every pose scores about the same, it keeps the guess instead of
+/// whichever end of the window is searched first.
+#define SCANMATCHER_GUESS_PENALTY	0.1
+/// Distance from the reference within which a point counts as fitting, in
+/// meters
+#define SCANMATCHER_FIT_DISTANCE	0.1
+/// Share of points that must fit for a match to count
+#define SCANMATCHER_MIN_FIT	0.7
+
+
+/**
+ * Finds where one laser scan was taken relative to another
+ *
+ * The reference scan is drawn into a small OccupancyGrid and turned into a
+ * LikelihoodField, as MonteCarloLocalizer does with the static map. match()
+ * tries every pose of a window around a guess, in steps of a cell and
+ * SCANMATCHER_ANGLE_STEP, and scores it by the sum of the likelihoods of
+ * the points. The best pose is then refined with smaller steps.
+ *
+ * A brute force search does not get stuck in the nearest local optimum like
+ * ICP would, so matches against old scans with a poor guess work as well,
+ * which closing loops needs.
+ *
+ * See @link ScanMatcher.h @endlink for documentation of @c \#define parameters
+ */
+class ScanMatcher
+{
+ public:
+	/**
+	 * Constructs ScanMatcher
+	 */
+	ScanMatcher();
+
+	/**
+	 * Sets the scan to match against
+	 *
+	 * @param	x	x of the points, in the frame of the reference
+	 * @param	y	y of the points
+	 * @param	count	Number of points
+	 * @param	join	Longest distance between two points in a row that are
+	 * drawn as a line between them, in meters. Points of one scan in the
+	 * order of the readings lie along surfaces, and drawing the surfaces keeps
+	 * a scan taken a little further along them from fitting best where it
+	 * stands still. 0 draws the points only.
+	 */
+	void setReference( const float * x, const float * y, unsigned int count, float join = 0.0 );
+
+	/**
+	 * Finds the pose of a scan in the frame of the reference
+	 *
+	 * @param	x	x of the points, in the frame of the scan
+	 * @param	y	y of the points
+	 * @param	count	Number of points
+	 * @param	guess	Guessed x, y and heading
+	 * @param	window	Distance from the guess searched in x and y, in meters
+	 * @param	angleWindow	Angle from the guess searched, in rad
+	 * @param	pose	Set to the best x, y and heading found
+	 * @param	fit	Set to the share of points within
+	 * SCANMATCHER_FIT_DISTANCE of the reference from there
+	 *
+	 * @return	True if the share is at least SCANMATCHER_MIN_FIT
+	 */
+	bool match( const float * x, const float * y, unsigned int count, const double * guess,
+			float window, float angleWindow, double * pose, float * fit );
+
+ private:
+	OccupancyGrid
+	/// The reference scan
+		grid;
+
+	LikelihoodField
+	/// Log-likelihood of a point landing on each cell of grid
+		likelihood;
+
+	double
+	/// The guess of the current match
+		guessX,
+		guessY,
+		guessPhi;
+
+	std::vector< int >
+	/// Cells of grid set by the last reference, to clear for the next
+		drawn;
+
+	std::vector< float >
+	/// Offset of each point from the pose, in cells, for one heading
+		offsetColumn,
+		offsetRow;
+
+	/**
+	 * Scores all positions of a window for one heading
+	 *
+	 * @param	x	x of the points
+	 * @param	y	y of the points
+	 * @param	count	Number of points
+	 * @param	centerX	x of the center of the window, in meters
+	 * @param	centerY	y of the center
+	 * @param	phi	The heading
+	 * @param	cells	Distance searched from the center, in steps
+	 * @param	step	Step of x and y, in meters
+	 * @param	bestX	Set to x of the best position if better than best
+	 * @param	bestY	Set to y of the best position
+	 * @param	best	The best score so far, updated
+	 *
+	 * @return	True if a better position was found
+	 */
+	bool search( const float * x, const float * y, unsigned int count, double centerX, double centerY,
+			double phi, int cells, float step, double * bestX, double * bestY, float * best );
+};
+
+#endif
@@ -0,0 +1,241 @@
+#include "SlipDetector.h"
+
+#include "../robotino/headers/Brain.h"
+#include "../robotino/headers/_Odometry.h"
+#include "../robotino/headers/_OmniDrive.h"
+#include "../robotino/headers/_LaserRangeFinder.h"
+
+#include <math.h>
+#include <algorithm>
+#include <iostream>
+
+
+SlipDetector::SlipDetector( Brain * pBrain )
+	: Axon::Axon( pBrain )
+{
+	SlipDetector::clear( this->command );
+	SlipDetector::clear( this->scan );
+
+	this->slipping = false;
+	this->_slips = 0;
+	this->lastScanTime = 0;
+	this->lastOdometryTime = 0;
+	this->lastCommand[ 0 ] = 0.0;
+	this->lastCommand[ 1 ] = 0.0;
+	this->lastCommand[ 2 ] = 0.0;
+	this->referenced = false;
+	this->observed[ 0 ] = this->observed[ 3 ] = 1.0;
+	this->observed[ 1 ] = this->observed[ 2 ] = 0.0;
+}
+
+bool
+SlipDetector::isSlipping()
+{
+	return this->slipping;
+}
+
+unsigned int
+SlipDetector::slips()
+{
+	return this->_slips;
+}
+
+float
+SlipDetector::evidence()
+{
+	return std::max( this->command.sum, this->scan.sum ) / SLIPDETECTOR_THRESHOLD;
+}
+
+void
+SlipDetector::analyze()
+{
+	this->compareCommand();
+	if ( this->brain()->hasLRF() ) this->compareScan();
+
+	bool slipping = this->command.sum > SLIPDETECTOR_THRESHOLD || this->scan.sum > SLIPDETECTOR_THRESHOLD;
+	if ( slipping == this->slipping ) return;
+
+	// The estimator is told at once, _OmniDrive asks before it applies
+	this->slipping = slipping;
+	this->brain()->odom()->setSlipping( slipping );
+	if ( slipping )
+	{
+		this->_slips++;
+		std::cout << "SlipDetector: wheels slipping, "
+			<< ( ( this->command.sum > SLIPDETECTOR_THRESHOLD ) ? "not following commands" : "not moving as the laser sees" )
+			<< std::endl;
+	}
+	else
+		std::cout << "SlipDetector: traction regained" << std::endl;
+}
+
+void
+SlipDetector::apply()
+{}  /// Should be empty, _OmniDrive and _Odometry react themselves
+
+// Private functions
+
+void
+SlipDetector::compareCommand()
+{
+	float commanded[ 3 ];
+	this->brain()->drive()->commandedSpeed( & commanded[ 0 ], & commanded[ 1 ], & commanded[ 2 ] );
+
+	// Only a new reading tells anything new
+	unsigned int now = this->brain()->msecsElapsed();
+	unsigned int readingTime = now - this->brain()->odom()->dataAge();
+	bool fresh = readingTime != this->lastOdometryTime && this->brain()->odom()->dataAge() <= BRAIN_DATA_MAX_AGE;
+	this->lastOdometryTime = readingTime;
+
+	if ( fresh )
+	{
+		float measured[ 3 ];
+		this->brain()->odom()->currentSpeed( & measured[ 0 ], & measured[ 1 ], & measured[ 2 ] );
+
+		const float base[ 3 ] = { SLIPDETECTOR_SPEED_DEVIATION, SLIPDETECTOR_SPEED_DEVIATION, SLIPDETECTOR_OMEGA_DEVIATION };
+		float lag = SLIPDETECTOR_LAG / this->brain()->drive()->cycleTime();
+
+		double normalized[ 3 ];
+		for ( unsigned int i = 0; i < 3; i++ )
+		{
+			float deviation = base[ i ] + lag * fabs( commanded[ i ] - this->lastCommand[ i ] );
+			normalized[ i ] = ( measured[ i ] - commanded[ i ] ) / deviation;
+		}
+		SlipDetector::add( this->command, normalized );
+	}
+
+	for ( unsigned int i = 0; i < 3; i++ )
+		this->lastCommand[ i ] = commanded[ i ];
+}
+
+void
+SlipDetector::compareScan()
+{
+	unsigned int scanTime = this->brain()->lrf()->scanTime();
+	if ( scanTime == this->lastScanTime ) return;
+	this->lastScanTime = scanTime;
+
+	PreciseAngularCoordinate pose = this->brain()->odom()->getPosition( scanTime );
+	std::vector< Coordinate > points = this->brain()->lrf()->scanCoordinates( AngularCoordinate( 0.0, 0.0, 0.0 ) );
+	if ( points.empty() ) return;
+
+	unsigned int count = std::min( (unsigned int) points.size(), (unsigned int) SLIPDETECTOR_POINTS );
+	this->x.resize( count );
+	this->y.resize( count );
+	for ( unsigned int p = 0; p < count; p++ )
+	{
+		unsigned int i = p * points.size() / count;
+		this->x[ p ] = points[ i ].x();
+		this->y[ p ] = points[ i ].y();
+	}
+
+	if ( this->referenced )
+	{
+		// The odometry since the reference, in the frame of the reference
+		double c = cos( this->referencePose.phi() ), s = sin( this->referencePose.phi() );
+		double dx = pose.x() - this->referencePose.x(), dy = pose.y() - this->referencePose.y();
+		double dphi = pose.phi() - this->referencePose.phi();
+		double guess[ 3 ] = { c * dx + s * dy, - s * dx + c * dy, atan2( sin( dphi ), cos( dphi ) ) };
+		double length = sqrt( dx * dx + dy * dy );
+
+		double matched[ 3 ];
+		float fit;
+		if ( this->matcher.match( & this->x[ 0 ], & this->y[ 0 ], count, guess,
+				SLIPDETECTOR_SCAN_WINDOW, SLIPDETECTOR_SCAN_ANGLE_WINDOW, matched, & fit ) )
+		{
+			double deviation = SLIPDETECTOR_SCAN_DEVIATION + SLIPDETECTOR_SCAN_SCALE_DEVIATION * length;
+			double phiDeviation = SLIPDETECTOR_SCAN_PHI_DEVIATION
+				+ SLIPDETECTOR_SCAN_ROTATION_DEVIATION * fabs( guess[ 2 ] ) + SLIPDETECTOR_SCAN_DRIFT_DEVIATION * length;
+			double offX = matched[ 0 ] - guess[ 0 ], offY = matched[ 1 ] - guess[ 1 ];
+			double turn = matched[ 2 ] - guess[ 2 ];
+			double normalized[ 3 ] = {
+				( this->observed[ 0 ] * offX + this->observed[ 1 ] * offY ) / deviation,
+				( this->observed[ 2 ] * offX + this->observed[ 3 ] * offY ) / deviation,
+				atan2( sin( turn ), cos( turn ) ) / phiDeviation };
+			SlipDetector::add( this->scan, normalized );
+		}
+
+		// Keep the reference while it is near, so slip piles up against it
+		if ( length < SLIPDETECTOR_SCAN_DISTANCE && fabs( guess[ 2 ] ) < SLIPDETECTOR_SCAN_ANGLE ) return;
+	}
+
+	this->matcher.setReference( & this->x[ 0 ], & this->y[ 0 ], count, SLIPDETECTOR_NORMAL_SPAN );
+	this->constrain( count );
+	this->referencePose = pose;
+	this->referenced = true;
+}
+
+void
+SlipDetector::constrain( unsigned int count )
+{
+	// Sum of the outer products of the normals, each direction weighed by
+	// how many surfaces face it
+	double xx = 0.0, xy = 0.0, yy = 0.0;
+	unsigned int normals = 0;
+	for ( unsigned int i = 1; i + 1 < count; i++ )
+	{
+		double tx = this->x[ i + 1 ] - this->x[ i - 1 ], ty = this->y[ i + 1 ] - this->y[ i - 1 ];
+		double length = sqrt( tx * tx + ty * ty );
+		if ( length <= 0.0 || length > SLIPDETECTOR_NORMAL_SPAN ) continue;
+
+		xx += ty * ty / ( length * length );
+		xy -= tx * ty / ( length * length );
+		yy += tx * tx / ( length * length );
+		normals++;
+	}
+
+	// Keep the eigenvectors of the sum that hold enough of the normals
+	this->observed[ 0 ] = this->observed[ 1 ] = this->observed[ 2 ] = this->observed[ 3 ] = 0.0;
+	if ( normals == 0 ) return;
+	double mean = ( xx + yy ) / 2.0, spread = sqrt( ( xx - yy ) * ( xx - yy ) / 4.0 + xy * xy );
+	double angle = atan2( 2.0 * xy, xx - yy ) / 2.0;
+	const double values[ 2 ] = { mean + spread, mean - spread };
+	const double vectors[ 2 ][ 2 ] = { { cos( angle ), sin( angle ) }, { - sin( angle ), cos( angle ) } };
+
+	for ( unsigned int k = 0; k < 2; k++ )
+	{
+		if ( values[ k ] < SLIPDETECTOR_MIN_CONSTRAINT * normals ) continue;
+		this->observed[ 0 ] += vectors[ k ][ 0 ] * vectors[ k ][ 0 ];
+		this->observed[ 1 ] += vectors[ k ][ 0 ] * vectors[ k ][ 1 ];
+		this->observed[ 2 ] += vectors[ k ][ 1 ] * vectors[ k ][ 0 ];
+		this->observed[ 3 ] += vectors[ k ][ 1 ] * vectors[ k ][ 1 ];
+	}
+}
+
+void
+SlipDetector::add( Residual & residual, const double * normalized )
+{
+	double statistic = 0.0;
+	for ( unsigned int i = 0; i < 3; i++ )
+	{
+		double offset = normalized[ i ] - residual.mean[ i ];
+		statistic += offset * offset / residual.variance[ i ];
+	}
+
+	// Capped, so it takes a bounded time to drop back once the slip is over
+	residual.sum = std::min( std::max( 0.0, residual.sum + statistic - SLIPDETECTOR_DRIFT ),
+		2.0 * SLIPDETECTOR_THRESHOLD );
+	if ( residual.sum > 0.0 ) return;
+
+	// Learn only from residuals that do not look like slip. The variance is
+	// kept from going below the deviations given.
+	const double forget = SLIPDETECTOR_FORGETTING;
+	for ( unsigned int i = 0; i < 3; i++ )
+	{
+		double offset = normalized[ i ] - residual.mean[ i ];
+		residual.mean[ i ] += ( 1.0 - forget ) * offset;
+		residual.variance[ i ] = forget * ( residual.variance[ i ] + ( 1.0 - forget ) * offset * offset );
+		residual.variance[ i ] = std::min( std::max( residual.variance[ i ], 1.0 ), (double) SLIPDETECTOR_MAX_VARIANCE );
+	}
+}
+
+void
+SlipDetector::clear( Residual & residual )
+{
+	for ( unsigned int i = 0; i < 3; i++ )
+	{
+		residual.mean[ i ] = 0.0;
+		residual.variance[ i ] = 1.0;
+	}
+	residual.sum = 0.0;
+}
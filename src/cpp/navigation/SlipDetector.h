@@ -0,0 +1,252 @@
+/**
+ * @file	SlipDetector.h
+ * @brief	Header file for the SlipDetector class
+ */
+#ifndef SLIPDETECTOR_H
+#define SLIPDETECTOR_H
+
+#include "../robotino/headers/Axon.h"
+
+#include "../geometry/AngularCoordinate.h"
+#include "ScanMatcher.h"
+
+#include <atomic>
+#include <vector>
+
+class Brain;
+
+
+	// Commanded against measured speed
+
+/// Deviation of the x and y speeds measured by the odometry from the ones
+/// commanded while the wheels follow, in m/s
+#define SLIPDETECTOR_SPEED_DEVIATION	0.03
+/// Deviation of the measured rotation speed from the commanded one, in rad/s
+#define SLIPDETECTOR_OMEGA_DEVIATION	0.15
+/// Time the wheels take to follow a new command, in seconds. The deviation
+/// grows by how much the command changed over this time, so accellerating
+/// is not taken for slip.
+#define SLIPDETECTOR_LAG	0.15
+
+
+	// Odometry against laser
+
+/// Deviation of the distance moved since the reference scan found by
+/// matching, in meters
+#define SLIPDETECTOR_SCAN_DEVIATION	0.01
+/// Deviation of the angle turned since the reference scan found by matching,
+/// in rad
+#define SLIPDETECTOR_SCAN_PHI_DEVIATION	0.01
+/// Deviation of the odometry per meter driven since the reference scan, in
+/// meters
+#define SLIPDETECTOR_SCAN_SCALE_DEVIATION	0.05
+/// Deviation of the odometry heading per rad turned since the reference
+/// scan, in rad
+#define SLIPDETECTOR_SCAN_ROTATION_DEVIATION	0.05
+/// Deviation of the odometry heading per meter driven since the reference
+/// scan, in rad
+#define SLIPDETECTOR_SCAN_DRIFT_DEVIATION	0.05
+/// Distance since the reference scan after which the next scan becomes the
+/// reference, in meters. Longer lets more slip pile up between the odometry
+/// and the laser before a scan is compared.
+#define SLIPDETECTOR_SCAN_DISTANCE	0.15
+/// Turn since the reference scan after which the next scan becomes the
+/// reference, in rad
+#define SLIPDETECTOR_SCAN_ANGLE	0.15
+/// Distance from the odometry searched when matching a scan, in meters
+#define SLIPDETECTOR_SCAN_WINDOW	0.1
+/// Angle from the odometry searched when matching a scan, in rad
+#define SLIPDETECTOR_SCAN_ANGLE_WINDOW	0.1
+/// Number of laser readings used for matching, spread evenly over the scan
+#define SLIPDETECTOR_POINTS	180
+/// Share of the surface normals of the reference scan along a direction
+/// below which the scan is not taken to show motion that way. Along a bare
+/// corridor matching slides, and would report slip that is not there.
+#define SLIPDETECTOR_MIN_CONSTRAINT	0.2
+/// Longest distance between neighbouring readings taken to lie on one
+/// surface, in meters. The reference scan is drawn as lines between them,
+/// and the normals of the surfaces are worked out from them.
+#define SLIPDETECTOR_NORMAL_SPAN	0.3
+
+
+	// Decision
+
+/// Weight kept by the residual statistics for every new residual. They are
+/// only learned while nothing looks wrong.
+#define SLIPDETECTOR_FORGETTING	0.98
+/// Most the learned variance of a normalized residual may grow to. Above 1
+/// the floor is noisier than the deviations assume.
+#define SLIPDETECTOR_MAX_VARIANCE	4.0
+/// Squared normalized residual, summed over x, y and rotation, expected
+/// without slip. Only what exceeds it adds up, 6 is well above the 3 of the
+/// chi-square distribution.
+#define SLIPDETECTOR_DRIFT	6.0
+/// Sum of the excess above which slip is reported. A single residual of
+/// five deviations does it at once, smaller ones must last.
+#define SLIPDETECTOR_THRESHOLD	25.0
+
+
+/**
+ * Detects wheels slipping, spinning or stalling, from residuals between
+ * what Robotino is told to do, what the odometry measures, and what the
+ * LaserRangeFinder sees
+ *
+ * Two residuals are watched, each for x, y and rotation:
+ * - The speeds measured by the odometry against the speeds _OmniDrive last
+ *   sent. This catches wheels that do not turn as told, like when blocked
+ *   or when Robotino pushes against something.
+ * - The motion since a reference scan found by matching the laser scans,
+ *   against the motion the odometry reports. A wheel spinning on a polished
+ *   floor turns as told, so only this catches it. Only the directions the
+ *   surfaces around Robotino pin down count, worked out from their normals,
+ *   so along a corridor only sideways motion and turning are compared.
+ *
+ * Each residual is divided by its expected deviation. The mean and variance
+ * of these normalized residuals are updated with every new one, with
+ * forgetting, while nothing looks wrong, so a drive that lags or a floor
+ * that is bumpy does not raise false alarms. The squared distance of a new
+ * residual from the mean is summed up by a CUSUM, a sum of what exceeds
+ * SLIPDETECTOR_DRIFT that never drops below 0. Slip is reported above
+ * SLIPDETECTOR_THRESHOLD.
+ *
+ * analyze() runs after the sensors are read and before _OmniDrive::apply(),
+ * which slows down while slip is reported, and hands the state to _Odometry
+ * at once, which trusts its wheels less. Both react in the same cycle the
+ * slip is detected in.
+ *
+ * See @link SlipDetector.h @endlink for documentation of @c \#define
+ * parameters
+ */
+class SlipDetector : public Axon
+{
+ public:
+	/**
+	 * Constructs SlipDetector
+	 *
+	 * @param	pBrain	A pointer to the owner Brain object
+	 */
+	SlipDetector( Brain * pBrain );
+
+	/**
+	 * Checks if the wheels slip
+	 *
+	 * @return	True while slip is reported
+	 */
+	bool isSlipping();
+
+	/**
+	 * Gets the number of times slip was reported
+	 *
+	 * @return	Number of times slip started since construction
+	 */
+	unsigned int slips();
+
+	/**
+	 * Gets how close the evidence of slip is to being reported
+	 *
+	 * @return	The larger of the sums of the two residuals, divided by
+	 * SLIPDETECTOR_THRESHOLD
+	 */
+	float evidence();
+
+	void analyze();
+
+	void apply();
+
+ private:
+	/**
+	 * Incremental statistics of the normalized residuals of one kind
+	 */
+	struct Residual
+	{
+		double
+		/// Mean of each normalized residual
+			mean[ 3 ],
+		/// Variance of each normalized residual
+			variance[ 3 ],
+		/// Sum of the excess of the squared residuals above
+		/// SLIPDETECTOR_DRIFT
+			sum;
+	};
+
+	Residual
+	/// Measured against commanded speeds
+		command,
+	/// Odometry against laser motion
+		scan;
+
+	std::atomic< bool >
+	/// If slip is reported, read by other threads
+		slipping;
+
+	unsigned int
+	/// Times slip started
+		_slips,
+	/// Time of the last scan looked at
+		lastScanTime,
+	/// Time of the odometry reading last compared
+		lastOdometryTime;
+
+	float
+	/// Speeds sent by _OmniDrive at the last analyze()
+		lastCommand[ 3 ];
+
+	bool
+	/// If the reference scan is set
+		referenced;
+
+	PreciseAngularCoordinate
+	/// Odometry when the reference scan was taken
+		referencePose;
+
+	double
+	/// Projection of a motion onto the directions the reference scan pins
+	/// down, row major
+		observed[ 2 * 2 ];
+
+	ScanMatcher
+	/// Matcher holding the reference scan
+		matcher;
+
+	std::vector< float >
+	/// Scan points for the matcher, in Robotinos frame
+		x,
+		y;
+
+	/**
+	 * Compares the speeds measured by the odometry with the speeds commanded
+	 */
+	void compareCommand();
+
+	/**
+	 * Matches a new laser scan with the reference scan and compares the
+	 * motion with the odometry
+	 */
+	void compareScan();
+
+	/**
+	 * Works out which directions the reference scan pins down, from the
+	 * surface normals of the points, and sets @c observed
+	 *
+	 * @param	count	Number of points
+	 */
+	void constrain( unsigned int count );
+
+	/**
+	 * Adds a residual to its statistics and its sum
+	 *
+	 * @param	residual	The statistics
+	 * @param	normalized	The residual of x, y and rotation, each divided by
+	 * its deviation
+	 */
+	static void add( Residual & residual, const double * normalized );
+
+	/**
+	 * Empties statistics
+	 *
+	 * @param	residual	The statistics
+	 */
+	static void clear( Residual & residual );
+};
+
+#endif
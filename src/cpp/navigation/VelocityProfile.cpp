@@ -0,0 +1,44 @@
+#include "VelocityProfile.h"
+
+#include <math.h>
+#include <algorithm>
+
+
+VelocityProfile::VelocityProfile( float maxSpeed, float acceleration )
+{
+	this->maxSpeed = maxSpeed;
+	this->acceleration = acceleration;
+}
+
+float
+VelocityProfile::velocity( float distance, float currentSpeed, float dt )
+{
+	// Commands take effect a cycle late, count from where that will be
+	distance -= currentSpeed * dt;
+
+	float direction = ( distance < 0.0 ) ? -1.0 : 1.0;
+	float target = direction * this->brakingSpeed( fabs( distance ), dt );
+
+	// Never further than the target in one cycle
+	if ( dt > 0.0 && fabs( target ) * dt > fabs( distance ) ) target = distance / dt;
+
+	float step = this->acceleration * dt;
+	return std::max( currentSpeed - step, std::min( currentSpeed + step, target ) );
+}
+
+float
+VelocityProfile::brakingSpeed( float distance, float dt )
+{
+	if ( distance <= 0.0 ) return 0.0;
+
+	// Driving at speed n * step and braking by step each cycle covers
+	// step * dt * n ( n + 1 ) / 2, solved for n
+	float step = this->acceleration * dt;
+	float speed;
+	if ( step > 0.0 )
+		speed = step * ( sqrt( 0.25 + 2.0 * distance / ( step * dt ) ) - 0.5 );
+	else
+		speed = sqrt( 2.0 * this->acceleration * distance );
+
+	return std::min( speed, this->maxSpeed );
+}
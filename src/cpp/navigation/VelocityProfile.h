@@ -0,0 +1,67 @@
+/**
+ * @file	VelocityProfile.h
+ * @brief	Header file for the VelocityProfile class
+ */
+#ifndef VELOCITYPROFILE_H
+#define VELOCITYPROFILE_H
+
+
+/**
+ * Time-optimal trapezoidal velocity profile along one axis
+ *
+ * Given the distance left and the current speed, velocity() returns the speed
+ * to command for the next cycle on the fastest way to stop at the target:
+ * accelerate, cruise at the top speed and brake at the latest moment.
+ *
+ * Braking follows the discrete braking curve, not the continuous
+ * sqrt( 2 a d ). When the speed is commanded for a whole cycle and
+ * lowered by acceleration * dt every cycle, Robotino then stops on the
+ * target instead of hunting around it. The distance is counted from where
+ * Robotino will be when the command takes effect, a cycle on at the current
+ * speed.
+ *
+ * Units are up to the user, m and m/s or rad and rad/s. Distances may be
+ * negative, giving negative speeds.
+ */
+class VelocityProfile
+{
+ public:
+	/**
+	 * Constructs VelocityProfile
+	 *
+	 * @param	maxSpeed	The top speed
+	 * @param	acceleration	The acceleration and decelleration, per second
+	 */
+	VelocityProfile( float maxSpeed, float acceleration );
+
+	/**
+	 * Calculates the speed to command for the next cycle
+	 *
+	 * @param	distance	Signed distance left to the target
+	 * @param	currentSpeed	The currently commanded speed
+	 * @param	dt	Duration of the cycle, in seconds
+	 *
+	 * @return	The speed, within acceleration * dt of currentSpeed
+	 */
+	float velocity( float distance, float currentSpeed, float dt );
+
+	/**
+	 * Calculates the highest speed from which Robotino can still stop
+	 * within a distance, braking once per cycle
+	 *
+	 * @param	distance	Distance left, not negative
+	 * @param	dt	Duration of a cycle, in seconds
+	 *
+	 * @return	The speed, at most the top speed
+	 */
+	float brakingSpeed( float distance, float dt );
+
+ private:
+	float
+	/// The top speed
+		maxSpeed,
+	/// The acceleration and decelleration, per second
+		acceleration;
+};
+
+#endif
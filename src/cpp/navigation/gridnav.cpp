@@ -0,0 +1,293 @@
+#include "gridnav.h"
+
+#include "../robotino/headers/Brain.h"
+#include "../robotino/headers/_Odometry.h"
+#include "../robotino/headers/_OmniDrive.h"
+
+#include "../obstacle/OccupancyGrid.h"
+#include "../obstacle/InflationLayer.h"
+
+#include "../geometry/AngularCoordinate.h"
+#include "../geometry/Vector.h"
+
+#include <iostream>
+
+
+gridnav::gridnav( Brain * pBrain )
+	: Axon::Axon( pBrain ),
+	aStar( pBrain->costMap() ),
+	dStarLite( pBrain->costMap() )
+{
+	this->planner = & this->dStarLite;
+	this->aStar.setBudget( GRIDNAV_EXPANSIONS );
+	this->dStarLite.setBudget( GRIDNAV_EXPANSIONS );
+
+	this->corridorWidth = 0;
+	this->nextWaypoint = 0;
+	this->searching = false;
+	this->newGoal = false;
+	this->corridorChanged = false;
+	this->goalPending = false;
+	this->cancelled = false;
+	this->navigating = false;
+
+	pBrain->costMap()->grid()->addListener( this );
+}
+
+gridnav::~gridnav()
+{
+	this->brain()->costMap()->grid()->removeListener( this );
+}
+
+void
+gridnav::planTo( Coordinate goal )
+{
+	std::lock_guard< std::mutex > lock( this->goalMutex );
+	this->pendingGoal = goal;
+	this->goalPending = true;
+}
+
+bool
+gridnav::replan()
+{
+	OccupancyGrid * grid = this->brain()->costMap()->grid();
+	Coordinate position = this->brain()->odom()->getPosition();
+
+	int startX, startY, goalX, goalY;
+	grid->toCell( position, & startX, & startY );
+	grid->toCell( this->goal, & goalX, & goalY );
+
+	// The search takes in every change reported up to here
+	this->corridorChanged = false;
+	if ( ! this->planner->plan( startX, startY, goalX, goalY ) ) return false;
+
+	// Leading the same way, keep the plan _OmniDrive follows and its progress
+	if ( ! this->newGoal && this->follows( this->planner->path() ) ) return true;
+
+	this->cells = this->planner->path();
+	this->waypoints.clear();
+	this->waypointCells.clear();
+	this->nextWaypoint = 0;
+
+	// Keep only the cells where the path changes direction
+	int width = grid->width();
+	for ( unsigned int i = 1; i + 1 < this->cells.size(); i++ )
+	{
+		int in = this->cells[ i ] - this->cells[ i - 1 ];
+		int out = this->cells[ i + 1 ] - this->cells[ i ];
+		if ( in != out )
+		{
+			this->waypoints.push_back( grid->toCoordinate( this->cells[ i ] % width, this->cells[ i ] / width ) );
+			this->waypointCells.push_back( i );
+		}
+	}
+	this->waypoints.push_back( this->goal );
+	this->waypointCells.push_back( this->cells.size() - 1 );
+
+	this->markCorridor();
+	this->moveRobotino();
+
+	return true;
+}
+
+float
+gridnav::cellCost( int x, int y )
+{
+	return this->planner->cellCost( x, y );
+}
+
+void
+gridnav::useIncremental( bool incremental )
+{
+	if ( incremental )
+		this->planner = & this->dStarLite;
+	else
+		this->planner = & this->aStar;
+}
+
+bool
+gridnav::checkPlan()
+{
+	this->brain()->costMap()->update();
+
+	// Only the part from the last passed waypoint on matters
+	unsigned int first = ( this->nextWaypoint > 0 ) ? this->waypointCells[ this->nextWaypoint - 1 ] : 1;
+
+	int width = this->brain()->costMap()->grid()->width();
+	for ( unsigned int i = first; i < this->cells.size(); i++ )
+		if ( this->planner->cellCost( this->cells[ i ] % width, this->cells[ i ] / width ) < 0.0 )
+			return false;
+
+	return true;
+}
+
+void
+gridnav::moveRobotino()
+{
+	if ( this->waypoints.empty() ) return;
+
+	std::vector< Coordinate > path( 1, this->brain()->odom()->getPosition() );
+	path.insert( path.end(), this->waypoints.begin(), this->waypoints.end() );
+
+	this->brain()->drive()->followPath( path );
+}
+
+std::vector< Coordinate >
+gridnav::plan()
+{
+	return this->waypoints;
+}
+
+bool
+gridnav::isNavigating()
+{
+	return this->navigating;
+}
+
+void
+gridnav::cancel()
+{
+	this->goalPending = false;
+	this->cancelled = true;
+	this->navigating = false;
+	this->brain()->drive()->clearRoute();
+}
+
+void
+gridnav::cellChanged( int x, int y, unsigned char oldValue, unsigned char newValue )
+{
+	if ( x >= this->corridorWidth ) return;
+
+	unsigned int index = y * this->corridorWidth + x;
+	if ( index < this->corridor.size() && this->corridor[ index ] )
+		this->corridorChanged = true;
+}
+
+void
+gridnav::analyze()
+{
+	// Drop a search that was going on for the route cancelled
+	if ( this->cancelled.exchange( false ) )
+	{
+		this->searching = false;
+		this->newGoal = false;
+	}
+
+	// A new destination, searched for here where the maps are not changing
+	if ( this->goalPending.exchange( false ) )
+	{
+		{
+			std::lock_guard< std::mutex > lock( this->goalMutex );
+			this->goal = this->pendingGoal;
+		}
+
+		this->planner->abandon();
+		this->searching = true;
+		this->newGoal = true;
+	}
+
+	if ( ! this->searching )
+	{
+		if ( ! this->navigating ) return;
+
+		// Arrived, or the path was dropped by someone else
+		if ( this->brain()->drive()->pathLength() == 0 )
+		{
+			this->navigating = false;
+			return;
+		}
+
+		// The incremental search is repaired when costs near the route
+		// changed, A* searches again when the route is blocked
+		if ( this->planner == & this->dStarLite )
+		{
+			this->brain()->costMap()->update();
+			this->searching = this->corridorChanged;
+		}
+		else
+			this->searching = ! this->checkPlan();
+
+		if ( ! this->searching ) return;
+		this->planner->abandon();
+	}
+
+	this->search();
+}
+
+void
+gridnav::apply()
+{
+	if ( ! this->navigating ) return;
+
+	// _OmniDrive counts the waypoints of the path not yet passed
+	unsigned int left = this->brain()->drive()->pathLength();
+
+	// Done when the path is, _OmniDrive holds the goal. A path longer than
+	// the plan was set by someone else.
+	if ( left == 0 || left > this->waypoints.size() )
+		this->navigating = false;
+	else
+		this->nextWaypoint = this->waypoints.size() - left;
+}
+
+// Private functions
+
+void
+gridnav::search()
+{
+	if ( this->replan() )
+	{
+		if ( this->newGoal )
+			std::cout << "gridnav: route with " << this->waypoints.size() << " waypoints, "
+				<< this->planner->expanded() << " cells expanded" << std::endl;
+
+		this->searching = false;
+		this->newGoal = false;
+		this->navigating = true;
+		return;
+	}
+
+	// Not done yet, _OmniDrive goes on with the old route meanwhile
+	if ( this->planner->isSearching() ) return;
+
+	if ( this->newGoal )
+		std::cout << "gridnav: no route to " << this->goal << std::endl;
+	else
+		std::cout << "gridnav: route blocked, no way to " << this->goal << std::endl;
+
+	if ( this->navigating ) this->brain()->drive()->niceStop();
+	this->searching = false;
+	this->newGoal = false;
+	this->navigating = false;
+}
+
+void
+gridnav::markCorridor()
+{
+	OccupancyGrid * grid = this->brain()->costMap()->grid();
+	int width = grid->width();
+
+	this->corridor.assign( width * grid->height(), 0 );
+	this->corridorWidth = width;
+
+	for ( unsigned int i = 0; i < this->cells.size(); i++ )
+	{
+		int cx = this->cells[ i ] % width, cy = this->cells[ i ] / width;
+		for ( int y = cy - GRIDNAV_CORRIDOR_CELLS; y <= cy + GRIDNAV_CORRIDOR_CELLS; y++ )
+			for ( int x = cx - GRIDNAV_CORRIDOR_CELLS; x <= cx + GRIDNAV_CORRIDOR_CELLS; x++ )
+				if ( grid->contains( x, y ) )
+					this->corridor[ y * width + x ] = 1;
+	}
+}
+
+bool
+gridnav::follows( const std::vector< int > & path )
+{
+	// Compare from the goal back, both end there
+	unsigned int same = 0;
+	while ( same < path.size() && same < this->cells.size()
+			&& path[ path.size() - 1 - same ] == this->cells[ this->cells.size() - 1 - same ] )
+		same++;
+
+	return path.size() - same <= GRIDNAV_REJOIN_CELLS;
+}
@@ -0,0 +1,240 @@
+/**
+ * @file	gridnav.h
+ * @brief	Header file for the gridnav class
+ */
+#ifndef GRIDNAV_H
+#define GRIDNAV_H
+
+#include "../robotino/headers/Axon.h"
+
+#include "AStarPlanner.h"
+#include "DStarLitePlanner.h"
+
+#include "../geometry/Coordinate.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+class Brain;
+
+
+/// Cells at the start of a repaired path that may differ from the path being
+/// followed, while Robotino gets back onto it. If the rest is the same the
+/// path is kept, and _OmniDrive is not handed it again.
+#define GRIDNAV_REJOIN_CELLS	3
+/// Cells on each side of the path whose cost changes make the incremental
+/// search repair the route. Changes further off are left for the next
+/// repair, they can only open a shorter way.
+#define GRIDNAV_CORRIDOR_CELLS	4
+/// Most cells a search may expand per Brain cycle. make bench measures
+/// about 1 usec per expanded cell, so this keeps it near a fifth of
+/// BRAIN_LOOP_TIME.
+#define GRIDNAV_EXPANSIONS	10000
+
+
+/**
+ * Grid navigation, planning routes around obstacles on Brain's cost map
+ *
+ * planTo() sets a goal, and from the next analyze() on a path is searched
+ * from the current position on Brain::costMap() and reduced to the cells
+ * where the direction changes. Planning only ever runs on the main loop,
+ * where the maps are updated, so planTo() may be called from any thread.
+ * A search expands at most GRIDNAV_EXPANSIONS cells per cycle and carries
+ * on in the next one, so a large map does not hold up the drive. Until it
+ * is done _OmniDrive follows the old route, or keeps what it was doing.
+ * The waypoints are handed to _OmniDrive as a path for
+ * _OmniDrive::followPath(), which rounds them off without stopping, and
+ * apply() follows the progress along it.
+ *
+ * By default the search is a DStarLitePlanner. gridnav listens to the cost
+ * grid, and has the route repaired when costs change within
+ * GRIDNAV_CORRIDOR_CELLS of it. Only a path that really changed is handed
+ * to _OmniDrive again, so the path follower keeps its progress while the
+ * route stays the same. With useIncremental( false ) an AStarPlanner is
+ * used instead, and analyze() only searches again when the rest of the plan
+ * is no longer passable.
+ *
+ * See @link gridnav.h @endlink for documentation of @c \#define parameters
+ */
+class gridnav : public Axon, public GridListener
+{
+ public:
+	/**
+	 * Constructs gridnav
+	 *
+	 * @param	pBrain	A pointer to the owner Brain object
+	 */
+	gridnav( Brain * pBrain );
+
+	/**
+	 * Destructor, unregisters from the cost grid
+	 */
+	~gridnav();
+
+	/**
+	 * Sets a destination to plan a route to. From the next analyze() on the
+	 * route is searched and then followed, or it tells if there is none.
+	 *
+	 * @param	goal	The destination
+	 */
+	void planTo( Coordinate goal );
+
+	/**
+	 * Searches on for a route from the current position to the current
+	 * goal, at most GRIDNAV_EXPANSIONS cells. A route found replaces the
+	 * plan and is handed to _OmniDrive, unless it leads the same way.
+	 *
+	 * @return	Boolean indicating if a route was found, false as well while
+	 * the search is not done
+	 */
+	bool replan();
+
+	/**
+	 * Gets the cost multiplier for entering a cell, see
+	 * GridPlanner::cellCost()
+	 *
+	 * @param	x	Column
+	 * @param	y	Row
+	 *
+	 * @return	Step cost multiplier, negative if impassable
+	 */
+	float cellCost( int x, int y );
+
+	/**
+	 * Selects the path search
+	 *
+	 * @param	incremental	True for D* Lite, false for A*
+	 */
+	void useIncremental( bool incremental );
+
+	/**
+	 * Checks if all cells of the current plan are still passable
+	 *
+	 * @return	Boolean indicating if the plan is still valid
+	 */
+	bool checkPlan();
+
+	/**
+	 * Hands the current plan to _OmniDrive as a path to follow, from the
+	 * current position through the waypoints to the goal
+	 */
+	void moveRobotino();
+
+	/**
+	 * Gets the waypoints of the current plan
+	 *
+	 * @return	The waypoints, the last one being the goal
+	 */
+	std::vector< Coordinate > plan();
+
+	/**
+	 * Checks if a plan is being followed
+	 *
+	 * @return	Boolean indicating if navigating
+	 */
+	bool isNavigating();
+
+	/**
+	 * Stops following the plan, and drops a destination not planned yet.
+	 * _OmniDrive drops the path but keeps its current destination.
+	 */
+	void cancel();
+
+	/**
+	 * Notes a changed cost cell close to the route, see GridListener
+	 */
+	void cellChanged( int x, int y, unsigned char oldValue, unsigned char newValue );
+
+	void analyze();
+
+	void apply();
+
+ private:
+	AStarPlanner
+	/// Search from scratch
+		aStar;
+
+	DStarLitePlanner
+	/// Incremental search
+		dStarLite;
+
+	GridPlanner
+	/// The search in use, one of the above
+		* planner;
+
+	Coordinate
+	/// The destination of the current plan
+		goal,
+	/// Destination set by planTo(), not planned yet
+		pendingGoal;
+
+	std::mutex
+	/// Guards pendingGoal
+		goalMutex;
+
+	std::atomic< bool >
+	/// If planTo() set a destination the next analyze() has to plan
+		goalPending,
+	/// If cancel() was called since the last analyze()
+		cancelled;
+
+	std::vector< Coordinate >
+	/// Waypoints of the current plan
+		waypoints;
+
+	std::vector< int >
+	/// All cells of the current plan
+		cells;
+
+	std::vector< unsigned int >
+	/// Position in @c cells of each waypoint
+		waypointCells;
+
+	std::vector< unsigned char >
+	/// Flags for the cells within GRIDNAV_CORRIDOR_CELLS of the plan
+		corridor;
+
+	int
+	/// Width of the grid @c corridor was marked on
+		corridorWidth;
+
+	unsigned int
+	/// Index of the waypoint currently driven towards
+		nextWaypoint;
+
+	bool
+	/// If a search is going on, over as many cycles as it takes
+		searching,
+	/// If the search is for a new destination rather than a repair
+		newGoal,
+	/// If costs in the corridor changed since the last search
+		corridorChanged;
+
+	std::atomic< bool >
+	/// If a plan is being followed
+		navigating;
+
+	/**
+	 * Goes on with the search, and starts or stops following the route
+	 * when it is done
+	 */
+	void search();
+
+	/**
+	 * Marks the cells around the plan in @c corridor
+	 */
+	void markCorridor();
+
+	/**
+	 * Checks if a new path leads the same way as the current plan, up to
+	 * GRIDNAV_REJOIN_CELLS cells at its start
+	 *
+	 * @param	path	Cells of the new path
+	 *
+	 * @return	Boolean indicating if the rest of the paths is the same
+	 */
+	bool follows( const std::vector< int > & path );
+};
+
+#endif
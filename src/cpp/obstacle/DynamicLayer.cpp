@@ -0,0 +1,122 @@
+#include "DynamicLayer.h"
+
+#include "OccupancyGrid.h"
+
+#include <algorithm>
+
+
+DynamicLayer::DynamicLayer( OccupancyGrid * pStatic )
+	: layer( pStatic->width(), pStatic->height(), pStatic->resolution(), pStatic->origin() )
+{
+	this->pStatic = pStatic;
+
+	int size = pStatic->width() * pStatic->height();
+	this->lastSeen.assign( size, 0 );
+	this->scheduled.assign( size, 0 );
+	this->wheel.resize( DYNAMICLAYER_WHEEL_SLOTS );
+
+	this->now = 0;
+	this->wheelTime = 0;
+}
+
+OccupancyGrid *
+DynamicLayer::grid()
+{
+	return & this->layer;
+}
+
+void
+DynamicLayer::mark( Coordinate coordinate, unsigned int now )
+{
+	int x, y;
+	if ( ! this->layer.toCell( coordinate, & x, & y ) ) return;
+
+	int index = y * this->layer.width() + x;
+	this->now = now;
+	this->lastSeen[ index ] = now;
+	this->layer.setCell( x, y, OCCUPANCYGRID_OCCUPIED );
+
+	// Already in the wheel, it will be moved along when its slot comes up
+	if ( ! this->scheduled[ index ] )
+		this->schedule( index );
+}
+
+void
+DynamicLayer::expire( unsigned int now )
+{
+	this->now = now;
+
+	// Visit every slot passed since last time, but never the wheel more than once
+	unsigned int ticks = now / DYNAMICLAYER_WHEEL_TICK - this->wheelTime / DYNAMICLAYER_WHEEL_TICK;
+	ticks = std::min( ticks, (unsigned int) DYNAMICLAYER_WHEEL_SLOTS );
+
+	std::vector< int > expiring;
+	for ( unsigned int i = 0; i < ticks; i++ )
+	{
+		unsigned int slot = ( this->wheelTime / DYNAMICLAYER_WHEEL_TICK + 1 + i ) % DYNAMICLAYER_WHEEL_SLOTS;
+		expiring.swap( this->wheel[ slot ] );
+
+		for ( unsigned int j = 0; j < expiring.size(); j++ )
+		{
+			int index = expiring[ j ];
+			if ( this->lastSeen[ index ] + DYNAMICLAYER_LIFETIME <= now )
+			{
+				this->scheduled[ index ] = 0;
+				this->layer.setCell( index % this->layer.width(), index / this->layer.width(), OCCUPANCYGRID_FREE );
+			}
+			else
+			{
+				// Seen again since it was scheduled
+				this->schedule( index );
+			}
+		}
+
+		// Hand the (cleared) storage back to keep its capacity, unless cells
+		// seen again were scheduled into this very slot while it was drained
+		expiring.clear();
+		if ( this->wheel[ slot ].empty() )
+			expiring.swap( this->wheel[ slot ] );
+	}
+
+	this->wheelTime = now;
+}
+
+unsigned char
+DynamicLayer::dynamicOccupancy( int x, int y )
+{
+	if ( this->layer.cell( x, y ) == OCCUPANCYGRID_FREE ) return OCCUPANCYGRID_FREE;
+
+	unsigned int age = this->now - this->lastSeen[ y * this->layer.width() + x ];
+	if ( age >= DYNAMICLAYER_LIFETIME ) return OCCUPANCYGRID_FREE;
+
+	return ( OCCUPANCYGRID_OCCUPIED * ( DYNAMICLAYER_LIFETIME - age ) ) / DYNAMICLAYER_LIFETIME;
+}
+
+unsigned char
+DynamicLayer::occupancy( int x, int y )
+{
+	return std::max( this->pStatic->cell( x, y ), this->dynamicOccupancy( x, y ) );
+}
+
+bool
+DynamicLayer::isObstacle( Coordinate coordinate, unsigned char threshold )
+{
+	int x, y;
+	if ( ! this->layer.toCell( coordinate, & x, & y ) ) return false;
+
+	return this->occupancy( x, y ) >= threshold;
+}
+
+
+// Private functions
+
+void
+DynamicLayer::schedule( int index )
+{
+	// Round up, so the cell has expired when its slot is visited
+	unsigned int expiry = this->lastSeen[ index ] + DYNAMICLAYER_LIFETIME;
+	unsigned int slot = ( ( expiry + DYNAMICLAYER_WHEEL_TICK - 1 ) / DYNAMICLAYER_WHEEL_TICK ) % DYNAMICLAYER_WHEEL_SLOTS;
+
+	this->wheel[ slot ].push_back( index );
+	this->scheduled[ index ] = 1;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file	DynamicLayer.h
+ * @brief	Header file for the DynamicLayer class
+ */
+#ifndef DYNAMICLAYER_H
+#define DYNAMICLAYER_H
+
+#include "OccupancyGrid.h"
+
+#include "../geometry/Coordinate.h"
+
+#include <vector>
+
+
+/// Milliseconds a dynamic obstacle stays in the layer after it was last seen
+#define DYNAMICLAYER_LIFETIME	2000
+/// Milliseconds covered by one slot of the timing wheel
+#define DYNAMICLAYER_WHEEL_TICK	50
+/// Number of slots in the timing wheel. Slots times tick must exceed
+/// DYNAMICLAYER_LIFETIME, or cells will be checked more than once.
+#define DYNAMICLAYER_WHEEL_SLOTS	64
+
+
+/**
+ * Short lived obstacles, like people walking past Robotino
+ *
+ * The layer is an OccupancyGrid of the same size as the static map, where
+ * every marked cell remembers when it was last seen. The occupancy reported
+ * by occupancy() fades linearly from OCCUPANCYGRID_OCCUPIED to free over
+ * DYNAMICLAYER_LIFETIME, after which the cell is cleared.
+ *
+ * Clearing is driven by a timing wheel. Every marked cell has exactly one
+ * entry in the wheel, placed in the slot where it will expire. expire()
+ * only visits the slots that have passed since the last call, so the cost
+ * is proportional to the number of cells expiring, not the size of the map.
+ * A cell seen again before its slot comes up is simply moved to a later
+ * slot when it is visited.
+ *
+ * See @link DynamicLayer.h @endlink for documentation of @c \#define
+ * parameters
+ */
+class DynamicLayer
+{
+ public:
+	/**
+	 * Constructs an empty layer matching the static map
+	 *
+	 * @param	pStatic	Pointer to the static map, used for size and by the
+	 * combined queries
+	 */
+	DynamicLayer( OccupancyGrid * pStatic );
+
+	/**
+	 * Gets the grid holding the dynamic obstacles, so views and listeners
+	 * can be attached to it
+	 *
+	 * @return	Pointer to the dynamic grid
+	 */
+	OccupancyGrid * grid();
+
+	/**
+	 * Registers an obstacle seen at a world coordinate
+	 *
+	 * @param	coordinate	Where the obstacle was seen
+	 * @param	now	The current time in milliseconds
+	 */
+	void mark( Coordinate coordinate, unsigned int now );
+
+	/**
+	 * Clears all cells that have not been seen for DYNAMICLAYER_LIFETIME
+	 *
+	 * Should be called once per cycle.
+	 *
+	 * @param	now	The current time in milliseconds
+	 */
+	void expire( unsigned int now );
+
+	/**
+	 * Gets the decayed occupancy of a dynamic cell
+	 *
+	 * @param	x	Column
+	 * @param	y	Row
+	 *
+	 * @return	Occupancy value, fading with the time since last seen
+	 */
+	unsigned char dynamicOccupancy( int x, int y );
+
+	/**
+	 * Gets the combined occupancy of the static and the dynamic layer
+	 *
+	 * @param	x	Column
+	 * @param	y	Row
+	 *
+	 * @return	The highest of the static and the decayed dynamic value
+	 */
+	unsigned char occupancy( int x, int y );
+
+	/**
+	 * Checks if a world coordinate is blocked in either layer
+	 *
+	 * @param	coordinate	World coordinate
+	 * @param	threshold	Occupancy value considered an obstacle
+	 *
+	 * @return	Boolean indicating if there is an obstacle
+	 */
+	bool isObstacle( Coordinate coordinate, unsigned char threshold = OCCUPANCYGRID_OBSTACLE_THRESHOLD );
+
+ private:
+	OccupancyGrid
+	/// The static map
+		* pStatic,
+	/// The dynamic obstacles
+		layer;
+
+	std::vector< unsigned int >
+	/// Time each cell was last seen
+		lastSeen;
+
+	std::vector< unsigned char >
+	/// If the cell currently has an entry in the wheel
+		scheduled;
+
+	std::vector< std::vector< int > >
+	/// The timing wheel, each slot holding the indexes of cells expiring in it
+		wheel;
+
+	unsigned int
+	/// The time of the latest expire() or mark()
+		now,
+	/// The time of the last slot processed by expire()
+		wheelTime;
+
+	/**
+	 * Puts a cell in the slot where it expires
+	 *
+	 * @param	index	Cell index
+	 */
+	void schedule( int index );
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include "FreeSpace.h"
+
+#include <algorithm>
+
+#ifndef _USE_MATH_DEFINES
+#define _USE_MATH_DEFINES
+#endif
+#include <math.h>
+
+
+FreeSpace::FreeSpace()
+{
+	for ( unsigned int i = 0; i < FREESPACE_DIRECTIONS; i++ )
+	{
+		this->directionX[ i ] = cos( 2.0 * M_PI * i / FREESPACE_DIRECTIONS );
+		this->directionY[ i ] = sin( 2.0 * M_PI * i / FREESPACE_DIRECTIONS );
+	}
+
+	this->clear();
+}
+
+void
+FreeSpace::clear()
+{
+	std::fill( this->free, this->free + FREESPACE_DIRECTIONS, (float) FREESPACE_MAX_DISTANCE );
+}
+
+void
+FreeSpace::addPoint( float x, float y )
+{
+	const float radius2 = FREESPACE_ROBOT_RADIUS * FREESPACE_ROBOT_RADIUS;
+
+	for ( unsigned int i = 0; i < FREESPACE_DIRECTIONS; i++ )
+	{
+		// The point in a frame along the direction
+		float along = x * this->directionX[ i ] + y * this->directionY[ i ];
+		float lateral = y * this->directionX[ i ] - x * this->directionY[ i ];
+		if ( lateral * lateral >= radius2 ) continue;
+
+		// The footprint reaches it when moved this far, negative if it is
+		// behind or inside the footprint
+		float edge = sqrt( radius2 - lateral * lateral );
+		if ( along + edge < 0.0 ) continue;
+
+		this->free[ i ] = std::min( this->free[ i ], std::max( 0.0f, along - edge ) );
+	}
+}
+
+float
+FreeSpace::distance( float direction )
+{
+	float index = direction * FREESPACE_DIRECTIONS / ( 2.0 * M_PI );
+	int below = (int) floor( index );
+
+	unsigned int first = ( ( below % FREESPACE_DIRECTIONS ) + FREESPACE_DIRECTIONS ) % FREESPACE_DIRECTIONS;
+	unsigned int second = ( first + 1 ) % FREESPACE_DIRECTIONS;
+
+	return std::min( this->free[ first ], this->free[ second ] );
+}
@@ -0,0 +1,66 @@
+/**
+ * @file	FreeSpace.h
+ * @brief	Header file for the FreeSpace class
+ */
+#ifndef FREESPACE_H
+#define FREESPACE_H
+
+
+/// Number of directions the free distance is kept for, evenly spread
+#define FREESPACE_DIRECTIONS	72
+/// Radius of Robotinos footprint, in meters
+#define FREESPACE_ROBOT_RADIUS	0.2
+/// Free distance reported when nothing is in the way, in meters
+#define FREESPACE_MAX_DISTANCE	10.0
+
+
+/**
+ * How far Robotino can drive in every direction
+ *
+ * Obstacle points relative to Robotino are added one at a time, as the
+ * sensor owning the FreeSpace goes through its readings anyway. For each of
+ * FREESPACE_DIRECTIONS directions the distance Robotino can drive straight
+ * before its footprint touches a point is kept, so asking for the free
+ * distance in a direction costs a lookup and no pass over the readings.
+ *
+ * See @link FreeSpace.h @endlink for documentation of @c \#define parameters
+ */
+class FreeSpace
+{
+ public:
+	FreeSpace();
+
+	/**
+	 * Forgets all points, every direction becomes free
+	 */
+	void clear();
+
+	/**
+	 * Adds an obstacle point
+	 *
+	 * @param	x	Forward coordinate relative to Robotino
+	 * @param	y	Leftward coordinate relative to Robotino
+	 */
+	void addPoint( float x, float y );
+
+	/**
+	 * Gets the distance Robotino can drive in a direction. Between the kept
+	 * directions the shorter of the two nearest is used.
+	 *
+	 * @param	direction	Direction relative to Robotinos heading, in rad
+	 *
+	 * @return	Free distance in meters, 0 if already touching
+	 */
+	float distance( float direction );
+
+ private:
+	float
+	/// Forward component of each direction
+		directionX[ FREESPACE_DIRECTIONS ],
+	/// Leftward component of each direction
+		directionY[ FREESPACE_DIRECTIONS ],
+	/// Free distance in each direction
+		free[ FREESPACE_DIRECTIONS ];
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "InflationLayer.h"
+
+#include "OccupancyGrid.h"
+
+#include <math.h>
+#include <algorithm>
+
+
+InflationLayer::InflationLayer( OccupancyGrid * pStatic, OccupancyGrid * pDynamic, float robotRadius, float inflationRadius, float decay )
+	: costs( pStatic->width(), pStatic->height(), pStatic->resolution(), pStatic->origin() )
+{
+	this->pStatic = pStatic;
+	this->pDynamic = pDynamic;
+
+	this->pStatic->addListener( this );
+	if ( this->pDynamic != NULL )
+		this->pDynamic->addListener( this );
+
+	this->setCurve( robotRadius, inflationRadius, decay );
+}
+
+InflationLayer::~InflationLayer()
+{
+	this->pStatic->removeListener( this );
+	if ( this->pDynamic != NULL )
+		this->pDynamic->removeListener( this );
+}
+
+void
+InflationLayer::cellChanged( int x, int y, unsigned char oldValue, unsigned char newValue )
+{
+	// Only a change of obstacle status moves any costs
+	if ( ( oldValue >= OCCUPANCYGRID_OBSTACLE_THRESHOLD ) != ( newValue >= OCCUPANCYGRID_OBSTACLE_THRESHOLD ) )
+		this->markDirty( x, y );
+}
+
+OccupancyGrid *
+InflationLayer::grid()
+{
+	return & this->costs;
+}
+
+unsigned char
+InflationLayer::cost( int x, int y )
+{
+	this->update();
+	return this->costs.cell( x, y );
+}
+
+unsigned char
+InflationLayer::cost( Coordinate coordinate )
+{
+	int x, y;
+	this->costs.toCell( coordinate, & x, & y );
+	return this->cost( x, y );
+}
+
+void
+InflationLayer::update()
+{
+	if ( this->dirtyMinX > this->dirtyMaxX ) return;
+
+	// A changed obstacle affects costs within the kernel radius
+	int x0 = std::max( this->dirtyMinX - this->kernelRadius, 0 );
+	int y0 = std::max( this->dirtyMinY - this->kernelRadius, 0 );
+	int x1 = std::min( this->dirtyMaxX + this->kernelRadius, this->costs.width() - 1 );
+	int y1 = std::min( this->dirtyMaxY + this->kernelRadius, this->costs.height() - 1 );
+	int boxWidth = x1 - x0 + 1;
+
+	this->dirtyMinX = this->dirtyMinY = 1;
+	this->dirtyMaxX = this->dirtyMaxY = 0;
+
+	this->scratch.assign( boxWidth * ( y1 - y0 + 1 ), 0 );
+
+	// Stamp the kernel of every obstacle that can reach into the box
+	int searchX0 = std::max( x0 - this->kernelRadius, 0 );
+	int searchY0 = std::max( y0 - this->kernelRadius, 0 );
+	int searchX1 = std::min( x1 + this->kernelRadius, this->costs.width() - 1 );
+	int searchY1 = std::min( y1 + this->kernelRadius, this->costs.height() - 1 );
+
+	for ( int y = searchY0; y <= searchY1; y++ )
+		for ( int x = searchX0; x <= searchX1; x++ )
+		{
+			if ( ! this->isObstacle( x, y ) ) continue;
+
+			for ( unsigned int i = 0; i < this->kernel.size(); i++ )
+			{
+				int cx = x + this->kernel[ i ].dx;
+				int cy = y + this->kernel[ i ].dy;
+				if ( cx < x0 || cx > x1 || cy < y0 || cy > y1 ) continue;
+
+				unsigned char & cell = this->scratch[ ( cy - y0 ) * boxWidth + ( cx - x0 ) ];
+				if ( this->kernel[ i ].cost > cell ) cell = this->kernel[ i ].cost;
+			}
+		}
+
+	// Write back, only changed cells are passed on to listeners
+	for ( int y = y0; y <= y1; y++ )
+		for ( int x = x0; x <= x1; x++ )
+			this->costs.setCell( x, y, this->scratch[ ( y - y0 ) * boxWidth + ( x - x0 ) ] );
+}
+
+void
+InflationLayer::setCurve( float robotRadius, float inflationRadius, float decay )
+{
+	float resolution = this->costs.resolution();
+	this->kernelRadius = (int) ceil( inflationRadius / resolution );
+
+	this->kernel.clear();
+	for ( int dy = - this->kernelRadius; dy <= this->kernelRadius; dy++ )
+		for ( int dx = - this->kernelRadius; dx <= this->kernelRadius; dx++ )
+		{
+			float distance = sqrt( (float) ( dx * dx + dy * dy ) ) * resolution;
+			if ( distance > inflationRadius ) continue;
+
+			Offset offset;
+			offset.dx = dx;
+			offset.dy = dy;
+			if ( dx == 0 && dy == 0 )
+				offset.cost = INFLATION_LETHAL_COST;
+			else if ( distance <= robotRadius )
+				offset.cost = INFLATION_INSCRIBED_COST;
+			else
+				offset.cost = (unsigned char) ( INFLATION_MAX_FREE_COST * exp( - decay * ( distance - robotRadius ) ) );
+
+			if ( offset.cost > 0 ) this->kernel.push_back( offset );
+		}
+
+	// Everything must be recomputed with the new curve
+	this->dirtyMinX = 0;
+	this->dirtyMinY = 0;
+	this->dirtyMaxX = this->costs.width() - 1;
+	this->dirtyMaxY = this->costs.height() - 1;
+}
+
+
+// Private functions
+
+bool
+InflationLayer::isObstacle( int x, int y )
+{
+	if ( this->pStatic->cell( x, y ) >= OCCUPANCYGRID_OBSTACLE_THRESHOLD ) return true;
+
+	return this->pDynamic != NULL && this->pDynamic->cell( x, y ) >= OCCUPANCYGRID_OBSTACLE_THRESHOLD;
+}
+
+void
+InflationLayer::markDirty( int x, int y )
+{
+	if ( this->dirtyMinX > this->dirtyMaxX )
+	{
+		this->dirtyMinX = this->dirtyMaxX = x;
+		this->dirtyMinY = this->dirtyMaxY = y;
+		return;
+	}
+
+	this->dirtyMinX = std::min( this->dirtyMinX, x );
+	this->dirtyMinY = std::min( this->dirtyMinY, y );
+	this->dirtyMaxX = std::max( this->dirtyMaxX, x );
+	this->dirtyMaxY = std::max( this->dirtyMaxY, y );
+}
@@ -0,0 +1,164 @@
+/**
+ * @file	InflationLayer.h
+ * @brief	Header file for the InflationLayer class
+ */
+#ifndef INFLATIONLAYER_H
+#define INFLATIONLAYER_H
+
+#include "OccupancyGrid.h"
+
+#include "../geometry/Coordinate.h"
+
+#include <vector>
+
+
+/// Radius of Robotinos footprint, in meters
+#define INFLATION_ROBOT_RADIUS	0.2
+/// Distance from an obstacle beyond which no cost is added, in meters
+#define INFLATION_RADIUS	0.6
+/// How fast the cost falls off outside the footprint, per meter. Higher
+/// values let the robot pass closer to obstacles.
+#define INFLATION_DECAY	10.0
+
+/// Cost of a cell holding an obstacle
+#define INFLATION_LETHAL_COST	255
+/// Cost of a cell where Robotinos footprint would touch an obstacle.
+/// Cells at or above this cost must not be entered by Robotinos center.
+#define INFLATION_INSCRIBED_COST	254
+/// Highest cost of a cell outside the footprint, the decay curve starts here
+#define INFLATION_MAX_FREE_COST	253
+
+
+/**
+ * Obstacle costs inflated by Robotinos footprint
+ *
+ * Every cell gets a cost from its distance to the nearest obstacle in the
+ * static map and, if given, the dynamic layer: INFLATION_LETHAL_COST on the
+ * obstacle, INFLATION_INSCRIBED_COST within the robot radius, and from
+ * there an exponential decay down to 0 at the inflation radius. A planner
+ * can then treat Robotino as a point, only avoiding cells at or above
+ * INFLATION_INSCRIBED_COST.
+ *
+ * The costs are kept in an OccupancyGrid, so other views can listen to it.
+ * Changed obstacle cells only grow a dirty box. The next query recomputes
+ * that box, expanded by the inflation radius, and nothing else.
+ *
+ * See @link InflationLayer.h @endlink for documentation of @c \#define
+ * parameters
+ */
+class InflationLayer : public GridListener
+{
+ public:
+	/**
+	 * Constructs the layer and registers as a listener on the source grids
+	 *
+	 * @param	pStatic	Pointer to the static map
+	 * @param	pDynamic	Pointer to the grid of a DynamicLayer, or NULL
+	 * @param	robotRadius	Radius of the footprint, in meters
+	 * @param	inflationRadius	Distance where the cost reaches 0, in meters
+	 * @param	decay	Decay factor of the cost curve, per meter
+	 */
+	InflationLayer(
+			OccupancyGrid * pStatic,
+			OccupancyGrid * pDynamic = NULL,
+			float robotRadius = INFLATION_ROBOT_RADIUS,
+			float inflationRadius = INFLATION_RADIUS,
+			float decay = INFLATION_DECAY );
+
+	/**
+	 * Destructor, unregisters from the source grids
+	 */
+	~InflationLayer();
+
+	/**
+	 * Grows the dirty box if a cell became or stopped being an obstacle,
+	 * see GridListener
+	 */
+	void cellChanged( int x, int y, unsigned char oldValue, unsigned char newValue );
+
+	/**
+	 * Gets the grid holding the costs. Call update() before reading it
+	 * directly.
+	 *
+	 * @return	Pointer to the cost grid
+	 */
+	OccupancyGrid * grid();
+
+	/**
+	 * Gets the inflated cost of a cell
+	 *
+	 * @param	x	Column
+	 * @param	y	Row
+	 *
+	 * @return	Cost from 0 to INFLATION_LETHAL_COST
+	 */
+	unsigned char cost( int x, int y );
+
+	/**
+	 * Gets the inflated cost of the cell containing a world coordinate
+	 *
+	 * @param	coordinate	World coordinate
+	 *
+	 * @return	Cost from 0 to INFLATION_LETHAL_COST
+	 */
+	unsigned char cost( Coordinate coordinate );
+
+	/**
+	 * Recomputes the dirty box, if any
+	 */
+	void update();
+
+	/**
+	 * Changes the footprint and the decay curve, and recomputes all costs
+	 *
+	 * @param	robotRadius	Radius of the footprint, in meters
+	 * @param	inflationRadius	Distance where the cost reaches 0, in meters
+	 * @param	decay	Decay factor of the cost curve, per meter
+	 */
+	void setCurve( float robotRadius, float inflationRadius, float decay );
+
+ private:
+	/// One cell of the precomputed cost stamp around an obstacle
+	struct Offset
+	{
+		int dx, dy;
+		unsigned char cost;
+	};
+
+	OccupancyGrid
+	/// The static map
+		* pStatic,
+	/// The dynamic obstacles, may be NULL
+		* pDynamic,
+	/// The inflated costs
+		costs;
+
+	std::vector< Offset >
+	/// Costs around a single obstacle cell, within the inflation radius
+		kernel;
+
+	int
+	/// Inflation radius in cells
+		kernelRadius,
+	/// Dirty box, inclusive, empty if minX > maxX
+		dirtyMinX,
+		dirtyMinY,
+		dirtyMaxX,
+		dirtyMaxY;
+
+	std::vector< unsigned char >
+	/// Scratch buffer for the box being recomputed
+		scratch;
+
+	/**
+	 * Checks if a cell is an obstacle in any of the source grids
+	 */
+	bool isObstacle( int x, int y );
+
+	/**
+	 * Grows the dirty box to include a cell
+	 */
+	void markDirty( int x, int y );
+};
+
+#endif
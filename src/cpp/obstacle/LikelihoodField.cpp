@@ -0,0 +1,141 @@
+#include "LikelihoodField.h"
+
+#include "OccupancyGrid.h"
+
+#include <math.h>
+#include <algorithm>
+
+
+LikelihoodField::LikelihoodField( float sigma, float maxDistance, float hitWeight )
+{
+	this->sigma = sigma;
+	this->maxDistance = maxDistance;
+	this->hitWeight = hitWeight;
+	this->_resolution = OCCUPANCYGRID_RESOLUTION;
+	this->_width = 0;
+	this->_height = 0;
+	this->minX = this->minY = 1;
+	this->maxX = this->maxY = 0;
+}
+
+unsigned int
+LikelihoodField::build( OccupancyGrid * pMap )
+{
+	this->_resolution = pMap->resolution();
+	this->_width = pMap->width() + 2;
+	this->_height = pMap->height() + 2;
+	this->_origin = Coordinate(
+			pMap->origin().x() - this->_resolution,
+			pMap->origin().y() - this->_resolution );
+
+	// Squared distance to the nearest obstacle in cells, found by stamping
+	// the kernel of every obstacle like InflationLayer does
+	int radius = (int) ceil( this->maxDistance / this->_resolution );
+	int farDistance = radius * radius + 1;
+	std::vector< int > distance( this->_width * this->_height, farDistance );
+
+	this->minX = this->minY = 1;
+	this->maxX = this->maxY = 0;
+	unsigned int obstacles = 0;
+
+	for ( int y = 0; y < pMap->height(); y++ )
+		for ( int x = 0; x < pMap->width(); x++ )
+		{
+			if ( pMap->cell( x, y ) < OCCUPANCYGRID_OBSTACLE_THRESHOLD ) continue;
+
+			if ( obstacles == 0 )
+			{
+				this->minX = this->maxX = x;
+				this->minY = this->maxY = y;
+			}
+			this->minX = std::min( this->minX, x );
+			this->minY = std::min( this->minY, y );
+			this->maxX = std::max( this->maxX, x );
+			this->maxY = std::max( this->maxY, y );
+			obstacles++;
+
+			int y0 = std::max( y + 1 - radius, 1 ), y1 = std::min( y + 1 + radius, this->_height - 2 );
+			int x0 = std::max( x + 1 - radius, 1 ), x1 = std::min( x + 1 + radius, this->_width - 2 );
+			for ( int cy = y0; cy <= y1; cy++ )
+				for ( int cx = x0; cx <= x1; cx++ )
+				{
+					int dx = cx - x - 1, dy = cy - y - 1;
+					int & cell = distance[ cy * this->_width + cx ];
+					cell = std::min( cell, dx * dx + dy * dy );
+				}
+		}
+
+	// Only as many different values as squared distances in the kernel, so
+	// look them up
+	std::vector< float > curve( farDistance + 1 );
+	for ( int d = 0; d <= farDistance; d++ )
+		curve[ d ] = this->value( (float) sqrt( (float) d ) * this->_resolution );
+
+	this->field.resize( distance.size() );
+	for ( unsigned int i = 0; i < distance.size(); i++ )
+		this->field[ i ] = curve[ distance[ i ] ];
+
+	return obstacles;
+}
+
+int
+LikelihoodField::width()
+{
+	return this->_width;
+}
+
+int
+LikelihoodField::height()
+{
+	return this->_height;
+}
+
+float
+LikelihoodField::resolution()
+{
+	return this->_resolution;
+}
+
+Coordinate
+LikelihoodField::origin()
+{
+	return this->_origin;
+}
+
+const float *
+LikelihoodField::values()
+{
+	return this->field.empty() ? NULL : & this->field[ 0 ];
+}
+
+float
+LikelihoodField::value( Coordinate coordinate )
+{
+	if ( this->field.empty() ) return 0.0;
+
+	int x = (int) floor( ( coordinate.x() - this->_origin.x() ) / this->_resolution );
+	int y = (int) floor( ( coordinate.y() - this->_origin.y() ) / this->_resolution );
+	x = std::min( std::max( x, 0 ), this->_width - 1 );
+	y = std::min( std::max( y, 0 ), this->_height - 1 );
+
+	return this->field[ y * this->_width + x ];
+}
+
+float
+LikelihoodField::value( float distance )
+{
+	distance = std::min( distance, this->maxDistance );
+	return log( this->hitWeight * exp( - distance * distance / ( 2.0 * this->sigma * this->sigma ) )
+			+ 1.0 - this->hitWeight );
+}
+
+bool
+LikelihoodField::bounds( int * x0, int * y0, int * x1, int * y1 )
+{
+	* x0 = this->minX;
+	* y0 = this->minY;
+	* x1 = this->maxX;
+	* y1 = this->maxY;
+
+	return this->minX <= this->maxX;
+}
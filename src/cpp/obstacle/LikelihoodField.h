@@ -0,0 +1,162 @@
+/**
+ * @file	LikelihoodField.h
+ * @brief	Header file for the LikelihoodField class
+ */
+#ifndef LIKELIHOODFIELD_H
+#define LIKELIHOODFIELD_H
+
+#include "../geometry/Coordinate.h"
+
+#include <vector>
+
+class OccupancyGrid;
+
+
+/// Deviation of a laser reading from the obstacle it hit, in meters
+#define LIKELIHOODFIELD_SIGMA	0.1
+/// Distance to the nearest obstacle above which all points are equally
+/// unlikely, in meters
+#define LIKELIHOODFIELD_MAX_DISTANCE	0.5
+/// Share of readings that hit an obstacle of the map. The rest hit something
+/// the map does not know about, and are equally likely anywhere.
+#define LIKELIHOODFIELD_HIT_WEIGHT	0.9
+
+
+/**
+ * Log-likelihood of a laser scan point falling on each cell of a map
+ *
+ * The likelihood of a point is a normal distribution of the distance to the
+ * nearest obstacle, plus a constant for readings of things not in the map.
+ * Its log is worked out once per cell by build(), so weighing a point is a
+ * single lookup.
+ *
+ * The field has a border of one cell around the map, holding the value of
+ * points far from any obstacle. Clamping a cell index to the field then
+ * handles points outside the map without a branch.
+ *
+ * See @link LikelihoodField.h @endlink for documentation of @c \#define
+ * parameters
+ */
+class LikelihoodField
+{
+ public:
+	/**
+	 * Constructs an empty LikelihoodField
+	 *
+	 * @param	sigma	Deviation of a reading, in meters
+	 * @param	maxDistance	Distance where the likelihood stops falling,
+	 * in meters
+	 * @param	hitWeight	Share of readings that hit the map
+	 */
+	LikelihoodField(
+			float sigma = LIKELIHOODFIELD_SIGMA,
+			float maxDistance = LIKELIHOODFIELD_MAX_DISTANCE,
+			float hitWeight = LIKELIHOODFIELD_HIT_WEIGHT );
+
+	/**
+	 * Works out the field for a map
+	 *
+	 * @param	pMap	Pointer to the map
+	 *
+	 * @return	The number of obstacle cells in the map
+	 */
+	unsigned int build( OccupancyGrid * pMap );
+
+	/**
+	 * Gets the number of columns, including the border
+	 *
+	 * @return	The width of the field in cells
+	 */
+	int width();
+
+	/**
+	 * Gets the number of rows, including the border
+	 *
+	 * @return	The height of the field in cells
+	 */
+	int height();
+
+	/**
+	 * Gets the edge length of a cell
+	 *
+	 * @return	Cell size in meters
+	 */
+	float resolution();
+
+	/**
+	 * Gets the world coordinate of the lower left corner of the field,
+	 * one cell outside the map
+	 *
+	 * @return	The origin as a Coordinate
+	 */
+	Coordinate origin();
+
+	/**
+	 * Gets the log-likelihood of all cells, row by row
+	 *
+	 * @return	Pointer to width() * height() values
+	 */
+	const float * values();
+
+	/**
+	 * Gets the log-likelihood of a point
+	 *
+	 * @param	coordinate	World coordinate of the point
+	 *
+	 * @return	Log-likelihood
+	 */
+	float value( Coordinate coordinate );
+
+	/**
+	 * Gets the log-likelihood of a point at a distance from the nearest
+	 * obstacle
+	 *
+	 * @param	distance	The distance, in meters
+	 *
+	 * @return	Log-likelihood
+	 */
+	float value( float distance );
+
+	/**
+	 * Gets the bounding box of the obstacles found by build()
+	 *
+	 * @param	x0	Set to the lowest column, in map cells
+	 * @param	y0	Set to the lowest row
+	 * @param	x1	Set to the highest column
+	 * @param	y1	Set to the highest row
+	 *
+	 * @return	False if the map had no obstacles
+	 */
+	bool bounds( int * x0, int * y0, int * x1, int * y1 );
+
+ private:
+	float
+	/// Deviation of a reading
+		sigma,
+	/// Distance where the likelihood stops falling
+		maxDistance,
+	/// Share of readings that hit the map
+		hitWeight,
+	/// Edge length of a cell
+		_resolution;
+
+	int
+	/// Columns and rows, including the border
+		_width,
+		_height,
+	/// Bounding box of the obstacles, in map cells
+		minX,
+		minY,
+		maxX,
+		maxY;
+
+	Coordinate
+	/// Lower left corner of the border
+		_origin;
+
+	std::vector< float >
+	/// Log-likelihood of every cell, row by row
+		field;
+};
+
+#endif
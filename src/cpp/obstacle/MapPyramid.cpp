@@ -0,0 +1,254 @@
+#include "MapPyramid.h"
+
+#include "OccupancyGrid.h"
+
+#include <math.h>
+#include <algorithm>
+
+
+MapPyramid::MapPyramid( OccupancyGrid * pGrid )
+{
+	this->pGrid = pGrid;
+
+	int width = pGrid->width();
+	int height = pGrid->height();
+
+	// Level 0 is the grid, keep halving until a single cell remains
+	while ( true )
+	{
+		this->levelWidth.push_back( width );
+		this->levelHeight.push_back( height );
+		this->data.push_back( std::vector< unsigned char >() );
+		this->dirtyFlag.push_back( std::vector< unsigned char >() );
+		this->dirty.push_back( std::vector< int >() );
+
+		if ( width <= 1 && height <= 1 ) break;
+
+		width = ( width + 1 ) / 2;
+		height = ( height + 1 ) / 2;
+	}
+
+	// Build all coarse levels from the current grid contents
+	for ( int level = 1; level < this->levels(); level++ )
+	{
+		int size = this->levelWidth[ level ] * this->levelHeight[ level ];
+		this->data[ level ].assign( size, OCCUPANCYGRID_FREE );
+		this->dirtyFlag[ level ].assign( size, 0 );
+
+		for ( int y = 0; y < this->levelHeight[ level ]; y++ )
+			for ( int x = 0; x < this->levelWidth[ level ]; x++ )
+			{
+				unsigned char max = std::max(
+						std::max( this->value( level - 1, 2 * x, 2 * y ), this->value( level - 1, 2 * x + 1, 2 * y ) ),
+						std::max( this->value( level - 1, 2 * x, 2 * y + 1 ), this->value( level - 1, 2 * x + 1, 2 * y + 1 ) ) );
+				this->data[ level ][ y * this->levelWidth[ level ] + x ] = max;
+			}
+	}
+
+	this->pGrid->addListener( this );
+}
+
+MapPyramid::~MapPyramid()
+{
+	this->pGrid->removeListener( this );
+}
+
+void
+MapPyramid::cellChanged( int x, int y, unsigned char oldValue, unsigned char newValue )
+{
+	if ( this->levels() > 1 )
+		this->markDirty( 1, x / 2, y / 2 );
+}
+
+int
+MapPyramid::levels()
+{
+	return this->levelWidth.size();
+}
+
+unsigned char
+MapPyramid::maxOccupancy( int level, int x, int y )
+{
+	this->refresh();
+	return this->value( level, x, y );
+}
+
+bool
+MapPyramid::boxIsFree( Coordinate corner1, Coordinate corner2, unsigned char threshold )
+{
+	this->refresh();
+
+	int x0, y0, x1, y1;
+	this->pGrid->toCell( corner1, & x0, & y0 );
+	this->pGrid->toCell( corner2, & x1, & y1 );
+
+	// Order and clip to the grid
+	if ( x0 > x1 ) std::swap( x0, x1 );
+	if ( y0 > y1 ) std::swap( y0, y1 );
+	x0 = std::max( x0, 0 );
+	y0 = std::max( y0, 0 );
+	x1 = std::min( x1, this->pGrid->width() - 1 );
+	y1 = std::min( y1, this->pGrid->height() - 1 );
+	if ( x0 > x1 || y0 > y1 ) return true;
+
+	int top = this->levels() - 1;
+	for ( int y = ( y0 >> top ); y <= ( y1 >> top ); y++ )
+		for ( int x = ( x0 >> top ); x <= ( x1 >> top ); x++ )
+			if ( this->boxOccupied( top, x, y, x0, y0, x1, y1, threshold ) )
+				return false;
+
+	return true;
+}
+
+bool
+MapPyramid::castRay( Coordinate from, Coordinate to, Coordinate * hit, unsigned char threshold )
+{
+	this->refresh();
+
+	// Work in continuous cell units, the ray is start + t * delta for t in [0, 1]
+	float resolution = this->pGrid->resolution();
+	Coordinate origin = this->pGrid->origin();
+	float startX = ( from.x() - origin.x() ) / resolution;
+	float startY = ( from.y() - origin.y() ) / resolution;
+	float deltaX = ( to.x() - from.x() ) / resolution;
+	float deltaY = ( to.y() - from.y() ) / resolution;
+
+	// Clip the ray to the grid (Liang-Barsky), outside is free
+	float tMin = 0.0, tMax = 1.0;
+	float p[] = { -deltaX, deltaX, -deltaY, deltaY };
+	float q[] = { startX, this->pGrid->width() - startX, startY, this->pGrid->height() - startY };
+	for ( int i = 0; i < 4; i++ )
+	{
+		if ( p[ i ] == 0.0 )
+		{
+			if ( q[ i ] < 0.0 ) return false;
+			continue;
+		}
+		float r = q[ i ] / p[ i ];
+		if ( p[ i ] < 0.0 )
+			tMin = std::max( tMin, r );
+		else
+			tMax = std::min( tMax, r );
+	}
+	if ( tMin > tMax ) return false;
+
+	// Small step, in t, used to push the ray across a cell border
+	float length = sqrt( deltaX * deltaX + deltaY * deltaY );
+	float nudge = ( length > 0.0 ) ? 0.0001 / length : 1.0;
+
+	int top = this->levels() - 1;
+	float t = tMin;
+	while ( t <= tMax )
+	{
+		float px = startX + deltaX * t;
+		float py = startY + deltaY * t;
+		int cx = std::min( std::max( (int) floor( px ), 0 ), this->pGrid->width() - 1 );
+		int cy = std::min( std::max( (int) floor( py ), 0 ), this->pGrid->height() - 1 );
+
+		// Find the coarsest free cell containing the current point
+		int level = top;
+		while ( level >= 0 && this->value( level, cx >> level, cy >> level ) >= threshold )
+			level--;
+
+		if ( level < 0 )
+		{
+			if ( hit != NULL )
+				* hit = Coordinate( origin.x() + px * resolution, origin.y() + py * resolution );
+			return true;
+		}
+
+		// Skip to where the ray leaves that cell
+		float cellX = (float) ( ( cx >> level ) << level );
+		float cellY = (float) ( ( cy >> level ) << level );
+		float size = (float) ( 1 << level );
+		float exitX = ( deltaX > 0.0 ) ? ( cellX + size - startX ) / deltaX
+			: ( deltaX < 0.0 ) ? ( cellX - startX ) / deltaX : tMax + 1.0;
+		float exitY = ( deltaY > 0.0 ) ? ( cellY + size - startY ) / deltaY
+			: ( deltaY < 0.0 ) ? ( cellY - startY ) / deltaY : tMax + 1.0;
+
+		t = std::max( std::min( exitX, exitY ), t ) + nudge;
+	}
+
+	return false;
+}
+
+
+// Private functions
+
+void
+MapPyramid::refresh()
+{
+	for ( int level = 1; level < this->levels(); level++ )
+	{
+		std::vector< int > & pending = this->dirty[ level ];
+		int width = this->levelWidth[ level ];
+
+		for ( unsigned int i = 0; i < pending.size(); i++ )
+		{
+			int index = pending[ i ];
+			int x = index % width;
+			int y = index / width;
+			this->dirtyFlag[ level ][ index ] = 0;
+
+			unsigned char max = std::max(
+					std::max( this->value( level - 1, 2 * x, 2 * y ), this->value( level - 1, 2 * x + 1, 2 * y ) ),
+					std::max( this->value( level - 1, 2 * x, 2 * y + 1 ), this->value( level - 1, 2 * x + 1, 2 * y + 1 ) ) );
+
+			// Only propagate further up if this cell actually changed
+			if ( max != this->data[ level ][ index ] )
+			{
+				this->data[ level ][ index ] = max;
+				if ( level + 1 < this->levels() )
+					this->markDirty( level + 1, x / 2, y / 2 );
+			}
+		}
+		pending.clear();
+	}
+}
+
+void
+MapPyramid::markDirty( int level, int x, int y )
+{
+	int index = y * this->levelWidth[ level ] + x;
+	if ( this->dirtyFlag[ level ][ index ] ) return;
+
+	this->dirtyFlag[ level ][ index ] = 1;
+	this->dirty[ level ].push_back( index );
+}
+
+unsigned char
+MapPyramid::value( int level, int x, int y )
+{
+	if ( level == 0 ) return this->pGrid->cell( x, y );
+
+	if ( x < 0 || y < 0 || x >= this->levelWidth[ level ] || y >= this->levelHeight[ level ] )
+		return OCCUPANCYGRID_FREE;
+
+	return this->data[ level ][ y * this->levelWidth[ level ] + x ];
+}
+
+bool
+MapPyramid::boxOccupied( int level, int x, int y, int x0, int y0, int x1, int y1, unsigned char threshold )
+{
+	if ( this->value( level, x, y ) < threshold ) return false;
+
+	// A cell entirely inside the box holds its max value somewhere inside
+	int cellX0 = x << level, cellY0 = y << level;
+	int cellX1 = cellX0 + ( 1 << level ) - 1, cellY1 = cellY0 + ( 1 << level ) - 1;
+	if ( level == 0 || ( cellX0 >= x0 && cellX1 <= x1 && cellY0 >= y0 && cellY1 <= y1 ) )
+		return true;
+
+	// Descend into the children overlapping the box
+	int half = 1 << ( level - 1 );
+	for ( int j = 0; j < 2; j++ )
+		for ( int i = 0; i < 2; i++ )
+		{
+			int childX0 = cellX0 + i * half, childY0 = cellY0 + j * half;
+			if ( childX0 > x1 || childY0 > y1 || childX0 + half - 1 < x0 || childY0 + half - 1 < y0 )
+				continue;
+			if ( this->boxOccupied( level - 1, 2 * x + i, 2 * y + j, x0, y0, x1, y1, threshold ) )
+				return true;
+		}
+
+	return false;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file	MapPyramid.h
+ * @brief	Header file for the MapPyramid class
+ */
+#ifndef MAPPYRAMID_H
+#define MAPPYRAMID_H
+
+#include "OccupancyGrid.h"
+
+#include "../geometry/Coordinate.h"
+
+#include <vector>
+
+
+/**
+ * Multi-resolution view of an OccupancyGrid
+ *
+ * The pyramid is a quadtree stored level by level. Level 0 is the grid
+ * itself, and every cell of level n holds the highest occupancy value of the
+ * (up to) four cells below it in level n - 1. The top level is a single cell
+ * covering the entire grid.
+ *
+ * The view listens to the grid, but changed cells are only recorded when
+ * they happen. The coarse levels are brought up to date at the start of the
+ * next query, and only along the paths from the changed cells to the top.
+ *
+ * Queries work coarse-to-fine: a coarse cell below the threshold proves its
+ * whole area free with a single check, so an empty area costs one check
+ * no matter how many grid cells it covers.
+ */
+class MapPyramid : public GridListener
+{
+ public:
+	/**
+	 * Constructs the pyramid and registers it as a listener on the grid
+	 *
+	 * @param	pGrid	Pointer to the grid to view
+	 */
+	MapPyramid( OccupancyGrid * pGrid );
+
+	/**
+	 * Destructor, unregisters from the grid
+	 */
+	~MapPyramid();
+
+	/**
+	 * Records a changed grid cell, see GridListener
+	 */
+	void cellChanged( int x, int y, unsigned char oldValue, unsigned char newValue );
+
+	/**
+	 * Gets the number of levels, including the grid itself
+	 *
+	 * @return	The number of levels
+	 */
+	int levels();
+
+	/**
+	 * Gets the highest occupancy value inside a cell of the given level
+	 *
+	 * @param	level	Pyramid level, 0 being the grid
+	 * @param	x	Column at the given level
+	 * @param	y	Row at the given level
+	 *
+	 * @return	The highest occupancy value covered by the cell
+	 */
+	unsigned char maxOccupancy( int level, int x, int y );
+
+	/**
+	 * Checks if an axis aligned box contains no cell at or above the
+	 * threshold
+	 *
+	 * @param	corner1	One corner of the box, in world coordinates
+	 * @param	corner2	The opposite corner of the box
+	 * @param	threshold	Occupancy value considered an obstacle
+	 *
+	 * @return	Boolean indicating if the box is free
+	 */
+	bool boxIsFree( Coordinate corner1, Coordinate corner2, unsigned char threshold = OCCUPANCYGRID_OBSTACLE_THRESHOLD );
+
+	/**
+	 * Follows a straight line and finds the first cell at or above the
+	 * threshold. Free coarse cells are skipped in one step.
+	 *
+	 * @param	from	Start of the ray, in world coordinates
+	 * @param	to	End of the ray, in world coordinates
+	 * @param	hit	If not NULL, set to the point where the obstacle was met
+	 * @param	threshold	Occupancy value considered an obstacle
+	 *
+	 * @return	Boolean indicating if an obstacle was found before @c to
+	 */
+	bool castRay( Coordinate from, Coordinate to, Coordinate * hit = NULL, unsigned char threshold = OCCUPANCYGRID_OBSTACLE_THRESHOLD );
+
+ private:
+	OccupancyGrid
+	/// The viewed grid
+		* pGrid;
+
+	std::vector< int >
+	/// Number of columns of each level
+		levelWidth,
+	/// Number of rows of each level
+		levelHeight;
+
+	std::vector< std::vector< unsigned char > >
+	/// Max occupancy values of each level, level 0 is left empty (read from
+	/// the grid)
+		data,
+	/// Flags for cells in @c dirty, to avoid duplicates
+		dirtyFlag;
+
+	std::vector< std::vector< int > >
+	/// Indexes of cells of each level that need to be recomputed
+		dirty;
+
+	/**
+	 * Brings all levels up to date with the changes recorded since the last
+	 * call, working from the bottom up
+	 */
+	void refresh();
+
+	/**
+	 * Marks a cell as needing recomputation
+	 *
+	 * @param	level	Pyramid level, must be 1 or above
+	 * @param	x	Column at the given level
+	 * @param	y	Row at the given level
+	 */
+	void markDirty( int level, int x, int y );
+
+	/**
+	 * Reads a value without refreshing, used internally by the queries
+	 */
+	unsigned char value( int level, int x, int y );
+
+	/**
+	 * Recursive part of boxIsFree(), box limits are grid cells (inclusive)
+	 *
+	 * @return	Boolean indicating if an obstacle was found
+	 */
+	bool boxOccupied( int level, int x, int y, int x0, int y0, int x1, int y1, unsigned char threshold );
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "OccupancyGrid.h"
+
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+
+OccupancyGrid::OccupancyGrid( int width, int height, float resolution, Coordinate origin )
+{
+	this->_width = width;
+	this->_height = height;
+	this->_resolution = resolution;
+	this->_origin = origin;
+	this->cells.assign( width * height, OCCUPANCYGRID_FREE );
+}
+
+int
+OccupancyGrid::width()
+{
+	return this->_width;
+}
+
+int
+OccupancyGrid::height()
+{
+	return this->_height;
+}
+
+float
+OccupancyGrid::resolution()
+{
+	return this->_resolution;
+}
+
+Coordinate
+OccupancyGrid::origin()
+{
+	return this->_origin;
+}
+
+bool
+OccupancyGrid::contains( int x, int y )
+{
+	return x >= 0 && y >= 0 && x < this->_width && y < this->_height;
+}
+
+unsigned char
+OccupancyGrid::cell( int x, int y )
+{
+	if ( ! this->contains( x, y ) ) return OCCUPANCYGRID_FREE;
+
+	return this->cells[ y * this->_width + x ];
+}
+
+void
+OccupancyGrid::setCell( int x, int y, unsigned char value )
+{
+	if ( ! this->contains( x, y ) ) return;
+
+	unsigned char oldValue = this->cells[ y * this->_width + x ];
+	if ( oldValue == value ) return;
+
+	this->cells[ y * this->_width + x ] = value;
+
+	for ( unsigned int i = 0; i < this->listeners.size(); i++ )
+		this->listeners[ i ]->cellChanged( x, y, oldValue, value );
+}
+
+void
+OccupancyGrid::setCell( Coordinate coordinate, unsigned char value )
+{
+	int x, y;
+	if ( this->toCell( coordinate, & x, & y ) )
+		this->setCell( x, y, value );
+}
+
+bool
+OccupancyGrid::toCell( Coordinate coordinate, int * x, int * y )
+{
+	* x = (int) floor( ( coordinate.x() - this->_origin.x() ) / this->_resolution );
+	* y = (int) floor( ( coordinate.y() - this->_origin.y() ) / this->_resolution );
+
+	return this->contains( * x, * y );
+}
+
+Coordinate
+OccupancyGrid::toCoordinate( int x, int y )
+{
+	return Coordinate(
+			this->_origin.x() + ( x + 0.5 ) * this->_resolution,
+			this->_origin.y() + ( y + 0.5 ) * this->_resolution );
+}
+
+bool
+OccupancyGrid::load( const char * fileName )
+{
+	std::ifstream file( fileName, std::ios::binary );
+	std::string magic;
+	int width, height, maxValue;
+	file >> magic >> width >> height >> maxValue;
+	if ( ! file || magic != "P5" || maxValue != 255 ) return false;
+	if ( width != this->_width || height != this->_height ) return false;
+
+	// A single whitespace separates the header from the pixels
+	file.get();
+	std::vector< unsigned char > pixels( width * height );
+	file.read( (char *) & pixels[ 0 ], pixels.size() );
+	if ( ! file ) return false;
+
+	for ( int y = 0; y < height; y++ )
+		for ( int x = 0; x < width; x++ )
+			this->setCell( x, y, 255 - pixels[ ( height - 1 - y ) * width + x ] );
+
+	return true;
+}
+
+bool
+OccupancyGrid::save( const char * fileName )
+{
+	std::ofstream file( fileName, std::ios::binary );
+	file << "P5\n" << this->_width << ' ' << this->_height << "\n255\n";
+
+	std::vector< unsigned char > row( this->_width );
+	for ( int y = this->_height - 1; y >= 0; y-- )
+	{
+		for ( int x = 0; x < this->_width; x++ )
+			row[ x ] = 255 - this->cells[ y * this->_width + x ];
+		file.write( (const char *) & row[ 0 ], row.size() );
+	}
+
+	return (bool) file;
+}
+
+void
+OccupancyGrid::addListener( GridListener * listener )
+{
+	this->listeners.push_back( listener );
+}
+
+void
+OccupancyGrid::removeListener( GridListener * listener )
+{
+	this->listeners.erase(
+			std::remove( this->listeners.begin(), this->listeners.end(), listener ),
+			this->listeners.end() );
+}
@@ -0,0 +1,221 @@
+/**
+ * @file	OccupancyGrid.h
+ * @brief	Header file for the OccupancyGrid class
+ */
+#ifndef OCCUPANCYGRID_H
+#define OCCUPANCYGRID_H
+
+#include "../geometry/Coordinate.h"
+
+#include <vector>
+
+
+/// Default edge length of one grid cell, in meters
+#define OCCUPANCYGRID_RESOLUTION	0.05
+/// Default number of cells along each side of the grid Brain creates
+/// (400 cells of 5 cm gives a 20 x 20 meter map)
+#define OCCUPANCYGRID_DEFAULT_SIZE	400
+
+/// Occupancy value of a cell known to be free
+#define OCCUPANCYGRID_FREE	0
+/// Occupancy value of a cell known to be occupied
+#define OCCUPANCYGRID_OCCUPIED	255
+/// Occupancy value at or above which a cell is treated as an obstacle
+#define OCCUPANCYGRID_OBSTACLE_THRESHOLD	128
+
+
+/**
+ * Interface for objects that need to know when a cell of an OccupancyGrid
+ * changes value, for instance views or layers derived from the grid.
+ */
+class GridListener
+{
+ public:
+	virtual ~GridListener() {}
+
+	/**
+	 * Called by OccupancyGrid::setCell() whenever a cell changes value
+	 *
+	 * @param	x	Column of the changed cell
+	 * @param	y	Row of the changed cell
+	 * @param	oldValue	The previous occupancy value of the cell
+	 * @param	newValue	The new occupancy value of the cell
+	 */
+	virtual void cellChanged( int x, int y, unsigned char oldValue, unsigned char newValue ) = 0;
+};
+
+
+/**
+ * A fixed size, two-dimensional grid of occupancy values
+ *
+ * Each cell holds a value from OCCUPANCYGRID_FREE to OCCUPANCYGRID_OCCUPIED.
+ * Cell [0, 0] has its lower left corner at the origin of the grid, x
+ * (columns) and y (rows) follow the axes of the odometry coordinate system.
+ *
+ * Cells outside the grid are reported as free.
+ *
+ * See @link OccupancyGrid.h @endlink for documentation of @c \#define
+ * parameters
+ */
+class OccupancyGrid
+{
+ public:
+	/**
+	 * Constructs an OccupancyGrid with all cells free
+	 *
+	 * @param	width	Number of columns
+	 * @param	height	Number of rows
+	 * @param	resolution	Edge length of a cell, in meters
+	 * @param	origin	World coordinate of the lower left corner of the grid
+	 */
+	OccupancyGrid( int width, int height, float resolution = OCCUPANCYGRID_RESOLUTION, Coordinate origin = Coordinate( 0.0, 0.0 ) );
+
+	/**
+	 * Gets the number of columns
+	 *
+	 * @return	The width of the grid in cells
+	 */
+	int width();
+
+	/**
+	 * Gets the number of rows
+	 *
+	 * @return	The height of the grid in cells
+	 */
+	int height();
+
+	/**
+	 * Gets the edge length of a cell
+	 *
+	 * @return	Cell size in meters
+	 */
+	float resolution();
+
+	/**
+	 * Gets the world coordinate of the lower left corner of the grid
+	 *
+	 * @return	The origin as a Coordinate
+	 */
+	Coordinate origin();
+
+	/**
+	 * Checks if a cell index is inside the grid
+	 *
+	 * @param	x	Column
+	 * @param	y	Row
+	 *
+	 * @return	Boolean indicating if the cell exists
+	 */
+	bool contains( int x, int y );
+
+	/**
+	 * Gets the occupancy value of a cell
+	 *
+	 * @param	x	Column
+	 * @param	y	Row
+	 *
+	 * @return	Occupancy value, OCCUPANCYGRID_FREE if outside the grid
+	 */
+	unsigned char cell( int x, int y );
+
+	/**
+	 * Sets the occupancy value of a cell and notifies all listeners if the
+	 * value changed. Cells outside the grid are ignored.
+	 *
+	 * @param	x	Column
+	 * @param	y	Row
+	 * @param	value	New occupancy value
+	 */
+	void setCell( int x, int y, unsigned char value );
+
+	/**
+	 * Sets the occupancy value of the cell containing a world coordinate
+	 *
+	 * @param	coordinate	World coordinate
+	 * @param	value	New occupancy value
+	 */
+	void setCell( Coordinate coordinate, unsigned char value );
+
+	/**
+	 * Finds the cell containing a world coordinate
+	 *
+	 * @param	coordinate	World coordinate
+	 * @param	x	Set to the column of the cell
+	 * @param	y	Set to the row of the cell
+	 *
+	 * @return	Boolean indicating if the cell is inside the grid
+	 */
+	bool toCell( Coordinate coordinate, int * x, int * y );
+
+	/**
+	 * Gets the world coordinate of the center of a cell
+	 *
+	 * @param	x	Column
+	 * @param	y	Row
+	 *
+	 * @return	Coordinate of the cell center
+	 */
+	Coordinate toCoordinate( int x, int y );
+
+	/**
+	 * Loads a map saved by save(). The file must have the same number of
+	 * rows and columns as the grid. Cells are set through setCell(), so
+	 * listeners see every change.
+	 *
+	 * @param	fileName	The file to read
+	 *
+	 * @return	False if there was no valid file of the right size, the grid
+	 * is then unchanged
+	 */
+	bool load( const char * fileName );
+
+	/**
+	 * Saves the grid as a binary PGM image, free cells white and obstacles
+	 * black, with the top row of the image the top row of the map
+	 *
+	 * @param	fileName	The file to write
+	 *
+	 * @return	False if it could not be written
+	 */
+	bool save( const char * fileName );
+
+	/**
+	 * Registers a listener to be notified about changed cells
+	 *
+	 * @param	listener	Pointer to the listener, must outlive the grid or
+	 * be removed by removeListener()
+	 */
+	void addListener( GridListener * listener );
+
+	/**
+	 * Unregisters a listener
+	 *
+	 * @param	listener	Pointer to a previously added listener
+	 */
+	void removeListener( GridListener * listener );
+
+ private:
+	int
+	/// Number of columns
+		_width,
+	/// Number of rows
+		_height;
+
+	float
+	/// Edge length of a cell in meters
+		_resolution;
+
+	Coordinate
+	/// World coordinate of the lower left corner
+		_origin;
+
+	std::vector< unsigned char >
+	/// Occupancy values, row by row
+		cells;
+
+	std::vector< GridListener * >
+	/// Objects to notify when a cell changes
+		listeners;
+};
+
+#endif
@@ -1,39 +1,15 @@
 #ifndef KART_H
 #define KART_H
 
-#include <iostream>
-
+/// Step cost multiplier of a cell inside Robotinos footprint of an obstacle.
+/// High enough to always route around, but still lets a robot that is
+/// already too close get out.
 #define BIGCOST 500
-#define GRIDSIZE 12
+/// Length of a diagonal step, in cells
 #define SQRT2 1.4142136
-const bool EMPTY = false;
-const bool FULL = true;
-
-extern int occupancy[GRIDSIZE][GRIDSIZE];
-extern float cost[GRIDSIZE][GRIDSIZE];
-
-//position
-
-extern float robot_x ; //
-extern float robot_y;
-const int goal_x = 2;
-const int goal_y = 0;
-extern int cellCount;
-
-void initialiser();
-void findPos(int x, int y);
-int sjekkLaser(float *F, float *L, float *R);
-void updateKart( float *F, float *L, float *R);
-extern int cellCost(int x, int y);
-void replan();
-void moveRobotino(float heading);
-float checkPlan( int x, int y);
-
-#endif 
-
-
-
-
-
 
+// The occupancy grid, cellCost(), replan(), checkPlan() and moveRobotino()
+// once prototyped here are implemented by gridnav (navigation/gridnav.h),
+// on Brain's OccupancyGrid and InflationLayer.
 
+#endif
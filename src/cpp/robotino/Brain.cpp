@@ -6,11 +6,23 @@
 #include "headers/_Odometry.h"
 #include "headers/_DistanceSensors.h"
 #include "headers/_LaserRangeFinder.h"
+#include "headers/_Motor.h"
 
 #include "../geometry/All.h"
 
 #include "../kinect/KinectReader.h"
 
+#include "../obstacle/OccupancyGrid.h"
+#include "../obstacle/MapPyramid.h"
+#include "../obstacle/DynamicLayer.h"
+#include "../obstacle/InflationLayer.h"
+
+#include "../navigation/gridnav.h"
+#include "../navigation/DynamicWindow.h"
+#include "../navigation/MonteCarloLocalizer.h"
+#include "../navigation/GraphSlam.h"
+#include "../navigation/SlipDetector.h"
+
 #include <rec/robotino/api2/Com.h>
 
 #include <stdlib.h>
@@ -91,11 +103,81 @@ Brain::dist()
 	return this->pDistSensors;
 }
 
+_Motor *
+Brain::motor( unsigned int number )
+{
+	if ( number >= this->pMotors.size() ) return 0;
+	return this->pMotors[ number ];
+}
+
 gridnav *
 Brain::gdn()
 {
 	return this->pGDN;
 }
+
+DynamicWindow *
+Brain::dwa()
+{
+	return this->pDWA;
+}
+
+MonteCarloLocalizer *
+Brain::localizer()
+{
+	return this->pLocalizer;
+}
+
+GraphSlam *
+Brain::slam()
+{
+	return this->pSlam;
+}
+
+SlipDetector *
+Brain::slip()
+{
+	return this->pSlip;
+}
+
+OccupancyGrid *
+Brain::map()
+{
+	return this->pMap;
+}
+
+void
+Brain::loadMap( std::string file )
+{
+	std::lock_guard< std::mutex > lock( this->mapMutex );
+	this->mapLoadFile = file;
+}
+
+void
+Brain::saveMap( std::string file )
+{
+	std::lock_guard< std::mutex > lock( this->mapMutex );
+	this->mapSaveFile = file;
+}
+
+MapPyramid *
+Brain::mapView()
+{
+	return this->pMapView;
+}
+
+DynamicLayer *
+Brain::dynamicMap()
+{
+	return this->pDynamicMap;
+}
+
+InflationLayer *
+Brain::costMap()
+{
+	return this->pCostMap;
+}
+
 bool
 Brain::hasLRF()
 {
@@ -146,6 +228,10 @@ Brain::initialize()
 	this->pOdom = new _Odometry( this );
 	this->pOdom->set( 0.0, 0.0, 0.0 );
 
+	std::cerr << "- Motors" << std::endl;
+	for ( unsigned int i = 0; i < MOTOR_COUNT; i++ )
+		this->pMotors.push_back( new _Motor( this, i ) );
+
 	std::cerr << "- OmniDrive " << std::endl;
 	this->pDrive = new _OmniDrive( this );
 
@@ -166,6 +252,29 @@ Brain::initialize()
 		delete this->pLRF;  /// @todo Not sure if this is the best way
 	}
 
+	std::cerr << "- Map" << std::endl;
+	float mapSide = OCCUPANCYGRID_DEFAULT_SIZE * OCCUPANCYGRID_RESOLUTION;
+	this->pMap = new OccupancyGrid( OCCUPANCYGRID_DEFAULT_SIZE, OCCUPANCYGRID_DEFAULT_SIZE,
+			OCCUPANCYGRID_RESOLUTION, Coordinate( - mapSide / 2, - mapSide / 2 ) );
+	this->pMapView = new MapPyramid( this->pMap );
+	this->pDynamicMap = new DynamicLayer( this->pMap );
+	this->pCostMap = new InflationLayer( this->pMap, this->pDynamicMap->grid() );
+
+	std::cerr << "- Grid navigation" << std::endl;
+	this->pGDN = new gridnav( this );
+
+	std::cerr << "- Local planner" << std::endl;
+	this->pDWA = new DynamicWindow( this );
+
+	std::cerr << "- Localizer" << std::endl;
+	this->pLocalizer = new MonteCarloLocalizer( this );
+
+	std::cerr << "- Mapper" << std::endl;
+	this->pSlam = new GraphSlam( this );
+
+	std::cerr << "- Slip detector" << std::endl;
+	this->pSlip = new SlipDetector( this );
+
 	this->initializationDone = true;
 	std::cerr << "--Initialization complete" << std::endl;
 	
@@ -328,6 +437,10 @@ Brain::mainLoop()
 		// Update all Robotino sensor data
 		this->processEvents();
 
+		// Before the analyzers, so a localizer started along with a load
+		// sees the loaded map
+		this->processMapRequests();
+
 		// Check critical data to see if any action needs to be taken ASAP (_Bumper::contact)
 		if ( this->pBumper->contact() )
 		{
@@ -336,10 +449,30 @@ Brain::mainLoop()
 		
 		// Call analyzers for all Robotino sensors
 		this->pOdom->analyze();
-//		this->pDistSensors->analyze();	// Not yet implemented
+		for ( unsigned int i = 0; i < this->pMotors.size(); i++ )
+			this->pMotors[ i ]->analyze();
+		this->pDistSensors->analyze();
 		this->pCbha->analyze();
+		if ( this->hasLaserRangeFinder )
+		{
+			this->pLRF->analyze();
+			this->pLocalizer->analyze();
+			this->pSlam->analyze();
+		}
+
+		// Before the drive applies, so it reacts to slip in the same cycle
+		this->pSlip->analyze();
+
+		// Forget dynamic obstacles that have not been seen for a while
+		this->pDynamicMap->expire( this->msecsElapsed() );
+
+		// Verify the planned route against the updated maps
+		this->pGDN->analyze();
+		this->pDWA->analyze();
 
 		// Call appliers for all Robotino actuators
+		this->pGDN->apply();
+		this->pDWA->apply();
 		this->pDrive->apply();
 		this->pCbha->apply();
 
@@ -364,6 +497,33 @@ Brain::mainLoop()
 	std::cerr << "Brain main loop ended" << std::endl;
 }
 
+void
+Brain::processMapRequests()
+{
+	std::string load, save;
+	{
+		std::lock_guard< std::mutex > lock( this->mapMutex );
+		load.swap( this->mapLoadFile );
+		save.swap( this->mapSaveFile );
+	}
+
+	if ( ! load.empty() )
+	{
+		if ( this->pMap->load( load.c_str() ) )
+			std::cerr << "Brain: map loaded from " << load << std::endl;
+		else
+			std::cerr << "Brain: could not load a map of the right size from " << load << std::endl;
+	}
+
+	if ( ! save.empty() )
+	{
+		if ( this->pMap->save( save.c_str() ) )
+			std::cerr << "Brain: map saved to " << save << std::endl;
+		else
+			std::cerr << "Brain: could not save the map to " << save << std::endl;
+	}
+}
+
 void
 Brain::errorEvent( const char * errorString )
 {
@@ -563,8 +563,10 @@ _CompactBha::calibrateOdometry()
 		return;
 	}
 
-	// calculate new center position based on kinect coordinate and arm position
-	AngularCoordinate odomPosition = this->brain()->odom()->getPosition();
+	// calculate new center position based on kinect coordinate and arm
+	// position, as of when the Kinect saw the gripper
+	unsigned int measureTime = this->brain()->msecsElapsed() - dataAge;
+	AngularCoordinate odomPosition = this->brain()->odom()->getPosition( measureTime );
 
 	/// @todo Project suggestion: Precice position of cBHA gripper derived from potmeters
 	Vector cbhaVector( CBHA_ARM_RELAXED_DISTANCE_FROM_CENTER, odomPosition.phi() );
@@ -593,13 +595,20 @@ _CompactBha::calibrateOdometry()
 		return;
 	}
 
+	// Update Odometry
+	if ( ! this->brain()->odom()->fixPosition( newPosition, measureTime ) )
+	{
+		std::cout
+			<< "CompactBha: Calibration rejected by the pose filter: ["
+			<< deltaX << ',' << deltaY << ']'
+			<< std::endl;
+		return;
+	}
+
 	std::cout
-		<< "CompactBha: OdometryCalibration, adjust current position by: ["
+		<< "CompactBha: OdometryCalibration, corrected position by up to: ["
 		<< deltaX << ',' << deltaY << ']'
 		<< std::endl;
-
-	// Update Odometry
-	this->brain()->odom()->set( newPosition.x(), newPosition.y(), odomPosition.phi() );
 }
 
 void
@@ -31,7 +31,22 @@ _DistanceSensors::_DistanceSensors( Brain * pBrain )
 void
 _DistanceSensors::analyze()
 {
-	/// @todo Not yet implemented
+	if ( ! this->distancesUpdated ) return;
+
+	// The sensors measure from the edge of the footprint
+	this->freeSpace.clear();
+	for ( unsigned int i = 0; i < DISTANCESENSORS_COUNT; i++ )
+	{
+		float distance = this->readDistances[ i ];
+		if ( distance <= 0.0 || distance > DISTANCESENSORS_RANGE ) continue;
+
+		float angle = ( ( 2 * M_PI ) / 9 ) * i;
+		this->freeSpace.addPoint(
+				( FREESPACE_ROBOT_RADIUS + distance ) * cos( angle ),
+				( FREESPACE_ROBOT_RADIUS + distance ) * sin( angle ) );
+	}
+
+	this->distancesUpdated = false;
 }
 
 void
@@ -56,6 +71,12 @@ _DistanceSensors::sensorAngle( unsigned int sensorNo )
 	return Angle( ( ( 2 * M_PI ) / 9 ) * sensorNo );
 }
 
+float
+_DistanceSensors::freeDistance( float direction )
+{
+	return this->freeSpace.distance( direction );
+}
+
 
 // Private functions
 
@@ -2,7 +2,11 @@
 
 #include "headers/Axon.h"
 #include "headers/Brain.h"
+#include "headers/_Odometry.h"
 #include "../geometry/Angle.h"
+#include "../obstacle/DynamicLayer.h"
+
+#include <math.h>
 #include <stdlib.h>
 #include <stdexcept>
 #include <string>
@@ -21,8 +25,27 @@ _LaserRangeFinder::_LaserRangeFinder( Brain * pBrain ) :
 void
 _LaserRangeFinder::analyze()
 {
-	/// @todo Not yet implemented
-	
+	// Register everything seen as a dynamic obstacle, the static map is left
+	// untouched so passers-by are not burned into it. The same pass finds
+	// the free distances around Robotino.
+	if ( this->readingsUpdated )
+	{
+		std::vector< Coordinate > points = this->scanCoordinates( AngularCoordinate( 0.0, 0.0, 0.0 ) );
+		unsigned int now = this->brain()->msecsElapsed();
+
+		PreciseAngularCoordinate pose = this->brain()->odom()->getPosition( this->scanTime() );
+
+		float c = cos( pose.phi() ), s = sin( pose.phi() );
+		this->freeSpace.clear();
+
+		for ( unsigned int i = 0; i < points.size(); i++ )
+		{
+			float x = points[ i ].x(), y = points[ i ].y();
+			this->freeSpace.addPoint( x, y );
+			this->brain()->dynamicMap()->mark( Coordinate( pose.x() + c * x - s * y, pose.y() + s * x + c * y ), now );
+		}
+	}
+
 	this->readingsUpdated = false;
 }
 
@@ -207,6 +230,43 @@ _LaserRangeFinder::sensorLeft( )
 
 
 }
+std::vector< Coordinate >
+_LaserRangeFinder::scanCoordinates( AngularCoordinate pose )
+{
+	std::vector< Coordinate > points;
+	const float * rangev;
+	unsigned int rangec = 0;
+
+	this->latestReadings.ranges( & rangev, & rangec );
+	points.reserve( rangec );
+
+	for ( unsigned int i = 0; i < rangec; i++ )
+	{
+		if ( rangev[ i ] < this->latestReadings.range_min || rangev[ i ] > this->latestReadings.range_max )
+			continue;
+
+		float angle = pose.phi() + this->latestReadings.angle_min + i * this->latestReadings.angle_increment;
+		points.push_back( Coordinate(
+					pose.x() + rangev[ i ] * cos( angle ),
+					pose.y() + rangev[ i ] * sin( angle ) ) );
+	}
+
+	return points;
+}
+
+float
+_LaserRangeFinder::freeDistance( float direction )
+{
+	return this->freeSpace.distance( direction );
+}
+
+unsigned int
+_LaserRangeFinder::scanTime()
+{
+	// scan_time is the duration of a sweep in seconds
+	return this->updateTime - (unsigned int) ( this->latestReadings.scan_time * 500.0 );
+}
+
 // Private functions
 
 void
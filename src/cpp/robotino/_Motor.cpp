@@ -0,0 +1,160 @@
+#include "headers/_Motor.h"
+
+#include "headers/Axon.h"
+#include "headers/Brain.h"
+
+#include <rec/robotino/api2/Motor.h>
+
+#include <math.h>
+#include <iostream>
+
+
+_Motor::_Motor( Brain * pBrain, unsigned int number )
+	: Axon::Axon( pBrain )
+	  , rec::robotino::api2::Motor::Motor()
+{
+	this->stalled = false;
+
+	this->_number = number;
+	this->stallSince = 0;
+	this->fresh = false;
+	this->started = false;
+
+	this->reading.time = 0;
+	this->reading.velocity = 0.0;
+	this->reading.position = 0;
+	this->reading.current = 0.0;
+	this->latest = this->reading;
+
+	this->_meanCurrent = 0.0;
+	this->_meanSpeed = 0.0;
+	this->_sampleRate = 0.0;
+	this->_energy = 0.0;
+
+	this->setMotorNumber( number );
+}
+
+void
+_Motor::analyze()
+{
+	if ( ! this->fresh ) return;
+	this->fresh = false;
+	this->add( this->reading );
+
+	// Drawing current without turning, for long enough
+	bool stalling = this->_meanCurrent > MOTOR_STALL_CURRENT && this->_meanSpeed < MOTOR_STALL_SPEED;
+	if ( ! stalling )
+		this->stallSince = 0;
+	else if ( this->stallSince == 0 )
+		this->stallSince = this->latest.time;
+
+	bool stalled = this->stallSince != 0 && this->latest.time - this->stallSince >= MOTOR_STALL_TIME;
+	if ( stalled == this->stalled ) return;
+
+	this->stalled = stalled;
+	if ( stalled )
+		std::cout << "_Motor: motor " << this->_number << " stalled, drawing "
+			<< this->_meanCurrent << " A" << std::endl;
+	else
+		std::cout << "_Motor: motor " << this->_number << " turning again" << std::endl;
+}
+
+void
+_Motor::apply()
+{}  /// Should be empty, _OmniDrive sets the motor speeds
+
+unsigned int
+_Motor::number()
+{
+	return this->_number;
+}
+
+float
+_Motor::velocity()
+{
+	return this->latest.velocity;
+}
+
+int
+_Motor::position()
+{
+	return this->latest.position;
+}
+
+float
+_Motor::current()
+{
+	return this->latest.current;
+}
+
+float
+_Motor::meanCurrent()
+{
+	return this->_meanCurrent;
+}
+
+float
+_Motor::meanSpeed()
+{
+	return this->_meanSpeed;
+}
+
+bool
+_Motor::isStalled()
+{
+	return this->stalled;
+}
+
+double
+_Motor::energy()
+{
+	return this->_energy;
+}
+
+float
+_Motor::sampleRate()
+{
+	return this->_sampleRate;
+}
+
+// Private functions
+
+void
+_Motor::add( const Sample & sample )
+{
+	float current = fabs( sample.current );
+	float speed = fabs( sample.velocity );
+
+	if ( ! this->started )
+	{
+		this->_meanCurrent = current;
+		this->_meanSpeed = speed;
+		this->started = true;
+	}
+	else if ( sample.time > this->latest.time )
+	{
+		// Weighed by the time since the last reading, so the means do not
+		// depend on the length of the cycle
+		float seconds = ( sample.time - this->latest.time ) / 1000.0;
+		float weight = seconds / ( MOTOR_MEAN_TIME + seconds );
+		this->_meanCurrent += ( current - this->_meanCurrent ) * weight;
+		this->_meanSpeed += ( speed - this->_meanSpeed ) * weight;
+		this->_sampleRate += ( 1.0 / seconds - this->_sampleRate ) * weight;
+
+		// The current is taken to have held since the last reading
+		this->_energy += MOTOR_SUPPLY_VOLTAGE * fabs( this->latest.current ) * seconds;
+	}
+
+	this->latest = sample;
+}
+
+void
+_Motor::motorReadingsChanged( float velocity, int position, float current )
+{
+	// Several readings in one cycle replace each other, the latest counts
+	this->reading.time = this->brain()->msecsElapsed();
+	this->reading.velocity = velocity;
+	this->reading.position = position;
+	this->reading.current = current;
+	this->fresh = true;
+}
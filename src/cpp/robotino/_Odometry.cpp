@@ -12,6 +12,44 @@ _Odometry::_Odometry( Brain * pBrain )
 	Axon::Axon( pBrain )
 {
 	this->updateTime = 0;
+	this->sequence = 0;
+
+	this->x = 0.0;
+	this->y = 0.0;
+	this->phi = 0.0;
+	this->vx = 0.0;
+	this->vy = 0.0;
+	this->omega = 0.0;
+
+	this->rawValid = false;
+	this->rawTime = 0;
+	this->setPending = false;
+	this->setTime = 0;
+	this->historyReset = false;
+	this->slipping = false;
+
+	if ( this->calibration.load( ODOMETRY_CALIBRATION_FILE ) )
+		std::cout
+			<< "Odometry: calibration loaded, scale " << this->calibration.scale( 0.0 )
+			<< " standing to " << this->calibration.scale( 0.2 ) << " at 0.2 m/s, drift "
+			<< this->calibration.drift() << " rad/m"
+			<< std::endl;
+
+	// Start the thread refreshing stale readings and saving the calibration
+	this->refreshRequested = false;
+	this->saveRequested = false;
+	this->runRefreshLoop = true;
+	this->tRefresh = std::thread( & _Odometry::refreshLoop, this );
+}
+
+_Odometry::~_Odometry()
+{
+	{
+		std::lock_guard< std::mutex > lock( this->refreshMutex );
+		this->runRefreshLoop = false;
+	}
+	this->refreshCondition.notify_one();
+	this->tRefresh.join();
 }
 
 bool
@@ -19,6 +57,23 @@ _Odometry::set( double x, double y, double phi, bool blocking )
 {
 	if ( rec::robotino::api2::Odometry::set( x / ODOMETRY_ADJUSTMENT_FACTOR, y / ODOMETRY_ADJUSTMENT_FACTOR, phi, blocking ) ) 
 	{
+		{
+			// Continue from the next reading, the old ones are off now
+			std::lock_guard< std::mutex > lock( this->filterMutex );
+			this->filter.reset( x, y, phi );
+			this->rawValid = false;
+			this->historyReset = true;
+			this->setPending = true;
+			this->setX = x;
+			this->setY = y;
+			this->setPhi = phi;
+			this->setTime = this->brain()->msecsElapsed();
+			this->calibration.abandon();
+			this->x = this->filter.x();
+			this->y = this->filter.y();
+			this->phi = this->filter.phi();
+		}
+
 		if ( ! blocking ) return true;
 		std::cout
 			<< "Odometry successfully set to "
@@ -34,6 +89,71 @@ _Odometry::set( double x, double y, double phi, bool blocking )
 	}
 }
 
+bool
+_Odometry::fixPosition( PreciseCoordinate position, unsigned int time )
+{
+	float age = ( (int) ( this->brain()->msecsElapsed() - time ) ) / 1000.0;
+	double then[ 3 ];
+	bool recorded = this->history.lookup( time, then );
+
+	std::lock_guard< std::mutex > lock( this->filterMutex );
+	double x = position.x(), y = position.y();
+	if ( recorded )
+	{
+		// Move the fix along with Robotino since it was taken
+		x += this->x - then[ 0 ];
+		y += this->y - then[ 1 ];
+		age = 0.0;
+	}
+
+	if ( ! this->filter.correctPosition( x, y, ODOMETRY_KINECT_DEVIATION, age ) )
+		return false;
+
+	// Only a fix moved to now pairs with the odometry counted up to now
+	if ( recorded && this->calibration.fixPosition( x, y ) )
+		this->requestSave();
+
+	this->x = this->filter.x();
+	this->y = this->filter.y();
+	this->phi = this->filter.phi();
+	return true;
+}
+
+bool
+_Odometry::fixPose( PreciseAngularCoordinate pose, unsigned int time )
+{
+	float age = ( (int) ( this->brain()->msecsElapsed() - time ) ) / 1000.0;
+	double then[ 3 ];
+	bool recorded = this->history.lookup( time, then );
+
+	std::lock_guard< std::mutex > lock( this->filterMutex );
+	double x = pose.x(), y = pose.y(), phi = pose.phi();
+	if ( recorded )
+	{
+		// Move the fix along with Robotino since it was taken, turning the
+		// move from the recorded heading to the measured one
+		double c = cos( then[ 2 ] ), s = sin( then[ 2 ] );
+		double dx = c * ( this->x - then[ 0 ] ) + s * ( this->y - then[ 1 ] );
+		double dy = - s * ( this->x - then[ 0 ] ) + c * ( this->y - then[ 1 ] );
+		x += cos( phi ) * dx - sin( phi ) * dy;
+		y += sin( phi ) * dx + cos( phi ) * dy;
+		phi += this->phi - then[ 2 ];
+		age = 0.0;
+	}
+
+	if ( ! this->filter.correctPose( x, y, phi,
+			ODOMETRY_SCANMATCH_DEVIATION, ODOMETRY_SCANMATCH_PHI_DEVIATION, age ) )
+		return false;
+
+	if ( recorded && this->calibration.fixPose( x, y, phi ) )
+		this->requestSave();
+
+	this->x = this->filter.x();
+	this->y = this->filter.y();
+	this->phi = this->filter.phi();
+	return true;
+}
+
 void
 _Odometry::analyze()
 {}
@@ -42,22 +162,38 @@ void
 _Odometry::apply()
 {}
 
-AngularCoordinate
+PreciseAngularCoordinate
 _Odometry::getPosition()
 {
-	if ( ( this->brain()->msecsElapsed() - this->updateTime ) > BRAIN_DATA_MAX_AGE )
-	{
-		this->update();
-	}
-	return AngularCoordinate( this->x, this->y, this->phi );
+	if ( this->dataAge() > BRAIN_DATA_MAX_AGE ) this->requestRefresh();
+
+	std::lock_guard< std::mutex > lock( this->filterMutex );
+	return PreciseAngularCoordinate( this->x, this->y, this->phi );
+}
+
+PreciseAngularCoordinate
+_Odometry::getPosition( unsigned int time )
+{
+	double pose[ 3 ];
+	if ( ! this->history.lookup( time, pose ) ) return this->getPosition();
+
+	return PreciseAngularCoordinate( pose[ 0 ], pose[ 1 ], pose[ 2 ] );
 }
 
-Angle
+PreciseAngle
 _Odometry::getPhi()
 {
-	this->update();
+	if ( this->dataAge() > BRAIN_DATA_MAX_AGE ) this->requestRefresh();
 
-	return Angle( this->phi );
+	std::lock_guard< std::mutex > lock( this->filterMutex );
+	return PreciseAngle( this->phi );
+}
+
+unsigned int
+_Odometry::dataAge()
+{
+	std::lock_guard< std::mutex > lock( this->filterMutex );
+	return this->brain()->msecsElapsed() - this->updateTime;
 }
 
 float
@@ -72,6 +208,21 @@ _Odometry::currentAbsOmega()
 	return fabs( this->omega );
 }
 
+void
+_Odometry::currentSpeed( float * vx, float * vy, float * omega )
+{
+	std::lock_guard< std::mutex > lock( this->filterMutex );
+	* vx = this->vx;
+	* vy = this->vy;
+	* omega = this->omega;
+}
+
+void
+_Odometry::setSlipping( bool slipping )
+{
+	this->slipping = slipping;
+}
+
 // Private functions
 
 void
@@ -81,36 +232,156 @@ _Odometry::readings( double * x, double * y, double * phi, unsigned int * sequen
 void
 _Odometry::readingsEvent( double x, double y, double phi, float vx, float vy, float omega, unsigned int sequence )
 {
-	this->x = x * ODOMETRY_ADJUSTMENT_FACTOR;
-	this->y = y * ODOMETRY_ADJUSTMENT_FACTOR;
-	this->phi = phi;
+	std::lock_guard< std::mutex > lock( this->filterMutex );
+	this->integrate( x * ODOMETRY_ADJUSTMENT_FACTOR, y * ODOMETRY_ADJUSTMENT_FACTOR, phi );
+	this->filter.correctSpeed( vx, vy, omega );
 	this->vx = vx;
 	this->vy = vy;
 	this->omega = omega;
 	this->sequence = sequence;
 	this->updateTime = this->brain()->msecsElapsed();
+
+	// Poses from before a set() would be interpolated across the jump
+	if ( this->historyReset.exchange( false ) ) this->history.clear();
+	const double pose[ 3 ] = { this->x, this->y, this->phi };
+	const float speed[ 3 ] = { vx, vy, omega };
+	this->history.add( this->updateTime, pose, speed );
 }
 
 void
 _Odometry::update()
 {
-	double
-		* x = & this->x,
-		* y = & this->y,
-		* phi = & this->phi;
-	
-	unsigned int
-		* sequence = & this->sequence;
+	double x, y, phi;
+	unsigned int sequence;
 
-	rec::robotino::api2::Odometry::readings( x, y, phi, sequence );
+	rec::robotino::api2::Odometry::readings( & x, & y, & phi, & sequence );
 //	std::cout
-//		<< "Odom read:  " << this->x << " " << this->y << " " << this->phi
+//		<< "Odom read:  " << x << " " << y << " " << phi
 //		<< std::endl;
-	this->x *= ODOMETRY_ADJUSTMENT_FACTOR;
-	this->y *= ODOMETRY_ADJUSTMENT_FACTOR;
+
+	std::lock_guard< std::mutex > lock( this->filterMutex );
+
+	// An event may have brought a newer reading while this one was requested
+	if ( (int) ( sequence - this->sequence ) < 0 ) return;
+	this->integrate( x * ODOMETRY_ADJUSTMENT_FACTOR, y * ODOMETRY_ADJUSTMENT_FACTOR, phi );
+	this->sequence = sequence;
 	this->updateTime = this->brain()->msecsElapsed();
 //	std::cout
 //		<< "Odom wrote: " << this->x << " " << this->y << " " << this->phi
 //		<< std::endl;
 }
 
+void
+_Odometry::integrate( double x, double y, double phi )
+{
+	unsigned int now = this->brain()->msecsElapsed();
+
+	// Readings queued before Robotino applied set() are still in the old
+	// frame, continuing from one would drive the filter by the correction
+	if ( this->setPending )
+	{
+		double distance = sqrt( ( x - this->setX ) * ( x - this->setX ) + ( y - this->setY ) * ( y - this->setY ) );
+		double turn = atan2( sin( phi - this->setPhi ), cos( phi - this->setPhi ) );
+		if ( ( distance > ODOMETRY_SET_TOLERANCE || fabs( turn ) > ODOMETRY_SET_TURN_TOLERANCE )
+			&& now - this->setTime < ODOMETRY_SET_TIMEOUT )
+			return;
+		this->setPending = false;
+	}
+
+	if ( this->rawValid )
+	{
+		// The increment in the frame of the last reading
+		double c = cos( this->rawPhi ), s = sin( this->rawPhi );
+		double dx = c * ( x - this->rawX ) + s * ( y - this->rawY );
+		double dy = - s * ( x - this->rawX ) + c * ( y - this->rawY );
+		double dphi = atan2( sin( phi - this->rawPhi ), cos( phi - this->rawPhi ) );
+
+		float dt = ( now - this->rawTime ) / 1000.0;
+		double length = sqrt( dx * dx + dy * dy );
+		float speed = ( dt > 0.0 ) ? length / dt : 0.0;
+
+		// A jump means the odometry was set, not driven
+		if ( length <= ODOMETRY_MAX_STEP && fabs( dphi ) <= ODOMETRY_MAX_TURN )
+		{
+			// Slipping wheels tell little about where Robotino went, and
+			// nothing to learn from
+			bool slipping = this->slipping;
+			if ( slipping )
+				this->calibration.abandon();
+			else
+				this->calibration.accumulate( dx, dy, dphi, this->filter.phi(), speed );
+			this->calibration.correct( dx, dy, dphi, speed );
+			this->filter.predict( dx, dy, dphi, dt, slipping ? ODOMETRY_SLIP_NOISE_FACTOR : 1.0 );
+		}
+		else
+			this->calibration.abandon();
+	}
+
+	this->rawX = x;
+	this->rawY = y;
+	this->rawPhi = phi;
+	this->rawTime = now;
+	this->rawValid = true;
+
+	this->x = this->filter.x();
+	this->y = this->filter.y();
+	this->phi = this->filter.phi();
+}
+
+void
+_Odometry::requestRefresh()
+{
+	{
+		// Callers asking while a refresh is pending share it
+		std::lock_guard< std::mutex > lock( this->refreshMutex );
+		if ( this->refreshRequested ) return;
+		this->refreshRequested = true;
+	}
+	this->refreshCondition.notify_one();
+}
+
+void
+_Odometry::requestSave()
+{
+	{
+		// Copied, so the file is written while the filter goes on learning
+		std::lock_guard< std::mutex > lock( this->refreshMutex );
+		this->savedCalibration = this->calibration;
+		this->saveRequested = true;
+	}
+	this->refreshCondition.notify_one();
+}
+
+void
+_Odometry::refreshLoop()
+{
+	std::unique_lock< std::mutex > lock( this->refreshMutex );
+
+	while ( true )
+	{
+		// A request made before waiting is seen by the check, not missed
+		while ( ! this->refreshRequested && ! this->saveRequested && this->runRefreshLoop )
+			this->refreshCondition.wait( lock );
+
+		// Before stopping, so what was learned last is not lost
+		if ( this->saveRequested )
+		{
+			OdometryCalibration calibration = this->savedCalibration;
+			this->saveRequested = false;
+
+			lock.unlock();
+			calibration.save( ODOMETRY_CALIBRATION_FILE );
+			lock.lock();
+			continue;
+		}
+
+		if ( ! this->runRefreshLoop ) break;
+
+		// Read without holding the lock, so requests do not wait for Robotino
+		lock.unlock();
+		this->update();
+		lock.lock();
+
+		this->refreshRequested = false;
+	}
+}
@@ -3,6 +3,10 @@
 #include "headers/Axon.h"
 #include "headers/Brain.h"
 #include "headers/_Odometry.h"
+#include "headers/_LaserRangeFinder.h"
+#include "headers/_DistanceSensors.h"
+
+#include "../navigation/SlipDetector.h"
 
 #include "../geometry/Angle.h"
 #include "../geometry/AngularCoordinate.h"
@@ -14,13 +18,16 @@
 #include <stdlib.h>
 #include <iostream>
 #include <math.h> // For abs()
-
+#include <algorithm>
 
 /// @todo Ressurect travelReversed functionality
 
 _OmniDrive::_OmniDrive( Brain * pBrain )
 	: Axon::Axon( pBrain ),
-	rec::robotino::api2::OmniDrive::OmniDrive()
+	rec::robotino::api2::OmniDrive::OmniDrive(),
+	travelProfile( OMNIDRIVE_TRAVEL_MAX_SPEED, OMNIDRIVE_ACCELLERATION ),
+	manouverProfile( OMNIDRIVE_MANOUVER_MAX_SPEED, OMNIDRIVE_ACCELLERATION ),
+	rotateProfile( OMNIDRIVE_ROTATE_MAX_SPEED, OMNIDRIVE_ROTATE_ACCELLERATION )
 {
 	this->xSpeed = 0.0;
 	this->ySpeed = 0.0;
@@ -28,23 +35,46 @@ _OmniDrive::_OmniDrive( Brain * pBrain )
 	this->xOld = 0.0;
 	this->yOld = 0.0;
 	this->omegaOld = 0.0;
+	this->xAccelleration = 0.0;
+	this->yAccelleration = 0.0;
+	this->omegaAccelleration = 0.0;
+	this->_cycleTime = BRAIN_LOOP_TIME / 1000.0;
+	this->applyTime = 0;
+
+	this->sentXSpeed = 0.0;
+	this->sentYSpeed = 0.0;
+	this->sentOmega = 0.0;
+	this->sendTime = 0;
+	this->commandEpsilon = OMNIDRIVE_COMMAND_EPSILON;
+	this->keepaliveTime = OMNIDRIVE_COMMAND_KEEPALIVE;
+	this->_commandsSent = 0;
+	this->_commandsSuppressed = 0;
 
 	this->targetXSpeed = 0.0;
 	this->targetYSpeed = 0.0;
 	this->targetOmega = 0.0;
 
+	this->plannedXSpeed = 0.0;
+	this->plannedYSpeed = 0.0;
+	this->plannedOmega = 0.0;
+	this->planned = false;
+
 	this->travelReversed = false;
 	this->onlyManouver = false;
+	this->holonomic = false;
+	this->modelPredictive = false;
+	this->mpcReset = false;
+	this->proximityLimiting = true;
 	this->stop = false;
 	this->autoDrive = false;
 
-	this->_destination = (Coordinate) this->brain()->odom()->getPosition();
-	this->_pointAt = Coordinate( 0.0, 0.0 );
+	this->_destination = (PreciseCoordinate) this->brain()->odom()->getPosition();
+	this->_pointAt = PreciseCoordinate( 0.0, 0.0 );
 	this->_doPointAt = false;
 	this->_stopWithin = 0.0;
 }
 
-Coordinate
+PreciseCoordinate
 _OmniDrive::destination()
 {
 	// Not sure if this is the best value, however, returning 
@@ -55,20 +85,77 @@ _OmniDrive::destination()
 }
 
 void
-_OmniDrive::setDestination( Coordinate destination )
+_OmniDrive::setDestination( PreciseCoordinate destination )
 {
+	this->clearRoute();
 	this->autoDrive = true;
 	this->_destination = destination;
+	this->mpcReset = true;
+}
+
+void
+_OmniDrive::followPath( std::vector< Coordinate > path )
+{
+	if ( path.empty() ) return;
+
+	std::lock_guard< std::mutex > lock( this->routeMutex );
+
+	this->_route.clear();
+	this->pursuit.setPath( path );
+	this->_destination = path.back();
+	this->autoDrive = true;
+}
+
+unsigned int
+_OmniDrive::pathLength()
+{
+	std::lock_guard< std::mutex > lock( this->routeMutex );
+	return this->pursuit.verticesLeft();
+}
+
+void
+_OmniDrive::setRoute( std::vector< Waypoint > route )
+{
+	std::lock_guard< std::mutex > lock( this->routeMutex );
+
+	this->pursuit.clear();
+	this->_route.assign( route.begin(), route.end() );
+	if ( ! this->_route.empty() ) this->startWaypoint( this->_route.front() );
 }
 
-Coordinate
+void
+_OmniDrive::addWaypoint( Waypoint waypoint )
+{
+	std::lock_guard< std::mutex > lock( this->routeMutex );
+
+	this->pursuit.clear();
+	this->_route.push_back( waypoint );
+	if ( this->_route.size() == 1 ) this->startWaypoint( this->_route.front() );
+}
+
+unsigned int
+_OmniDrive::routeLength()
+{
+	std::lock_guard< std::mutex > lock( this->routeMutex );
+	return this->_route.size();
+}
+
+void
+_OmniDrive::clearRoute()
+{
+	std::lock_guard< std::mutex > lock( this->routeMutex );
+	this->_route.clear();
+	this->pursuit.clear();
+}
+
+PreciseCoordinate
 _OmniDrive::pointAt()
 {
 	return this->_pointAt;
 }
 
 void
-_OmniDrive::setPointAt( Coordinate target )
+_OmniDrive::setPointAt( PreciseCoordinate target )
 {
 	if ( ! this->autoDrive )
 	{
@@ -91,6 +178,37 @@ _OmniDrive::stopPointing()
 	this->_doPointAt = false;
 }
 
+void
+_OmniDrive::setHolonomic( bool enable )
+{
+	this->holonomic = enable;
+}
+
+bool
+_OmniDrive::isHolonomic()
+{
+	return this->holonomic;
+}
+
+void
+_OmniDrive::setModelPredictive( bool enable )
+{
+	if ( enable && ! this->modelPredictive ) this->mpcReset = true;
+	this->modelPredictive = enable;
+}
+
+bool
+_OmniDrive::isModelPredictive()
+{
+	return this->modelPredictive;
+}
+
+void
+_OmniDrive::setProximityLimiting( bool enable )
+{
+	this->proximityLimiting = enable;
+}
+
 float
 _OmniDrive::stopWithin()
 {
@@ -113,12 +231,32 @@ _OmniDrive::analyze()
 void
 _OmniDrive::apply()
 {
+	// Measure the cycle, the first one is assumed to be nominal
+	unsigned int now = this->brain()->msecsElapsed();
+	if ( this->applyTime > 0 )
+		this->_cycleTime = std::min( (float) OMNIDRIVE_MAX_CYCLE_TIME, ( now - this->applyTime ) / 1000.0f );
+	this->applyTime = now;
+
+	// Asked for by setters on other threads, done here where it solves
+	if ( this->mpcReset.exchange( false ) ) this->mpc.reset();
+
+	// If speeds are set for a direction in the world frame
+	bool worldFrame = false;
+
 	// Preserve old speed values
 	this->xOld = this->xSpeed;
 	this->yOld = this->ySpeed;
 	this->omegaOld = this->omega;
 
-	if ( this->autoDrive )
+	if ( this->planned )
+	{
+		// A local planner decides for this cycle
+		this->xSpeed = ( this->stop ) ? 0.0 : this->plannedXSpeed;
+		this->ySpeed = ( this->stop ) ? 0.0 : this->plannedYSpeed;
+		this->omega = ( this->stop ) ? 0.0 : this->plannedOmega;
+		this->planned = false;
+	}
+	else if ( this->autoDrive )
 	{
 		// Initial values = stop
 		this->xSpeed = 0.0;
@@ -128,20 +266,48 @@ _OmniDrive::apply()
 		if ( ! this->stop )
 		{
 			// Aquire position and destination
-			AngularCoordinate position = this->brain()->odom()->getPosition();
-			Coordinate destination = this->destination();
-			Vector destinationVector = position.getVector( destination );
+			PreciseAngularCoordinate position = this->brain()->odom()->getPosition();
+
+			// Smooth path following, until the end is reached which is then
+			// approached as a normal destination
+			bool following = this->followTowards( position );
+
+			float distance = this->followRoute( position );
+			PreciseCoordinate destination = this->destination();
+			PreciseVector destinationVector = position.getVector( destination );
+
+			// The predictive controller turns by itself
+			bool predicted = this->modelPredictive && ! following;
 
 			// Calculate driving speed
-			if ( this->onlyManouver || destinationVector.magnitude() < OMNIDRIVE_TRAVEL_MIN_DISTANCE )
-				this->manouverTowards( (Angle) position, destinationVector );
-			else
-				this->travelTowards( destinationVector );
-
-			// Calculate turning speed if not driving
-			if ( this->pointingActive() && destinationVector.magnitude() <
-					( OMNIDRIVE_POINTING_DESTINATION_MAX_DISTANCE - this->_stopWithin ) )
+			if ( ! following )
+			{
+				if ( predicted )
+					this->predictTowards( position, distance );
+				else if ( this->holonomic )
+					this->holonomicTowards( (PreciseAngle) position, destinationVector, distance );
+				else if ( this->onlyManouver || distance < OMNIDRIVE_TRAVEL_MIN_DISTANCE )
+					this->manouverTowards( (PreciseAngle) position, destinationVector );
+				else
+					this->travelTowards( destinationVector, distance );
+			}
+
+			// Calculate turning speed if not driving, which includes being
+			// within the stop distance of a waypoint. Path following and
+			// holonomic driving do not turn, so pointing can be done at the
+			// same time.
+			worldFrame = following || this->holonomic || predicted;
+			if ( ! predicted && this->pointingActive() && ( worldFrame || destinationVector.magnitude() <
+					( OMNIDRIVE_POINTING_DESTINATION_MAX_DISTANCE - this->_stopWithin )
+					|| distance < this->_stopWithin ) )
+			{
 				this->turnTowards( position, _pointAt );
+
+				// The direction to the target changes on the way, keep
+				// pointing until arrived
+				if ( this->holonomic && ! following && distance >= this->_stopWithin )
+					this->_doPointAt = true;
+			}
 		}
 	}
 	else
@@ -152,10 +318,16 @@ _OmniDrive::apply()
 		this->omega = this->targetOmega;
 	}
 	
+	if ( this->proximityLimiting ) this->limitForProximity();
+	if ( this->brain()->slip()->isSlipping() ) this->limitForSlip();
+
 	// Apply soft accelleration
-	this->xSpeed = this->softAccellerate( this->xSpeed, this->xOld );
-	this->ySpeed = this->softAccellerate( this->ySpeed, this->yOld );
-	this->omega = this->softAccellerate( this->omega, this->omegaOld, true );
+	this->softAccellerate();
+
+	if ( worldFrame ) this->compensateRotation();
+
+	// A saturated wheel would bend the direction, slow down evenly instead
+	this->kinematics.saturate( this->xSpeed, this->ySpeed, this->omega );
 	
 	// Apply velocities
 //	std::cout
@@ -165,7 +337,7 @@ _OmniDrive::apply()
 //		<< this->omega
 //		<< std::endl;
 
-	rec::robotino::api2::OmniDrive::setVelocity( xSpeed, ySpeed, omega );
+	this->sendVelocity( false );
 }
 
 void
@@ -179,13 +351,16 @@ void
 _OmniDrive::fullStop()
 {
 	std::cout << "OmniDrive: performing emergency full stop" << std::endl;
-	rec::robotino::api2::OmniDrive::setVelocity( 0.0, 0.0, 0.0 );
 	this->xSpeed = 0.0;
 	this->ySpeed = 0.0;
 	this->omega = 0.0;
+	this->sendVelocity( true );
 	this->xOld = 0.0;
 	this->yOld = 0.0;
 	this->omegaOld = 0.0;
+	this->xAccelleration = 0.0;
+	this->yAccelleration = 0.0;
+	this->omegaAccelleration = 0.0;
 	this->stop = true;
 }
 
@@ -217,48 +392,322 @@ _OmniDrive::setVelocity( float xSpeed, float ySpeed, float omega )
 		std::cout << "Switched to manual drive mode" << std::endl;
 	}
 
-	this->targetXSpeed = xSpeed < OMNIDRIVE_MAX_SPEED ? xSpeed : OMNIDRIVE_MAX_SPEED;
-	this->targetYSpeed = ySpeed < OMNIDRIVE_MAX_SPEED ? ySpeed : OMNIDRIVE_MAX_SPEED;
-	this->targetOmega = omega < OMNIDRIVE_MAX_SPEED ? omega : OMNIDRIVE_MAX_SPEED;
+	float factor = this->kinematics.saturate( xSpeed, ySpeed, omega );
+	if ( factor < 1.0 )
+		std::cout << "OmniDrive: speeds scaled by " << factor << " to stay within wheel limits" << std::endl;
+
+	this->targetXSpeed = xSpeed;
+	this->targetYSpeed = ySpeed;
+	this->targetOmega = omega;
 }
 
 
+void
+_OmniDrive::setPlannedVelocity( float xSpeed, float ySpeed, float omega )
+{
+	this->plannedXSpeed = xSpeed;
+	this->plannedYSpeed = ySpeed;
+	this->plannedOmega = omega;
+	this->planned = true;
+}
+
+float
+_OmniDrive::cycleTime()
+{
+	return this->_cycleTime;
+}
+
+void
+_OmniDrive::commandedSpeed( float * xSpeed, float * ySpeed, float * omega )
+{
+	* xSpeed = this->sentXSpeed;
+	* ySpeed = this->sentYSpeed;
+	* omega = this->sentOmega;
+}
+
+void
+_OmniDrive::setCommandSuppression( float epsilon, unsigned int keepalive )
+{
+	this->commandEpsilon = epsilon;
+	this->keepaliveTime = keepalive;
+}
+
+unsigned int
+_OmniDrive::commandsSent()
+{
+	return this->_commandsSent;
+}
+
+unsigned int
+_OmniDrive::commandsSuppressed()
+{
+	return this->_commandsSuppressed;
+}
+
 
 // PRIVATE FUNCTIONS
 
 void
-_OmniDrive::travelTowards( Vector destinationVector )
+_OmniDrive::startWaypoint( const Waypoint & waypoint )
 {
-	if ( destinationVector.magnitude() < this->_stopWithin ) return;
+	this->autoDrive = true;
+	this->_destination = waypoint.position;
+	this->setStopWithin( waypoint.tolerance );
+
+	// A waypoint without a target drops the one of the waypoint before
+	this->_doPointAt = waypoint.point;
+	if ( waypoint.point ) this->_pointAt = waypoint.pointAt;
+}
+
+float
+_OmniDrive::followRoute( PreciseCoordinate position )
+{
+	std::lock_guard< std::mutex > lock( this->routeMutex );
+
+	if ( this->_route.empty() ) return position.getVector( this->_destination ).magnitude();
+
+	// Move on past every waypoint already reached. Slipping wheels may have
+	// counted the way without driving it.
+	bool slipping = this->brain()->slip()->isSlipping();
+	while ( ! this->_route.empty() && ! slipping )
+	{
+		const Waypoint & current = this->_route.front();
+		if ( position.getVector( current.position ).magnitude() > this->_stopWithin ) break;
+
+		// Stop waypoints, and the end of the route, also require Robotino to
+		// have stopped and turned
+		if ( ( current.stop || this->_route.size() == 1 ) && ( this->_doPointAt
+				|| fabs( this->xOld ) > OMNIDRIVE_ROUTE_STOPPED_SPEED
+				|| fabs( this->yOld ) > OMNIDRIVE_ROUTE_STOPPED_SPEED
+				|| fabs( this->omegaOld ) > OMNIDRIVE_ROUTE_STOPPED_SPEED ) ) break;
+
+		this->_route.pop_front();
+		if ( ! this->_route.empty() ) this->startWaypoint( this->_route.front() );
+	}
+
+	// The last waypoint stays as destination when the route is done
+	if ( this->_route.empty() ) return position.getVector( this->_destination ).magnitude();
+
+	// Sum up the legs until the next stop
+	float distance = position.getVector( this->_route[ 0 ].position ).magnitude();
+	for ( unsigned int i = 0; i + 1 < this->_route.size() && ! this->_route[ i ].stop; i++ )
+		distance += this->_route[ i ].position.getVector( this->_route[ i + 1 ].position ).magnitude();
+
+	return distance;
+}
+
+bool
+_OmniDrive::followTowards( PreciseAngularCoordinate position )
+{
+	std::lock_guard< std::mutex > lock( this->routeMutex );
+
+	if ( ! this->pursuit.isActive() ) return false;
+
+	// Current velocity in the world frame
+	Vector current(
+			sqrt( this->xOld * this->xOld + this->yOld * this->yOld ),
+			position.phi() + atan2( this->yOld, this->xOld ) );
+
+	Vector velocity = this->pursuit.velocity( position, current );
+	if ( ! this->pursuit.isActive() ) return false;
+
+	// To the robot frame
+	velocity.setPhi( ( (Angle) position ).deltaAngle( velocity ).phi() );
+	Coordinate cartesian = velocity.cartesian();
+
+	this->xSpeed = cartesian.x();
+	this->ySpeed = cartesian.y();
+
+	return true;
+}
+
+void
+_OmniDrive::travelTowards( PreciseVector destinationVector, float distance )
+{
+	if ( distance < this->_stopWithin ) return;
 
 	// Calculate new turn and drive speeds
-	Angle deltaAngle = this->brain()->odom()->getPosition().deltaAngle( destinationVector );
+	PreciseAngle deltaAngle = this->brain()->odom()->getPosition().deltaAngle( destinationVector );
 	if ( this->travelReversed ) deltaAngle.reverse();
 
-	this->xSpeed = findTravelVelocity( destinationVector.magnitude(), deltaAngle.phi() );
+	this->xSpeed = findTravelVelocity( distance, deltaAngle.phi() );
 	this->omega = findAngularVelocity( deltaAngle.phi() );
 }
 
 void
-_OmniDrive::manouverTowards( Angle heading, Vector destinationVector )
+_OmniDrive::holonomicTowards( PreciseAngle heading, PreciseVector destinationVector, float distance )
+{
+	float length = destinationVector.magnitude();
+	if ( distance < this->_stopWithin || length <= 0.0 ) return;
+
+	destinationVector.setPhi( heading.deltaAngle( destinationVector ).phi() );
+	Coordinate cartesian = destinationVector.cartesian();
+
+	float currentSpeed = ( this->xOld * cartesian.x() + this->yOld * cartesian.y() ) / length;
+	float speed = this->travelProfile.velocity( distance, currentSpeed, this->_cycleTime );
+	if ( speed > 0 && speed < OMNIDRIVE_TRAVEL_MIN_SPEED )
+		speed = std::min( (float) OMNIDRIVE_TRAVEL_MIN_SPEED, distance / this->_cycleTime );
+
+	this->xSpeed = speed * cartesian.x() / length;
+	this->ySpeed = speed * cartesian.y() / length;
+}
+
+void
+_OmniDrive::limitForProximity()
+{
+	float speed = sqrt( this->xSpeed * this->xSpeed + this->ySpeed * this->ySpeed );
+	if ( speed <= 0.0 ) return;
+
+	float direction = atan2( this->ySpeed, this->xSpeed );
+	float free = this->brain()->dist()->freeDistance( direction );
+	if ( this->brain()->hasLRF() )
+		free = std::min( free, this->brain()->lrf()->freeDistance( direction ) );
+
+	// Fastest speed that stops within the free distance, reacting first:
+	// v t + v^2 / 2a = d
+	const float a = OMNIDRIVE_PROXIMITY_DECELLERATION;
+	const float t = OMNIDRIVE_PROXIMITY_REACTION_TIME;
+	float distance = std::max( 0.0f, free - (float) OMNIDRIVE_PROXIMITY_MARGIN );
+	float limit = a * ( sqrt( t * t + 2.0 * distance / a ) - t );
+
+	if ( speed > limit )
+	{
+		this->xSpeed *= limit / speed;
+		this->ySpeed *= limit / speed;
+	}
+}
+
+void
+_OmniDrive::limitForSlip()
+{
+	float speed = sqrt( this->xSpeed * this->xSpeed + this->ySpeed * this->ySpeed );
+	if ( speed > OMNIDRIVE_SLIP_MAX_SPEED )
+	{
+		this->xSpeed *= OMNIDRIVE_SLIP_MAX_SPEED / speed;
+		this->ySpeed *= OMNIDRIVE_SLIP_MAX_SPEED / speed;
+	}
+	this->omega = std::min( std::max( this->omega, (float) - OMNIDRIVE_SLIP_MAX_OMEGA ), (float) OMNIDRIVE_SLIP_MAX_OMEGA );
+}
+
+void
+_OmniDrive::predictTowards( PreciseAngularCoordinate position, float distance )
+{
+	float heading = position.phi();
+	float c = cos( heading ), s = sin( heading );
+
+	// Subtracted in double, the difference is small enough for float
+	float error[ 3 ] = {
+		(float) ( position.x() - this->_destination.x() ),
+		(float) ( position.y() - this->_destination.y() ),
+		0.0 };
+
+	// Turn to the pointing target on the way, done once there and turned
+	if ( this->_doPointAt )
+	{
+		PreciseVector targetVector = position.getVector( this->_pointAt );
+		if ( targetVector.magnitude() >= OMNIDRIVE_POINTING_TARGET_MIN_DISTANCE + this->_stopWithin )
+			error[ 2 ] = - position.deltaAngle( targetVector ).phi();
+
+		if ( distance < this->_stopWithin && fabs( error[ 2 ] ) < OMNIDRIVE_ROTATE_ACCEPTABLE_DELTA_ANGLE )
+			this->_doPointAt = false;
+	}
+
+	// Last command in the world frame
+	float current[ 3 ] = {
+		c * this->xOld - s * this->yOld,
+		s * this->xOld + c * this->yOld,
+		this->omegaOld };
+
+	const float maxSpeed[ 3 ] = { OMNIDRIVE_TRAVEL_MAX_SPEED, OMNIDRIVE_TRAVEL_MAX_SPEED, OMNIDRIVE_ROTATE_MAX_SPEED };
+	const float maxAccelleration[ 3 ] = { OMNIDRIVE_ACCELLERATION, OMNIDRIVE_ACCELLERATION, OMNIDRIVE_ROTATE_ACCELLERATION };
+
+	float speed[ 3 ];
+	this->mpc.control( error, current, maxSpeed, maxAccelleration,
+			OMNIDRIVE_MPC_BUDGET * BRAIN_LOOP_TIME / 1000.0, speed );
+
+	// Back to the robot frame
+	this->xSpeed = c * speed[ 0 ] + s * speed[ 1 ];
+	this->ySpeed = - s * speed[ 0 ] + c * speed[ 1 ];
+	this->omega = speed[ 2 ];
+}
+
+void
+_OmniDrive::sendVelocity( bool force )
+{
+	unsigned int now = this->brain()->msecsElapsed();
+
+	// Compared to what was sent, so small changes cannot add up unsent
+	bool changed =
+		fabs( this->xSpeed - this->sentXSpeed ) > this->commandEpsilon ||
+		fabs( this->ySpeed - this->sentYSpeed ) > this->commandEpsilon ||
+		fabs( this->omega - this->sentOmega ) > this->commandEpsilon;
+	bool stopping = this->xSpeed == 0.0 && this->ySpeed == 0.0 && this->omega == 0.0 &&
+		( this->sentXSpeed != 0.0 || this->sentYSpeed != 0.0 || this->sentOmega != 0.0 );
+
+	if ( ! force && ! changed && ! stopping && this->_commandsSent > 0 &&
+			now - this->sendTime < this->keepaliveTime )
+	{
+		this->_commandsSuppressed++;
+		return;
+	}
+
+	rec::robotino::api2::OmniDrive::setVelocity( this->xSpeed, this->ySpeed, this->omega );
+	this->sentXSpeed = this->xSpeed;
+	this->sentYSpeed = this->ySpeed;
+	this->sentOmega = this->omega;
+	this->sendTime = now;
+	this->_commandsSent++;
+}
+
+void
+_OmniDrive::compensateRotation()
+{
+	// Turning omega * dt during the cycle at constant speeds in the robot
+	// frame drives a chord of an arc. Rotating the speeds back by half the
+	// turn, and stretching them from chord to arc length, keeps the
+	// direction and distance of the movement.
+	float half = this->omega * this->_cycleTime / 2.0;
+	if ( fabs( half ) < 1.0e-4 ) return;
+
+	float stretch = half / sin( half );
+	float c = cos( half ), s = sin( half );
+	float x = this->xSpeed, y = this->ySpeed;
+
+	this->xSpeed = stretch * ( c * x + s * y );
+	this->ySpeed = stretch * ( - s * x + c * y );
+}
+
+void
+_OmniDrive::manouverTowards( PreciseAngle heading, PreciseVector destinationVector )
 {
 	if ( destinationVector.magnitude() < this->_stopWithin ) return;
 
 	destinationVector.setPhi( heading.deltaAngle( destinationVector ).phi() );
 	Coordinate cartesian = destinationVector.cartesian();
 
-	this->xSpeed = this->findManouverVelocity( cartesian.x() );
-	this->ySpeed = this->findManouverVelocity( cartesian.y() );
+	// One profile along the straight line, so x and y arrive together
+	float length = destinationVector.magnitude();
+	float currentSpeed = ( this->xOld * cartesian.x() + this->yOld * cartesian.y() ) / length;
+	float speed = this->findManouverVelocity( length, currentSpeed );
+
+	this->xSpeed = speed * cartesian.x() / length;
+	this->ySpeed = speed * cartesian.y() / length;
 }
 
 void
-_OmniDrive::turnTowards( AngularCoordinate position, Coordinate target ) 
+_OmniDrive::turnTowards( PreciseAngularCoordinate position, PreciseCoordinate target ) 
 {
-	Vector targetVector = position.getVector( target );
+	PreciseVector targetVector = position.getVector( target );
+
+	// Too close to tell a direction, there is nothing to turn to
 	if ( targetVector.magnitude() <
-			( OMNIDRIVE_POINTING_TARGET_MIN_DISTANCE + _stopWithin ) ) return;
+			( OMNIDRIVE_POINTING_TARGET_MIN_DISTANCE + _stopWithin ) )
+	{
+		this->_doPointAt = false;
+		return;
+	}
 
-	Angle deltaAngle = position.deltaAngle( targetVector );
+	PreciseAngle deltaAngle = position.deltaAngle( targetVector );
 
 //	std::cout
 //		<< "OmniDrive position		 : " << position
@@ -272,12 +721,13 @@ _OmniDrive::turnTowards( AngularCoordinate position, Coordinate target )
 }
 
 float
-_OmniDrive::findManouverVelocity( float length )
+_OmniDrive::findManouverVelocity( float length, float currentSpeed )
 {
-	/// @todo better math could be applied here
-	float speed = length * 1.3;
-	if ( speed > OMNIDRIVE_MANOUVER_MAX_SPEED ) return OMNIDRIVE_MANOUVER_MAX_SPEED;
-	if ( speed > 0 && speed < OMNIDRIVE_MANOUVER_MIN_SPEED ) return OMNIDRIVE_MANOUVER_MIN_SPEED;
+	float speed = this->manouverProfile.velocity( length, currentSpeed, this->_cycleTime );
+
+	// Not below the minimum speed, unless that would drive past
+	if ( speed > 0 && speed < OMNIDRIVE_MANOUVER_MIN_SPEED )
+		return std::min( (float) OMNIDRIVE_MANOUVER_MIN_SPEED, length / this->_cycleTime );
 	return speed;
 }
 
@@ -286,34 +736,95 @@ _OmniDrive::findTravelVelocity( float length, float deltaAngle )
 {
 	if ( fabs( deltaAngle ) > OMNIDRIVE_TRAVEL_MAX_ANGLE ) return 0.0;
 
-	/// @todo better math could be applied here
-	float speed = length * 1.3 * (( OMNIDRIVE_TRAVEL_MAX_ANGLE - fabs( deltaAngle )) / OMNIDRIVE_TRAVEL_MAX_ANGLE );
-	if ( speed > OMNIDRIVE_TRAVEL_MAX_SPEED ) return OMNIDRIVE_TRAVEL_MAX_SPEED;
-	if ( speed > 0 && speed < OMNIDRIVE_TRAVEL_MIN_SPEED ) return OMNIDRIVE_TRAVEL_MIN_SPEED;
+	float speed = this->travelProfile.velocity( length, this->xOld, this->_cycleTime );
+	speed *= ( OMNIDRIVE_TRAVEL_MAX_ANGLE - fabs( deltaAngle ) ) / OMNIDRIVE_TRAVEL_MAX_ANGLE;
+
+	if ( speed > 0 && speed < OMNIDRIVE_TRAVEL_MIN_SPEED )
+		return std::min( (float) OMNIDRIVE_TRAVEL_MIN_SPEED, length / this->_cycleTime );
 	return speed;
 }
 
 float
 _OmniDrive::findAngularVelocity( float deltaAngle )
 {
-	/// @todo better math could be applied here
-	deltaAngle *= 1.5;
-	float abs = fabs( deltaAngle );
-	if ( abs > OMNIDRIVE_ROTATE_MAX_SPEED )
-		return ( ( deltaAngle > 0 ) ? OMNIDRIVE_ROTATE_MAX_SPEED : - OMNIDRIVE_ROTATE_MAX_SPEED );
+	float speed = this->rotateProfile.velocity( deltaAngle, this->omegaOld, this->_cycleTime );
+
+	float abs = fabs( speed );
+	float limit = fabs( deltaAngle ) / this->_cycleTime;
 	if ( abs < ( OMNIDRIVE_ROTATE_MIN_SPEED / 4 ) ) return 0.0f;
-	if ( abs < OMNIDRIVE_ROTATE_MIN_SPEED )
-		return ( deltaAngle > 0 ) ? OMNIDRIVE_ROTATE_MIN_SPEED : - OMNIDRIVE_ROTATE_MIN_SPEED;
-	return deltaAngle;
+	if ( abs < OMNIDRIVE_ROTATE_MIN_SPEED && speed * deltaAngle > 0 )
+		return ( ( deltaAngle > 0 ) ? 1.0 : -1.0 ) * std::min( (float) OMNIDRIVE_ROTATE_MIN_SPEED, limit );
+	return speed;
 }
 
-float
-_OmniDrive::softAccellerate( float newSpeed, float currentSpeed, bool isRotation )
+void
+_OmniDrive::softAccellerate()
 {
-	float deltaSpeed = newSpeed - currentSpeed;
-	float maxSpeedAdjust = ( isRotation ) ? OMNIDRIVE_ROTATE_MAX_ADJUST : OMNIDRIVE_VELOCITY_MAX_ADJUST;
-	if ( fabs( deltaSpeed ) > maxSpeedAdjust )
-		return ( deltaSpeed > 0 ) ? currentSpeed + maxSpeedAdjust : currentSpeed - maxSpeedAdjust;
-	return newSpeed;
+	float linear[ 2 ] = { this->xSpeed - this->xOld, this->ySpeed - this->yOld };
+	float linearAccelleration[ 2 ] = { this->xAccelleration, this->yAccelleration };
+	this->limitChange( linear, linearAccelleration, 2, OMNIDRIVE_MAX_ACCELLERATION, OMNIDRIVE_MAX_JERK );
+
+	this->xSpeed = this->xOld + linear[ 0 ];
+	this->ySpeed = this->yOld + linear[ 1 ];
+	this->xAccelleration = linearAccelleration[ 0 ];
+	this->yAccelleration = linearAccelleration[ 1 ];
+
+	float rotation = this->omega - this->omegaOld;
+	this->limitChange( & rotation, & this->omegaAccelleration, 1,
+			OMNIDRIVE_MAX_ROTATE_ACCELLERATION, OMNIDRIVE_MAX_ROTATE_JERK );
+	this->omega = this->omegaOld + rotation;
 }
 
+void
+_OmniDrive::limitChange( float * delta, float * accelleration, unsigned int dimensions,
+		float maxAccelleration, float maxJerk )
+{
+	float dt = this->_cycleTime;
+	if ( dt <= 0.0 )
+	{
+		for ( unsigned int i = 0; i < dimensions; i++ ) delta[ i ] = 0.0;
+		return;
+	}
+
+	float length = 0.0;
+	for ( unsigned int i = 0; i < dimensions; i++ ) length += delta[ i ] * delta[ i ];
+	length = sqrt( length );
+
+	// Wanted accelleration, low enough that the jerk limit can bring it back
+	// to 0 by the time the new speed is reached
+	float wanted = std::min( length / dt, std::min( maxAccelleration, (float) sqrt( 2.0 * maxJerk * length ) ) );
+	float target[ 2 ];
+	for ( unsigned int i = 0; i < dimensions; i++ )
+		target[ i ] = ( length > 0.0 ) ? delta[ i ] * wanted / length : 0.0;
+
+	// Move the accelleration towards it within the jerk limit
+	float jerk = 0.0;
+	for ( unsigned int i = 0; i < dimensions; i++ )
+		jerk += ( target[ i ] - accelleration[ i ] ) * ( target[ i ] - accelleration[ i ] );
+	jerk = sqrt( jerk );
+	float jerkScale = ( jerk > maxJerk * dt ) ? maxJerk * dt / jerk : 1.0;
+
+	float magnitude = 0.0;
+	for ( unsigned int i = 0; i < dimensions; i++ )
+	{
+		accelleration[ i ] += ( target[ i ] - accelleration[ i ] ) * jerkScale;
+		magnitude += accelleration[ i ] * accelleration[ i ];
+	}
+	magnitude = sqrt( magnitude );
+	float scale = ( magnitude > maxAccelleration ) ? maxAccelleration / magnitude : 1.0;
+
+	// Never past the new speed
+	float along = 0.0;
+	for ( unsigned int i = 0; i < dimensions; i++ )
+	{
+		accelleration[ i ] *= scale;
+		along += accelleration[ i ] * dt * delta[ i ];
+	}
+	if ( along >= length * length )
+	{
+		for ( unsigned int i = 0; i < dimensions; i++ ) accelleration[ i ] = delta[ i ] / dt;
+		return;
+	}
+
+	for ( unsigned int i = 0; i < dimensions; i++ ) delta[ i ] = accelleration[ i ] * dt;
+}
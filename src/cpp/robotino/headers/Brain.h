@@ -10,8 +10,10 @@
 
 #include <rec/robotino/api2/Com.h>
 
+#include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 class _Bumper;
 class _CompactBha;
@@ -19,9 +21,18 @@ class _Odometry;
 class _OmniDrive;
 class _DistanceSensors;
 class _LaserRangeFinder;
+class _Motor;
 
 class KinectReader;
 class gridnav;
+class DynamicWindow;
+class MonteCarloLocalizer;
+class GraphSlam;
+class SlipDetector;
+class OccupancyGrid;
+class MapPyramid;
+class DynamicLayer;
+class InflationLayer;
 
 /// Desired loop time of the main loop in milliseconds, to avoid overloading
 /// the Robotino command bridge
@@ -90,8 +101,103 @@ class Brain : public rec::robotino::api2::Com
 
 	_DistanceSensors * dist();
 
+	/**
+	 * Gets a pointer to the _Motor object of a wheel
+	 *
+	 * @param	number	Number of the motor, from 0 to MOTOR_COUNT - 1
+	 *
+	 * @return	Pointer to the _Motor object, 0 if there is no such motor
+	 */
+	_Motor * motor( unsigned int number );
+
+	/**
+	 * Gets a pointer to the gridnav object, planning routes on the cost map
+	 *
+	 * @return	Pointer to the gridnav object
+	 */
 	gridnav * gdn();
 
+	/**
+	 * Gets a pointer to the DynamicWindow local planner, steering around
+	 * obstacles seen by the sensors
+	 *
+	 * @return	Pointer to the DynamicWindow object
+	 */
+	DynamicWindow * dwa();
+
+	/**
+	 * Gets a pointer to the MonteCarloLocalizer, finding Robotinos pose on
+	 * the static map with the LaserRangeFinder
+	 *
+	 * @return	Pointer to the MonteCarloLocalizer object
+	 */
+	MonteCarloLocalizer * localizer();
+
+	/**
+	 * Gets a pointer to GraphSlam, building the static map from laser scans
+	 *
+	 * @return	Pointer to the GraphSlam object
+	 */
+	GraphSlam * slam();
+
+	/**
+	 * Gets a pointer to the SlipDetector, telling if the wheels slip
+	 *
+	 * @return	Pointer to the SlipDetector object
+	 */
+	SlipDetector * slip();
+
+	/**
+	 * Gets a pointer to the OccupancyGrid holding the static map
+	 *
+	 * @return	Pointer to the OccupancyGrid object
+	 */
+	OccupancyGrid * map();
+
+	/**
+	 * Has the main loop load the static map from a file, see
+	 * OccupancyGrid::load(). The planners and localizers listen to the map
+	 * on the main loop, so it is only changed there. The outcome is
+	 * printed.
+	 *
+	 * @param	file	Name of the file
+	 */
+	void loadMap( std::string file );
+
+	/**
+	 * Has the main loop save the static map to a file, see
+	 * OccupancyGrid::save(), so it is not saved while being drawn. The
+	 * outcome is printed.
+	 *
+	 * @param	file	Name of the file
+	 */
+	void saveMap( std::string file );
+
+	/**
+	 * Gets a pointer to the multi-resolution view of the static map, for
+	 * long-range ray casts and box queries
+	 *
+	 * @return	Pointer to the MapPyramid object
+	 */
+	MapPyramid * mapView();
+
+	/**
+	 * Gets a pointer to the layer of short lived obstacles seen by the
+	 * LaserRangeFinder. Planners should query this layer, it combines the
+	 * static map and the dynamic obstacles.
+	 *
+	 * @return	Pointer to the DynamicLayer object
+	 */
+	DynamicLayer * dynamicMap();
+
+	/**
+	 * Gets a pointer to the costs of the static and dynamic obstacles,
+	 * inflated by Robotinos footprint
+	 *
+	 * @return	Pointer to the InflationLayer object
+	 */
+	InflationLayer * costMap();
+
 	/** Returns if a LaserRangeFinder is present
 	 *
 	 * @return  Presence of LaserRangeFinder
@@ -183,6 +289,10 @@ class Brain : public rec::robotino::api2::Com
 	/// Holds a pointer to the _Odometry object
 	   	* pOdom;
 
+	std::vector< _Motor * >
+	/// Holds pointers to the _Motor objects, one per wheel
+		pMotors;
+
 	_OmniDrive
 	/// Holds a pointer to the _OmniDrive object
 	   	* pDrive;
@@ -200,8 +310,51 @@ class Brain : public rec::robotino::api2::Com
 		* pKinect;
 
 	gridnav 
+	/// Holds a pointer to the gridnav object
 		* pGDN;
 
+	DynamicWindow
+	/// Holds a pointer to the local planner
+		* pDWA;
+
+	MonteCarloLocalizer
+	/// Holds a pointer to the localizer
+		* pLocalizer;
+
+	GraphSlam
+	/// Holds a pointer to the mapper
+		* pSlam;
+
+	SlipDetector
+	/// Holds a pointer to the slip detector
+		* pSlip;
+
+	OccupancyGrid
+	/// Holds a pointer to the static map
+		* pMap;
+
+	MapPyramid
+	/// Holds a pointer to the multi-resolution view of the static map
+		* pMapView;
+
+	DynamicLayer
+	/// Holds a pointer to the layer of short lived obstacles
+		* pDynamicMap;
+
+	InflationLayer
+	/// Holds a pointer to the inflated obstacle costs
+		* pCostMap;
+
+	std::string
+	/// File to load the static map from on the main loop, empty if none
+		mapLoadFile,
+	/// File to save the static map to on the main loop, empty if none
+		mapSaveFile;
+
+	std::mutex
+	/// Guards mapLoadFile and mapSaveFile
+		mapMutex;
+
 	std::thread
 	/// Thread for running the main loop of Brain
 		tBrainMain,
@@ -238,6 +391,12 @@ class Brain : public rec::robotino::api2::Com
 	 */
 	void mainLoop();
 
+	/**
+	 * Loads and saves the static map as asked for by loadMap() and
+	 * saveMap(). Called by mainLoop().
+	 */
+	void processMapRequests();
+
 	/**
 	 * Implementation of virtual function from rec::robotino::api2::Com, called
 	 * by processComEvents() when an errorEvent has occured. Prints any error
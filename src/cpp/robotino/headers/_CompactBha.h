@@ -363,8 +363,8 @@ class _CompactBha : public rec::robotino::api2::CompactBHA, public Axon
 	 * the cBHA is detected. The function checks a number of states to see if
 	 * performing calibration is safe, then gets the latest coordinate from
 	 * the KinectReader and uses this to determine an accurate position.
-	 * If the calculated position is within reasonable limits, the new position
-	 * is applied to the odometry.
+	 * If the calculated position is within reasonable limits, it is given to
+	 * the odometry as a fix, timestamped with when the Kinect took it.
 	 */
 	void calibrateOdometry();
 
@@ -8,12 +8,15 @@
 #include "Axon.h"
 
 #include "../../geometry/Angle.h"
+#include "../../obstacle/FreeSpace.h"
 
 #include <rec/robotino/api2/DistanceSensorArray.h>
 
 
 ///	The number of distancesensors available
 #define DISTANCESENSORS_COUNT 9
+/// Readings above this distance are not taken as obstacles, in meters
+#define DISTANCESENSORS_RANGE	0.3
 
 
 /**
@@ -67,11 +70,26 @@ class _DistanceSensors : public Axon, public rec::robotino::api2::DistanceSensor
 	 */
 	Angle sensorAngle( unsigned int sensorNo );
 
+	/**
+	 * Gets the distance Robotino can drive in a direction before touching
+	 * anything the sensors see. Worked out in analyze(), so this is only a
+	 * lookup.
+	 *
+	 * @param	direction	Direction relative to Robotinos heading, in rad
+	 *
+	 * @return	Free distance in meters
+	 */
+	float freeDistance( float direction );
+
  private:
 	float
 	/// Array storing the latest values
 		readDistances[ DISTANCESENSORS_COUNT ];
 
+	FreeSpace
+	/// Free distances around Robotino from the latest readings
+		freeSpace;
+
 	bool
 	/// If the distances were updated in the last cycle
 		distancesUpdated;
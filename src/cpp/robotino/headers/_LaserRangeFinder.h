@@ -7,10 +7,14 @@
 
 #include "Axon.h"
 #include "../../geometry/Angle.h"
+#include "../../geometry/AngularCoordinate.h"
+#include "../../obstacle/FreeSpace.h"
 
 #include <rec/robotino/api2/LaserRangeFinder.h>
 #include <rec/robotino/api2/LaserRangeFinderReadings.h>
 
+#include <vector>
+
 
 /**
  * Reimplementation of the LaserRangeFinder class from RobotinoAPI2
@@ -78,6 +82,35 @@ class _LaserRangeFinder :
 	
 	bool checkFront();
 
+	/**
+	 * Converts the latest readings to world coordinates. Readings outside
+	 * [range_min, range_max] are left out.
+	 *
+	 * @param	pose	Robotinos position and heading when the scan was taken
+	 *
+	 * @return	The coordinates of all valid scan points
+	 */
+	std::vector< Coordinate > scanCoordinates( AngularCoordinate pose );
+
+	/**
+	 * Gets the distance Robotino can drive in a direction before touching
+	 * anything in the latest scan. Worked out in analyze(), so this is only a
+	 * lookup.
+	 *
+	 * @param	direction	Direction relative to Robotinos heading, in rad
+	 *
+	 * @return	Free distance in meters
+	 */
+	float freeDistance( float direction );
+
+	/**
+	 * Gets when the latest scan was taken, halfway through the sweep, for
+	 * pairing it with the pose Robotino had
+	 *
+	 * @return	The time, in msecs since Brain started
+	 */
+	unsigned int scanTime();
+
 	obstacleAvoidance sensorLeft();
 	
 	obstacleAvoidance sensorRight();
@@ -89,6 +122,10 @@ class _LaserRangeFinder :
 	/// The last laserRangeFinderReadings object
 		latestReadings;
 
+	FreeSpace
+	/// Free distances around Robotino from the latest scan
+		freeSpace;
+
 	bool
 	/// If the readings were updated in the last cycle
 		readingsUpdated;
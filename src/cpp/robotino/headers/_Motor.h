@@ -0,0 +1,200 @@
+/**
+ * @file	_Motor.h
+ * @brief	Header file for the _Motor class
+ */
+#ifndef _MOTOR_H
+#define _MOTOR_H
+
+#include "Axon.h"
+
+#include <rec/robotino/api2/Motor.h>
+
+#include <atomic>
+
+
+/// Number of drive motors, one per wheel
+#define MOTOR_COUNT	3
+
+
+	// Statistics
+
+/// Time over which the rolling means are taken, in seconds
+#define MOTOR_MEAN_TIME	0.2
+/// Battery voltage, for the energy drawn, in V
+#define MOTOR_SUPPLY_VOLTAGE	24.0
+
+
+	// Stall
+
+/// Mean current above which a motor may be stalled, in A
+#define MOTOR_STALL_CURRENT	2.0
+/// Mean absolute speed below which a motor may be stalled, in rpm
+#define MOTOR_STALL_SPEED	100.0
+/// Time both have to last before a stall is reported, in msecs
+#define MOTOR_STALL_TIME	200
+
+
+/**
+ * Reimplementation of the Motor class from RobotinoAPI2, for one of the
+ * three drive motors
+ *
+ * Robotino's readings of speed, encoder position and current arrive through
+ * Brain::processEvents() on the main loop, so there is at most one new
+ * reading per Brain cycle, the latest. analyze() folds it into rolling means
+ * with a time constant of MOTOR_MEAN_TIME, weighed by the time since the
+ * last reading, sums up the energy drawn, and reports a stall when the motor
+ * draws MOTOR_STALL_CURRENT but turns slower than MOTOR_STALL_SPEED for
+ * MOTOR_STALL_TIME. The statistics are per cycle, so they can not see
+ * anything shorter than BRAIN_LOOP_TIME.
+ *
+ * The energy is the motor current at MOTOR_SUPPLY_VOLTAGE. Below full speed
+ * the motor controller draws less than that from the battery, so it is an
+ * upper bound.
+ *
+ * See @link _Motor.h @endlink for documentation of @c \#define parameters
+ */
+class _Motor : public Axon, public rec::robotino::api2::Motor
+{
+ public:
+	/**
+	 * Constructs _Motor
+	 *
+	 * @param	pBrain	A pointer to the owner Brain object
+	 * @param	number	Number of the motor, from 0 to MOTOR_COUNT - 1
+	 */
+	_Motor( Brain * pBrain, unsigned int number );
+
+	void analyze();
+
+	void apply();
+
+	/**
+	 * Gets the number of the motor
+	 *
+	 * @return	Number of the motor
+	 */
+	unsigned int number();
+
+	/**
+	 * Gets the latest speed
+	 *
+	 * @return	Speed of the motor shaft, in rpm
+	 */
+	float velocity();
+
+	/**
+	 * Gets the latest encoder position
+	 *
+	 * @return	Position in encoder ticks
+	 */
+	int position();
+
+	/**
+	 * Gets the latest current
+	 *
+	 * @return	Current in A
+	 */
+	float current();
+
+	/**
+	 * Gets the rolling mean of the current
+	 *
+	 * @return	Mean current in A
+	 */
+	float meanCurrent();
+
+	/**
+	 * Gets the rolling mean of the absolute speed
+	 *
+	 * @return	Mean speed in rpm
+	 */
+	float meanSpeed();
+
+	/**
+	 * Checks if the motor is stalled
+	 *
+	 * @return	True while a stall is reported
+	 */
+	bool isStalled();
+
+	/**
+	 * Gets the energy drawn since construction
+	 *
+	 * @return	Energy in J
+	 */
+	double energy();
+
+	/**
+	 * Gets the rate new readings are analyzed at
+	 *
+	 * @return	Rolling mean of the readings per second
+	 */
+	float sampleRate();
+
+ private:
+	/**
+	 * One reading of the motor
+	 */
+	struct Sample
+	{
+		/// Time of the reading, in msecs since Brain started
+		unsigned int time;
+		/// Speed in rpm
+		float velocity;
+		/// Position in encoder ticks
+		int position;
+		/// Current in A
+		float current;
+	};
+
+	Sample
+	/// The latest reading, set by motorReadingsChanged()
+		reading,
+	/// The last reading analyzed
+		latest;
+
+	std::atomic< bool >
+	/// If a stall is reported, read by other threads
+		stalled;
+
+	unsigned int
+	/// Number of the motor
+		_number,
+	/// Time the stall conditions started, 0 if they do not hold
+		stallSince;
+
+	bool
+	/// If @c reading is new since the last analyze()
+		fresh,
+	/// If a reading was analyzed yet
+		started;
+
+	float
+	/// Rolling mean of the current
+		_meanCurrent,
+	/// Rolling mean of the absolute speed
+		_meanSpeed,
+	/// Rolling mean of the readings per second
+		_sampleRate;
+
+	double
+	/// Energy drawn, in J
+		_energy;
+
+	/**
+	 * Adds a reading to the statistics
+	 *
+	 * @param	sample	The reading
+	 */
+	void add( const Sample & sample );
+
+	/**
+	 * Implementation of virtual function from rec::robotino::api2::Motor.
+	 * Called by Brain::processEvents() when new readings of the motor have
+	 * arrived. Keeps them for the next analyze().
+	 * See RobotinoAPI2 documentation for details.
+	 */
+	void motorReadingsChanged( float velocity, int position, float current );
+};
+
+#endif
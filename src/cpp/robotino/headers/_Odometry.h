@@ -8,9 +8,17 @@
 #include "Axon.h"
 
 #include "../../geometry/AngularCoordinate.h"
+#include "../../navigation/PoseFilter.h"
+#include "../../navigation/PoseHistory.h"
+#include "../../navigation/OdometryCalibration.h"
 
 #include <rec/robotino/api2/Odometry.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 class Brain;
 
 
@@ -31,8 +39,41 @@ class Brain;
 /// odometry values differ by the at any time given speed of the omnidrive,
 /// adjusting by this value can never be assumed to be entirely correct.
 /// With prolonged continuos use the deviation will only continue to increase,
-/// requiring periodical recalibration.
+/// requiring periodical recalibration. The speed dependent rest is learned
+/// while driving, see ODOMETRY_CALIBRATION_FILE.
 #define ODOMETRY_ADJUSTMENT_FACTOR	1
+/// File the odometry calibration learned from fixes is kept in, relative to
+/// the working directory. Delete it to start learning over.
+#define ODOMETRY_CALIBRATION_FILE	"odometry_calibration.txt"
+
+
+	// Pose filter
+
+/// Deviation of a position fix from the Kinect, in meters
+#define ODOMETRY_KINECT_DEVIATION	0.03
+/// Deviation of the position from matching laser scans, in meters
+#define ODOMETRY_SCANMATCH_DEVIATION	0.02
+/// Deviation of the heading from matching laser scans, in rad
+#define ODOMETRY_SCANMATCH_PHI_DEVIATION	0.02
+/// Distance between two readings above which the odometry is taken to have
+/// been set rather than driven, in meters
+#define ODOMETRY_MAX_STEP	0.5
+/// Turn between two readings above which the odometry is taken to have been
+/// set rather than turned, in rad
+#define ODOMETRY_MAX_TURN	1.0
+/// Factor the deviation of the odometry is multiplied by while the wheels
+/// slip, see setSlipping()
+#define ODOMETRY_SLIP_NOISE_FACTOR	5.0
+/// Distance from the pose passed to set() within which a reading counts as
+/// taken after Robotino applied it, in meters. Readings still queued from
+/// before are dropped, see set().
+#define ODOMETRY_SET_TOLERANCE	0.1
+/// Turn from the heading passed to set() within which a reading counts as
+/// taken after Robotino applied it, in rad
+#define ODOMETRY_SET_TURN_TOLERANCE	0.1
+/// Time after set() from which readings are taken again even if not close
+/// to the pose set, in milliseconds. Nothing from before is queued by then.
+#define ODOMETRY_SET_TIMEOUT	500
 
 
 /**
@@ -41,8 +82,19 @@ class Brain;
  * The original Odometry class handles the odometry system which calculates the
  * current position from the wheel movements of the OmniDrive.
  * This implementation features correction by value of deviations from the
- * odometry. It also packs position in an AngularCoordinate object for
- * easier handling and computation.
+ * odometry. It also packs position in a PreciseAngularCoordinate object for
+ * easier handling and computation. The pose stays in double from the
+ * readings on, so it does not lose precision far from the origin.
+ *
+ * The position is not the raw odometry. Every reading drives a PoseFilter by
+ * the increment since the last one, and absolute fixes correct it: from the
+ * Kinect through fixPosition(), and from the MonteCarloLocalizer matching
+ * laser scans to the map through fixPose(). getPosition() returns the filtered pose, and with a time, the pose
+ * Robotino had then. The fixes also teach an OdometryCalibration, which
+ * corrects the increments before they reach the filter.
+ *
+ * While a SlipDetector reports slip, the increments are taken as much less
+ * certain, so the fixes weigh more, and the calibration learns nothing.
  * 
  * See @link _Odometry.h @endlink for documentation of @c \#define parameters
  */
@@ -56,6 +108,11 @@ class _Odometry : public rec::robotino::api2::Odometry, public Axon
 	 */
 	_Odometry( Brain * pBrain );
 
+	/**
+	 * Stops the refresh thread
+	 */
+	~_Odometry();
+
 	/**
 	 * Set the values of the internal odometry
 	 *
@@ -69,9 +126,39 @@ class _Odometry : public rec::robotino::api2::Odometry, public Axon
 	 * @param	blocking	Tells RobotinoAPI2 to wait and verify if the
 	 * call was completed successfully. If false, RobotinoAPI2 will return
 	 * true immediately.
+	 *
+	 * Robotino applies the pose later than the filter is reset, so readings
+	 * are dropped until one is within ODOMETRY_SET_TOLERANCE of the pose, or
+	 * ODOMETRY_SET_TIMEOUT passed. A reading from before would otherwise be
+	 * continued from, and the next one look like driving the whole way to
+	 * the pose set.
 	 */
 	bool set( double x, double y, double phi, bool blocking = true );
 
+	/**
+	 * Corrects the position with a Kinect fix. Unlike set() the fix is
+	 * weighed against how certain the current position is, and rejected if
+	 * it is too far off.
+	 *
+	 * @param	position	The measured position
+	 * @param	time	When it was measured, in msecs since Brain started
+	 *
+	 * @return	False if the fix was rejected
+	 */
+	bool fixPosition( PreciseCoordinate position, unsigned int time );
+
+	/**
+	 * Corrects the position and heading with a fix from matching laser
+	 * scans, like fixPosition(). The MonteCarloLocalizer gives one for every
+	 * scan while it tracks.
+	 *
+	 * @param	pose	The measured position and heading
+	 * @param	time	When it was measured, in msecs since Brain started
+	 *
+	 * @return	False if the fix was rejected
+	 */
+	bool fixPose( PreciseAngularCoordinate pose, unsigned int time );
+
 	void analyze();
 
 	void apply();
@@ -79,10 +166,32 @@ class _Odometry : public rec::robotino::api2::Odometry, public Axon
 	/**
 	 * Gets the current position and course.
 	 *
-	 * @return	The current position and course as an AngularCoordinate
+	 * This never waits for Robotino. If the readings are older than
+	 * BRAIN_DATA_MAX_AGE, fresh ones are requested in the background and the
+	 * latest known position is returned, see dataAge().
+	 *
+	 * @return	The current position and course as a PreciseAngularCoordinate
+	 */
+	PreciseAngularCoordinate getPosition();
+
+	/**
+	 * Gets the position and course at a past time, for pairing measurements
+	 * with where Robotino was when they were taken. Falls back to the
+	 * current position when the time is not in the history.
+	 *
+	 * @param	time	The time, in msecs since Brain started
+	 *
+	 * @return	The position and course as a PreciseAngularCoordinate
+	 */
+	PreciseAngularCoordinate getPosition( unsigned int time );
+	PreciseAngle getPhi();
+
+	/**
+	 * Gets the age of the position returned by getPosition() and getPhi()
+	 *
+	 * @return	Time since the last reading, in msecs
 	 */
-	AngularCoordinate getPosition();
-	Angle getPhi();
+	unsigned int dataAge();
 
 	/**
 	 * Gets the current absolute speed.
@@ -100,6 +209,23 @@ class _Odometry : public rec::robotino::api2::Odometry, public Axon
 	 */
 	float currentAbsOmega();
 
+	/**
+	 * Gets the current speeds measured by the odometry
+	 *
+	 * @param	vx	Set to the forward speed, in m/s
+	 * @param	vy	Set to the leftward speed, in m/s
+	 * @param	omega	Set to the rotation speed, in rad/s
+	 */
+	void currentSpeed( float * vx, float * vy, float * omega );
+
+	/**
+	 * Tells if the wheels slip. Takes effect from the next reading, and may
+	 * be called from any thread.
+	 *
+	 * @param	slipping	True while the wheels slip
+	 */
+	void setSlipping( bool slipping );
+
  private:
 	double
 	/// The current x value of the coordinate
@@ -107,7 +233,15 @@ class _Odometry : public rec::robotino::api2::Odometry, public Axon
 	/// The current y value of the coordinate
 		y,
 	/// The current heading
-		phi;
+		phi,
+	/// The last position read from Robotino, adjusted
+		rawX,
+		rawY,
+		rawPhi,
+	/// The pose passed to the last set(), adjusted
+		setX,
+		setY,
+		setPhi;
 
 	float
 	/// The current speed in the x direction
@@ -121,7 +255,62 @@ class _Odometry : public rec::robotino::api2::Odometry, public Axon
 	/// The time the values were last updated
 		updateTime,
 	/// The sequence number of the last update
-		sequence;
+		sequence,
+	/// The time of the last position read from Robotino
+		rawTime,
+	/// The time of the last set()
+		setTime;
+
+	bool
+	/// If rawX, rawY and rawPhi hold a reading to continue from
+		rawValid,
+	/// If readings are dropped until Robotino reports the pose of set()
+		setPending;
+
+	PoseFilter
+	/// Filter for the position
+		filter;
+
+	OdometryCalibration
+	/// Scale and heading corrections, learned from fixes
+		calibration,
+	/// Copy of the calibration for the refresh thread to save, guarded by
+	/// refreshMutex
+		savedCalibration;
+
+	PoseHistory
+	/// The filtered poses of the last seconds, added by readingsEvent()
+		history;
+
+	std::atomic< bool >
+	/// Set by set() for readingsEvent() to clear the history
+		historyReset,
+	/// If the wheels slip, see setSlipping()
+		slipping;
+
+	std::mutex
+	/// Guards filter, calibration, the position, updateTime and the pose of
+	/// set()
+		filterMutex,
+	/// Guards refreshRequested, saveRequested, savedCalibration and
+	/// runRefreshLoop
+		refreshMutex;
+
+	std::condition_variable
+	/// Wakes the refresh thread
+		refreshCondition;
+
+	bool
+	/// If a refresh is pending, see requestRefresh()
+		refreshRequested,
+	/// If savedCalibration waits to be saved, see requestSave()
+		saveRequested,
+	/// Keeps the refresh thread running
+		runRefreshLoop;
+
+	std::thread
+	/// Thread running refreshLoop()
+		tRefresh;
 
 	/**
 	 * This function reimplements the readings function of the original Odometry
@@ -141,9 +330,39 @@ class _Odometry : public rec::robotino::api2::Odometry, public Axon
 
 	/**
 	 * Requests and saves updated sensor values from Robotino.
-	 * Called by getter if a the updateTime value is too long.
+	 * Called by the refresh thread, as this waits for Robotino.
 	 */
 	void update();
+
+	/**
+	 * Has the refresh thread call update(), unless it is about to already.
+	 * Returns at once.
+	 */
+	void requestRefresh();
+
+	/**
+	 * Has the refresh thread save the calibration to
+	 * ODOMETRY_CALIBRATION_FILE, so the file is not written with
+	 * filterMutex held. Call with filterMutex locked.
+	 */
+	void requestSave();
+
+	/**
+	 * Calls update() whenever requested, and saves the calibration, until
+	 * runRefreshLoop is cleared
+	 */
+	void refreshLoop();
+
+	/**
+	 * Moves the filter by the increment from the last reading, and copies
+	 * the filtered pose to x, y and phi. Drops the reading while a set() is
+	 * pending. Call with filterMutex locked.
+	 *
+	 * @param	x	X value read, adjusted
+	 * @param	y	Y value read, adjusted
+	 * @param	phi	Heading read
+	 */
+	void integrate( double x, double y, double phi );
 };
 
 #endif
@@ -8,18 +8,22 @@
 #include "Axon.h"
 
 #include "../../geometry/Coordinate.h"
+#include "../../geometry/Angle.h"
+#include "../../geometry/Vector.h"
+#include "../../geometry/AngularCoordinate.h"
+#include "../../navigation/PurePursuit.h"
+#include "../../navigation/VelocityProfile.h"
+#include "../../navigation/OmniKinematics.h"
+#include "../../navigation/MpcController.h"
 
 #include <rec/robotino/api2/OmniDrive.h>
 
-class Angle;
-class Vector;
-class AngularCoordinate;
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <mutex>
 
 
-	// Speed
-/// The maximum top speed when setting speed manually
-#define OMNIDRIVE_MAX_SPEED	0.2
-
 	// Travel
 
 /// The maximum speed Robotino will travel at, in m/s.
@@ -57,16 +61,28 @@ class AngularCoordinate;
 
 	// Accelleration
 
-/// The maximum adjustment that will be done to the speed, x or y, each cycle.
-/// This is valid for both accelleration and decelleration
-/// @todo needs cycle duration factor to stay constant with changes in cycle
-/// duration. Should preferrably be given as m/s^2.
-#define OMNIDRIVE_VELOCITY_MAX_ADJUST	0.02
-/// The maximum adjustment that will be done to the rotation, omega, each cycle.
-/// This is valid for both accelleration and decelleration
-/// @todo needs cycle duration factor to stay constant with changes in cycle
-/// duration. Should preferrably be given as m/s^2.
-#define OMNIDRIVE_ROTATE_MAX_ADJUST	0.4
+/// The maximum accelleration of the speed, x and y combined, in m/s^2.
+/// This is valid for both accelleration and decelleration, and is applied
+/// using the measured time between cycles.
+#define OMNIDRIVE_MAX_ACCELLERATION	0.4
+/// The maximum accelleration of the rotation, omega, in rad/s^2.
+/// This is valid for both accelleration and decelleration.
+#define OMNIDRIVE_MAX_ROTATE_ACCELLERATION	8.0
+/// The maximum change of the accelleration, x and y combined, in m/s^3.
+/// The default reaches full accelleration within a 50 ms cycle.
+#define OMNIDRIVE_MAX_JERK	8.0
+/// The maximum change of the rotation accelleration, in rad/s^3
+#define OMNIDRIVE_MAX_ROTATE_JERK	160.0
+/// The longest time between cycles taken into account, in seconds. A
+/// stalled cycle does not allow a larger jump in speed than this.
+#define OMNIDRIVE_MAX_CYCLE_TIME	0.1
+/// The accelleration and decelleration of travel and manouver speed profiles,
+/// in m/s^2. Should not exceed OMNIDRIVE_MAX_ACCELLERATION, or braking will
+/// be cut short.
+#define OMNIDRIVE_ACCELLERATION	0.4
+/// The accelleration and decelleration of the rotation speed profile, in
+/// rad/s^2. Should not exceed OMNIDRIVE_MAX_ROTATE_ACCELLERATION.
+#define OMNIDRIVE_ROTATE_ACCELLERATION	4.0
 
 
 	// Rotation
@@ -89,6 +105,105 @@ class AngularCoordinate;
 #define OMNIDRIVE_POINTING_TARGET_MIN_DISTANCE	0.0
 
 
+	// Model predictive control
+
+/// Share of BRAIN_LOOP_TIME the predictive controller may use
+#define OMNIDRIVE_MPC_BUDGET	0.2
+
+
+	// Proximity
+
+/// Decelleration assumed when limiting speed near obstacles, in m/s^2.
+/// Below OMNIDRIVE_MAX_ACCELLERATION, so the limit is never braked past.
+#define OMNIDRIVE_PROXIMITY_DECELLERATION	0.3
+/// Time from an obstacle being seen to braking, in seconds
+#define OMNIDRIVE_PROXIMITY_REACTION_TIME	0.1
+/// Distance to keep between the footprint and obstacles, in meters
+#define OMNIDRIVE_PROXIMITY_MARGIN	0.05
+
+
+	// Slip
+
+/// Fastest x and y speed while SlipDetector reports slip, in m/s. Slow
+/// wheels grip again, and do not dig Robotino further in when blocked.
+#define OMNIDRIVE_SLIP_MAX_SPEED	0.05
+/// Fastest rotation while SlipDetector reports slip, in rad/s
+#define OMNIDRIVE_SLIP_MAX_OMEGA	0.5
+
+
+	// Command bridge
+
+/// Default change in speed below which apply() does not send a command, in
+/// m/s for x and y and rad/s for omega
+#define OMNIDRIVE_COMMAND_EPSILON	0.002
+/// Default longest time without sending a command, in msecs. Robotino stops
+/// the drive when commands stop arriving, so this stays well below that.
+#define OMNIDRIVE_COMMAND_KEEPALIVE	200
+
+
+	// Routes
+
+/// Default distance to a pass-through waypoint at which Robotino moves on to
+/// the next waypoint of the route, in meters
+#define OMNIDRIVE_WAYPOINT_PASS_DISTANCE	0.15
+/// Commanded speed below which Robotino is considered stopped at a stop
+/// waypoint, in m/s for x and y and rad/s for omega
+#define OMNIDRIVE_ROUTE_STOPPED_SPEED	0.01
+
+
+/**
+ * A waypoint of a route given to _OmniDrive::setRoute()
+ *
+ * Robotino drives through a pass-through waypoint without slowing down for
+ * it, moving on to the next waypoint as soon as it is within @c tolerance.
+ * At a stop waypoint Robotino stops within @c tolerance, turns to the
+ * pointing target if one is set, and then continues. A target within
+ * @c tolerance of Robotino has no direction and is not turned to. A
+ * waypoint without a target stops any pointing, also one set before by
+ * setPointAt(). The last waypoint of a route is always a stop waypoint.
+ */
+struct Waypoint
+{
+	/**
+	 * Constructs a waypoint without a pointing target
+	 *
+	 * @param	position	Coordinate of the waypoint
+	 * @param	tolerance	Distance counting as reached
+	 * @param	stop	True to stop at the waypoint, false to pass through
+	 */
+	Waypoint( PreciseCoordinate position, float tolerance = OMNIDRIVE_WAYPOINT_PASS_DISTANCE, bool stop = false )
+		: position( position ), tolerance( tolerance ), stop( stop ), point( false )
+	{}
+
+	/**
+	 * Constructs a stop waypoint with a pointing target
+	 *
+	 * @param	position	Coordinate of the waypoint
+	 * @param	tolerance	Distance counting as reached
+	 * @param	pointAt	Coordinate to point at when there
+	 */
+	Waypoint( PreciseCoordinate position, float tolerance, PreciseCoordinate pointAt )
+		: position( position ), pointAt( pointAt ), tolerance( tolerance ), stop( true ), point( true )
+	{}
+
+	PreciseCoordinate
+	/// Coordinate to drive to
+		position,
+	/// Pointing target, used only if @c point is set
+		pointAt;
+
+	float
+	/// Distance to @c position counting as reached, in meters
+		tolerance;
+
+	bool
+	/// Stop at the waypoint rather than passing through
+		stop,
+	/// Point at @c pointAt on arrival
+		point;
+};
+
+
 /**
  * Reimplementation of the OmniDrive class from RobotinoAPI2
  *
@@ -98,7 +213,12 @@ class AngularCoordinate;
  * easily drive Robotino to a destination just by providing the desired
  * coordinate. Other features include pointing at a coordinate, stopping at
  * a desired distance, smooth accelleration and both smooth and emergency
- * stopping.
+ * stopping. While a SlipDetector reports slip, speeds are held low and
+ * waypoints are not counted as reached.
+ *
+ * Destinations, waypoints and the position they are compared with are kept
+ * in double, as PreciseCoordinate, so the small vectors between them stay
+ * exact far from the origin. Paths for followPath() are float.
  *
  * See @link _OmniDrive.h @endlink for documentation of @c \#define parameters
  */
@@ -115,29 +235,82 @@ class _OmniDrive : public Axon, public rec::robotino::api2::OmniDrive
 	/**
 	 * Gets the current destination
 	 *
-	 * @return	Current destination as a Coordinate
+	 * @return	Current destination as a PreciseCoordinate
 	 */
-	Coordinate destination();
+	PreciseCoordinate destination();
 
 	/**
 	 * Sets desired destination
 	 *
 	 * The destination will be taken into accord at the next execution of
-	 * analyze()
+	 * analyze(). Cancels any route set by setRoute().
 	 *
 	 * @param	destination	Coordinate of the desired destination
 	 */
-	void setDestination( Coordinate destination );
+	void setDestination( PreciseCoordinate destination );
+
+	/**
+	 * Sets a route of waypoints to follow, replacing any current route or
+	 * destination
+	 *
+	 * Each waypoint in turn becomes the destination, and its tolerance
+	 * becomes the stopWithin value. Robotino moves on to the next waypoint by
+	 * itself, without stopping at pass-through waypoints.
+	 *
+	 * @param	route	The waypoints, in order
+	 */
+	void setRoute( std::vector< Waypoint > route );
+
+	/**
+	 * Appends a waypoint to the current route. If no route is being followed
+	 * the waypoint starts a new one.
+	 *
+	 * @param	waypoint	The waypoint to add
+	 */
+	void addWaypoint( Waypoint waypoint );
+
+	/**
+	 * Gets the number of waypoints not yet reached, including the one
+	 * currently driven towards
+	 *
+	 * @return	Number of remaining waypoints, 0 when no route is followed
+	 */
+	unsigned int routeLength();
+
+	/**
+	 * Drops the rest of the current route. The current destination is kept.
+	 */
+	void clearRoute();
+
+	/**
+	 * Follows a path smoothly, replacing any current route or destination
+	 *
+	 * The path is tracked by a PurePursuit follower, driving in any
+	 * direction without turning, and slowing down only for curves and the
+	 * end of the path. The heading is kept unless a pointing target is set.
+	 * When the end is reached it becomes the destination.
+	 *
+	 * @param	path	Vertexes of the path, usually starting at the current
+	 * position
+	 */
+	void followPath( std::vector< Coordinate > path );
+
+	/**
+	 * Gets the number of path vertexes not yet passed
+	 *
+	 * @return	Number of vertexes ahead, 0 when no path is followed
+	 */
+	unsigned int pathLength();
 
 	/**
 	 * Gets the current pointing target
 	 *
-	 * @return	The current pointing target as a Coordinate
+	 * @return	The current pointing target as a PreciseCoordinate
 	 *
 	 * @warning	This will return the last set target even if pointing is set
 	 * to disabled by @c stopPointing()
 	 */
-	Coordinate pointAt();
+	PreciseCoordinate pointAt();
 
 	/**
 	 * Sets desired target for pointing.
@@ -148,7 +321,7 @@ class _OmniDrive : public Axon, public rec::robotino::api2::OmniDrive
 	 * the current destination and sufficiently far from the pointing target
 	 * see \#defines in @link _OmniDrive.h @endlink
 	 */
-	void setPointAt( Coordinate target );
+	void setPointAt( PreciseCoordinate target );
 
 	/**
 	 * Check if pointing is activated
@@ -165,6 +338,56 @@ class _OmniDrive : public Axon, public rec::robotino::api2::OmniDrive
 	 */
 	void stopPointing();
 
+	/**
+	 * Switches holonomic driving on or off
+	 *
+	 * In holonomic mode Robotino drives the straight line to the destination
+	 * in any direction, turning towards the pointing target on the way
+	 * rather than first turning to face the destination. When off, Robotino
+	 * travels facing the destination and manouvers only close to it.
+	 *
+	 * @param	enable	True for holonomic driving
+	 */
+	void setHolonomic( bool enable );
+
+	/**
+	 * Checks if holonomic driving is on
+	 *
+	 * @return	Boolean indicating if holonomic driving is on
+	 */
+	bool isHolonomic();
+
+	/**
+	 * Switches model predictive control on or off
+	 *
+	 * With model predictive control Robotino drives to the destination, and
+	 * turns to the pointing target, as planned by an MpcController over the
+	 * next second. This gives precise approaches without overshoot or
+	 * crawling at the minimum speeds. Path following still uses PurePursuit.
+	 *
+	 * @param	enable	True for model predictive control
+	 */
+	void setModelPredictive( bool enable );
+
+	/**
+	 * Checks if model predictive control is on
+	 *
+	 * @return	Boolean indicating if model predictive control is on
+	 */
+	bool isModelPredictive();
+
+	/**
+	 * Switches speed limiting near obstacles on or off
+	 *
+	 * When on, the speed is limited every cycle so Robotino can stop before
+	 * the nearest obstacle in its direction of travel, as seen by the
+	 * LaserRangeFinder and the distance sensors. Switch off to approach
+	 * something on purpose, like an object to grip.
+	 *
+	 * @param	enable	True to limit speed near obstacles
+	 */
+	void setProximityLimiting( bool enable );
+
 	/**
 	 * Get the currnet stopWithin value
 	 *
@@ -213,13 +436,68 @@ class _OmniDrive : public Axon, public rec::robotino::api2::OmniDrive
 	/**
 	 * Overrides rec::robotino::api2::OmniDrive::setVelocity()
 	 * Suspends the automatic driving system and sets given speeds for
-	 * x, y and omega:
+	 * x, y and omega. If a wheel would exceed its top speed all three are
+	 * scaled down together, see OmniKinematics::saturate().
 	 *
 	 * @param xSpeed	Desired speed in x direction
 	 * @param ySpeed	Desired speed in y direction
 	 * @param omega		Desired rotation speed
 	 */
 	void setVelocity( float xSpeed, float ySpeed, float omega );
+
+	/**
+	 * Sets speeds chosen by a local planner for the next apply() only
+	 *
+	 * Unlike setVelocity() this does not leave automatic driving, so when
+	 * the planner stops calling, Robotino carries on towards the current
+	 * destination. A stop order still takes precedence.
+	 *
+	 * @param xSpeed	Desired speed in x direction
+	 * @param ySpeed	Desired speed in y direction
+	 * @param omega		Desired rotation speed
+	 */
+	void setPlannedVelocity( float xSpeed, float ySpeed, float omega );
+
+	/**
+	 * Gets the measured time between the last two calls to apply()
+	 *
+	 * @return	Cycle time in seconds, at most OMNIDRIVE_MAX_CYCLE_TIME
+	 */
+	float cycleTime();
+
+	/**
+	 * Gets the speeds last sent to Robotino, which the wheels should be
+	 * turning at
+	 *
+	 * @param	xSpeed	Set to the speed in x direction
+	 * @param	ySpeed	Set to the speed in y direction
+	 * @param	omega	Set to the rotation speed
+	 */
+	void commandedSpeed( float * xSpeed, float * ySpeed, float * omega );
+
+	/**
+	 * Sets when apply() may skip sending the speeds to Robotino. A command is
+	 * skipped if no speed changed by more than epsilon since the last one
+	 * sent, unless that was keepalive msecs ago. Stopping is always sent.
+	 *
+	 * @param	epsilon	Change in speed ignored, 0 to only skip repeats
+	 * @param	keepalive	Longest time without sending, in msecs
+	 */
+	void setCommandSuppression( float epsilon, unsigned int keepalive );
+
+	/**
+	 * Gets the number of speed commands sent to Robotino
+	 *
+	 * @return	Commands sent since construction
+	 */
+	unsigned int commandsSent();
+
+	/**
+	 * Gets the number of speed commands apply() skipped as unchanged
+	 *
+	 * @return	Commands skipped since construction
+	 */
+	unsigned int commandsSuppressed();
 	
 
  private:
@@ -236,39 +514,187 @@ class _OmniDrive : public Axon, public rec::robotino::api2::OmniDrive
 		yOld,
 	/// Previous turning speed
 		omegaOld,
+	/// Current accelleration in x direction
+		xAccelleration,
+	/// Current accelleration in y direction
+		yAccelleration,
+	/// Current rotation accelleration
+		omegaAccelleration,
+	/// Measured time between the last two cycles, in seconds
+		_cycleTime,
 	/// Distance to target do considere as arrived
 		_stopWithin,
 	/// Target manual speeds
 		targetXSpeed,
 		targetYSpeed,
-		targetOmega;
+		targetOmega,
+	/// Speeds from setPlannedVelocity()
+		plannedXSpeed,
+		plannedYSpeed,
+		plannedOmega,
+	/// Speeds last sent to Robotino
+		sentXSpeed,
+		sentYSpeed,
+		sentOmega,
+	/// Change in speed not worth sending, see setCommandSuppression()
+		commandEpsilon;
+
+	unsigned int
+	/// Time of the last call to apply(), in msecs since Brain started
+		applyTime,
+	/// Time the speeds were last sent, in msecs since Brain started
+		sendTime,
+	/// Longest time without sending, see setCommandSuppression()
+		keepaliveTime,
+	/// Commands sent, see commandsSent()
+		_commandsSent,
+	/// Commands skipped, see commandsSuppressed()
+		_commandsSuppressed;
 
 	bool
 	/// Travel backwards, protecting the cBHA
 		travelReversed,
 	/// Do not travel, only perform manouvering
 		onlyManouver,
+	/// Drive straight to the destination while turning, see setHolonomic()
+		holonomic,
+	/// Limit speed near obstacles, see setProximityLimiting()
+		proximityLimiting,
+	/// Drive by model predictive control, see setModelPredictive()
+		modelPredictive,
 	/// Yup, do that
 		_doPointAt,
 	/// If set, Robotino will stop and will not move.
 		stop,
 	/// Automatically moving to destination
-		autoDrive;
+		autoDrive,
+	/// Speeds were set by setPlannedVelocity() since the last apply()
+		planned;
 
-	Coordinate
+	PreciseCoordinate
 	/// Coordinate of the current destination
 		_destination,
 	/// Coordinate of the current pointing target
 		_pointAt;
 
+	std::deque< Waypoint >
+	/// Waypoints not yet reached, the first being the current destination
+		_route;
+
+	PurePursuit
+	/// Path follower for followPath()
+		pursuit;
+
+	VelocityProfile
+	/// Speed profile for travelling
+		travelProfile,
+	/// Speed profile for manouvering
+		manouverProfile,
+	/// Speed profile for turning
+		rotateProfile;
+
+	OmniKinematics
+	/// Wheel kinematics, limiting commands to what the wheels can do
+		kinematics;
+
+	MpcController
+	/// Controller for setModelPredictive()
+		mpc;
+
+	std::atomic< bool >
+	/// If apply() has to reset @c mpc before it runs, set from other threads
+		mpcReset;
+
+	std::mutex
+	/// Guards @c _route and @c pursuit, which are set from other threads
+	/// than apply()
+		routeMutex;
+
+	/**
+	 * Makes a waypoint the current destination
+	 *
+	 * @param	waypoint	The waypoint
+	 */
+	void startWaypoint( const Waypoint & waypoint );
+
+	/**
+	 * Moves on through the route as waypoints are reached, and calculates
+	 * the distance left to drive before the next stop.
+	 *
+	 * @param	position	Current position
+	 *
+	 * @return	Distance along the route to the next stop waypoint, or to the
+	 * destination if no route is followed
+	 */
+	float followRoute( PreciseCoordinate position );
+
+
+	/**
+	 * Calculates speeds in the X and Y axes to follow the current path
+	 *
+	 * @param	position	Current position
+	 *
+	 * @return	False when the end of the path has been reached
+	 */
+	bool followTowards( PreciseAngularCoordinate position );
 
 	/**
 	 * Calculates speed in the X axis and turning speed to drive towards the
 	 * desired destination.
 	 *
 	 * @param	destinationVector	Vector pointing to destination.
+	 * @param	distance	Distance left to drive before stopping, which is
+	 * longer than the destination vector when passing through waypoints
+	 */
+	void travelTowards( PreciseVector destinationVector, float distance );
+
+	/**
+	 * Calculates speeds in the X and Y axes to drive straight towards the
+	 * destination, in whichever direction it is.
+	 *
+	 * @param	heading	The current heading
+	 * @param	destinationVector	A vector pointing to the destination.
+	 * @param	distance	Distance left to drive before stopping, which is
+	 * longer than the destination vector when passing through waypoints
 	 */
-	void travelTowards( Vector destinationVector );
+	void holonomicTowards( PreciseAngle heading, PreciseVector destinationVector, float distance );
+
+	/**
+	 * Calculates speeds to drive to the destination, and turn to the
+	 * pointing target, with the MpcController
+	 *
+	 * @param	position	Current position
+	 * @param	distance	Distance left to drive before stopping
+	 */
+	void predictTowards( PreciseAngularCoordinate position, float distance );
+
+	/**
+	 * Slows the X and Y speeds down, keeping their direction, to a speed
+	 * from which Robotino can stop OMNIDRIVE_PROXIMITY_MARGIN short of the
+	 * nearest obstacle in that direction
+	 */
+	void limitForProximity();
+
+	/**
+	 * Slows the speeds down to OMNIDRIVE_SLIP_MAX_SPEED and
+	 * OMNIDRIVE_SLIP_MAX_OMEGA, keeping the direction of the X and Y speeds
+	 */
+	void limitForSlip();
+
+	/**
+	 * Sends the speeds to Robotino, unless they are too close to the last
+	 * ones sent, see setCommandSuppression()
+	 *
+	 * @param	force	True to send regardless
+	 */
+	void sendVelocity( bool force );
+
+	/**
+	 * Corrects the X and Y speeds for the turning done during the cycle.
+	 * The speeds are calculated for the heading at the start of the cycle,
+	 * this makes Robotino still end up going in the intended direction.
+	 */
+	void compensateRotation();
 
 	/**
 	 * Calculates speeds to manouver towards a destination.
@@ -276,29 +702,31 @@ class _OmniDrive : public Axon, public rec::robotino::api2::OmniDrive
 	 * @param	heading	The current heading
 	 * @param	destinationVector	A vector pointing to the destination.
 	 */
-	void manouverTowards( Angle heading, Vector destinationVector );
+	void manouverTowards( PreciseAngle heading, PreciseVector destinationVector );
 
 	/**
-	 * Calculates speeds to turn Robotino towards the given target
+	 * Calculates speeds to turn Robotino towards the given target. Pointing
+	 * is done once turned, or if the target is within the stop distance.
 	 *
 	 * @param	position	Current position
 	 * @param	target	Pointing target
 	 */
-	void turnTowards( AngularCoordinate position, Coordinate target );
+	void turnTowards( PreciseAngularCoordinate position, PreciseCoordinate target );
 
 	/**
-	 * Calculates speeds for manouvering. Used for both X and Y directions.
+	 * Calculates the manouvering speed from a time-optimal profile.
 	 *
-	 * @param	length	The X or Y deviation from desired destination
+	 * @param	length	Distance left to the destination
+	 * @param	currentSpeed	The current speed towards the destination
 	 *
-	 * @return	An appropriate speed for approachin the destination
+	 * @return	An appropriate speed for approaching the destination
 	 */
-	float findManouverVelocity( float length );
+	float findManouverVelocity( float length, float currentSpeed );
 
 	/**
-	 * Calculates the appropriate travel speed based on the distance and
-	 * angle to the destination. Speed will be 0 until the the angle is smaller
-	 * than set in OMNIDRIVE_TRAVEL_MAX_ANGLE.
+	 * Calculates the travel speed from a time-optimal profile for the
+	 * distance, scaled down by the angle to the destination. Speed will be
+	 * 0 until the the angle is smaller than set in OMNIDRIVE_TRAVEL_MAX_ANGLE.
 	 *
 	 * @param	lenght	Distance to destination
 	 * @param	omega	Angle to destination
@@ -308,7 +736,8 @@ class _OmniDrive : public Axon, public rec::robotino::api2::OmniDrive
 	float findTravelVelocity( float length, float omega );
 
 	/**
-	 * Calculates the neccesary speed to turn to deminish the parameter.
+	 * Calculates the turning speed from a time-optimal profile, stopping
+	 * the turn at the desired heading.
 	 * 
 	 * @param	deltaAngle	An angle in rad describing the difference between
 	 * the current and the desired heading.
@@ -318,15 +747,26 @@ class _OmniDrive : public Axon, public rec::robotino::api2::OmniDrive
 	float findAngularVelocity( float deltaAngle );
 
 	/**
-	 * Calculates new speed values based on current and desired speeds.
-	 *
-	 * @param	newSpeed	The desired speed
-	 * @param	currentSpeed	The current speed
-	 * @param	rotation	If this is a rotation velocity (omega)
+	 * Limits the change from the previous speeds to the new ones, x and y
+	 * together so the direction of accelleration is kept, within the
+	 * accelleration and jerk limits over the measured cycle time.
+	 */
+	void softAccellerate();
+
+	/**
+	 * Limits a change of speed within an accelleration and jerk limit,
+	 * easing off the accelleration in time to not overshoot the new speed.
+	 * The limits apply to the length of the vectors, keeping their direction.
 	 *
-	 * @return	A speed complying with the set options
+	 * @param	delta	Wanted change of speed, set to the change to apply
+	 * @param	accelleration	Current accelleration, updated
+	 * @param	dimensions	Number of elements in @c delta and
+	 * @c accelleration
+	 * @param	maxAccelleration	Accelleration limit
+	 * @param	maxJerk	Jerk limit
 	 */
-	float softAccellerate( float newSpeed, float currentSpeed, bool rotation = false );
+	void limitChange( float * delta, float * accelleration, unsigned int dimensions,
+			float maxAccelleration, float maxJerk );
 };
 
 #endif